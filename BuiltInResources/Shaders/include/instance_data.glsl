@@ -0,0 +1,5 @@
+// written per frame by RenderResourceManager::UpdatePerFrameBuffer(), indexed with gl_InstanceIndex
+layout(std430, set = 0, binding = 1) readonly buffer InstanceBuffer
+{
+	mat4 modelMatrices[];
+} instanceData;
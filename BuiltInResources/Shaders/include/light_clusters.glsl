@@ -0,0 +1,38 @@
+// written per frame by RenderResourceManager::UpdatePerFrameBuffer() from LightClusters
+struct Light
+{
+	vec4 positionRange;		// world space, w: nothing past this distance is lit
+	vec4 colorIntensity;
+	vec4 directionSpotCos;	// w: cos of the outer cone angle, -1 for point lights
+};
+
+layout(set = 0, binding = 2) uniform LightClusterData
+{
+	uvec4 gridSize;		// tiles x, tiles y, depth slices, light count
+	vec4 depthParams;	// slice = log(view depth) * x + y, z: z near, w: z far
+} lightClusterData;
+
+layout(std430, set = 0, binding = 3) readonly buffer LightBuffer
+{
+	Light lights[];
+} lightData;
+
+layout(std430, set = 0, binding = 4) readonly buffer LightClusterBuffer
+{
+	uvec2 clusterRanges[];	// offset and count into lightIndexes
+} lightClusterRanges;
+
+layout(std430, set = 0, binding = 5) readonly buffer LightIndexBuffer
+{
+	uint lightIndexes[];
+} lightIndexData;
+
+// ndc from -1 to 1, viewDepth is the positive distance along the view direction
+uint GetLightClusterIndex(vec2 ndc, float viewDepth)
+{
+	uvec3 grid = lightClusterData.gridSize.xyz;
+	uvec2 tile = min(uvec2((ndc * 0.5 + 0.5) * vec2(grid.xy)), grid.xy - 1);
+	float slice = floor(log(max(viewDepth, lightClusterData.depthParams.z)) * lightClusterData.depthParams.x + lightClusterData.depthParams.y);
+	uint z = uint(clamp(slice, 0.0, float(grid.z - 1)));
+	return (z * grid.y + tile.y) * grid.x + tile.x;
+}
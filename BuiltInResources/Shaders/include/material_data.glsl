@@ -0,0 +1,14 @@
+// written by RenderResourceManager when materials change, indexed with the material index of the draw
+struct Material
+{
+	vec4 colorFactors;
+	float metallicFactor;
+	float roughnessFactor;
+	uint baseColorTexture;			// indexes of the bindless image array
+	uint metallicRoughnessTexture;
+};
+
+layout(std430, set = 0, binding = 6) readonly buffer MaterialBuffer
+{
+	Material data[];
+} materials;
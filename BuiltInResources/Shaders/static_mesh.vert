@@ -2,7 +2,8 @@
 
 #extension GL_GOOGLE_include_directive : require
 
-#include "include/input_structures.glsl"
+#include "include/uniform_scene.glslh"
+#include "include/instance_data.glsl"
 
 layout(location = 0) in vec3 inPosition;
 
@@ -21,19 +22,14 @@ layout(location = 4) in vec4 inColor;
 layout(location = 4) out vec4 vColor;
 #endif
 
-//push constants block
-layout(push_constant, std430) uniform PushConstants
-{
-	mat4 modelMatrix;
-} modelData;
-
 void main() 
 {
+	mat4 modelMatrix = instanceData.modelMatrices[gl_InstanceIndex];
 	vec4 position = vec4(inPosition, 1.0f);
-	gl_Position =  sceneData.viewproj * modelData.modelMatrix * position;
+	gl_Position =  sceneData.viewproj * modelMatrix * position;
 
 #ifdef HAVE_NORMAL
-	mat3 normalTransform = mat3(modelData.modelMatrix[0].xyz, modelData.modelMatrix[1].xyz, modelData.modelMatrix[2].xyz);
+	mat3 normalTransform = mat3(modelMatrix[0].xyz, modelMatrix[1].xyz, modelMatrix[2].xyz);
 	vNormal = normalize(normalTransform * inNormal);
 #endif
 
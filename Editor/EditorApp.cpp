@@ -63,6 +63,10 @@ void EditorApp::OnUpdate(TimeStep ts)
     if (m_viewportHovered && Input::Get()->IsKeyPressed(Key::LeftAlt, true))
         m_editorCamera.OnUpdate(ts);
 
+    // stream world partition cells around the editor camera
+    if (m_worldPartition)
+        m_worldPartition->Update(m_editorCamera.GetPosition());
+
     // update scene
     m_scene->OnUpdate();
 
@@ -100,11 +104,9 @@ void EditorApp::OnUpdate(TimeStep ts)
     cam_swap_data.view = cameraData.view;
     swap_data.camera_swap_data = cam_swap_data;
 
-    // swap render and logic data
+    // render and logic data are swapped by the application once the frame's logic is done
     // RenderSystem::Get().UpdateDrawContext(m_scene, m_drawContext);
     // RenderSystem::Get().UpdateVisibility(m_drawContext, m_visibility, cameraData);
-
-    RenderSystem::Get().GetSwapContext().SwapLogicRenderData();
 }   
 
 void EditorApp::OnImGuiUpdate()
@@ -122,6 +124,9 @@ void EditorApp::OnImGuiUpdate()
             if (ImGui::MenuItem("Open Scene...", "Ctrl+O"))
                 OpenScene();
 
+            if (ImGui::MenuItem("Save Scene", "Ctrl+S"))
+                SaveScene();
+
             if (ImGui::MenuItem("Save Scene As...", "Ctrl+Shift+S"))
                 SaveSceneAs();
 
@@ -143,6 +148,21 @@ void EditorApp::OnImGuiUpdate()
         ImGui::Text("Frame Time: %f ms", m_status.lastFrameDuration);
         ImGui::Text("CmdList Record Time: %f ms", m_cmdListRecordTime);
 
+        // OnRender moves to its own thread from the next frame on
+        bool framePipelining = IsFramePipelining();
+        if (ImGui::Checkbox("Frame Pipelining", &framePipelining))
+            SetFramePipelining(framePipelining);
+
+        const RenderStats& renderStats = RenderSystem::Get().GetStats();
+        ImGui::Text("Draw Calls: %u, Instances: %u", renderStats.draw_calls, renderStats.instances);
+        ImGui::Text("Triangles: %llu", (unsigned long long)renderStats.triangles);
+        ImGui::Text("Binds: %u pipelines, %u materials, %u meshes", renderStats.pipeline_binds, renderStats.material_binds, renderStats.mesh_binds);
+        ImGui::Text("Skipped Draw Calls: %u (%u pipelines compiling)", renderStats.skipped_draw_calls, renderStats.pending_pipelines);
+        ImGui::Text("Secondary Command Lists: %u", renderStats.secondary_cmd_lists);
+        ImGui::Text("Occluded Objects: %u", renderStats.occluded_objects);
+        ImGui::Text("Visibility Time: %f ms", renderStats.visibility_time_ms);
+        ImGui::Text("Light Cluster Time: %f ms", renderStats.light_cluster_time_ms);
+
         std::string entityName = "None";
         if (m_hoverdEntity)
             entityName = m_hoverdEntity->GetComponent<NameCmpt>()->name;
@@ -173,6 +193,7 @@ void EditorApp::OnImGuiUpdate()
 
     m_viewportFocused = ImGui::IsWindowFocused();
     m_viewportHovered = ImGui::IsWindowHovered();
+    m_viewportMousePos = ImGui::GetMousePos(); // OnRender may run on the render thread, don't let it query ImGui
 
     ImVec2 viewportPanelSize = ImGui::GetContentRegionAvail();
     m_viewportSize = { viewportPanelSize.x, viewportPanelSize.y };
@@ -237,6 +258,8 @@ void EditorApp::OnImGuiUpdate()
 
 void EditorApp::NewScene()
 {
+    m_worldPartition.reset();
+    m_sceneJournal.reset();
     m_scene = CreateRef<Scene>("New Scene");
 
     m_heirarchyPanel.SetScene(m_scene);
@@ -245,16 +268,39 @@ void EditorApp::NewScene()
 
 void EditorApp::OpenScene()
 {
-    std::filesystem::path filepath = FileSystem::OpenFileDialog({ { "Quark Scene", "qkscene" } });
+    std::filesystem::path filepath = FileSystem::OpenFileDialog({ { "Quark Scene", "qkscene,qkbscene" }, { "Quark World", "qkworld" } });
     if (!filepath.empty())
         OpenScene(filepath);
 }
 
 void EditorApp::OpenScene(const std::filesystem::path& path)
 {
+    m_worldPartition.reset();
+    m_sceneJournal.reset();
     m_scene = CreateRef<Scene>("");
-    SceneSerializer serializer(m_scene);
-    serializer.Deserialize(path.string());
+
+    if (path.extension() == WorldPartition::s_DefaultExtension)
+    {
+        m_worldPartition = CreateRef<WorldPartition>(m_scene, *GetJobSystem());
+        m_worldPartition->SetUnloadCallback([this]()
+        {
+            // the selected or hovered entity may be in the cell
+            m_heirarchyPanel.SetSelectedEntity(nullptr);
+            m_inspectorPanel.SetSelectedEntity(nullptr);
+            m_hoverdEntity = nullptr;
+        });
+        if (m_worldPartition->Open(path))
+            m_worldPartition->Flush(m_editorCamera.GetPosition());
+    }
+    else
+    {
+        SceneSerializer serializer(m_scene);
+        if (serializer.DeserializeAuto(path) && path.extension() == SceneSerializer::s_DefaultExtension)
+        {
+            m_sceneJournal = CreateRef<SceneJournal>(m_scene, *GetJobSystem());
+            m_sceneJournal->Begin(path);
+        }
+    }
 
     m_heirarchyPanel.SetScene(m_scene);
     m_inspectorPanel.SetScene(m_scene);
@@ -262,13 +308,42 @@ void EditorApp::OpenScene(const std::filesystem::path& path)
     m_hoverdEntity = nullptr;
 }
 
+void EditorApp::SaveScene()
+{
+    // Only the changes since the last save are written
+    if (m_sceneJournal)
+        m_sceneJournal->Save();
+    else
+        SaveSceneAs();
+}
+
 void EditorApp::SaveSceneAs()
 {
-    std::filesystem::path filepath = FileSystem::SaveFileDialog({ { "Quark Scene", "qkscene" } });
+    std::filesystem::path filepath = FileSystem::SaveFileDialog({ { "Quark Scene", "qkscene" }, { "Quark Binary Scene", "qkbscene" } });
     if (!filepath.empty())
     {
+        // The journal may be compacting into the file being overwritten
+        if (m_sceneJournal)
+            m_sceneJournal->WaitForCompaction();
+
         SceneSerializer serializer(m_scene);
-        serializer.Serialize(filepath.string());
+        if (!serializer.SerializeAuto(filepath))
+        {
+            QK_CORE_LOGE_TAG("Editor", "Failed to save scene to {}", filepath.string());
+            return;
+        }
+
+        // Later saves go to the new file, incrementally only if it is a YAML scene
+        if (filepath.extension() == SceneSerializer::s_DefaultExtension && !m_worldPartition)
+        {
+            if (!m_sceneJournal)
+                m_sceneJournal = CreateRef<SceneJournal>(m_scene, *GetJobSystem());
+            m_sceneJournal->Begin(filepath);
+        }
+        else
+        {
+            m_sceneJournal.reset();
+        }
     }
 }
 
@@ -339,152 +414,89 @@ void EditorApp::OnRender(TimeStep ts)
         scissor.offset.x = 0;
         scissor.offset.y = 0;
 
+        // the graph computes the barriers and owns the depth and entity ID attachments, which alias each other
+        // when their passes don't overlap. The viewport color is imported, ImGui samples it.
+        RenderGraph& graph = *m_renderGraph;
+        graph.Reset();
+        RenderGraphImage swap_chain = graph.ImportImage("swapchain", swap_chain_image, RenderGraphImageUsage::NONE, RenderGraphImageUsage::PRESENT);
+        RenderGraphImage color = graph.ImportImage("viewport_color", m_color_attachment.get());
+        RenderGraphImage depth = graph.CreateImage("viewport_depth", m_depth_desc);
+
         // Main pass
-        {
-            rhi::PipelineImageBarrier image_barrier;
-            image_barrier.image = m_color_attachment.get();
-            image_barrier.srcStageBits = rhi::PIPELINE_STAGE_ALL_GRAPHICS_BIT;
-            image_barrier.srcMemoryAccessBits = 0;
-            image_barrier.dstStageBits = rhi::PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            image_barrier.dstMemoryAccessBits = rhi::BARRIER_ACCESS_COLOR_ATTACHMENT_READ_BIT | rhi::BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            image_barrier.layoutBefore = rhi::ImageLayout::UNDEFINED;
-            image_barrier.layoutAfter = rhi::ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
-            graphic_cmd->PipeLineBarriers(nullptr, 0, &image_barrier, 1, nullptr, 0);
-
-            // Begin pass
-            rhi::FrameBufferInfo fb_info;
-            fb_info.colorAttatchemtsLoadOp[0] = rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR;
-            fb_info.colorAttatchemtsStoreOp[0] = rhi::FrameBufferInfo::AttachmentStoreOp::STORE;
-            fb_info.colorAttachments[0] = m_color_attachment.get();
-            fb_info.clearColors[0] = { 0.2f, 0.2f, 0.2f, 0.f };
-            fb_info.depthAttachment = m_depth_attachment.get();
-            fb_info.depthAttachmentLoadOp = rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR;
-            fb_info.depthAttachmentStoreOp = rhi::FrameBufferInfo::AttachmentStoreOp::STORE;
-            fb_info.clearDepthStencil.depth_stencil = { 1.f, 0 };
-
-            graphic_cmd->BeginRenderPass(render_system.GetRenderResourceManager().renderPassInfo_simpleMainPass, fb_info);
-            graphic_cmd->SetViewPort(viewport);
-            graphic_cmd->SetScissor(scissor);
-
-            // draw skybox
-            // render_system.DrawSkybox(m_drawContext, m_cubeMapTexture, graphic_cmd);
-            render_system.DrawSkybox(m_cubeMapId, graphic_cmd);
-            
-            // draw infinite grid
-            // render_system.DrawGrid(graphic_cmd);
-
-            // draw scene
-            auto geometry_start = m_timer.ElapsedMillis();
-            render_system.DrawScene(*render_scene, render_scene->main_camera_visibility, graphic_cmd);
-            m_cmdListRecordTime = m_timer.ElapsedMillis() - geometry_start;
-
-            graphic_cmd->EndRenderPass();
-        }
+        rhi::ClearValue clear_color = { 0.2f, 0.2f, 0.2f, 0.f };
+        graph.AddPass("main")
+            .AddColorOutput(color, rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR, clear_color)
+            .SetDepthOutput(depth)
+            .SetContents(rhi::RenderPassContents::SECONDARY_COMMAND_LISTS) // the draws of this pass are recorded in secondary command lists, on the job system for the scene
+            .SetExecute([&](rhi::CommandList* cmd)
+            {
+                cmd->SetViewPort(viewport);
+                cmd->SetScissor(scissor);
+
+                // draw skybox
+                rhi::CommandList* skybox_cmd = m_graphicDevice->BeginSecondaryCommandList(*cmd);
+                render_system.DrawSkybox(m_cubeMapId, skybox_cmd);
+                cmd->ExecuteSecondaryCommandLists(&skybox_cmd, 1);
+
+                // draw infinite grid
+                // render_system.DrawGrid(graphic_cmd);
+
+                // draw scene
+                auto geometry_start = m_timer.ElapsedMillis();
+                render_system.DrawSceneParallel(*render_scene, render_scene->main_camera_visibility, cmd);
+                m_cmdListRecordTime = m_timer.ElapsedMillis() - geometry_start;
+            });
 
         // ui pass
-        {
-            rhi::PipelineImageBarrier image_barriers[2];
-            image_barriers[0].image = swap_chain_image;
-            image_barriers[0].srcStageBits = rhi::PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            image_barriers[0].srcMemoryAccessBits = 0;
-            image_barriers[0].dstStageBits = rhi::PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            image_barriers[0].dstMemoryAccessBits = rhi::BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            image_barriers[0].layoutBefore = rhi::ImageLayout::UNDEFINED;
-            image_barriers[0].layoutAfter = rhi::ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
-            image_barriers[1].image = m_color_attachment.get();
-            image_barriers[1].srcStageBits = rhi::PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            image_barriers[1].srcMemoryAccessBits = rhi::BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            image_barriers[1].dstStageBits = rhi::PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-            image_barriers[1].dstMemoryAccessBits = rhi::BARRIER_ACCESS_SHADER_READ_BIT;
-            image_barriers[1].layoutBefore = rhi::ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
-            image_barriers[1].layoutAfter = rhi::ImageLayout::SHADER_READ_ONLY_OPTIMAL;
-            graphic_cmd->PipeLineBarriers(nullptr, 0, image_barriers, 2, nullptr, 0);
-
-            rhi::FrameBufferInfo fb_info;
-            fb_info.colorAttatchemtsLoadOp[0] = rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR;
-            fb_info.colorAttatchemtsStoreOp[0] = rhi::FrameBufferInfo::AttachmentStoreOp::STORE;
-            fb_info.colorAttachments[0] = swap_chain_image;
-
-            graphic_cmd->BeginRenderPass(render_system.GetRenderResourceManager().renderPassInfo_swapchainPass, fb_info);
-            UI::Get()->OnRender(graphic_cmd);
-            graphic_cmd->EndRenderPass();
-        }
+        graph.AddPass("ui")
+            .AddTextureInput(color)
+            .AddColorOutput(swap_chain)
+            .SetExecute([&](rhi::CommandList* cmd) { UI::Get()->OnRender(cmd); });
 
-        // transit swapchain image to present layout for presenting
+        // color picking
+        if (m_viewportHovered)
         {
-            rhi::PipelineImageBarrier present_barrier;
-            present_barrier.image = swap_chain_image;
-            present_barrier.srcStageBits = rhi::PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            present_barrier.srcMemoryAccessBits = rhi::BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            present_barrier.dstStageBits = rhi::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-            present_barrier.dstMemoryAccessBits = 0;
-            present_barrier.layoutBefore = rhi::ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
-            present_barrier.layoutAfter = rhi::ImageLayout::PRESENT;
-            graphic_cmd->PipeLineBarriers(nullptr, 0, &present_barrier, 1, nullptr, 0);
-
-            // Submit graphic command list
-            m_graphicDevice->SubmitCommandList(graphic_cmd);
+            RenderGraphImage entity_id = graph.CreateImage("entity_id", m_entityID_desc);
+            RenderGraphImage entity_depth = graph.CreateImage("entity_id_depth", m_depth_desc);
+
+            // color ID pass
+            rhi::ClearValue clear_id = {};
+            clear_id.color.uint32[0] = 0;
+            clear_id.color.uint32[1] = 10;
+            graph.AddPass("entity_id")
+                .AddColorOutput(entity_id, rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR, clear_id)
+                .SetDepthOutput(entity_depth)
+                .SetExecute([&](rhi::CommandList* cmd)
+                {
+                    cmd->SetViewPort(viewport);
+                    cmd->SetScissor(scissor);
+                    render_system.DrawEntityID(*render_scene, render_scene->main_camera_visibility, cmd);
+                });
+
+            // transfer data back to cpu buffer
+            graph.AddPass("entity_id_readback")
+                .AddTransferInput(entity_id)
+                .SetSideEffect()
+                .SetExecute([&, entity_id](rhi::CommandList* cmd)
+                {
+                    auto [mx, my] = m_viewportMousePos;
+                    mx -= m_viewportBounds[0].x;
+                    my -= m_viewportBounds[0].y;
+                    glm::vec2 viewportSize = m_viewportBounds[1] - m_viewportBounds[0];
+                    int mouseX = (int)mx;
+                    int mouseY = (int)my;
+                    uint32_t image_width = m_color_attachment->GetDesc().width;
+                    uint32_t image_height = m_color_attachment->GetDesc().height;
+                    int x = static_cast<int>(((mouseX / viewportSize.x) * image_width));
+                    int y = static_cast<int>(((mouseY / viewportSize.y) * image_height));
+                    cmd->CopyImageToBuffer(*m_stage_buffer, *graph.GetImage(entity_id), 0, { x, y, 0 },
+                        { 1, 1, 1 }, 0, 0, { rhi::ImageAspect::COLOR, 0, 0, 1 });
+                });
         }
 
-         // color picking
-         if (m_viewportHovered)
-         {
-             // color ID pass
-             rhi::CommandList* cmd = m_graphicDevice->BeginCommandList();
-
-             rhi::PipelineImageBarrier image_barrier;
-             image_barrier.image = m_entityID_color_attachment.get();
-             image_barrier.srcStageBits = rhi::PIPELINE_STAGE_TRANSFER_BIT;
-             image_barrier.srcMemoryAccessBits = rhi::BARRIER_ACCESS_TRANSFER_READ_BIT;
-             image_barrier.dstStageBits = rhi::PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-             image_barrier.dstMemoryAccessBits = rhi::BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-             image_barrier.layoutBefore = rhi::ImageLayout::UNDEFINED;
-             image_barrier.layoutAfter = rhi::ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
-             cmd->PipeLineBarriers(nullptr, 0, &image_barrier, 1, nullptr, 0);
-
-             rhi::FrameBufferInfo fb_info;
-             fb_info.colorAttatchemtsLoadOp[0] = rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR;
-             fb_info.colorAttatchemtsStoreOp[0] = rhi::FrameBufferInfo::AttachmentStoreOp::STORE;
-             fb_info.colorAttachments[0] = m_entityID_color_attachment.get();
-             fb_info.clearColors[0].color.uint32[0] = 0;
-             fb_info.clearColors[0].color.uint32[1] = 10;
-             fb_info.depthAttachment = m_entityID_depth_attachment.get();
-             fb_info.depthAttachmentLoadOp = rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR;
-             fb_info.depthAttachmentStoreOp = rhi::FrameBufferInfo::AttachmentStoreOp::STORE;
-             fb_info.clearDepthStencil.depth_stencil = { 1.f, 0 };
-
-             cmd->BeginRenderPass(render_system.GetRenderResourceManager().renderPassInfo_entityIdPass, fb_info);
-             cmd->SetViewPort(viewport);
-             cmd->SetScissor(scissor);
-             render_system.DrawEntityID(*render_scene, render_scene->main_camera_visibility, cmd);
-             cmd->EndRenderPass();
-
-             // transfer data back to cpu buffer
-             rhi::PipelineImageBarrier barrier;
-             barrier.image = m_entityID_color_attachment.get();
-             barrier.srcStageBits = rhi::PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-             barrier.srcMemoryAccessBits = 0;
-             barrier.dstStageBits = rhi::PIPELINE_STAGE_TRANSFER_BIT;
-             barrier.dstMemoryAccessBits = rhi::BARRIER_ACCESS_TRANSFER_READ_BIT;
-             barrier.layoutBefore = rhi::ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
-             barrier.layoutAfter = rhi::ImageLayout::TRANSFER_SRC_OPTIMAL;
-             cmd->PipeLineBarriers(nullptr, 0, &barrier, 1, nullptr, 0);
-
-             auto [mx, my] = ImGui::GetMousePos();
-             mx -= m_viewportBounds[0].x;
-             my -= m_viewportBounds[0].y;
-             glm::vec2 viewportSize = m_viewportBounds[1] - m_viewportBounds[0];
-             int mouseX = (int)mx;
-             int mouseY = (int)my;
-             uint32_t image_width = m_color_attachment->GetDesc().width;
-             uint32_t image_height = m_color_attachment->GetDesc().height;
-             int x = static_cast<int>(((mouseX / viewportSize.x) * image_width));
-             int y = static_cast<int>(((mouseY / viewportSize.y) * image_height));
-             cmd->CopyImageToBuffer(*m_stage_buffer, *m_entityID_color_attachment, 0, { x, y, 0 },
-                 { 1, 1, 1 }, 0, 0, { rhi::ImageAspect::COLOR, 0, 0, 1 });
-
-             m_graphicDevice->SubmitCommandList(cmd, nullptr, 0, false);
-         }
+        graph.Compile();
+        graph.Execute(graphic_cmd);
+        m_graphicDevice->SubmitCommandList(graphic_cmd);
 
         m_graphicDevice->EndFrame(ts);
     }
@@ -511,6 +523,8 @@ void EditorApp::OnKeyPressed(const KeyPressedEvent& e)
     case Key::S:
 		if (control && shift)
 			SaveSceneAs();
+		else if (control)
+			SaveScene();
 		break;
     // Gizmos
     case Key::Q:
@@ -553,21 +567,19 @@ void EditorApp::CreateGraphicResources()
     image_desc.format = RenderSystem::Get().GetRenderResourceManager().format_depthAttachment_main;
     image_desc.arraySize = 1;
     image_desc.mipLevels = 1;
-    image_desc.initialLayout = ImageLayout::DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    image_desc.initialLayout = ImageLayout::UNDEFINED;
     image_desc.usageBits = IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-    m_depth_attachment = m_graphicDevice->CreateImage(image_desc);
-    m_entityID_depth_attachment = m_graphicDevice->CreateImage(image_desc);
+    m_depth_desc = image_desc;  // created by the render graph
 
     // Create color image
     image_desc.format = RenderSystem::Get().GetRenderResourceManager().format_colorAttachment_main;
-    image_desc.initialLayout = ImageLayout::UNDEFINED;
     image_desc.usageBits = IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rhi::IMAGE_USAGE_SAMPLING_BIT;
     m_color_attachment = m_graphicDevice->CreateImage(image_desc);
 
     // Create entityID image
     image_desc.format = DataFormat::R32G32_UINT;
     image_desc.usageBits = IMAGE_USAGE_COLOR_ATTACHMENT_BIT | IMAGE_USAGE_CAN_COPY_FROM_BIT;
-    m_entityID_color_attachment = m_graphicDevice->CreateImage(image_desc);
+    m_entityID_desc = image_desc;
 
     // Create stage buffer
     BufferDesc buffer_desc;
@@ -575,6 +587,8 @@ void EditorApp::CreateGraphicResources()
     buffer_desc.usageBits = BUFFER_USAGE_TRANSFER_TO_BIT;
     buffer_desc.size = image_desc.width * image_desc.height * sizeof(uint64_t);
     m_stage_buffer = m_graphicDevice->CreateBuffer(buffer_desc);
+
+    m_renderGraph = CreateScope<RenderGraph>(m_graphicDevice.get());
 }
 
 }
\ No newline at end of file
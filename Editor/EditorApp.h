@@ -2,7 +2,10 @@
 #include <Quark/Core/Application.h>
 #include <Quark/Core/FileSystem.h>
 #include <Quark/Scene/Scene.h>
+#include <Quark/Scene/WorldPartition.h>
+#include <Quark/Scene/SceneJournal.h>
 #include <Quark/Render/RenderSystem.h>
+#include <Quark/Render/RenderGraph.h>
 #include <Quark/Events/KeyEvent.h>
 #include <Quark/Events/MouseEvent.h>
 
@@ -27,6 +30,7 @@ public:
     void NewScene();
     void OpenScene();
     void OpenScene(const std::filesystem::path& path);
+    void SaveScene();
     void SaveSceneAs();
 
     bool OpenProject(const std::filesystem::path& path);
@@ -35,10 +39,10 @@ public:
 private:
     void CreateGraphicResources();
 
-    Ref<rhi::Image> m_depth_attachment;
-    Ref<rhi::Image> m_color_attachment;
-    Ref<rhi::Image> m_entityID_color_attachment;
-    Ref<rhi::Image> m_entityID_depth_attachment;
+    Ref<rhi::Image> m_color_attachment;    // sampled by the viewport panel, imported into the render graph
+    rhi::ImageDesc m_depth_desc;
+    rhi::ImageDesc m_entityID_desc;
+    Scope<RenderGraph> m_renderGraph;
 
     Ref<rhi::Buffer> m_stage_buffer;
 
@@ -46,11 +50,14 @@ private:
     AssetID m_cubeMapId;
     
     Ref<Scene> m_scene;
+    Ref<WorldPartition> m_worldPartition;   // only when a .qkworld is open
+    Ref<SceneJournal> m_sceneJournal;       // only when the scene has a .qkscene file
     Entity* m_hoverdEntity;
     EditorCamera m_editorCamera;
 
     glm::vec2 m_viewportSize;
     glm::vec2 m_viewportBounds[2];
+    ImVec2 m_viewportMousePos;
 
     bool m_viewportFocused;
     bool m_viewportHovered;
@@ -325,6 +325,11 @@ void InspectorPanel::OnImGuiUpdate()
 				return;
 
             Ref<MeshAsset> mesh = meshCmpt->uniqueMesh ? meshCmpt->uniqueMesh : meshCmpt->sharedMesh;
+
+            bool occluder = component.IsOccluder();
+            if (ImGui::Checkbox("Occluder", &occluder))
+                component.SetOccluder(occluder);
+
 			for (uint32_t i = 0; i < mesh->subMeshes.size(); i++)
 			{
                 auto id = component.GetMaterialID(i);
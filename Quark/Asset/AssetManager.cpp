@@ -55,6 +55,7 @@ AssetManager::AssetManager()
 
 void AssetManager::Init()
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	m_loadedAssets.clear();
 	m_assetMetadata.clear();
 
@@ -64,6 +65,7 @@ void AssetManager::Init()
 
 Ref<Asset> AssetManager::GetAsset(AssetID id)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	Ref<Asset> asset = nullptr;
 
 	// builtin assets?
@@ -126,21 +128,25 @@ Ref<Asset> AssetManager::GetAsset(AssetID id)
 
 bool AssetManager::IsAssetLoaded(AssetID id)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	return m_loadedAssets.contains(id);
 }
 
 bool AssetManager::IsAssetIdValid(AssetID id)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	return GetAssetMetadata(id).IsValid();
 }
 
 void AssetManager::AddMemoryOnlyAsset(Ref<Asset> asset)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	m_memoryOnlyAssets[asset->GetAssetID()] = asset;
 }
 
 void AssetManager::RemoveAsset(AssetID id)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	if (m_loadedAssets.contains(id))
 		m_loadedAssets.erase(id);
 
@@ -168,6 +174,7 @@ AssetType AssetManager::GetAssetTypeFromExtension(const std::string& extension)
 
 AssetType AssetManager::GetAssetTypeFromID(AssetID id)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	if (IsAssetIdValid(id))
 		return GetAssetMetadata(id).type;
 	else
@@ -176,11 +183,13 @@ AssetType AssetManager::GetAssetTypeFromID(AssetID id)
 
 AssetID AssetManager::GetAssetIDFromFilePath(const std::filesystem::path& filepath)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	return GetAssetMetadata(filepath).id;
 }
 
 std::unordered_set<AssetID> AssetManager::GetAllAssetsWithType(AssetType type)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	std::unordered_set<AssetID> result;
 
 	for (auto& [id, metadata] : m_assetMetadata)
@@ -201,7 +210,7 @@ void AssetManager::SetMetadata(AssetID id, AssetMetadata metaData)
 
 AssetID AssetManager::ImportAsset(const std::filesystem::path &filepath)
 {
-
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	if (auto metadata = GetAssetMetadata(filepath); metadata.IsValid())
 	{
 		QK_CORE_LOGW_TAG("AssetManager" ,"Asset already Imported with id{0}", uint64_t(metadata.id));
@@ -226,6 +235,7 @@ AssetID AssetManager::ImportAsset(const std::filesystem::path &filepath)
 
 AssetMetadata AssetManager::GetAssetMetadata(AssetID id)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	if (m_assetMetadata.contains(id))
 		return m_assetMetadata[id];
 
@@ -234,6 +244,7 @@ AssetMetadata AssetManager::GetAssetMetadata(AssetID id)
 
 AssetMetadata AssetManager::GetAssetMetadata(const std::filesystem::path& filepath)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	for (auto& [id, metadata] : m_assetMetadata)
 	{
 		if (metadata.filePath == filepath)
@@ -245,6 +256,7 @@ AssetMetadata AssetManager::GetAssetMetadata(const std::filesystem::path& filepa
 
 void AssetManager::LoadAssetRegistry()
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	auto registryPath = Project::GetActive()->GetAssetRegistryPath();
 	if (!FileSystem::Exists(registryPath))
 		QK_CORE_VERIFY(0)
@@ -294,6 +306,7 @@ void AssetManager::LoadAssetRegistry()
 }
 void AssetManager::SaveAssetRegistry()
 {
+	std::lock_guard<std::recursive_mutex> lock(m_lock);
 	QK_CORE_LOGI_TAG("AssetManager", "Saving asset registry with{0} assets", m_assetMetadata.size());
 
 	YAML::Emitter out;
@@ -8,6 +8,7 @@
 #include "Quark/Asset/ImageAsset.h"
 #include "Quark/Project/Project.h"
 
+#include <mutex>
 #include <unordered_set>
 
 namespace quark {
@@ -52,6 +53,10 @@ private:
 	std::unordered_map<AssetID, Ref<Asset>> m_memoryOnlyAssets;
 	std::unordered_map<AssetID, Ref<Asset>> m_loadedAssets;
 	std::unordered_map<AssetID, AssetMetadata> m_assetMetadata;
+
+	// With frame pipelining the render thread resolves assets while the logic thread streams scenes in.
+	// Recursive, because GetAsset and friends go through GetAssetMetadata
+	std::recursive_mutex m_lock;
 };
 
 template<typename T>
@@ -48,6 +48,32 @@ bool MeshAsset::IsVertexDataArraysValid() const
         return false;
 }
 
+bool MeshAsset::IsLodChainValid() const
+{
+    if (GetLodCount() > MESH_LOD_MAX_NUM)
+        return false;
+
+    for (size_t i = 1; i < lodScreenSizes.size(); i++)
+    {
+        if (lodScreenSizes[i] >= lodScreenSizes[i - 1])
+            return false;
+    }
+
+    for (const auto& submesh : subMeshes)
+    {
+        if (submesh.lods.size() != lodScreenSizes.size())
+            return false;
+
+        for (const auto& lod : submesh.lods)
+        {
+            if (lod.count == 0 || lod.startIndex + lod.count > indices.size())
+                return false;
+        }
+    }
+
+    return true;
+}
+
 void MeshAsset::CalculateAabbs()
 {
     if (vertex_positions.empty())
@@ -6,6 +6,9 @@
 
 namespace quark {
 
+// Levels of detail of a mesh the renderer can pick from, including the full resolution one
+constexpr uint32_t MESH_LOD_MAX_NUM = 4;
+
 //TODO: move this to render module
 enum class MeshAttribute : unsigned
 {
@@ -34,15 +37,27 @@ enum MeshAttributeFlagBits
 class MeshAsset : public Asset {
 public:
     QUARK_ASSET_TYPE_DECL(MESH)
+    // A coarser version of a sub mesh, indexing the same vertices
+    struct SubMeshLod
+    {
+        uint32_t startIndex = 0;
+        uint32_t count = 0;
+    };
+
     struct SubMeshDescriptor 
     {
         uint32_t startVertex = 0;
         uint32_t startIndex = 0; // This is not relative to the startVertex
         uint32_t count = 0;
         math::Aabb aabb = {};
+        std::vector<SubMeshLod> lods; // level 1 and up, level 0 is the sub mesh itself
     };
     std::vector<SubMeshDescriptor> subMeshes;
 
+    // Screen size (projected bounding sphere diameter / viewport height) under which each coarser level is used,
+    // lodScreenSizes[i] belongs to level i + 1 and the values are decreasing. Every sub mesh has one lod per entry
+    std::vector<float> lodScreenSizes;
+
     std::vector<uint32_t> indices;
     std::vector<glm::vec3> vertex_positions;
     std::vector<glm::vec2> vertex_uvs;
@@ -56,6 +71,7 @@ public:
     MeshAsset() = default;
 
     uint32_t GetMeshAttributeMask() const;
+    uint32_t GetLodCount() const { return (uint32_t)lodScreenSizes.size() + 1; }
     size_t GetVertexCount() const { return vertex_positions.size(); }
     size_t GetPositionBufferStride() const;
     size_t GetAttributeBufferStride() const;
@@ -67,6 +83,7 @@ public:
     void CalculateNormals();
 
     bool IsVertexDataArraysValid() const;
+    bool IsLodChainValid() const;
 
 private:
     bool m_isDynamic = false;
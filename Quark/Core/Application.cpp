@@ -5,6 +5,7 @@
 #include "Quark/Events/ApplicationEvent.h"
 #include "Quark/Asset/AssetManager.h"
 #include "Quark/Render/RenderSystem.h"
+#include "Quark/RHI/Null/Device_Null.h"
 
 #ifdef USE_VULKAN_DRIVER
 #include "Quark/RHI/Vulkan/Device_Vulkan.h"
@@ -16,11 +17,37 @@
 
 #include <nfd.hpp>
 
+#if defined(QK_AVX2_BUILD) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace quark {
 
 Application* Application::s_instance = nullptr;
 
+#ifdef QK_AVX2_BUILD
+// This translation unit is built without AVX2, so the check itself runs anywhere
+static bool IsAvx2Supported()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) // the OS saves the ymm registers
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
 Application::Application(const ApplicationSpecification& specs) 
+    : m_enableFramePipelining(specs.enableFramePipelining)
+    , m_headless(specs.headless)
 {
     s_instance = this;
 
@@ -29,6 +56,11 @@ Application::Application(const ApplicationSpecification& specs)
 
     Logger::Init();
 
+#ifdef QK_AVX2_BUILD
+    // Fail with a message rather than an illegal instruction somewhere in the frame
+    QK_CORE_VERIFY(IsAvx2Supported(), "This build requires a CPU with AVX2, rebuild with QUARK_ENABLE_AVX2=OFF")
+#endif
+
     // Init Job System
     m_jobSystem = CreateRef<JobSystem>();
 
@@ -40,6 +72,7 @@ Application::Application(const ApplicationSpecification& specs)
     Input::Get()->Init();
 
     // Create Window
+    if (!specs.headless)
     {
         WindowSpecification windowSpec;
         windowSpec.width = specs.width;
@@ -56,10 +89,18 @@ Application::Application(const ApplicationSpecification& specs)
         QK_CORE_LOGI_TAG("Core", "Window created");
     }
 
+    if (specs.headless)
+    {
+        m_graphicDevice = CreateRef<rhi::Device_Null>(specs.width, specs.height);
+        m_graphicDevice->Init();
+    }
+    else
+    {
 #ifdef USE_VULKAN_DRIVER
-    m_graphicDevice = CreateRef<rhi::Device_Vulkan>();
-    m_graphicDevice->Init();
+        m_graphicDevice = CreateRef<rhi::Device_Vulkan>();
+        m_graphicDevice->Init();
 #endif
+    }
 
     // Init Render System
     JobSystem::Counter counter;
@@ -73,21 +114,27 @@ Application::Application(const ApplicationSpecification& specs)
     }, &counter);
 
     // Init Asset system
+    JobSystem::Counter dependent_counter;
     m_jobSystem->Execute([this, &counter]() 
     {
         m_jobSystem->Wait(&counter, 1);
         AssetManager::CreateSingleton(); 
-    });
+    }, &dependent_counter);
 
     // Init UI system
-    m_jobSystem->Execute([this, &specs, &counter]() 
+    if (!specs.headless)
     {
-        m_jobSystem->Wait(&counter, 1);
-        UI::CreateSingleton();
-        UI::Get()->Init(m_graphicDevice.get(), specs.uiSpecs);
-    });
+        m_jobSystem->Execute([this, &specs, &counter]() 
+        {
+            m_jobSystem->Wait(&counter, 1);
+            UI::CreateSingleton();
+            UI::Get()->Init(m_graphicDevice.get(), specs.uiSpecs);
+        }, &dependent_counter);
+    }
 
+    // the jobs reference specs and counter, and OnUpdate() may use any of the systems right away
     m_jobSystem->Wait(&counter, 1);
+    m_jobSystem->Wait(&dependent_counter, 1);
 
     // Register application callback functions
     EventManager::Get().Subscribe<WindowCloseEvent>([this](const WindowCloseEvent& event) { OnWindowClose(event);});
@@ -96,8 +143,11 @@ Application::Application(const ApplicationSpecification& specs)
 
 Application::~Application() {
 
-    UI::Get()->Finalize();
-    UI::FreeSingleton();
+    if (UI::Get())
+    {
+        UI::Get()->Finalize();
+        UI::FreeSingleton();
+    }
 
     AssetManager::FreeSingleton();
 
@@ -111,8 +161,11 @@ Application::~Application() {
     Input::FreeSingleton();
 
     // Destroy window
-    m_window->ShutDown();
-    m_window.reset();
+    if (m_window)
+    {
+        m_window->ShutDown();
+        m_window.reset();
+    }
 
     EventManager::FreeSingleton();
 
@@ -123,29 +176,116 @@ Application::~Application() {
 
 void Application::Run()
 {
-    while (m_status.isRunning) 
+    while (m_status.isRunning)
     {
-        float start_frame = m_timer.ElapsedSeconds();
+        // Between two frames nothing is published, so the render thread can come and go
+        if (m_enableFramePipelining != m_renderThread.joinable())
+        {
+            if (m_enableFramePipelining)
+                StartRenderThread();
+            else
+                StopRenderThread();
+        }
 
-        // Poll events
+        if (m_renderThread.joinable())
+            RunPipelinedFrame();
+        else
+            RunSerialFrame();
+    }
+
+    if (m_renderThread.joinable())
+        StopRenderThread();
+}
+
+void Application::RunSerialFrame()
+{
+    auto& swapContext = RenderSystem::Get().GetSwapContext();
+    float start_frame = m_timer.ElapsedSeconds();
+
+    // Poll events
+    if (!m_headless)
         Input::Get()->OnUpdate();
-        
-        if (!m_status.isMinimized)
-        {
-            // TODO: Multithreading
-            OnUpdate(m_status.lastFrameDuration);
+    
+    if (!m_status.isMinimized)
+    {
+        OnUpdate(m_status.lastFrameDuration);
 
-            OnImGuiUpdate();
+        OnImGuiUpdate();
 
-            OnRender(m_status.lastFrameDuration);
-        }
+        swapContext.SwapLogicRenderData();
+
+        OnRender(m_status.lastFrameDuration);
+    }
+
+    // Dispatch events
+    EventManager::Get().DispatchEvents();
+
+    m_status.lastFrameDuration = m_timer.ElapsedSeconds() - start_frame;
+    m_status.fps = 1.f / m_status.lastFrameDuration;
+}
+
+void Application::RunPipelinedFrame()
+{
+    auto& swapContext = RenderSystem::Get().GetSwapContext();
+    float start_frame = m_timer.ElapsedSeconds();
+
+    // Poll events
+    if (!m_headless)
+        Input::Get()->OnUpdate();
+
+    // Game logic of this frame overlaps with the render thread working on the previous frame
+    if (!m_status.isMinimized)
+        OnUpdate(m_status.lastFrameDuration);
+
+    // Everything below touches state shared with the render side: ImGui draw data, window/swapchain events.
+    swapContext.WaitForRenderIdle();
+
+    // Dispatch events
+    EventManager::Get().DispatchEvents();
+
+    if (!m_status.isMinimized && m_status.isRunning)
+    {
+        OnImGuiUpdate();
 
-        // Dispatch events
-        EventManager::Get().DispatchEvents();
+        m_renderFrameDuration = m_status.lastFrameDuration;
+        swapContext.SwapLogicRenderData();
+    }
+
+    m_status.lastFrameDuration = m_timer.ElapsedSeconds() - start_frame;
+    m_status.fps = 1.f / m_status.lastFrameDuration;
+}
+
+void Application::StartRenderThread()
+{
+    RenderSystem::Get().GetSwapContext().SetPipelined(true);
+    m_renderThread = std::thread([this]() { RenderThreadLoop(); });
+
+    QK_CORE_LOGI_TAG("Core", "Frame pipelining enabled");
+}
 
-        m_status.lastFrameDuration = m_timer.ElapsedSeconds() - start_frame;
-        m_status.fps = 1.f / m_status.lastFrameDuration;
+void Application::StopRenderThread()
+{
+    auto& swapContext = RenderSystem::Get().GetSwapContext();
+    swapContext.WaitForRenderIdle();
+    swapContext.RequestExit();
+    m_renderThread.join();
+    swapContext.SetPipelined(false);
+
+    QK_CORE_LOGI_TAG("Core", "Frame pipelining disabled");
+}
+
+void Application::RenderThreadLoop()
+{
+    QK_CORE_LOGT_TAG("Core", "Render thread start working");
+
+    auto& swapContext = RenderSystem::Get().GetSwapContext();
+    while (swapContext.BeginRenderFrame())
+    {
+        OnRender(m_renderFrameDuration);
+        swapContext.EndRenderFrame();
     }
+
+    QK_CORE_LOGT_TAG("Core", "Render thread finished execution");
 }
 
 void Application::OnWindowClose(const WindowCloseEvent& e)
@@ -18,6 +18,13 @@ struct ApplicationSpecification
     std::string workingDirectory;
     bool isFullScreen = false;
     UiSpecification uiSpecs = {};
+
+    // Run OnRender of frame N on a dedicated render thread while OnUpdate of frame N+1 runs on the main thread.
+    // The two stages only communicate through RenderSwapContext. Can be switched later with Application::SetFramePipelining()
+    bool enableFramePipelining = false;
+
+    // No window, input polling, file dialogs or UI, frames are rendered on the Null device. For tests and benchmarks
+    bool headless = false;
 };  
 
 class Application {
@@ -33,9 +40,10 @@ public:
     virtual void OnUpdate(TimeStep ts) = 0;
 
     // Render per frame : Sync draw data with scene & All rendering cmd list recording here
+    // Called on the render thread when frame pipelining is enabled, so only touch render side data in here
     virtual void OnRender(TimeStep ts) = 0;
 
-    // Prepare UI data
+    // Prepare UI data. Always called on the main thread while the render side is idle
     virtual void OnImGuiUpdate() {};
 
     // Callback functions for events
@@ -49,6 +57,10 @@ public:
 
     Window* GetWindow() { return m_window.get(); }
 
+    // Takes effect between two frames, the render thread is started or stopped while the render side is idle
+    void SetFramePipelining(bool enable) { m_enableFramePipelining = enable; }
+    bool IsFramePipelining() const { return m_enableFramePipelining; }
+
 protected:
     struct ApplicationStatus
     {
@@ -65,6 +77,17 @@ protected:
     Scope<Window> m_window;
 
 private:
+    void RunSerialFrame();
+    void RunPipelinedFrame();
+    void StartRenderThread();
+    void StopRenderThread();
+    void RenderThreadLoop();
+
+    bool m_enableFramePipelining;
+    bool m_headless;
+    std::thread m_renderThread;
+    float m_renderFrameDuration = 0; // frame duration handed over to the render thread
+
     static Application* s_instance;
 };
 
@@ -53,6 +53,21 @@ bool FileSystem::ReadFileBytes(const std::string& fileName, std::vector<byte>& d
     return false;
 }
 
+bool FileSystem::WriteFileBytes(const std::string& fileName, const std::vector<byte>& data)
+{
+    std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+
+    if (file.is_open())
+    {
+        file.write((const char*)data.data(), data.size());
+        file.close();
+        return !file.fail();
+    }
+
+    QK_CORE_LOGW_TAG("Core", "FileSystem::WriteFile: Failed to open file{}", fileName);
+    return false;
+}
+
 bool FileSystem::ReadFileText(const std::string& fileName, std::string& outString)
 {
     std::vector<byte> data;
@@ -83,9 +83,10 @@ void JobSystem::JobQueue::SignalWorkDone()
 	m_condition.notify_all();
 };
 
-JobSystem::JobSystem()
+JobSystem::JobSystem(uint32_t numWorkerThreads)
 {
-	m_numWorkerThreads = std::thread::hardware_concurrency() - 1; // Leave one thread for the main thread
+	// Leave one thread for the main thread, but always have a worker so jobs can't starve on single core machines
+	m_numWorkerThreads = numWorkerThreads > 0 ? numWorkerThreads : std::max(std::thread::hardware_concurrency(), 2u) - 1;
 
 	// Initialize the job queues
 	m_jobQueues = std::vector<JobQueue>(m_numWorkerThreads);
@@ -138,9 +139,21 @@ void JobSystem::Execute(const JobFunction& jobFunc, Counter* counter)
 	m_jobQueues[queueIndex % m_numWorkerThreads].BlockingPush(job);
 }
 
+void JobSystem::Dispatch(uint32_t jobCount, uint32_t groupSize, const DispatchFunction& dispatchFunc, Counter* counter)
+{
+	if (jobCount == 0 || groupSize == 0)
+		return;
+
+	for (uint32_t begin = 0; begin < jobCount; begin += groupSize)
+	{
+		uint32_t end = std::min(begin + groupSize, jobCount);
+		Execute([dispatchFunc, begin, end]() { dispatchFunc(begin, end); }, counter);
+	}
+}
+
 bool JobSystem::IsBusy(const Counter& counter) const
 {
-	return counter.count > 0;
+	return counter.count.load(std::memory_order_acquire) > 0;
 }
 
 void JobSystem::Wait(const Counter* counters, uint32_t numCounters)
@@ -182,8 +195,8 @@ void JobSystem::RunThread(uint32_t threadId)
 
 		if (job.counter)
 		{
-			// Decrement the counter
-			job.counter->count.fetch_sub(1, std::memory_order_relaxed);
+			// Decrement the counter, release the job's writes to whoever waits on it
+			job.counter->count.fetch_sub(1, std::memory_order_release);
 		}
 	}
 
@@ -13,21 +13,28 @@ class JobSystem
 {
 public:
 	using JobFunction = std::function<void()>;
+	using DispatchFunction = std::function<void(uint32_t begin, uint32_t end)>;
 
 	struct Counter
 	{
 		std::atomic<uint32_t> count;
 	};
 
-	JobSystem();
+	// 0 worker threads picks one less than the hardware threads
+	explicit JobSystem(uint32_t numWorkerThreads = 0);
 	~JobSystem();
 
 	void Execute(const JobFunction& jobFunc, Counter* counter = nullptr);
 
+	// Splits [0, jobCount) into ranges of groupSize and runs every range as one job
+	void Dispatch(uint32_t jobCount, uint32_t groupSize, const DispatchFunction& dispatchFunc, Counter* counter = nullptr);
+
 	bool IsBusy(const Counter& conter) const;
 
 	void Wait(const Counter* counter, uint32_t numCounters);
 
+	uint32_t GetNumWorkerThreads() const { return m_numWorkerThreads; }
+
 private:
 	void RunThread(uint32_t threadId);
 
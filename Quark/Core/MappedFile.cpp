@@ -0,0 +1,133 @@
+#include "Quark/qkpch.h"
+#include "Quark/Core/MappedFile.h"
+
+#ifdef QK_PLATFORM_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace quark {
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef QK_PLATFORM_WINDOWS
+
+bool MappedFile::Open(const std::filesystem::path& filepath)
+{
+	Close();
+
+	HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		QK_CORE_LOGW_TAG("Core", "MappedFile: Failed to open file {}", filepath.string());
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		QK_CORE_LOGW_TAG("Core", "MappedFile: File {} is empty", filepath.string());
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		QK_CORE_LOGW_TAG("Core", "MappedFile: Failed to map file {}", filepath.string());
+		CloseHandle(file);
+		return false;
+	}
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		QK_CORE_LOGW_TAG("Core", "MappedFile: Failed to map file {}", filepath.string());
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_data = static_cast<const byte*>(data);
+	m_size = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mappingHandle)
+		CloseHandle(m_mappingHandle);
+	if (m_fileHandle)
+		CloseHandle(m_fileHandle);
+
+	m_data = nullptr;
+	m_size = 0;
+	m_mappingHandle = nullptr;
+	m_fileHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::filesystem::path& filepath)
+{
+	Close();
+
+	int fd = open(filepath.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		QK_CORE_LOGW_TAG("Core", "MappedFile: Failed to open file {}", filepath.string());
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		QK_CORE_LOGW_TAG("Core", "MappedFile: File {} is empty", filepath.string());
+		close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED)
+	{
+		QK_CORE_LOGW_TAG("Core", "MappedFile: Failed to map file {}", filepath.string());
+		close(fd);
+		return false;
+	}
+
+	// Binary assets are mostly read front to back
+	madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	m_fileDescriptor = fd;
+	m_data = static_cast<const byte*>(data);
+	m_size = (size_t)st.st_size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data)
+		munmap(const_cast<byte*>(m_data), m_size);
+	if (m_fileDescriptor >= 0)
+		close(m_fileDescriptor);
+
+	m_data = nullptr;
+	m_size = 0;
+	m_fileDescriptor = -1;
+}
+
+#endif
+}
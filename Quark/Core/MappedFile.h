@@ -0,0 +1,36 @@
+#pragma once
+#include <filesystem>
+
+#include "Quark/Core/Base.h"
+
+namespace quark {
+
+// Read only view of a whole file, mapped into memory instead of being read into a buffer.
+// Pages are loaded lazily by the OS, so large binary assets can be accessed in place.
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::filesystem::path& filepath);
+	void Close();
+
+	bool IsValid() const { return m_data != nullptr; }
+	const byte* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	const byte* m_data = nullptr;
+	size_t m_size = 0;
+
+#ifdef QK_PLATFORM_WINDOWS
+	void* m_fileHandle = nullptr;
+	void* m_mappingHandle = nullptr;
+#else
+	int m_fileDescriptor = -1;
+#endif
+};
+}
@@ -16,11 +16,23 @@ float Aabb::GetRadius() const
     return 0.5f * glm::length(max_ - min_);
 }
 
+float Aabb::GetSurfaceArea() const
+{
+    glm::vec3 d = max_ - min_;
+    return 2.f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
 bool Aabb::IsValid() const 
 {
     return (max_[0] >= min_[0] && max_[1] >= min_[1] && max_[2] >= min_[2]);
 }
 
+bool Aabb::Contains(const Aabb& bb) const
+{
+    return min_.x <= bb.min_.x && min_.y <= bb.min_.y && min_.z <= bb.min_.z &&
+        max_.x >= bb.max_.x && max_.y >= bb.max_.y && max_.z >= bb.max_.z;
+}
+
 Aabb Aabb::Transform(const glm::mat4 &mat) const 
 {
 	glm::vec3 min = glm::vec3(FLT_MAX);
@@ -14,14 +14,16 @@ public:
     // Add two bounding boxes.
     Aabb& operator+=(const Aabb& bb);
 
-    glm::vec3 Min() { return min_; }
-    glm::vec3 Max() { return max_; }
+    glm::vec3 Min() const { return min_; }
+    glm::vec3 Max() const { return max_; }
     glm::vec3 GetCenter() const { return 0.5f * (min_ + max_); }
     glm::vec3 GetExtents() const { return 0.5f * (max_ - min_); }
     glm::vec3 GetCorner(uint32_t i) const;
 
     float GetRadius() const;
+    float GetSurfaceArea() const;
     bool IsValid() const;
+    bool Contains(const Aabb& bb) const;
     Aabb Transform(const glm::mat4& mat) const;
 
 private:
@@ -0,0 +1,424 @@
+#include "Quark/qkpch.h"
+#include "Quark/Core/Math/AabbTree.h"
+
+namespace quark::math {
+
+static Aabb Combine(const Aabb& a, const Aabb& b)
+{
+    Aabb result = a;
+    result += b;
+    return result;
+}
+
+AabbTree::AabbTree(float margin)
+    : m_margin(margin)
+{
+}
+
+void AabbTree::Clear()
+{
+    m_nodes.clear();
+    m_root = NULL_NODE;
+    m_freeList = NULL_NODE;
+    m_proxyCount = 0;
+}
+
+Aabb AabbTree::GetFatAabb(const Aabb& aabb) const
+{
+    // relative to the size, so the margin fits any scale of scene
+    glm::vec3 margin = glm::max(aabb.GetExtents() * m_margin, glm::vec3(0.01f));
+    return Aabb(aabb.Min() - margin, aabb.Max() + margin);
+}
+
+uint32_t AabbTree::AllocateNode()
+{
+    uint32_t node;
+    if (m_freeList != NULL_NODE)
+    {
+        node = m_freeList;
+        m_freeList = m_nodes[node].parent;
+    }
+    else
+    {
+        node = (uint32_t)m_nodes.size();
+        QK_CORE_ASSERT(node < (1u << 31))   // the top bit is used by Query()
+        m_nodes.emplace_back();
+    }
+
+    m_nodes[node] = Node();
+    m_nodes[node].height = 0;
+    return node;
+}
+
+void AabbTree::FreeNode(uint32_t node)
+{
+    m_nodes[node].parent = m_freeList;
+    m_nodes[node].height = -1;
+    m_freeList = node;
+}
+
+uint32_t AabbTree::CreateProxy(const Aabb& aabb, uint32_t user_data)
+{
+    uint32_t proxy = AllocateNode();
+    m_nodes[proxy].aabb = GetFatAabb(aabb);
+    m_nodes[proxy].user_data = user_data;
+
+    InsertLeaf(proxy);
+    m_proxyCount++;
+    return proxy;
+}
+
+void AabbTree::DestroyProxy(uint32_t proxy)
+{
+    QK_CORE_ASSERT(proxy < m_nodes.size() && m_nodes[proxy].IsLeaf())
+
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    m_proxyCount--;
+}
+
+bool AabbTree::MoveProxy(uint32_t proxy, const Aabb& aabb)
+{
+    QK_CORE_ASSERT(proxy < m_nodes.size() && m_nodes[proxy].IsLeaf())
+
+    // a fat box much larger than needed culls badly, so shrinking objects are reinserted too
+    const Aabb& fatAabb = m_nodes[proxy].aabb;
+    Aabb newFatAabb = GetFatAabb(aabb);
+    if (fatAabb.Contains(aabb) && fatAabb.GetSurfaceArea() <= 4.f * newFatAabb.GetSurfaceArea())
+        return false;
+
+    // stretch the box along the movement, so a proxy moving at a steady speed stays in it for a few frames
+    glm::vec3 displacement = 2.f * (aabb.GetCenter() - fatAabb.GetCenter());
+    newFatAabb = Aabb(newFatAabb.Min() + glm::min(displacement, glm::vec3(0.f)), newFatAabb.Max() + glm::max(displacement, glm::vec3(0.f)));
+
+    RemoveLeaf(proxy);
+    m_nodes[proxy].aabb = newFatAabb;
+    InsertLeaf(proxy);
+    return true;
+}
+
+void AabbTree::InsertLeaf(uint32_t leaf)
+{
+    if (m_root == NULL_NODE)
+    {
+        m_root = leaf;
+        m_nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // find the sibling that grows the total surface area the least
+    const Aabb leafAabb = m_nodes[leaf].aabb;
+    uint32_t index = m_root;
+    while (!m_nodes[index].IsLeaf())
+    {
+        const Node& node = m_nodes[index];
+        float area = node.aabb.GetSurfaceArea();
+        float combinedArea = Combine(node.aabb, leafAabb).GetSurfaceArea();
+
+        // cost of a new parent for this node and the leaf, and the growth every level below pays anyway
+        float cost = 2.f * combinedArea;
+        float inheritanceCost = 2.f * (combinedArea - area);
+
+        auto descend_cost = [&](uint32_t child)
+        {
+            const Node& childNode = m_nodes[child];
+            float childCombinedArea = Combine(childNode.aabb, leafAabb).GetSurfaceArea();
+            if (childNode.IsLeaf())
+                return childCombinedArea + inheritanceCost;
+            else
+                return childCombinedArea - childNode.aabb.GetSurfaceArea() + inheritanceCost;
+        };
+
+        float cost1 = descend_cost(node.child1);
+        float cost2 = descend_cost(node.child2);
+        if (cost < cost1 && cost < cost2)
+            break;
+
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const uint32_t sibling = index;
+    const uint32_t oldParent = m_nodes[sibling].parent;
+    const uint32_t newParent = AllocateNode();
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].aabb = Combine(leafAabb, m_nodes[sibling].aabb);
+    m_nodes[newParent].height = m_nodes[sibling].height + 1;
+    m_nodes[newParent].child1 = sibling;
+    m_nodes[newParent].child2 = leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    if (oldParent != NULL_NODE)
+    {
+        if (m_nodes[oldParent].child1 == sibling)
+            m_nodes[oldParent].child1 = newParent;
+        else
+            m_nodes[oldParent].child2 = newParent;
+    }
+    else
+    {
+        m_root = newParent;
+    }
+
+    RefitAncestors(m_nodes[leaf].parent);
+}
+
+void AabbTree::RemoveLeaf(uint32_t leaf)
+{
+    if (leaf == m_root)
+    {
+        m_root = NULL_NODE;
+        return;
+    }
+
+    const uint32_t parent = m_nodes[leaf].parent;
+    const uint32_t grandParent = m_nodes[parent].parent;
+    const uint32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    // the sibling takes the place of the parent
+    if (grandParent != NULL_NODE)
+    {
+        if (m_nodes[grandParent].child1 == parent)
+            m_nodes[grandParent].child1 = sibling;
+        else
+            m_nodes[grandParent].child2 = sibling;
+
+        m_nodes[sibling].parent = grandParent;
+        FreeNode(parent);
+        RefitAncestors(grandParent);
+    }
+    else
+    {
+        m_root = sibling;
+        m_nodes[sibling].parent = NULL_NODE;
+        FreeNode(parent);
+    }
+}
+
+void AabbTree::RefitAncestors(uint32_t node)
+{
+    while (node != NULL_NODE)
+    {
+        node = Balance(node);
+
+        Node& n = m_nodes[node];
+        n.height = 1 + std::max(m_nodes[n.child1].height, m_nodes[n.child2].height);
+        n.aabb = Combine(m_nodes[n.child1].aabb, m_nodes[n.child2].aabb);
+
+        node = n.parent;
+    }
+}
+
+// Rotates the taller child of a up if the children's heights differ by more than one, returns the new root of the subtree
+uint32_t AabbTree::Balance(uint32_t iA)
+{
+    Node& A = m_nodes[iA];
+    if (A.IsLeaf() || A.height < 2)
+        return iA;
+
+    const uint32_t iB = A.child1;
+    const uint32_t iC = A.child2;
+    Node& B = m_nodes[iB];
+    Node& C = m_nodes[iC];
+
+    const int32_t balance = C.height - B.height;
+
+    auto rotate_up = [&](uint32_t iUp, uint32_t iOther)
+    {
+        // iUp becomes the parent of a, a keeps iOther and the smaller child of iUp
+        Node& Up = m_nodes[iUp];
+        const uint32_t iF = Up.child1;
+        const uint32_t iG = Up.child2;
+        Node& F = m_nodes[iF];
+        Node& G = m_nodes[iG];
+
+        Up.child1 = iA;
+        Up.parent = A.parent;
+        A.parent = iUp;
+
+        if (Up.parent != NULL_NODE)
+        {
+            if (m_nodes[Up.parent].child1 == iA)
+                m_nodes[Up.parent].child1 = iUp;
+            else
+                m_nodes[Up.parent].child2 = iUp;
+        }
+        else
+        {
+            m_root = iUp;
+        }
+
+        const Node& Other = m_nodes[iOther];
+        const bool upIsChild2 = A.child2 == iUp;
+        if (F.height > G.height)
+        {
+            Up.child2 = iF;
+            if (upIsChild2) A.child2 = iG; else A.child1 = iG;
+            G.parent = iA;
+            A.aabb = Combine(Other.aabb, G.aabb);
+            Up.aabb = Combine(A.aabb, F.aabb);
+            A.height = 1 + std::max(Other.height, G.height);
+            Up.height = 1 + std::max(A.height, F.height);
+        }
+        else
+        {
+            Up.child2 = iG;
+            if (upIsChild2) A.child2 = iF; else A.child1 = iF;
+            F.parent = iA;
+            A.aabb = Combine(Other.aabb, F.aabb);
+            Up.aabb = Combine(A.aabb, G.aabb);
+            A.height = 1 + std::max(Other.height, F.height);
+            Up.height = 1 + std::max(A.height, G.height);
+        }
+    };
+
+    if (balance > 1)
+    {
+        rotate_up(iC, iB);
+        return iC;
+    }
+
+    if (balance < -1)
+    {
+        rotate_up(iB, iC);
+        return iB;
+    }
+
+    return iA;
+}
+
+void AabbTree::SplitQuery(const Frustum& frustum, uint32_t count, std::vector<QueryRoot>& out_roots) const
+{
+    out_roots.clear();
+    if (m_root == NULL_NODE)
+        return;
+
+    // one level at a time, so the subtrees end up about the same size
+    std::vector<QueryRoot> next;
+    out_roots.push_back({ m_root, false });
+    while (out_roots.size() < count)
+    {
+        bool expanded = false;
+        next.clear();
+        for (const QueryRoot& root : out_roots)
+        {
+            const Node& node = m_nodes[root.node];
+            if (node.IsLeaf())
+            {
+                next.push_back(root);
+                continue;
+            }
+
+            bool inside = root.fully_inside;
+            if (!inside)
+            {
+                Frustum::Intersection result = frustum.CheckAabb(node.aabb);
+                if (result == Frustum::Intersection::OUTSIDE)
+                    continue;
+                inside = result == Frustum::Intersection::INSIDE;
+            }
+
+            next.push_back({ node.child1, inside });
+            next.push_back({ node.child2, inside });
+            expanded = true;
+        }
+
+        out_roots.swap(next);
+        if (!expanded)
+            break;
+    }
+}
+
+void AabbTree::ClassifyNode(const Node& node, const Frustum* frusta, uint32_t& partial_mask, uint32_t& inside_mask) const
+{
+    if (partial_mask == 0)
+        return;
+
+    // the box is the same for every frustum
+    const glm::vec3 center = node.aabb.GetCenter();
+    const glm::vec3 extents = node.aabb.GetExtents();
+
+    uint32_t partial = partial_mask;
+    util::for_each_bit(partial, [&](uint32_t i)
+    {
+        switch (frusta[i].CheckAabb(center, extents))
+        {
+        case Frustum::Intersection::OUTSIDE:
+            partial_mask &= ~(1u << i);
+            break;
+        case Frustum::Intersection::INSIDE:
+            partial_mask &= ~(1u << i);
+            inside_mask |= 1u << i;
+            break;
+        default:
+            break;
+        }
+    });
+}
+
+void AabbTree::SplitMultiQuery(const Frustum* frusta, uint32_t frustum_count, uint32_t count, std::vector<MultiQueryRoot>& out_roots) const
+{
+    QK_CORE_ASSERT(frustum_count <= MAX_MULTI_QUERY_FRUSTA)
+
+    out_roots.clear();
+    if (m_root == NULL_NODE)
+        return;
+
+    // one level at a time, so the subtrees end up about the same size
+    std::vector<MultiQueryRoot> next;
+    out_roots.push_back({ m_root, frustum_count == 32 ? ~0u : (1u << frustum_count) - 1, 0 });
+    while (out_roots.size() < count)
+    {
+        bool expanded = false;
+        next.clear();
+        for (MultiQueryRoot root : out_roots)
+        {
+            const Node& node = m_nodes[root.node];
+            if (node.IsLeaf())
+            {
+                next.push_back(root);
+                continue;
+            }
+
+            ClassifyNode(node, frusta, root.partial_mask, root.inside_mask);
+            if ((root.partial_mask | root.inside_mask) == 0)
+                continue;
+
+            next.push_back({ node.child1, root.partial_mask, root.inside_mask });
+            next.push_back({ node.child2, root.partial_mask, root.inside_mask });
+            expanded = true;
+        }
+
+        out_roots.swap(next);
+        if (!expanded)
+            break;
+    }
+}
+
+bool AabbTree::Validate() const
+{
+    if (m_root == NULL_NODE)
+        return m_proxyCount == 0;
+
+    return m_nodes[m_root].parent == NULL_NODE && ValidateNode(m_root);
+}
+
+bool AabbTree::ValidateNode(uint32_t node) const
+{
+    const Node& n = m_nodes[node];
+    if (n.IsLeaf())
+        return n.height == 0 && n.child2 == NULL_NODE;
+
+    const Node& c1 = m_nodes[n.child1];
+    const Node& c2 = m_nodes[n.child2];
+    if (c1.parent != node || c2.parent != node)
+        return false;
+    if (n.height != 1 + std::max(c1.height, c2.height))
+        return false;
+    if (!n.aabb.Contains(c1.aabb) || !n.aabb.Contains(c2.aabb))
+        return false;
+
+    return ValidateNode(n.child1) && ValidateNode(n.child2);
+}
+
+}
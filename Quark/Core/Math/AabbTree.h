@@ -0,0 +1,197 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Quark/Core/Math/Aabb.h"
+#include "Quark/Core/Math/Frustum.h"
+#include "Quark/Core/Util/BitOperations.h"
+
+namespace quark::math {
+
+// Dynamic bounding volume hierarchy over moving boxes.
+// Leaves store a fat box, a margin around the real one, so small moves don't touch the tree.
+// A proxy that leaves its fat box is removed and reinserted at the cheapest place by surface area,
+// and the tree is kept balanced with rotations on the way back up.
+class AabbTree {
+public:
+    static constexpr uint32_t NULL_NODE = ~0u;
+
+    // A subtree left to query, see SplitQuery()
+    struct QueryRoot
+    {
+        uint32_t node = NULL_NODE;
+        bool fully_inside = false;
+    };
+
+    // A subtree left to query against several frusta, one bit per frustum, see SplitMultiQuery()
+    struct MultiQueryRoot
+    {
+        uint32_t node = NULL_NODE;
+        uint32_t partial_mask = 0;  // frusta the subtree is partly inside, still tested
+        uint32_t inside_mask = 0;   // frusta the subtree is fully inside
+    };
+
+    static constexpr uint32_t MAX_MULTI_QUERY_FRUSTA = 32;
+
+    explicit AabbTree(float margin = 0.1f);
+
+    uint32_t CreateProxy(const Aabb& aabb, uint32_t user_data);
+    void DestroyProxy(uint32_t proxy);
+
+    // Returns true if the proxy had to be reinserted
+    bool MoveProxy(uint32_t proxy, const Aabb& aabb);
+
+    uint32_t GetUserData(uint32_t proxy) const { return m_nodes[proxy].user_data; }
+    void SetUserData(uint32_t proxy, uint32_t user_data) { m_nodes[proxy].user_data = user_data; }
+    const Aabb& GetFatAabb(uint32_t proxy) const { return m_nodes[proxy].aabb; }
+
+    // Calls callback(user_data, fully_inside) for every leaf whose fat box is not outside the frustum.
+    // Leaves of subtrees fully inside aren't tested again and come with fully_inside = true
+    template<typename Callback>
+    void Query(const Frustum& frustum, Callback&& callback) const;
+
+    // Walks down the top of the tree until there are at least count subtrees not outside the frustum (or only leaves),
+    // so they can be queried on different threads. Together they give the same leaves as Query()
+    void SplitQuery(const Frustum& frustum, uint32_t count, std::vector<QueryRoot>& out_roots) const;
+
+    template<typename Callback>
+    void Query(const Frustum& frustum, const QueryRoot& root, Callback&& callback) const;
+
+    // Queries up to 32 frusta in one walk of the tree. Calls callback(user_data, partial_mask, inside_mask) for every leaf
+    // not outside all of them, with a bit per frustum. A node is only tested against the frusta that its parent was partly
+    // inside, so frusta that cover the same region share the walk and a subtree fully inside one of them drops its tests
+    template<typename Callback>
+    void MultiQuery(const Frustum* frusta, uint32_t frustum_count, Callback&& callback) const;
+
+    // Same as SplitQuery() for MultiQuery()
+    void SplitMultiQuery(const Frustum* frusta, uint32_t frustum_count, uint32_t count, std::vector<MultiQueryRoot>& out_roots) const;
+
+    template<typename Callback>
+    void MultiQuery(const Frustum* frusta, const MultiQueryRoot& root, Callback&& callback) const;
+
+    void Clear();
+    uint32_t GetProxyCount() const { return m_proxyCount; }
+    uint32_t GetHeight() const { return m_root == NULL_NODE ? 0 : (uint32_t)m_nodes[m_root].height; }
+    bool Validate() const;
+
+private:
+    struct Node
+    {
+        Aabb aabb;
+        uint32_t parent = NULL_NODE;    // next free node while free
+        uint32_t child1 = NULL_NODE;
+        uint32_t child2 = NULL_NODE;
+        int32_t height = -1;            // 0 for leaves, -1 while free
+        uint32_t user_data = 0;
+
+        bool IsLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    uint32_t AllocateNode();
+    void FreeNode(uint32_t node);
+    void InsertLeaf(uint32_t leaf);
+    void RemoveLeaf(uint32_t leaf);
+    void RefitAncestors(uint32_t node);
+    uint32_t Balance(uint32_t node);
+    Aabb GetFatAabb(const Aabb& aabb) const;
+    bool ValidateNode(uint32_t node) const;
+
+    // tests the node against the partial frusta, moving the ones it is fully inside to inside_mask and dropping the ones it is outside
+    void ClassifyNode(const Node& node, const Frustum* frusta, uint32_t& partial_mask, uint32_t& inside_mask) const;
+
+    std::vector<Node> m_nodes;
+    uint32_t m_root = NULL_NODE;
+    uint32_t m_freeList = NULL_NODE;
+    uint32_t m_proxyCount = 0;
+    float m_margin;
+};
+
+template<typename Callback>
+void AabbTree::Query(const Frustum& frustum, Callback&& callback) const
+{
+    Query(frustum, QueryRoot{ m_root, false }, callback);
+}
+
+template<typename Callback>
+void AabbTree::Query(const Frustum& frustum, const QueryRoot& root, Callback&& callback) const
+{
+    if (root.node == NULL_NODE)
+        return;
+
+    // the top bit marks nodes under a subtree that is fully inside
+    constexpr uint32_t inside_bit = 1u << 31;
+
+    std::vector<uint32_t> stack;
+    stack.reserve(64);
+    stack.push_back(root.node | (root.fully_inside ? inside_bit : 0));
+
+    while (!stack.empty())
+    {
+        uint32_t entry = stack.back();
+        stack.pop_back();
+
+        const bool inside = entry & inside_bit;
+        const Node& node = m_nodes[entry & ~inside_bit];
+
+        Frustum::Intersection result = Frustum::Intersection::INSIDE;
+        if (!inside)
+        {
+            result = frustum.CheckAabb(node.aabb);
+            if (result == Frustum::Intersection::OUTSIDE)
+                continue;
+        }
+
+        if (node.IsLeaf())
+        {
+            callback(node.user_data, result == Frustum::Intersection::INSIDE);
+        }
+        else
+        {
+            uint32_t flag = result == Frustum::Intersection::INSIDE ? inside_bit : 0;
+            stack.push_back(node.child1 | flag);
+            stack.push_back(node.child2 | flag);
+        }
+    }
+}
+
+template<typename Callback>
+void AabbTree::MultiQuery(const Frustum* frusta, uint32_t frustum_count, Callback&& callback) const
+{
+    QK_CORE_ASSERT(frustum_count <= MAX_MULTI_QUERY_FRUSTA)
+    const uint32_t all_mask = frustum_count == 32 ? ~0u : (1u << frustum_count) - 1;
+    MultiQuery(frusta, MultiQueryRoot{ m_root, all_mask, 0 }, callback);
+}
+
+template<typename Callback>
+void AabbTree::MultiQuery(const Frustum* frusta, const MultiQueryRoot& root, Callback&& callback) const
+{
+    if (root.node == NULL_NODE)
+        return;
+
+    std::vector<MultiQueryRoot> stack;
+    stack.reserve(64);
+    stack.push_back(root);
+
+    while (!stack.empty())
+    {
+        MultiQueryRoot entry = stack.back();
+        stack.pop_back();
+
+        const Node& node = m_nodes[entry.node];
+        ClassifyNode(node, frusta, entry.partial_mask, entry.inside_mask);
+        if ((entry.partial_mask | entry.inside_mask) == 0)
+            continue;
+
+        if (node.IsLeaf())
+        {
+            callback(node.user_data, entry.partial_mask, entry.inside_mask);
+        }
+        else
+        {
+            stack.push_back({ node.child1, entry.partial_mask, entry.inside_mask });
+            stack.push_back({ node.child2, entry.partial_mask, entry.inside_mask });
+        }
+    }
+}
+
+}
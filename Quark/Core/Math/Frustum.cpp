@@ -3,7 +3,7 @@
 
 namespace quark::math {
 
-bool Frustum::CheckSphere(const Aabb &aabb)
+bool Frustum::CheckSphere(const Aabb &aabb) const
 {
 	glm::vec4 center(aabb.GetCenter(), 1.0f);
 	float radius = aabb.GetRadius();
@@ -16,6 +16,28 @@ bool Frustum::CheckSphere(const Aabb &aabb)
 	return true;
 }
 
+Frustum::Intersection Frustum::CheckAabb(const Aabb& aabb) const
+{
+	return CheckAabb(aabb.GetCenter(), aabb.GetExtents());
+}
+
+Frustum::Intersection Frustum::CheckAabb(const glm::vec3& center, const glm::vec3& extents) const
+{
+	Intersection result = Intersection::INSIDE;
+	for (const auto& plane : planes)
+	{
+		// distance of the center and projected extents of the box along the plane normal
+		float d = glm::dot(glm::vec3(plane), center) + plane.w;
+		float r = glm::dot(glm::abs(glm::vec3(plane)), extents);
+		if (d < -r)
+			return Intersection::OUTSIDE;
+		if (d < r)
+			result = Intersection::INTERSECT;
+	}
+
+	return result;
+}
+
 Frustum::Frustum(const glm::mat4& inv_view_proj_mat)
 {
 	Build(inv_view_proj_mat);
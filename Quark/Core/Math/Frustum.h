@@ -8,12 +8,18 @@ namespace quark::math {
 class Frustum {
 public:
 	enum side { LEFT = 0, RIGHT = 1, NEAR = 2, FAR = 3, TOP = 4, BOTTOM = 5 };
+	enum class Intersection { OUTSIDE, INTERSECT, INSIDE };
 	
     Frustum() = default;
     Frustum(const glm::mat4& inv_view_proj_mat);
 
     void Build(const glm::mat4& inv_view_proj_mat);
-    bool CheckSphere(const Aabb& aabb);
+    bool CheckSphere(const Aabb& aabb) const;
+    Intersection CheckAabb(const Aabb& aabb) const;   // exact against every plane, tighter than the sphere
+    Intersection CheckAabb(const glm::vec3& center, const glm::vec3& extents) const;
+
+    // normals point inside, a point p is inside a plane if dot(plane, vec4(p, 1)) >= 0
+    const std::array<glm::vec4, 6>& GetPlanes() const { return planes; }
 private:
     glm::mat4 inv_view_proj_matrix_;
     std::array<glm::vec4, 6> planes;
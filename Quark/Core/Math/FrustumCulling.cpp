@@ -0,0 +1,249 @@
+#include "Quark/qkpch.h"
+#include "Quark/Core/Math/FrustumCulling.h"
+#include "Quark/Core/Math/SimdFloat.h"
+#include "Quark/Core/Util/BitOperations.h"
+
+namespace quark::math {
+
+void BoundsSoA::Set(size_t i, const Aabb& aabb)
+{
+    glm::vec3 center = aabb.GetCenter();
+    glm::vec3 extents = aabb.GetExtents();
+    center_x[i] = center.x;
+    center_y[i] = center.y;
+    center_z[i] = center.z;
+    extent_x[i] = extents.x;
+    extent_y[i] = extents.y;
+    extent_z[i] = extents.z;
+    radius[i] = aabb.GetRadius();
+}
+
+Aabb BoundsSoA::Get(size_t i) const
+{
+    const glm::vec3 center(center_x[i], center_y[i], center_z[i]);
+    const glm::vec3 extents(extent_x[i], extent_y[i], extent_z[i]);
+    return Aabb(center - extents, center + extents);
+}
+
+void BoundsSoA::PushBack(const Aabb& aabb)
+{
+    size_t i = Size();
+    center_x.emplace_back();
+    center_y.emplace_back();
+    center_z.emplace_back();
+    extent_x.emplace_back();
+    extent_y.emplace_back();
+    extent_z.emplace_back();
+    radius.emplace_back();
+    Set(i, aabb);
+}
+
+void BoundsSoA::RemoveSwapBack(size_t i)
+{
+    auto remove = [i](std::vector<float>& v)
+    {
+        v[i] = v.back();
+        v.pop_back();
+    };
+
+    remove(center_x);
+    remove(center_y);
+    remove(center_z);
+    remove(extent_x);
+    remove(extent_y);
+    remove(extent_z);
+    remove(radius);
+}
+
+void BoundsSoA::Reserve(size_t size)
+{
+    center_x.reserve(size);
+    center_y.reserve(size);
+    center_z.reserve(size);
+    extent_x.reserve(size);
+    extent_y.reserve(size);
+    extent_z.reserve(size);
+    radius.reserve(size);
+}
+
+void BoundsSoA::Clear()
+{
+    center_x.clear();
+    center_y.clear();
+    center_z.clear();
+    extent_x.clear();
+    extent_y.clear();
+    extent_z.clear();
+    radius.clear();
+}
+
+namespace {
+
+// The operations are done in the same order as the scalar Frustum tests, so both give the same answer on the boundary
+bool IsSphereOutside(const std::array<glm::vec4, 6>& planes, const BoundsSoA& bounds, uint32_t i)
+{
+    for (const glm::vec4& p : planes)
+    {
+        float d = (p.x * bounds.center_x[i] + p.y * bounds.center_y[i]) + (p.z * bounds.center_z[i] + p.w);
+        if (d < -bounds.radius[i])
+            return true;
+    }
+    return false;
+}
+
+bool IsAabbOutside(const std::array<glm::vec4, 6>& planes, const BoundsSoA& bounds, uint32_t i)
+{
+    for (const glm::vec4& p : planes)
+    {
+        float d = (p.x * bounds.center_x[i] + p.y * bounds.center_y[i] + p.z * bounds.center_z[i]) + p.w;
+        float r = std::abs(p.x) * bounds.extent_x[i] + std::abs(p.y) * bounds.extent_y[i] + std::abs(p.z) * bounds.extent_z[i];
+        if (d < -r)
+            return true;
+    }
+    return false;
+}
+
+#ifdef QK_SIMD_FLOAT
+using V = SimdFloat::Type;
+constexpr uint32_t ALL_LANES = (1u << SimdFloat::width) - 1;
+
+struct SimdPlanes
+{
+    V x[6], y[6], z[6], w[6];
+    V abs_x[6], abs_y[6], abs_z[6];
+
+    SimdPlanes(const std::array<glm::vec4, 6>& planes)
+    {
+        for (uint32_t p = 0; p < 6; p++)
+        {
+            x[p] = SimdFloat::set1(planes[p].x);
+            y[p] = SimdFloat::set1(planes[p].y);
+            z[p] = SimdFloat::set1(planes[p].z);
+            w[p] = SimdFloat::set1(planes[p].w);
+            abs_x[p] = SimdFloat::set1(std::abs(planes[p].x));
+            abs_y[p] = SimdFloat::set1(std::abs(planes[p].y));
+            abs_z[p] = SimdFloat::set1(std::abs(planes[p].z));
+        }
+    }
+};
+
+// bit set for every lane that is not outside
+uint32_t SphereLanesVisible(const SimdPlanes& planes, V cx, V cy, V cz, V radius)
+{
+    using S = SimdFloat;
+    V outside = S::zero();
+    V neg_radius = S::neg(radius);
+    for (uint32_t p = 0; p < 6; p++)
+    {
+        V d = S::add(S::add(S::mul(planes.x[p], cx), S::mul(planes.y[p], cy)), S::add(S::mul(planes.z[p], cz), planes.w[p]));
+        outside = S::bit_or(outside, S::less(d, neg_radius));
+    }
+    return ~S::mask(outside) & ALL_LANES;
+}
+
+uint32_t AabbLanesVisible(const SimdPlanes& planes, V cx, V cy, V cz, V ex, V ey, V ez)
+{
+    using S = SimdFloat;
+    V outside = S::zero();
+    for (uint32_t p = 0; p < 6; p++)
+    {
+        V d = S::add(S::add(S::add(S::mul(planes.x[p], cx), S::mul(planes.y[p], cy)), S::mul(planes.z[p], cz)), planes.w[p]);
+        V r = S::add(S::add(S::mul(planes.abs_x[p], ex), S::mul(planes.abs_y[p], ey)), S::mul(planes.abs_z[p], ez));
+        outside = S::bit_or(outside, S::less(d, S::neg(r)));
+    }
+    return ~S::mask(outside) & ALL_LANES;
+}
+#endif
+
+}
+
+uint32_t CullSpheres(const Frustum& frustum, const BoundsSoA& bounds, uint32_t begin, uint32_t end, uint32_t* out_indexes)
+{
+    QK_CORE_ASSERT(end <= bounds.Size())
+
+    const auto& planes = frustum.GetPlanes();
+    uint32_t count = 0;
+    uint32_t i = begin;
+
+#ifdef QK_SIMD_FLOAT
+    const SimdPlanes simdPlanes(planes);
+    for (; i + SimdFloat::width <= end; i += SimdFloat::width)
+    {
+        uint32_t visible = SphereLanesVisible(simdPlanes,
+            SimdFloat::load(&bounds.center_x[i]), SimdFloat::load(&bounds.center_y[i]), SimdFloat::load(&bounds.center_z[i]),
+            SimdFloat::load(&bounds.radius[i]));
+
+        util::for_each_bit(visible, [&](uint32_t lane) { out_indexes[count++] = i + lane; });
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        if (!IsSphereOutside(planes, bounds, i))
+            out_indexes[count++] = i;
+    }
+
+    return count;
+}
+
+uint32_t CullAabbs(const Frustum& frustum, const BoundsSoA& bounds, uint32_t begin, uint32_t end, uint32_t* out_indexes)
+{
+    QK_CORE_ASSERT(end <= bounds.Size())
+
+    const auto& planes = frustum.GetPlanes();
+    uint32_t count = 0;
+    uint32_t i = begin;
+
+#ifdef QK_SIMD_FLOAT
+    const SimdPlanes simdPlanes(planes);
+    for (; i + SimdFloat::width <= end; i += SimdFloat::width)
+    {
+        uint32_t visible = AabbLanesVisible(simdPlanes,
+            SimdFloat::load(&bounds.center_x[i]), SimdFloat::load(&bounds.center_y[i]), SimdFloat::load(&bounds.center_z[i]),
+            SimdFloat::load(&bounds.extent_x[i]), SimdFloat::load(&bounds.extent_y[i]), SimdFloat::load(&bounds.extent_z[i]));
+
+        util::for_each_bit(visible, [&](uint32_t lane) { out_indexes[count++] = i + lane; });
+    }
+#endif
+
+    for (; i < end; i++)
+    {
+        if (!IsAabbOutside(planes, bounds, i))
+            out_indexes[count++] = i;
+    }
+
+    return count;
+}
+
+uint32_t CullIndexedAabbs(const Frustum& frustum, const BoundsSoA& bounds, const uint32_t* indexes, uint32_t index_count, uint32_t* out_indexes)
+{
+    const auto& planes = frustum.GetPlanes();
+    uint32_t count = 0;
+    uint32_t i = 0;
+
+#ifdef QK_SIMD_FLOAT
+    // out_indexes may be indexes itself, every batch is read before it is written
+    const SimdPlanes simdPlanes(planes);
+    uint32_t batch[SimdFloat::width];
+    for (; i + SimdFloat::width <= index_count; i += SimdFloat::width)
+    {
+        std::copy(indexes + i, indexes + i + SimdFloat::width, batch);
+        uint32_t visible = AabbLanesVisible(simdPlanes,
+            SimdFloat::gather(bounds.center_x.data(), batch), SimdFloat::gather(bounds.center_y.data(), batch), SimdFloat::gather(bounds.center_z.data(), batch),
+            SimdFloat::gather(bounds.extent_x.data(), batch), SimdFloat::gather(bounds.extent_y.data(), batch), SimdFloat::gather(bounds.extent_z.data(), batch));
+
+        util::for_each_bit(visible, [&](uint32_t lane) { out_indexes[count++] = batch[lane]; });
+    }
+#endif
+
+    for (; i < index_count; i++)
+    {
+        uint32_t index = indexes[i];
+        if (!IsAabbOutside(planes, bounds, index))
+            out_indexes[count++] = index;
+    }
+
+    return count;
+}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Quark/Core/Math/Aabb.h"
+#include "Quark/Core/Math/Frustum.h"
+
+namespace quark::math {
+
+// Bounds of many objects as a structure of arrays, read 8 (AVX2) or 4 (SSE) objects at a time by the culling kernels
+struct BoundsSoA
+{
+    std::vector<float> center_x, center_y, center_z;
+    std::vector<float> extent_x, extent_y, extent_z;
+    std::vector<float> radius;
+
+    size_t Size() const { return center_x.size(); }
+
+    void Set(size_t i, const Aabb& aabb);
+    Aabb Get(size_t i) const;
+    void PushBack(const Aabb& aabb);
+    void RemoveSwapBack(size_t i);  // same as std::vector erase by swap with the last element
+    void Reserve(size_t size);
+    void Clear();
+};
+
+// The kernels write the indexes of the objects that are not outside the frustum to out_indexes and return how many,
+// out_indexes needs room for every object tested. Results are the same as Frustum::CheckSphere() and Frustum::CheckAabb()
+uint32_t CullSpheres(const Frustum& frustum, const BoundsSoA& bounds, uint32_t begin, uint32_t end, uint32_t* out_indexes);
+uint32_t CullAabbs(const Frustum& frustum, const BoundsSoA& bounds, uint32_t begin, uint32_t end, uint32_t* out_indexes);
+
+// Only tests the listed objects
+uint32_t CullIndexedAabbs(const Frustum& frustum, const BoundsSoA& bounds, const uint32_t* indexes, uint32_t count, uint32_t* out_indexes);
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Thin wrapper over the widest float vector the translation unit is built for, 8 lanes with AVX2 and 4 with SSE2.
+// QK_SIMD_FLOAT is left undefined when neither is available and callers fall back to scalar code.
+// Only include this from .cpp files: the lane count depends on the compile flags of each file.
+namespace quark::math {
+namespace {
+
+#if defined(__AVX2__)
+struct SimdFloat
+{
+    using Type = __m256;
+    static constexpr uint32_t width = 8;
+
+    static Type load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, Type a) { _mm256_storeu_ps(p, a); }
+    static Type gather(const float* base, const uint32_t* indexes) { return _mm256_i32gather_ps(base, _mm256_loadu_si256((const __m256i*)indexes), 4); }
+    static Type set1(float v) { return _mm256_set1_ps(v); }
+    static Type lane_index() { return _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f); }
+    static Type zero() { return _mm256_setzero_ps(); }
+    static Type add(Type a, Type b) { return _mm256_add_ps(a, b); }
+    static Type mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+    static Type neg(Type a) { return _mm256_sub_ps(_mm256_setzero_ps(), a); }
+    static Type max(Type a, Type b) { return _mm256_max_ps(a, b); }
+    static Type less(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static Type greater_equal(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static Type bit_and(Type a, Type b) { return _mm256_and_ps(a, b); }
+    static Type bit_or(Type a, Type b) { return _mm256_or_ps(a, b); }
+    static Type select(Type mask, Type a, Type b) { return _mm256_blendv_ps(b, a, mask); }
+    static uint32_t mask(Type a) { return (uint32_t)_mm256_movemask_ps(a); }
+};
+#define QK_SIMD_FLOAT
+#elif defined(__SSE2__) || defined(_M_X64)
+struct SimdFloat
+{
+    using Type = __m128;
+    static constexpr uint32_t width = 4;
+
+    static Type load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, Type a) { _mm_storeu_ps(p, a); }
+    static Type gather(const float* base, const uint32_t* indexes) { return _mm_set_ps(base[indexes[3]], base[indexes[2]], base[indexes[1]], base[indexes[0]]); }
+    static Type set1(float v) { return _mm_set1_ps(v); }
+    static Type lane_index() { return _mm_setr_ps(0.f, 1.f, 2.f, 3.f); }
+    static Type zero() { return _mm_setzero_ps(); }
+    static Type add(Type a, Type b) { return _mm_add_ps(a, b); }
+    static Type mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+    static Type neg(Type a) { return _mm_sub_ps(_mm_setzero_ps(), a); }
+    static Type max(Type a, Type b) { return _mm_max_ps(a, b); }
+    static Type less(Type a, Type b) { return _mm_cmplt_ps(a, b); }
+    static Type greater_equal(Type a, Type b) { return _mm_cmpge_ps(a, b); }
+    static Type bit_and(Type a, Type b) { return _mm_and_ps(a, b); }
+    static Type bit_or(Type a, Type b) { return _mm_or_ps(a, b); }
+    static Type select(Type mask, Type a, Type b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    static uint32_t mask(Type a) { return (uint32_t)_mm_movemask_ps(a); }
+};
+#define QK_SIMD_FLOAT
+#endif
+
+}
+}
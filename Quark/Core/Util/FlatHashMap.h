@@ -0,0 +1,164 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <type_traits>
+
+namespace quark::util {
+
+// Open addressing hash map from an integer key to a small value, with linear probing in one flat array.
+// Erase shifts the following entries back instead of leaving tombstones, so lookups stay short after many deletes.
+// Pointers to values are invalidated by any insert or erase.
+template<typename Key, typename Value>
+class FlatHashMap
+{
+	static_assert(std::is_integral_v<Key>, "FlatHashMap: keys have to be integers");
+
+public:
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+
+	void clear()
+	{
+		m_slots.clear();
+		m_used.clear();
+		m_size = 0;
+	}
+
+	void reserve(size_t count)
+	{
+		size_t capacity = MIN_CAPACITY;
+		while (capacity * MAX_LOAD_NUMERATOR < count * MAX_LOAD_DENOMINATOR)
+			capacity *= 2;
+		if (capacity > m_slots.size())
+			Rehash(capacity);
+	}
+
+	Value* find(Key key)
+	{
+		if (m_size == 0)
+			return nullptr;
+
+		for (size_t i = GetHomeSlot(key);; i = (i + 1) & GetMask())
+		{
+			if (!m_used[i])
+				return nullptr;
+			if (m_slots[i].key == key)
+				return &m_slots[i].value;
+		}
+	}
+
+	const Value* find(Key key) const { return const_cast<FlatHashMap*>(this)->find(key); }
+	bool contains(Key key) const { return find(key) != nullptr; }
+
+	// default constructs the value of a new key
+	Value& operator[](Key key)
+	{
+		if ((m_size + 1) * MAX_LOAD_DENOMINATOR > m_slots.size() * MAX_LOAD_NUMERATOR)
+			Rehash(m_slots.empty() ? MIN_CAPACITY : m_slots.size() * 2);
+
+		size_t i = GetHomeSlot(key);
+		for (; m_used[i]; i = (i + 1) & GetMask())
+		{
+			if (m_slots[i].key == key)
+				return m_slots[i].value;
+		}
+
+		m_used[i] = 1;
+		m_slots[i] = { key, Value() };
+		m_size++;
+		return m_slots[i].value;
+	}
+
+	bool erase(Key key)
+	{
+		if (m_size == 0)
+			return false;
+
+		size_t hole = GetHomeSlot(key);
+		for (;; hole = (hole + 1) & GetMask())
+		{
+			if (!m_used[hole])
+				return false;
+			if (m_slots[hole].key == key)
+				break;
+		}
+
+		// move back every following entry of the run that may live in the hole
+		for (size_t i = (hole + 1) & GetMask(); m_used[i]; i = (i + 1) & GetMask())
+		{
+			const size_t home = GetHomeSlot(m_slots[i].key);
+			if (((i - home) & GetMask()) >= ((i - hole) & GetMask()))
+			{
+				m_slots[hole] = std::move(m_slots[i]);
+				hole = i;
+			}
+		}
+
+		m_used[hole] = 0;
+		m_size--;
+		return true;
+	}
+
+	// calls func(key, value) for every entry, in no particular order
+	template<typename Func>
+	void for_each(Func&& func) const
+	{
+		for (size_t i = 0; i < m_slots.size(); i++)
+		{
+			if (m_used[i])
+				func(m_slots[i].key, m_slots[i].value);
+		}
+	}
+
+private:
+	static constexpr size_t MIN_CAPACITY = 16;
+	static constexpr size_t MAX_LOAD_NUMERATOR = 3;		// at most 3/4 full
+	static constexpr size_t MAX_LOAD_DENOMINATOR = 4;
+
+	struct Slot
+	{
+		Key key;
+		Value value;
+	};
+
+	size_t GetMask() const { return m_slots.size() - 1; }
+
+	size_t GetHomeSlot(Key key) const
+	{
+		// murmur3 finalizer, sequential keys would otherwise fill runs of neighbouring slots
+		uint64_t h = (uint64_t)key;
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ull;
+		h ^= h >> 33;
+		return (size_t)h & GetMask();
+	}
+
+	void Rehash(size_t capacity)
+	{
+		std::vector<Slot> old_slots(capacity);
+		std::vector<uint8_t> old_used(capacity, 0);
+		m_slots.swap(old_slots);
+		m_used.swap(old_used);
+
+		for (size_t i = 0; i < old_slots.size(); i++)
+		{
+			if (!old_used[i])
+				continue;
+
+			size_t j = GetHomeSlot(old_slots[i].key);
+			while (m_used[j])
+				j = (j + 1) & GetMask();
+			m_used[j] = 1;
+			m_slots[j] = std::move(old_slots[i]);
+		}
+	}
+
+	std::vector<Slot> m_slots;		// power of two size
+	std::vector<uint8_t> m_used;
+	size_t m_size = 0;
+};
+
+}
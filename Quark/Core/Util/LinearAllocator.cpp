@@ -0,0 +1,50 @@
+#include "LinearAllocator.h"
+#include <algorithm>
+
+namespace quark::util {
+
+LinearAllocator::LinearAllocator(size_t block_size)
+	: block_size(block_size)
+{
+}
+
+void* LinearAllocator::allocate(size_t size, size_t alignment)
+{
+	// Try the current block first, then any block left over from previous frames that is large enough
+	while (current_block < blocks.size())
+	{
+		Block& block = blocks[current_block];
+		uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+		size_t aligned_offset = ((base + current_offset + alignment - 1) & ~(uintptr_t(alignment) - 1)) - base;
+		if (aligned_offset + size <= block.size)
+		{
+			current_offset = aligned_offset + size;
+			used_size += size;
+			return block.memory.get() + aligned_offset;
+		}
+
+		current_block++;
+		current_offset = 0;
+	}
+
+	// Out of memory, grow by a new block. Oversized requests get a block of their own
+	Block new_block;
+	new_block.size = std::max(block_size, size + alignment);
+	new_block.memory.reset(static_cast<uint8_t*>(memalign_alloc(64, new_block.size)));
+	if (!new_block.memory)
+		return nullptr;
+
+	blocks.push_back(std::move(new_block));
+	current_block = blocks.size() - 1;
+	current_offset = 0;
+	return allocate(size, alignment);
+}
+
+void LinearAllocator::reset()
+{
+	current_block = 0;
+	current_offset = 0;
+	used_size = 0;
+}
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <type_traits>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "AlignedAlloc.h"
+
+namespace quark::util {
+
+// Bump allocator for data that only lives for one frame.
+// Memory is handed out from big blocks which are kept when the allocator is reset, 
+// so once it has grown to the frame's working set, allocating from it never touches the heap again.
+// Destructors are never called, only trivially destructible types can live here.
+class LinearAllocator
+{
+public:
+	explicit LinearAllocator(size_t block_size = 64 * 1024);
+
+	LinearAllocator(const LinearAllocator&) = delete;
+	LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+	void* allocate(size_t size, size_t alignment);
+
+	template<typename T>
+	T* allocate_array(size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "LinearAllocator never calls destructors");
+		if (count == 0)
+			return nullptr;
+
+		T* ptr = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+		for (size_t i = 0; i < count; i++)
+			new (&ptr[i]) T();
+		return ptr;
+	}
+
+	// Invalidates everything allocated so far, the blocks are kept for reuse
+	void reset();
+
+	size_t get_block_count() const { return blocks.size(); }
+	size_t get_used_size() const { return used_size; }
+
+private:
+	struct MallocDeleter
+	{
+		void operator()(uint8_t* ptr) { memalign_free(ptr); }
+	};
+
+	struct Block
+	{
+		std::unique_ptr<uint8_t, MallocDeleter> memory;
+		size_t size = 0;
+	};
+
+	std::vector<Block> blocks;
+	size_t block_size;
+	size_t current_block = 0;
+	size_t current_offset = 0;
+	size_t used_size = 0;
+};
+
+}
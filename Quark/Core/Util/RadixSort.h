@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <algorithm>
+
+namespace quark::util {
+
+// LSD radix sort on a 64 bit key, 8 bits per pass. Stable, so equal keys keep their order.
+// Passes where every item has the same digit are skipped, which is common for keys with unused high bits.
+// temp needs room for count items; the sorted result always ends up in items.
+template<typename T, typename KeyFunc>
+void radix_sort(T* items, T* temp, size_t count, KeyFunc&& get_key)
+{
+	constexpr uint32_t DIGIT_BITS = 8;
+	constexpr uint32_t BUCKET_COUNT = 1u << DIGIT_BITS;
+	constexpr uint32_t PASS_COUNT = 64 / DIGIT_BITS;
+
+	if (count < 2)
+		return;
+
+	// every histogram in one read of the keys
+	size_t histograms[PASS_COUNT][BUCKET_COUNT] = {};
+	for (size_t i = 0; i < count; i++)
+	{
+		uint64_t key = get_key(items[i]);
+		for (uint32_t pass = 0; pass < PASS_COUNT; pass++)
+			histograms[pass][(key >> (pass * DIGIT_BITS)) & (BUCKET_COUNT - 1)]++;
+	}
+
+	T* src = items;
+	T* dst = temp;
+	for (uint32_t pass = 0; pass < PASS_COUNT; pass++)
+	{
+		size_t* histogram = histograms[pass];
+		const uint32_t shift = pass * DIGIT_BITS;
+
+		if (histogram[(get_key(src[0]) >> shift) & (BUCKET_COUNT - 1)] == count)
+			continue;
+
+		size_t offset = 0;
+		for (uint32_t bucket = 0; bucket < BUCKET_COUNT; bucket++)
+		{
+			size_t bucket_count = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucket_count;
+		}
+
+		for (size_t i = 0; i < count; i++)
+			dst[histogram[(get_key(src[i]) >> shift) & (BUCKET_COUNT - 1)]++] = src[i];
+
+		std::swap(src, dst);
+	}
+
+	if (src != items)
+		std::copy(src, src + count, items);
+}
+
+}
@@ -0,0 +1,83 @@
+#include "RingAllocator.h"
+
+namespace quark::util {
+
+RingAllocator::RingAllocator(uint64_t size)
+{
+	reset(size);
+}
+
+void RingAllocator::reset(uint64_t size)
+{
+	this->size = size;
+	pending.clear();
+	head = 0;
+	tail = 0;
+	used_size = 0;
+	open_size = 0;
+}
+
+uint64_t RingAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+	if (size == 0 || size > this->size)
+		return INVALID_OFFSET;
+
+	uint64_t aligned_head = (head + alignment - 1) / alignment * alignment;
+	uint64_t padding = aligned_head - head;
+
+	if (used_size == 0)
+	{
+		// empty, start over from the beginning
+		head = tail = 0;
+		aligned_head = 0;
+		padding = 0;
+	}
+	else if (head < tail)
+	{
+		// the free space is [head, tail)
+		if (aligned_head + size > tail)
+			return INVALID_OFFSET;
+	}
+	else
+	{
+		// the free space is [head, size) and [0, tail), head == tail means full
+		if (head == tail)
+			return INVALID_OFFSET;
+
+		if (aligned_head + size > this->size)
+		{
+			if (size > tail)
+				return INVALID_OFFSET;
+
+			// skip what is left at the end of the ring
+			aligned_head = 0;
+			padding = this->size - head;
+		}
+	}
+
+	used_size += padding + size;
+	open_size += padding + size;
+	head = aligned_head + size;
+	return aligned_head;
+}
+
+void RingAllocator::close(uint64_t value)
+{
+	if (open_size == 0)
+		return;
+
+	pending.push_back({ head, open_size, value });
+	open_size = 0;
+}
+
+void RingAllocator::release(uint64_t completed_value)
+{
+	while (!pending.empty() && pending.front().value <= completed_value)
+	{
+		tail = pending.front().end;
+		used_size -= pending.front().used_size;
+		pending.pop_front();
+	}
+}
+
+}
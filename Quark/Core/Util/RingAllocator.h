@@ -0,0 +1,53 @@
+#pragma once
+#include <deque>
+#include <stdint.h>
+
+namespace quark::util {
+
+// Hands out offsets into a fixed size ring, for memory the GPU reads some time after the CPU wrote it.
+// Allocations are closed in groups tagged with a fence value (a frame index, a timeline semaphore value...)
+// and the whole group is released once that value has completed. Only offsets are managed here, the owner
+// keeps the memory they point into.
+class RingAllocator
+{
+public:
+	static constexpr uint64_t INVALID_OFFSET = ~0ull;
+
+	explicit RingAllocator(uint64_t size = 0);
+
+	// Drops every allocation, pending or not
+	void reset(uint64_t size);
+
+	// Returns INVALID_OFFSET if there is no room until pending allocations are released.
+	// Allocations never wrap around the end of the ring.
+	uint64_t allocate(uint64_t size, uint64_t alignment);
+
+	// Everything allocated since the last close() is released by release() with completed_value >= value.
+	// Values must not decrease.
+	void close(uint64_t value);
+	void release(uint64_t completed_value);
+
+	bool has_pending() const { return !pending.empty(); }
+	uint64_t get_oldest_pending_value() const { return pending.front().value; }
+
+	uint64_t get_size() const { return size; }
+	uint64_t get_used_size() const { return used_size; }	// including alignment and wrap around padding
+	uint64_t get_open_size() const { return open_size; }	// allocated since the last close()
+
+private:
+	struct Range
+	{
+		uint64_t end;
+		uint64_t used_size;
+		uint64_t value;
+	};
+
+	std::deque<Range> pending;
+	uint64_t size = 0;
+	uint64_t head = 0;
+	uint64_t tail = 0;
+	uint64_t used_size = 0;
+	uint64_t open_size = 0;
+};
+
+}
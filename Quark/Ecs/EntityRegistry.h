@@ -14,6 +14,7 @@ public:
     std::vector<Entity*>& GetEntities() { return m_Entities;}
     
     Entity* CreateEntity();
+    void Reserve(size_t entityCount) { m_Entities.reserve(entityCount); }
     void DeleteEntity(Entity* entity);
 
 	template <typename... Ts>
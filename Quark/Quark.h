@@ -41,6 +41,8 @@
 #include <Quark/Ecs/Entity.h>
 #include <Quark/Scene/Scene.h>
 #include <Quark/Scene/SceneSerializer.h>
+#include <Quark/Scene/SceneJournal.h>
+#include <Quark/Scene/WorldPartition.h>
 #include <Quark/Scene/Components/CommonCmpts.h>
 #include <Quark/Scene/Components/TransformCmpt.h>
 #include <Quark/Scene/Components/CameraCmpt.h>
@@ -76,6 +76,14 @@ struct PipelineImageBarrier
     ImageLayout layoutAfter = ImageLayout::UNDEFINED;
 };
 
+// Where the commands of a render pass are recorded. A render pass with secondary command list contents only
+// takes ExecuteSecondaryCommandLists(), its draws are recorded by lists from Device::BeginSecondaryCommandList().
+enum class RenderPassContents : uint8_t
+{
+    INLINE,
+    SECONDARY_COMMAND_LISTS,
+};
+
 class CommandList : public GpuResource {
 public:
     CommandList(QueueType type) : m_QueueType(type) {};
@@ -89,6 +97,8 @@ public:
     virtual void BindVertexBuffer(uint32_t binding, const Buffer& buffer, uint64_t offset) = 0;
     virtual void BindIndexBuffer(const Buffer& buffer, uint64_t offset, const IndexBufferFormat format) = 0;
     virtual void BindSampler(uint32_t set, uint32_t binding, const Sampler& sampler) = 0;
+    // The device's bindless image array at this set, for pipelines whose shaders declare it there
+    virtual void BindBindlessImages(uint32_t set) = 0;
     
     virtual void CopyImageToBuffer(const Buffer& buffer, const Image& image, uint64_t buffer_offset, const Offset3D& offset, const Extent3D& extent, uint32_t row_pitch, uint32_t slice_pitch, const ImageSubresourceRange& subresouce) = 0;
 
@@ -100,9 +110,13 @@ public:
 
     virtual void PipeLineBarriers(const PipelineMemoryBarrier* memoryBarriers, uint32_t memoryBarriersCount, const PipelineImageBarrier* iamgeBarriers, uint32_t iamgeBarriersCount, const PipelineBufferBarrier* bufferBarriers, uint32_t bufferBarriersCount) = 0;
     
-    virtual void BeginRenderPass(const RenderPassInfo2& renderPassInfo, const FrameBufferInfo& frameBufferInfo) = 0;
+    virtual void BeginRenderPass(const RenderPassInfo2& renderPassInfo, const FrameBufferInfo& frameBufferInfo, RenderPassContents contents = RenderPassContents::INLINE) = 0;
     // virtual void BeginRenderPass(const RenderPassInfo& info) = 0;
     virtual void EndRenderPass() = 0;
+
+    // Executes finished secondary command lists in order, in the current render pass. They are not reused or
+    // recorded to afterwards
+    virtual void ExecuteSecondaryCommandLists(CommandList* const* cmds, uint32_t count) = 0;
     
     virtual const RenderPassInfo2& GetCurrentRenderPassInfo() const = 0;
     virtual const PipeLine* GetCurrentGraphicsPipeline() const = 0;
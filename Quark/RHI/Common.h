@@ -11,6 +11,7 @@ namespace quark::rhi {
 #define VERTEX_BUFFER_MAX_NUM 8
 #define MAX_COLOR_ATTHACHEMNT_NUM 8
 #define MAX_FRAME_NUM_IN_FLIGHT 2
+#define BINDLESS_IMAGE_MAX_NUM 16384
 
 // Forward declaraton
 class Device;
@@ -9,6 +9,7 @@
 #include "Quark/RHI/Shader.h"
 #include "Quark/RHI/PipeLine.h"
 #include "Quark/RHI/RenderPassInfo.h"
+#include "Quark/RHI/FrameDataAllocator.h"
 
 namespace quark::rhi {
 
@@ -17,6 +18,7 @@ struct DeviceProperties
     struct DeviceLimits 
     {
         u64 minUniformBufferOffsetAlignment = 0;
+        u64 minStorageBufferOffsetAlignment = 0;
     } limits;
 
 };
@@ -26,6 +28,28 @@ struct DeviceFeatures
     bool textureCompressionBC = false;
     bool textureCompressionASTC_LDR = false;
     bool textureCompressionETC2 = false;
+    bool bindlessImages = false;    // BINDLESS_IMAGE_MAX_NUM images sampled by index, see RegisterBindlessImage()
+};
+
+// How the descriptor sets that draws flush were found, since the device was initialized
+struct DescriptorSetStats
+{
+    uint64_t hits = 0;              // requests served by the set cached for the same hash
+    uint64_t misses = 0;
+    uint64_t vacantReuses = 0;      // misses served by an already allocated set
+    uint64_t descriptorUpdates = 0; // one per miss
+    uint64_t poolAllocations = 0;
+    uint64_t allocatedSets = 0;
+
+    void Add(const DescriptorSetStats& other)
+    {
+        hits += other.hits;
+        misses += other.misses;
+        vacantReuses += other.vacantReuses;
+        descriptorUpdates += other.descriptorUpdates;
+        poolAllocations += other.poolAllocations;
+        allocatedSets += other.allocatedSets;
+    }
 };
 
 class Device 
@@ -57,12 +81,28 @@ public:
     virtual Ref<Sampler> CreateSampler(const SamplerDesc& desc) = 0;
 
     // helper functions to upload data to GPU
-    // only use in the initialization stage
-    virtual void CopyBuffer(Buffer& dst, Buffer& src, uint64_t size, uint64_t dstOffset = 0, uint64_t srcOffset = 0) = 0;
+    // only use in the initialization stage, the device keeps src alive until the copy is done
+    virtual void CopyBuffer(Buffer& dst, const Ref<Buffer>& src, uint64_t size, uint64_t dstOffset = 0, uint64_t srcOffset = 0) = 0;
+
+    // Memory the CPU writes for the GPU to read in the current frame, from the frame's FrameDataAllocator.
+    // Can be called from any thread, the memory is recycled when this frame slot begins again
+    virtual FrameAllocation AllocateFrameData(u64 size) = 0;
 
 	/*** COMMAND LIST ***/
     virtual CommandList* BeginCommandList(QueueType type = QueueType::QUEUE_TYPE_GRAPHICS) = 0;
     virtual void SubmitCommandList(CommandList* cmd, CommandList* waitedCmds = nullptr, uint32_t waitedCmdCounts = 0, bool signal = false) = 0;
+    // A list recording into the render pass the primary list is in, which must have been begun with
+    // RenderPassContents::SECONDARY_COMMAND_LISTS. It starts with the primary's viewport and scissor and no other state.
+    // Command lists can be begun and recorded on any thread, the primary executes the secondary lists.
+    virtual CommandList* BeginSecondaryCommandList(const CommandList& primary) = 0;
+
+	/*** BINDLESS ***/
+    // Images registered here are sampled by index from one large descriptor array, shaders declare it as an unsized
+    // sampler2D array alone in its set and command lists bind it with BindBindlessImages(). Registering writes the
+    // descriptor once, drawing with it afterwards takes no descriptor work. Requires DeviceFeatures::bindlessImages.
+    // The image must outlive its registration, an unregistered index is reused once the frames in flight are done.
+    virtual uint32_t RegisterBindlessImage(const Image& image, const Sampler& sampler) = 0;
+    virtual void UnregisterBindlessImage(uint32_t index) = 0;
 
 	/*** SWAPCHAIN ***/
     virtual Image* GetPresentImage() = 0; // Owned by device.
@@ -72,6 +112,9 @@ public:
     virtual bool isFormatSupported(DataFormat format) = 0;
     virtual void SetDebugName(const Ref<GpuResource>& resouce, const char* name) = 0;
 
+    /*** STATS ***/
+    virtual DescriptorSetStats GetDescriptorSetStats() = 0;
+
 protected:
     uint32_t m_elapsedFrame = 0;
     uint32_t m_frameBufferWidth;
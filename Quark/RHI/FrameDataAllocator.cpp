@@ -0,0 +1,83 @@
+#include "Quark/qkpch.h"
+#include "Quark/RHI/FrameDataAllocator.h"
+#include "Quark/RHI/Device.h"
+
+namespace quark::rhi {
+
+void FrameDataAllocator::Init(Device* device, u64 alignment)
+{
+    QK_CORE_ASSERT(device != nullptr)
+    QK_CORE_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0)
+
+    m_device = device;
+    m_alignment = alignment;
+    Reset();
+}
+
+void FrameDataAllocator::Destroy()
+{
+    m_buffers.clear();
+    Reset();
+}
+
+FrameAllocation FrameDataAllocator::Allocate(u64 size)
+{
+    QK_CORE_ASSERT(m_device != nullptr)
+
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    // Try the current buffer first, then any buffer left over from previous frames that is large enough
+    while (m_currentBuffer < m_buffers.size())
+    {
+        Buffer& buffer = *m_buffers[m_currentBuffer];
+        const u64 aligned_offset = (m_currentOffset + m_alignment - 1) & ~(m_alignment - 1);
+        if (aligned_offset + size <= buffer.GetDesc().size)
+        {
+            m_currentOffset = aligned_offset + size;
+            m_usedSize += size;
+
+            FrameAllocation allocation;
+            allocation.buffer = &buffer;
+            allocation.offset = aligned_offset;
+            allocation.size = size;
+            allocation.data = static_cast<byte*>(buffer.GetMappedDataPtr()) + aligned_offset;
+            return allocation;
+        }
+
+        m_currentBuffer++;
+        m_currentOffset = 0;
+    }
+
+    // Out of memory, grow by a new buffer. Oversized requests get a buffer of their own
+    BufferDesc desc;
+    desc.domain = BufferMemoryDomain::CPU;
+    desc.size = std::max(BLOCK_SIZE, size);
+    desc.usageBits = BUFFER_USAGE_UNIFORM_BUFFER_BIT | BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        BUFFER_USAGE_VERTEX_BUFFER_BIT | BUFFER_USAGE_INDEX_BUFFER_BIT | BUFFER_USAGE_INDIRECT_BIT;
+    Ref<Buffer> buffer = m_device->CreateBuffer(desc);
+    QK_CORE_VERIFY(buffer && buffer->GetMappedDataPtr(), "FrameDataAllocator: failed to create a mapped buffer")
+    m_device->SetDebugName(buffer, "FrameDataAllocator buffer");
+
+    FrameAllocation allocation;
+    allocation.buffer = buffer.get();
+    allocation.offset = 0;
+    allocation.size = size;
+    allocation.data = buffer->GetMappedDataPtr();
+
+    m_buffers.push_back(std::move(buffer));
+    m_currentBuffer = (u32)m_buffers.size() - 1;
+    m_currentOffset = size;
+    m_usedSize += size;
+    return allocation;
+}
+
+void FrameDataAllocator::Reset()
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    m_currentBuffer = 0;
+    m_currentOffset = 0;
+    m_usedSize = 0;
+}
+
+}
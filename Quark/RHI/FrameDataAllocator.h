@@ -0,0 +1,57 @@
+#pragma once
+#include "Quark/Core/Base.h"
+#include "Quark/RHI/Buffer.h"
+
+namespace quark::rhi {
+
+class Device;
+
+// A range of one of a frame's data buffers, written through data.
+// Uniform ranges are bound with BindUniformBuffer(buffer, offset), rebinding the same buffer only changes the dynamic offset
+struct FrameAllocation
+{
+    Buffer* buffer = nullptr;
+    u64 offset = 0;
+    u64 size = 0;
+    void* data = nullptr;   // persistently mapped pointer to offset
+};
+
+// Linear allocator for data the CPU writes every frame and the GPU reads in that frame: scene uniforms, instance arrays,
+// skinning matrices, light lists...
+// Allocations come from host visible buffers that stay mapped, aligned so any of them can be bound as a uniform or a storage buffer.
+// The device keeps one per frame in flight and resets it when the frame's fences have signaled. Buffers are kept when
+// the allocator is reset, so it only creates buffers until it has grown to the frame's working set.
+class FrameDataAllocator
+{
+public:
+    static constexpr u64 BLOCK_SIZE = 4 * 1024 * 1024;
+
+    FrameDataAllocator() = default;
+    FrameDataAllocator(const FrameDataAllocator&) = delete;
+    FrameDataAllocator& operator=(const FrameDataAllocator&) = delete;
+
+    void Init(Device* device, u64 alignment);
+    void Destroy();
+
+    // Thread safe
+    FrameAllocation Allocate(u64 size);
+
+    // Invalidates everything allocated so far, only call once the GPU is done with it
+    void Reset();
+
+    u64 GetUsedSize() const { return m_usedSize; }
+    u32 GetBufferCount() const { return (u32)m_buffers.size(); }
+
+private:
+    Device* m_device = nullptr;
+    u64 m_alignment = 0;
+
+    std::vector<Ref<Buffer>> m_buffers;
+    u32 m_currentBuffer = 0;
+    u64 m_currentOffset = 0;
+    u64 m_usedSize = 0;
+
+    std::mutex m_lock;
+};
+
+}
@@ -0,0 +1,819 @@
+#include "Quark/qkpch.h"
+#include "Quark/RHI/Null/CommandList_Null.h"
+#include "Quark/Core/Util/BitOperations.h"
+#include "Quark/RHI/Null/Device_Null.h"
+
+namespace quark::rhi {
+
+// A recorded command is its op followed by its arguments. The argument structs have no implicit padding, so the
+// same commands always give the same bytes.
+enum class CommandOp_Null : uint8_t
+{
+    PUSH_CONSTANT,
+    BIND_PIPELINE,
+    BIND_UNIFORM_BUFFER,
+    BIND_STORAGE_BUFFER,
+    BIND_IMAGE,
+    BIND_VERTEX_BUFFER,
+    BIND_INDEX_BUFFER,
+    BIND_SAMPLER,
+    BIND_BINDLESS_IMAGES,
+    COPY_IMAGE_TO_BUFFER,
+    DRAW,
+    DRAW_INDEXED,
+    SET_VIEWPORT,
+    SET_SCISSOR,
+    PIPELINE_BARRIERS,
+    BEGIN_RENDER_PASS,
+    END_RENDER_PASS,
+    EXECUTE_SECONDARY_COMMAND_LISTS, // count, then each list's stream prefixed with its size
+    MAX_ENUM
+};
+
+struct BufferBindCommand
+{
+    const Buffer* buffer;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t set;
+    uint32_t binding;
+};
+
+struct ImageBindCommand
+{
+    const Image* image;
+    uint32_t set;
+    uint32_t binding;
+    ImageLayout layout;
+    uint8_t padding[7];
+};
+
+struct SamplerBindCommand
+{
+    const Sampler* sampler;
+    uint32_t set;
+    uint32_t binding;
+};
+
+struct VertexBufferBindCommand
+{
+    const Buffer* buffer;
+    uint64_t offset;
+    uint32_t binding;
+    uint32_t padding;
+};
+
+struct IndexBufferBindCommand
+{
+    const Buffer* buffer;
+    uint64_t offset;
+    IndexBufferFormat format;
+    uint32_t padding;
+};
+
+struct CopyImageToBufferCommand
+{
+    const Buffer* buffer;
+    const Image* image;
+    uint64_t bufferOffset;
+    Offset3D offset;
+    Extent3D extent;
+    uint32_t rowPitch;
+    uint32_t slicePitch;
+    uint32_t aspect;
+    uint32_t mipLevel;
+    uint32_t baseArrayLayer;
+    uint32_t layerCount;
+};
+
+struct DrawCommand
+{
+    uint32_t vertexCount;
+    uint32_t instanceCount;
+    uint32_t firstVertex;
+    uint32_t firstInstance;
+};
+
+struct DrawIndexedCommand
+{
+    uint32_t indexCount;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    uint32_t vertexOffset;
+    uint32_t firstInstance;
+};
+
+struct BarriersCommand
+{
+    uint32_t memoryBarriersCount;
+    uint32_t imageBarriersCount;
+    uint32_t bufferBarriersCount;
+};
+
+void CommandStats_Null::Add(const CommandStats_Null& other)
+{
+    renderPasses += other.renderPasses;
+    pipelineBinds += other.pipelineBinds;
+    redundantPipelineBinds += other.redundantPipelineBinds;
+    uniformBufferBinds += other.uniformBufferBinds;
+    storageBufferBinds += other.storageBufferBinds;
+    imageBinds += other.imageBinds;
+    samplerBinds += other.samplerBinds;
+    bindlessImageBinds += other.bindlessImageBinds;
+    descriptorSetFlushes += other.descriptorSetFlushes;
+    vertexBufferBinds += other.vertexBufferBinds;
+    indexBufferBinds += other.indexBufferBinds;
+    pushConstants += other.pushConstants;
+    viewports += other.viewports;
+    scissors += other.scissors;
+    barriers += other.barriers;
+    draws += other.draws;
+    indexedDraws += other.indexedDraws;
+    vertices += other.vertices;
+    indices += other.indices;
+    instances += other.instances;
+    validationErrors += other.validationErrors;
+}
+
+CommandList_Null::CommandList_Null(Device_Null* device, QueueType type)
+    : CommandList(type), m_device(device)
+{
+    QK_CORE_ASSERT(m_device != nullptr)
+}
+
+void CommandList_Null::Reset(bool recordCommands)
+{
+    state = CommandListState_Null::IN_RECORDING;
+    m_isSecondary = false;
+    m_currentPipeline = nullptr;
+    m_currentRenderPassInfo = {};
+    m_currentRenderPassHash = 0;
+    m_currentRenderPassContents = RenderPassContents::INLINE;
+    m_bindingState = {};
+    std::fill(&m_descriptors[0][0], &m_descriptors[0][0] + DESCRIPTOR_SET_MAX_NUM * SET_BINDINGS_MAX_NUM, Descriptor{});
+    m_dirtySetMask = 0;
+    m_stats = {};
+    m_recordCommands = recordCommands;
+    m_commands.clear();
+}
+
+void CommandList_Null::ResetSecondary(const CommandList_Null& primary, bool recordCommands)
+{
+    Reset(recordCommands);
+    m_isSecondary = true;
+    if (primary.m_isSecondary)
+        ValidationError("BeginSecondaryCommandList() with a secondary command list as primary");
+    if (primary.state != CommandListState_Null::IN_RENDERPASS || primary.m_currentRenderPassContents != RenderPassContents::SECONDARY_COMMAND_LISTS)
+        ValidationError("BeginSecondaryCommandList() primary is not in a render pass begun with RenderPassContents::SECONDARY_COMMAND_LISTS");
+
+    // continues the primary's render pass, but nothing bound in the primary is inherited
+    state = CommandListState_Null::IN_RENDERPASS;
+    m_currentRenderPassInfo = primary.m_currentRenderPassInfo;
+    m_currentRenderPassHash = primary.m_currentRenderPassHash;
+}
+
+void CommandList_Null::ValidationError(const char* message)
+{
+    QK_CORE_LOGE_TAG("RHI", "CommandList_Null: {}", message);
+    m_stats.validationErrors++;
+}
+
+void CommandList_Null::SetDescriptor(uint32_t set, uint32_t binding, const void* resource, uint64_t offset, uint64_t range)
+{
+    if (set >= DESCRIPTOR_SET_MAX_NUM || binding >= SET_BINDINGS_MAX_NUM)
+        return;
+
+    Descriptor& descriptor = m_descriptors[set][binding];
+    descriptor.resource = resource;
+    descriptor.offset = offset;
+    descriptor.range = range;
+    m_dirtySetMask |= 1u << set;
+}
+
+void CommandList_Null::SetDescriptorSampler(uint32_t set, uint32_t binding, const Sampler* sampler)
+{
+    if (set >= DESCRIPTOR_SET_MAX_NUM || binding >= SET_BINDINGS_MAX_NUM)
+        return;
+
+    m_descriptors[set][binding].sampler = sampler;
+    m_dirtySetMask |= 1u << set;
+}
+
+void CommandList_Null::PushConstant(const void* data, uint32_t offset, uint32_t size)
+{
+    m_stats.pushConstants++;
+    if (offset + size > PUSH_CONSTANT_DATA_SIZE)
+        ValidationError("PushConstant() writes past the push constant range");
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::PUSH_CONSTANT);
+        Write(offset);
+        Write(size);
+        WriteBytes(data, size);
+    }
+}
+
+void CommandList_Null::BindPipeLine(const PipeLine& pipeline)
+{
+    if (state != CommandListState_Null::IN_RENDERPASS)
+        ValidationError("BindPipeLine() outside of a render pass, the pipeline is unbound by BeginRenderPass()");
+    else if (m_currentRenderPassContents == RenderPassContents::SECONDARY_COMMAND_LISTS)
+        ValidationError("BindPipeLine() in a render pass whose contents are secondary command lists");
+
+    const PipeLine_Null* internal_pipeline = &ToInternal_Null(&pipeline);
+    m_stats.pipelineBinds++;
+    if (internal_pipeline == m_currentPipeline)
+        m_stats.redundantPipelineBinds++;
+    m_currentPipeline = internal_pipeline;
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::BIND_PIPELINE);
+        Write(&pipeline);
+    }
+}
+
+void CommandList_Null::BindUniformBuffer(uint32_t set, uint32_t binding, const Buffer& buffer, uint64_t offset, uint64_t size)
+{
+    m_stats.uniformBufferBinds++;
+    SetDescriptor(set, binding, &buffer, offset, size);
+    const uint64_t alignment = m_device->GetDeviceProperties().limits.minUniformBufferOffsetAlignment;
+    if (set >= DESCRIPTOR_SET_MAX_NUM || binding >= SET_BINDINGS_MAX_NUM)
+        ValidationError("BindUniformBuffer() set or binding out of range");
+    if ((buffer.GetDesc().usageBits & BUFFER_USAGE_UNIFORM_BUFFER_BIT) == 0)
+        ValidationError("BindUniformBuffer() with a buffer without BUFFER_USAGE_UNIFORM_BUFFER_BIT");
+    if (offset + size > buffer.GetDesc().size)
+        ValidationError("BindUniformBuffer() range is out of the buffer");
+    if (alignment > 0 && offset % alignment != 0)
+        ValidationError("BindUniformBuffer() offset is not aligned to minUniformBufferOffsetAlignment");
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::BIND_UNIFORM_BUFFER);
+        WriteCommand(BufferBindCommand{ &buffer, offset, size, set, binding });
+    }
+}
+
+void CommandList_Null::BindStorageBuffer(uint32_t set, uint32_t binding, const Buffer& buffer, uint64_t offset, uint64_t size)
+{
+    m_stats.storageBufferBinds++;
+    SetDescriptor(set, binding, &buffer, offset, size);
+    const uint64_t alignment = m_device->GetDeviceProperties().limits.minStorageBufferOffsetAlignment;
+    if (set >= DESCRIPTOR_SET_MAX_NUM || binding >= SET_BINDINGS_MAX_NUM)
+        ValidationError("BindStorageBuffer() set or binding out of range");
+    if ((buffer.GetDesc().usageBits & BUFFER_USAGE_STORAGE_BUFFER_BIT) == 0)
+        ValidationError("BindStorageBuffer() with a buffer without BUFFER_USAGE_STORAGE_BUFFER_BIT");
+    if (offset + size > buffer.GetDesc().size)
+        ValidationError("BindStorageBuffer() range is out of the buffer");
+    if (alignment > 0 && offset % alignment != 0)
+        ValidationError("BindStorageBuffer() offset is not aligned to minStorageBufferOffsetAlignment");
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::BIND_STORAGE_BUFFER);
+        WriteCommand(BufferBindCommand{ &buffer, offset, size, set, binding });
+    }
+}
+
+void CommandList_Null::BindImage(uint32_t set, uint32_t binding, const Image& image, ImageLayout layout)
+{
+    m_stats.imageBinds++;
+    SetDescriptor(set, binding, &image, (uint64_t)layout, 0);
+    if (set >= DESCRIPTOR_SET_MAX_NUM || binding >= SET_BINDINGS_MAX_NUM)
+        ValidationError("BindImage() set or binding out of range");
+    if ((image.GetDesc().usageBits & (IMAGE_USAGE_SAMPLING_BIT | IMAGE_USAGE_STORAGE_BIT)) == 0)
+        ValidationError("BindImage() with an image without IMAGE_USAGE_SAMPLING_BIT or IMAGE_USAGE_STORAGE_BIT");
+    if (layout != ImageLayout::SHADER_READ_ONLY_OPTIMAL && layout != ImageLayout::GENERAL)
+        ValidationError("BindImage() layout must be SHADER_READ_ONLY_OPTIMAL or GENERAL");
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::BIND_IMAGE);
+        WriteCommand(ImageBindCommand{ &image, set, binding, layout });
+    }
+}
+
+void CommandList_Null::BindSampler(uint32_t set, uint32_t binding, const Sampler& sampler)
+{
+    m_stats.samplerBinds++;
+    SetDescriptorSampler(set, binding, &sampler);
+    if (set >= DESCRIPTOR_SET_MAX_NUM || binding >= SET_BINDINGS_MAX_NUM)
+        ValidationError("BindSampler() set or binding out of range");
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::BIND_SAMPLER);
+        WriteCommand(SamplerBindCommand{ &sampler, set, binding });
+    }
+}
+
+void CommandList_Null::BindBindlessImages(uint32_t set)
+{
+    // the set is written when images are registered, binding it flushes nothing
+    m_stats.bindlessImageBinds++;
+    if (!m_device->GetDeviceFeatures().bindlessImages)
+        ValidationError("BindBindlessImages() on a device without DeviceFeatures::bindlessImages");
+    if (set >= DESCRIPTOR_SET_MAX_NUM)
+        ValidationError("BindBindlessImages() set out of range");
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::BIND_BINDLESS_IMAGES);
+        Write(set);
+    }
+}
+
+void CommandList_Null::BindVertexBuffer(uint32_t binding, const Buffer& buffer, uint64_t offset)
+{
+    m_stats.vertexBufferBinds++;
+    if (binding >= VERTEX_BUFFER_MAX_NUM)
+    {
+        ValidationError("BindVertexBuffer() binding out of range");
+    }
+    else
+    {
+        m_bindingState.vertexBuffers[binding] = &buffer;
+        m_bindingState.vertexBufferOffsets[binding] = offset;
+    }
+    if ((buffer.GetDesc().usageBits & BUFFER_USAGE_VERTEX_BUFFER_BIT) == 0)
+        ValidationError("BindVertexBuffer() with a buffer without BUFFER_USAGE_VERTEX_BUFFER_BIT");
+    if (offset > buffer.GetDesc().size)
+        ValidationError("BindVertexBuffer() offset is out of the buffer");
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::BIND_VERTEX_BUFFER);
+        WriteCommand(VertexBufferBindCommand{ &buffer, offset, binding });
+    }
+}
+
+void CommandList_Null::BindIndexBuffer(const Buffer& buffer, uint64_t offset, const IndexBufferFormat format)
+{
+    m_stats.indexBufferBinds++;
+    m_bindingState.indexBuffer = &buffer;
+    m_bindingState.indexBufferOffset = offset;
+    m_bindingState.indexBufferFormat = format;
+    if ((buffer.GetDesc().usageBits & BUFFER_USAGE_INDEX_BUFFER_BIT) == 0)
+        ValidationError("BindIndexBuffer() with a buffer without BUFFER_USAGE_INDEX_BUFFER_BIT");
+    if (offset > buffer.GetDesc().size)
+        ValidationError("BindIndexBuffer() offset is out of the buffer");
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::BIND_INDEX_BUFFER);
+        WriteCommand(IndexBufferBindCommand{ &buffer, offset, format });
+    }
+}
+
+void CommandList_Null::CopyImageToBuffer(const Buffer& buffer, const Image& image, uint64_t buffer_offset, const Offset3D& offset, const Extent3D& extent, uint32_t row_pitch, uint32_t slice_pitch, const ImageSubresourceRange& subresouce)
+{
+    if (state != CommandListState_Null::IN_RECORDING)
+        ValidationError("CopyImageToBuffer() must be called outside of a render pass");
+    if ((buffer.GetDesc().usageBits & BUFFER_USAGE_TRANSFER_TO_BIT) == 0)
+        ValidationError("CopyImageToBuffer() with a buffer without BUFFER_USAGE_TRANSFER_TO_BIT");
+    if ((image.GetDesc().usageBits & IMAGE_USAGE_CAN_COPY_FROM_BIT) == 0)
+        ValidationError("CopyImageToBuffer() with an image without IMAGE_USAGE_CAN_COPY_FROM_BIT");
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::COPY_IMAGE_TO_BUFFER);
+        WriteCommand(CopyImageToBufferCommand{ &buffer, &image, buffer_offset, offset, extent, row_pitch, slice_pitch, (uint32_t)subresouce.aspect, subresouce.mipLevel, subresouce.baseArrayLayer, subresouce.layerCount });
+    }
+}
+
+bool CommandList_Null::ValidateDraw()
+{
+    const uint32_t errors = m_stats.validationErrors;
+    if (state != CommandListState_Null::IN_RENDERPASS)
+        ValidationError("Draw outside of a render pass");
+    else if (m_currentRenderPassContents == RenderPassContents::SECONDARY_COMMAND_LISTS)
+        ValidationError("Draw in a render pass whose contents are secondary command lists");
+
+    // each flushed set is looked up by its contents, as the Vulkan backend finds its cached descriptor sets
+    m_stats.descriptorSetFlushes += popcount32(m_dirtySetMask);
+    util::for_each_bit(m_dirtySetMask, [&](uint32_t set)
+    {
+        util::Hasher h;
+        h.u32(set);
+        for (const Descriptor& descriptor : m_descriptors[set])
+        {
+            h.pointer(descriptor.resource);
+            h.pointer(descriptor.sampler);
+            h.u64(descriptor.offset);
+            h.u64(descriptor.range);
+        }
+        m_device->RequestDescriptorSet(h.get());
+    });
+    m_dirtySetMask = 0;
+
+    if (m_currentPipeline == nullptr)
+    {
+        ValidationError("Draw without a pipeline");
+        return false;
+    }
+
+    if (m_currentPipeline->GetRenderPassHash() != m_currentRenderPassHash)
+        ValidationError("Draw with a pipeline created for another render pass");
+
+    for (const auto& bind_info : m_currentPipeline->GetDesc().vertexInputLayout.vertexBindInfos)
+    {
+        if (bind_info.binding >= VERTEX_BUFFER_MAX_NUM || m_bindingState.vertexBuffers[bind_info.binding] == nullptr)
+            ValidationError("Draw without a vertex buffer the pipeline reads");
+    }
+
+    return m_stats.validationErrors == errors;
+}
+
+void CommandList_Null::Draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
+{
+    ValidateDraw();
+    m_stats.draws++;
+    m_stats.vertices += (uint64_t)vertex_count * instance_count;
+    m_stats.instances += instance_count;
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::DRAW);
+        WriteCommand(DrawCommand{ vertex_count, instance_count, first_vertex, first_instance });
+    }
+}
+
+void CommandList_Null::DrawIndexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, uint32_t vertex_offset, uint32_t first_instance)
+{
+    ValidateDraw();
+    if (m_bindingState.indexBuffer == nullptr)
+    {
+        ValidationError("DrawIndexed() without an index buffer");
+    }
+    else
+    {
+        const uint64_t stride = m_bindingState.indexBufferFormat == IndexBufferFormat::UINT16 ? 2 : 4;
+        if (m_bindingState.indexBufferOffset + ((uint64_t)first_index + index_count) * stride > m_bindingState.indexBuffer->GetDesc().size)
+            ValidationError("DrawIndexed() reads past the end of the index buffer");
+    }
+
+    m_stats.indexedDraws++;
+    m_stats.indices += (uint64_t)index_count * instance_count;
+    m_stats.instances += instance_count;
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::DRAW_INDEXED);
+        WriteCommand(DrawIndexedCommand{ index_count, instance_count, first_index, vertex_offset, first_instance });
+    }
+}
+
+void CommandList_Null::SetViewPort(const Viewport& viewport)
+{
+    m_stats.viewports++;
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::SET_VIEWPORT);
+        Write(viewport);
+    }
+}
+
+void CommandList_Null::SetScissor(const Scissor& scissor)
+{
+    m_stats.scissors++;
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::SET_SCISSOR);
+        Write(scissor);
+    }
+}
+
+void CommandList_Null::PipeLineBarriers(const PipelineMemoryBarrier* memoryBarriers, uint32_t memoryBarriersCount, const PipelineImageBarrier* imageBarriers, uint32_t imageBarriersCount, const PipelineBufferBarrier* bufferBarriers, uint32_t bufferBarriersCount)
+{
+    m_stats.barriers += memoryBarriersCount + imageBarriersCount + bufferBarriersCount;
+    if (state != CommandListState_Null::IN_RECORDING)
+        ValidationError("PipeLineBarriers() must be called outside of a render pass");
+    for (uint32_t i = 0; i < imageBarriersCount; i++)
+    {
+        if (imageBarriers[i].image == nullptr)
+            ValidationError("PipeLineBarriers() image barrier without an image");
+    }
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::PIPELINE_BARRIERS);
+        WriteCommand(BarriersCommand{ memoryBarriersCount, imageBarriersCount, bufferBarriersCount });
+        WriteBytes(memoryBarriers, memoryBarriersCount * sizeof(PipelineMemoryBarrier));
+        WriteBytes(imageBarriers, imageBarriersCount * sizeof(PipelineImageBarrier));
+        WriteBytes(bufferBarriers, bufferBarriersCount * sizeof(PipelineBufferBarrier));
+    }
+}
+
+void CommandList_Null::BeginRenderPass(const RenderPassInfo2& renderPassInfo, const FrameBufferInfo& frameBufferInfo, RenderPassContents contents)
+{
+    if (m_isSecondary)
+        ValidationError("BeginRenderPass() in a secondary command list");
+    else if (state != CommandListState_Null::IN_RECORDING)
+        ValidationError("BeginRenderPass() must be called in recording state");
+    if (renderPassInfo.numColorAttachments > MAX_COLOR_ATTHACHEMNT_NUM)
+        ValidationError("BeginRenderPass() with too many color attachments");
+
+    for (uint32_t i = 0; i < std::min<uint32_t>(renderPassInfo.numColorAttachments, MAX_COLOR_ATTHACHEMNT_NUM); i++)
+    {
+        const Image* image = frameBufferInfo.colorAttachments[i];
+        if (image == nullptr)
+            ValidationError("BeginRenderPass() color attachment is missing");
+        else if (image->GetDesc().format != renderPassInfo.colorAttachmentFormats[i])
+            ValidationError("BeginRenderPass() color attachment format differs from the render pass");
+        else if ((image->GetDesc().usageBits & IMAGE_USAGE_COLOR_ATTACHMENT_BIT) == 0)
+            ValidationError("BeginRenderPass() color attachment without IMAGE_USAGE_COLOR_ATTACHMENT_BIT");
+    }
+
+    if (frameBufferInfo.depthAttachment != nullptr)
+    {
+        if (frameBufferInfo.depthAttachment->GetDesc().format != renderPassInfo.depthAttachmentFormat)
+            ValidationError("BeginRenderPass() depth attachment format differs from the render pass");
+        else if ((frameBufferInfo.depthAttachment->GetDesc().usageBits & IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) == 0)
+            ValidationError("BeginRenderPass() depth attachment without IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT");
+    }
+    else if (renderPassInfo.depthAttachmentFormat != DataFormat::UNDEFINED)
+    {
+        ValidationError("BeginRenderPass() depth attachment is missing");
+    }
+
+    // same as the Vulkan backend, nothing bound before the render pass is kept
+    state = CommandListState_Null::IN_RENDERPASS;
+    m_currentRenderPassInfo = renderPassInfo;
+    m_currentRenderPassHash = renderPassInfo.GetHash();
+    m_currentRenderPassContents = contents;
+    m_currentPipeline = nullptr;
+    m_bindingState = {};
+    m_stats.renderPasses++;
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::BEGIN_RENDER_PASS);
+        Write(renderPassInfo);
+        Write(frameBufferInfo);
+        Write(contents);
+    }
+}
+
+void CommandList_Null::EndRenderPass()
+{
+    if (m_isSecondary)
+        ValidationError("EndRenderPass() in a secondary command list");
+    else if (state != CommandListState_Null::IN_RENDERPASS)
+        ValidationError("You must call BeginRenderPass() before calling EndRenderPass()");
+    state = CommandListState_Null::IN_RECORDING;
+    m_currentRenderPassContents = RenderPassContents::INLINE;
+
+    if (m_recordCommands)
+        Write(CommandOp_Null::END_RENDER_PASS);
+}
+
+void CommandList_Null::ExecuteSecondaryCommandLists(CommandList* const* cmds, uint32_t count)
+{
+    if (state != CommandListState_Null::IN_RENDERPASS || m_currentRenderPassContents != RenderPassContents::SECONDARY_COMMAND_LISTS)
+        ValidationError("ExecuteSecondaryCommandLists() outside of a render pass begun with RenderPassContents::SECONDARY_COMMAND_LISTS");
+
+    if (m_recordCommands)
+    {
+        Write(CommandOp_Null::EXECUTE_SECONDARY_COMMAND_LISTS);
+        Write(count);
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        auto& secondary = *static_cast<CommandList_Null*>(cmds[i]);
+        if (!secondary.m_isSecondary)
+            ValidationError("ExecuteSecondaryCommandLists() with a primary command list");
+        else if (secondary.state != CommandListState_Null::IN_RENDERPASS)
+            ValidationError("ExecuteSecondaryCommandLists() with a secondary command list executed already");
+        else if (secondary.m_currentRenderPassHash != m_currentRenderPassHash)
+            ValidationError("ExecuteSecondaryCommandLists() with a secondary command list begun for another render pass");
+        secondary.state = CommandListState_Null::READY_FOR_SUBMIT;
+
+        // what the secondaries did is submitted with this list
+        m_stats.Add(secondary.m_stats);
+
+        if (m_recordCommands)
+        {
+            Write((uint64_t)secondary.m_commands.size());
+            WriteBytes(secondary.m_commands.data(), secondary.m_commands.size());
+        }
+    }
+}
+
+class CommandReader_Null {
+public:
+    CommandReader_Null(const std::vector<byte>& commands) : m_commands(commands) {}
+
+    bool IsEnd() const { return m_pos == m_commands.size(); }
+
+    template<typename T>
+    bool Read(T& value)
+    {
+        if (m_commands.size() - m_pos < sizeof(T))
+            return false;
+        memcpy(&value, m_commands.data() + m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+    }
+
+    template<typename T>
+    bool ReadArray(std::vector<T>& values, uint32_t count)
+    {
+        if ((m_commands.size() - m_pos) / sizeof(T) < count)
+            return false;
+        values.resize(count);
+        memcpy(values.data(), m_commands.data() + m_pos, count * sizeof(T));
+        m_pos += count * sizeof(T);
+        return true;
+    }
+
+private:
+    const std::vector<byte>& m_commands;
+    size_t m_pos = 0;
+};
+
+bool ReplayCommands_Null(const std::vector<byte>& commands, Device& device, CommandList& cmd)
+{
+    CommandReader_Null reader(commands);
+    std::vector<byte> pushConstantData;
+    std::vector<PipelineMemoryBarrier> memoryBarriers;
+    std::vector<PipelineImageBarrier> imageBarriers;
+    std::vector<PipelineBufferBarrier> bufferBarriers;
+
+    while (!reader.IsEnd())
+    {
+        CommandOp_Null op;
+        if (!reader.Read(op))
+            return false;
+
+        switch (op)
+        {
+        case CommandOp_Null::PUSH_CONSTANT:
+        {
+            uint32_t offset, size;
+            if (!reader.Read(offset) || !reader.Read(size) || !reader.ReadArray(pushConstantData, size))
+                return false;
+            cmd.PushConstant(pushConstantData.data(), offset, size);
+            break;
+        }
+        case CommandOp_Null::BIND_PIPELINE:
+        {
+            const PipeLine* pipeline;
+            if (!reader.Read(pipeline))
+                return false;
+            cmd.BindPipeLine(*pipeline);
+            break;
+        }
+        case CommandOp_Null::BIND_UNIFORM_BUFFER:
+        case CommandOp_Null::BIND_STORAGE_BUFFER:
+        {
+            BufferBindCommand c;
+            if (!reader.Read(c))
+                return false;
+            if (op == CommandOp_Null::BIND_UNIFORM_BUFFER)
+                cmd.BindUniformBuffer(c.set, c.binding, *c.buffer, c.offset, c.size);
+            else
+                cmd.BindStorageBuffer(c.set, c.binding, *c.buffer, c.offset, c.size);
+            break;
+        }
+        case CommandOp_Null::BIND_IMAGE:
+        {
+            ImageBindCommand c;
+            if (!reader.Read(c))
+                return false;
+            cmd.BindImage(c.set, c.binding, *c.image, c.layout);
+            break;
+        }
+        case CommandOp_Null::BIND_SAMPLER:
+        {
+            SamplerBindCommand c;
+            if (!reader.Read(c))
+                return false;
+            cmd.BindSampler(c.set, c.binding, *c.sampler);
+            break;
+        }
+        case CommandOp_Null::BIND_BINDLESS_IMAGES:
+        {
+            uint32_t set;
+            if (!reader.Read(set))
+                return false;
+            cmd.BindBindlessImages(set);
+            break;
+        }
+        case CommandOp_Null::BIND_VERTEX_BUFFER:
+        {
+            VertexBufferBindCommand c;
+            if (!reader.Read(c))
+                return false;
+            cmd.BindVertexBuffer(c.binding, *c.buffer, c.offset);
+            break;
+        }
+        case CommandOp_Null::BIND_INDEX_BUFFER:
+        {
+            IndexBufferBindCommand c;
+            if (!reader.Read(c))
+                return false;
+            cmd.BindIndexBuffer(*c.buffer, c.offset, c.format);
+            break;
+        }
+        case CommandOp_Null::COPY_IMAGE_TO_BUFFER:
+        {
+            CopyImageToBufferCommand c;
+            if (!reader.Read(c))
+                return false;
+            ImageSubresourceRange subresource;
+            subresource.aspect = (ImageAspect)c.aspect;
+            subresource.mipLevel = c.mipLevel;
+            subresource.baseArrayLayer = c.baseArrayLayer;
+            subresource.layerCount = c.layerCount;
+            cmd.CopyImageToBuffer(*c.buffer, *c.image, c.bufferOffset, c.offset, c.extent, c.rowPitch, c.slicePitch, subresource);
+            break;
+        }
+        case CommandOp_Null::DRAW:
+        {
+            DrawCommand c;
+            if (!reader.Read(c))
+                return false;
+            cmd.Draw(c.vertexCount, c.instanceCount, c.firstVertex, c.firstInstance);
+            break;
+        }
+        case CommandOp_Null::DRAW_INDEXED:
+        {
+            DrawIndexedCommand c;
+            if (!reader.Read(c))
+                return false;
+            cmd.DrawIndexed(c.indexCount, c.instanceCount, c.firstIndex, c.vertexOffset, c.firstInstance);
+            break;
+        }
+        case CommandOp_Null::SET_VIEWPORT:
+        {
+            Viewport viewport;
+            if (!reader.Read(viewport))
+                return false;
+            cmd.SetViewPort(viewport);
+            break;
+        }
+        case CommandOp_Null::SET_SCISSOR:
+        {
+            Scissor scissor;
+            if (!reader.Read(scissor))
+                return false;
+            cmd.SetScissor(scissor);
+            break;
+        }
+        case CommandOp_Null::PIPELINE_BARRIERS:
+        {
+            BarriersCommand c;
+            if (!reader.Read(c) || !reader.ReadArray(memoryBarriers, c.memoryBarriersCount) ||
+                !reader.ReadArray(imageBarriers, c.imageBarriersCount) || !reader.ReadArray(bufferBarriers, c.bufferBarriersCount))
+                return false;
+            cmd.PipeLineBarriers(c.memoryBarriersCount ? memoryBarriers.data() : nullptr, c.memoryBarriersCount,
+                c.imageBarriersCount ? imageBarriers.data() : nullptr, c.imageBarriersCount,
+                c.bufferBarriersCount ? bufferBarriers.data() : nullptr, c.bufferBarriersCount);
+            break;
+        }
+        case CommandOp_Null::BEGIN_RENDER_PASS:
+        {
+            RenderPassInfo2 renderPassInfo;
+            FrameBufferInfo frameBufferInfo;
+            RenderPassContents contents;
+            if (!reader.Read(renderPassInfo) || !reader.Read(frameBufferInfo) || !reader.Read(contents))
+                return false;
+            cmd.BeginRenderPass(renderPassInfo, frameBufferInfo, contents);
+            break;
+        }
+        case CommandOp_Null::EXECUTE_SECONDARY_COMMAND_LISTS:
+        {
+            uint32_t count;
+            if (!reader.Read(count))
+                return false;
+
+            std::vector<CommandList*> secondaries;
+            std::vector<byte> secondaryCommands;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                uint64_t size;
+                if (!reader.Read(size) || size > UINT32_MAX || !reader.ReadArray(secondaryCommands, (uint32_t)size))
+                    return false;
+
+                CommandList* secondary = device.BeginSecondaryCommandList(cmd);
+                if (!ReplayCommands_Null(secondaryCommands, device, *secondary))
+                    return false;
+                secondaries.push_back(secondary);
+            }
+            cmd.ExecuteSecondaryCommandLists(secondaries.data(), count);
+            break;
+        }
+        case CommandOp_Null::END_RENDER_PASS:
+            cmd.EndRenderPass();
+            break;
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}
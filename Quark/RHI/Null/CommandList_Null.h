@@ -0,0 +1,167 @@
+#pragma once
+#include "Quark/RHI/CommandList.h"
+#include "Quark/RHI/RenderPassInfo.h"
+#include "Quark/RHI/Null/Common_Null.h"
+
+namespace quark::rhi {
+
+// What a command list was asked to do. Binds are counted when they are issued, redundant pipeline binds are the
+// ones that bind the pipeline which is already bound. Descriptor set flushes are the sets a draw finds changed since
+// the last draw, each is a descriptor set the Vulkan backend looks up or writes before drawing.
+struct CommandStats_Null
+{
+    uint32_t renderPasses = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t redundantPipelineBinds = 0;
+    uint32_t uniformBufferBinds = 0;
+    uint32_t storageBufferBinds = 0;
+    uint32_t imageBinds = 0;
+    uint32_t samplerBinds = 0;
+    uint32_t bindlessImageBinds = 0;
+    uint32_t descriptorSetFlushes = 0;
+    uint32_t vertexBufferBinds = 0;
+    uint32_t indexBufferBinds = 0;
+    uint32_t pushConstants = 0;
+    uint32_t viewports = 0;
+    uint32_t scissors = 0;
+    uint32_t barriers = 0;
+    uint32_t draws = 0;
+    uint32_t indexedDraws = 0;
+    uint64_t vertices = 0;
+    uint64_t indices = 0;
+    uint64_t instances = 0;
+    uint32_t validationErrors = 0;
+
+    uint32_t GetStateChanges() const
+    {
+        return pipelineBinds + uniformBufferBinds + storageBufferBinds + imageBinds + samplerBinds + bindlessImageBinds +
+            vertexBufferBinds + indexBufferBinds + pushConstants + viewports + scissors;
+    }
+
+    void Add(const CommandStats_Null& other);
+};
+
+enum class CommandListState_Null {
+    READY_FOR_RECORDING,
+    IN_RECORDING,
+    IN_RENDERPASS,
+    READY_FOR_SUBMIT,
+};
+
+// Validates and counts commands instead of executing them, and optionally records them into a binary stream.
+// Draws are checked against the state the Vulkan backend would flush for them: a render pass, a pipeline made
+// for that render pass, the vertex buffers of its input layout and, for indexed draws, an index buffer holding
+// the indices read. A failed check is logged and counted in validationErrors, the command still counts.
+class CommandList_Null final : public CommandList {
+public:
+    CommandListState_Null state = CommandListState_Null::READY_FOR_RECORDING;
+
+    CommandList_Null(Device_Null* device, QueueType type);
+    ~CommandList_Null() = default;
+
+    void PushConstant(const void* data, uint32_t offset, uint32_t size) override final;
+    void BindPipeLine(const PipeLine& pipeline) override final;
+    void BindUniformBuffer(uint32_t set, uint32_t binding, const Buffer& buffer, uint64_t offset, uint64_t size) override final;
+    void BindStorageBuffer(uint32_t set, uint32_t binding, const Buffer& buffer, uint64_t offset, uint64_t size) override final;
+    void BindImage(uint32_t set, uint32_t binding, const Image& image, ImageLayout layout) override final;
+    void BindVertexBuffer(uint32_t binding, const Buffer& buffer, uint64_t offset) override final;
+    void BindIndexBuffer(const Buffer& buffer, uint64_t offset, const IndexBufferFormat format) override final;
+    void BindSampler(uint32_t set, uint32_t binding, const Sampler& sampler) override final;
+    void BindBindlessImages(uint32_t set) override final;
+
+    void CopyImageToBuffer(const Buffer& buffer, const Image& image, uint64_t buffer_offset, const Offset3D& offset, const Extent3D& extent, uint32_t row_pitch, uint32_t slice_pitch, const ImageSubresourceRange& subresouce) override final;
+
+    void Draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance) override final;
+    void DrawIndexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, uint32_t vertex_offset, uint32_t first_instance) override final;
+
+    void SetViewPort(const Viewport& viewport) override final;
+    void SetScissor(const Scissor& scissor) override final;
+
+    void PipeLineBarriers(const PipelineMemoryBarrier* memoryBarriers, uint32_t memoryBarriersCount, const PipelineImageBarrier* imageBarriers, uint32_t imageBarriersCount, const PipelineBufferBarrier* bufferBarriers, uint32_t bufferBarriersCount) override final;
+
+    void BeginRenderPass(const RenderPassInfo2& renderPassInfo, const FrameBufferInfo& frameBufferInfo, RenderPassContents contents = RenderPassContents::INLINE) override final;
+    void EndRenderPass() override final;
+
+    void ExecuteSecondaryCommandLists(CommandList* const* cmds, uint32_t count) override final;
+
+    const RenderPassInfo2& GetCurrentRenderPassInfo() const override final { return m_currentRenderPassInfo; }
+    const PipeLine* GetCurrentGraphicsPipeline() const override final { return m_currentPipeline; }
+
+    ///////////////////////// Null specific /////////////////////////
+
+    void Reset(bool recordCommands);
+    // Starts recording a secondary list inside the render pass the primary is in
+    void ResetSecondary(const CommandList_Null& primary, bool recordCommands);
+    bool IsSecondary() const { return m_isSecondary; }
+    const CommandStats_Null& GetStats() const { return m_stats; }
+    const std::vector<byte>& GetRecordedCommands() const { return m_commands; }
+
+private:
+    void ValidationError(const char* message);
+    bool ValidateDraw();
+    // marks the set dirty, out of range sets and bindings are only reported
+    void SetDescriptor(uint32_t set, uint32_t binding, const void* resource, uint64_t offset, uint64_t range);
+    void SetDescriptorSampler(uint32_t set, uint32_t binding, const Sampler* sampler);
+
+    template<typename T>
+    void Write(const T& value)
+    {
+        const byte* bytes = reinterpret_cast<const byte*>(&value);
+        m_commands.insert(m_commands.end(), bytes, bytes + sizeof(T));
+    }
+
+    template<typename T>
+    void WriteCommand(const T& command)
+    {
+        static_assert(std::has_unique_object_representations_v<T>, "Recorded commands must not have padding");
+        Write(command);
+    }
+
+    void WriteBytes(const void* data, size_t size)
+    {
+        const byte* bytes = static_cast<const byte*>(data);
+        m_commands.insert(m_commands.end(), bytes, bytes + size);
+    }
+
+private:
+    struct BindingState
+    {
+        const Buffer* vertexBuffers[VERTEX_BUFFER_MAX_NUM] = {};
+        uint64_t vertexBufferOffsets[VERTEX_BUFFER_MAX_NUM] = {};
+        const Buffer* indexBuffer = nullptr;
+        uint64_t indexBufferOffset = 0;
+        IndexBufferFormat indexBufferFormat = IndexBufferFormat::UINT32;
+    };
+
+    // what a flushed descriptor set is written with, an image and its sampler share the binding
+    struct Descriptor
+    {
+        const void* resource = nullptr; // buffer or image
+        const Sampler* sampler = nullptr;
+        uint64_t offset = 0;            // the layout of an image
+        uint64_t range = 0;
+    };
+
+    Device_Null* m_device;
+    bool m_isSecondary = false;
+
+    const PipeLine_Null* m_currentPipeline = nullptr;
+    RenderPassInfo2 m_currentRenderPassInfo = {};
+    uint64_t m_currentRenderPassHash = 0;
+    RenderPassContents m_currentRenderPassContents = RenderPassContents::INLINE;
+    BindingState m_bindingState = {};
+    Descriptor m_descriptors[DESCRIPTOR_SET_MAX_NUM][SET_BINDINGS_MAX_NUM] = {};
+    uint32_t m_dirtySetMask = 0;
+
+    CommandStats_Null m_stats = {};
+    bool m_recordCommands = false;
+    std::vector<byte> m_commands;
+};
+
+// Issues the commands of a stream recorded by CommandList_Null on another command list, of any backend. Executed
+// secondary command lists are recorded again in secondary lists begun from device.
+// Resources are recorded by address, so a stream can only be replayed while everything it references is alive.
+// Returns false if the stream is malformed, commands before the malformed one have been issued already.
+bool ReplayCommands_Null(const std::vector<byte>& commands, Device& device, CommandList& cmd);
+
+}
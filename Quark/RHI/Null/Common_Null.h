@@ -0,0 +1,67 @@
+#pragma once
+#include "Quark/RHI/Buffer.h"
+#include "Quark/RHI/Image.h"
+#include "Quark/RHI/Shader.h"
+#include "Quark/RHI/PipeLine.h"
+
+namespace quark::rhi {
+
+class Device_Null;
+class CommandList_Null;
+
+#define CONVERT_TO_NULL_INTERNAL_FUNC(x_) \
+    inline x_##_Null& ToInternal_Null(x_* ptr) { return *static_cast<x_##_Null*>(ptr);} \
+    inline const x_##_Null& ToInternal_Null(const x_* ptr) {return *static_cast<const x_##_Null*>(ptr);}\
+
+// The null backend keeps buffer contents in system memory so that everything the renderer writes to a buffer
+// can still be read back and checked. Images, shaders and samplers are only their descriptions.
+class Buffer_Null final : public Buffer {
+public:
+    Buffer_Null(const BufferDesc& desc, const void* init_data = nullptr)
+        : Buffer(desc), m_data(desc.size)
+    {
+        if (init_data)
+            memcpy(m_data.data(), init_data, desc.size);
+
+        if (desc.domain == BufferMemoryDomain::CPU)
+            m_pMappedData = m_data.data();
+    }
+
+    byte* GetData() { return m_data.data(); }
+    const byte* GetData() const { return m_data.data(); }
+
+private:
+    std::vector<byte> m_data;
+};
+
+class Image_Null final : public Image {
+public:
+    Image_Null(const ImageDesc& desc) : Image(desc) {}
+};
+
+class Shader_Null final : public Shader {
+public:
+    Shader_Null(ShaderStage stage) : Shader(stage) {}
+};
+
+class Sampler_Null final : public Sampler {
+public:
+    Sampler_Null(const SamplerDesc& desc) : Sampler(desc) {}
+};
+
+class PipeLine_Null final : public PipeLine {
+public:
+    PipeLine_Null(const GraphicPipeLineDesc& desc)
+        : PipeLine(PipeLineBindingPoint::GRAPHIC), m_desc(desc), m_renderPassHash(desc.renderPassInfo.GetHash()) {}
+
+    const GraphicPipeLineDesc& GetDesc() const { return m_desc; }
+    uint64_t GetRenderPassHash() const { return m_renderPassHash; }
+
+private:
+    GraphicPipeLineDesc m_desc;
+    uint64_t m_renderPassHash;
+};
+
+CONVERT_TO_NULL_INTERNAL_FUNC(Buffer)
+CONVERT_TO_NULL_INTERNAL_FUNC(PipeLine)
+}
@@ -0,0 +1,292 @@
+#include "Quark/qkpch.h"
+#include "Quark/RHI/Null/Device_Null.h"
+
+namespace quark::rhi {
+
+Device_Null::Device_Null(uint32_t width, uint32_t height)
+{
+    m_frameBufferWidth = width;
+    m_frameBufferHeight = height;
+}
+
+bool Device_Null::Init()
+{
+    // the largest alignment Vulkan allows a driver to ask for, offsets that pass here pass on any driver
+    m_properties.limits.minUniformBufferOffsetAlignment = 256;
+    m_properties.limits.minStorageBufferOffsetAlignment = 256;
+    m_features.textureCompressionBC = true;
+    m_features.textureCompressionASTC_LDR = true;
+    m_features.textureCompressionETC2 = true;
+    m_features.bindlessImages = true;
+
+    m_elapsedFrame = 0;
+    m_frameStats = {};
+    m_totalStats = {};
+    m_descriptorSets.clear();
+    m_vacantDescriptorSets = 0;
+    m_descriptorSetStats = {};
+    for (PerFrameData& frame : m_frames)
+        frame.dataAllocator.Init(this, 256);
+    CreatePresentImage();
+
+    QK_CORE_LOGI_TAG("RHI", "Null device initialized: {}x{}", m_frameBufferWidth, m_frameBufferHeight);
+    return true;
+}
+
+void Device_Null::ShutDown()
+{
+    for (PerFrameData& frame : m_frames)
+    {
+        for (auto& cmdLists : frame.cmdLists)
+            cmdLists.clear();
+        frame.secondaryCmdLists.clear();
+        frame.dataAllocator.Destroy();
+        frame.unregisteredBindlessImages.clear();
+    }
+
+    m_bindlessImages.clear();
+    m_freeBindlessImages.clear();
+
+    m_presentImage.reset();
+    m_recordedCommands.clear();
+}
+
+bool Device_Null::BeiginFrame(TimeStep ts)
+{
+    PerFrameData& frame = GetCurrentFrame();
+    for (u32& count : frame.cmdListCount)
+        count = 0;
+    frame.submittedCmdListCount = 0;
+    frame.secondaryCmdListCount = 0;
+    frame.dataAllocator.Reset();
+    {
+        std::lock_guard<std::mutex> lock(m_bindlessLock);
+        m_freeBindlessImages.insert(m_freeBindlessImages.end(), frame.unregisteredBindlessImages.begin(), frame.unregisteredBindlessImages.end());
+        frame.unregisteredBindlessImages.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_descriptorSetLock);
+        m_vacantDescriptorSets += std::erase_if(m_descriptorSets, [&](const auto& set)
+            { return m_elapsedFrame - set.second >= DESCRIPTOR_SET_RING_SIZE; });
+    }
+
+    m_frameStats = {};
+    return true;
+}
+
+bool Device_Null::EndFrame(TimeStep ts)
+{
+    PerFrameData& frame = GetCurrentFrame();
+    u32 begun = 0;
+    for (u32 count : frame.cmdListCount)
+        begun += count;
+
+    if (begun != frame.submittedCmdListCount)
+    {
+        QK_CORE_LOGE_TAG("RHI", "Device_Null: {} command lists begun in this frame were never submitted", begun - frame.submittedCmdListCount);
+        m_frameStats.validationErrors++;
+        m_totalStats.validationErrors++;
+    }
+
+    u32 not_executed = 0;
+    for (u32 i = 0; i < frame.secondaryCmdListCount; i++)
+    {
+        if (frame.secondaryCmdLists[i]->state != CommandListState_Null::READY_FOR_SUBMIT)
+            not_executed++;
+    }
+
+    if (not_executed > 0)
+    {
+        QK_CORE_LOGE_TAG("RHI", "Device_Null: {} secondary command lists begun in this frame were never executed", not_executed);
+        m_frameStats.validationErrors++;
+        m_totalStats.validationErrors++;
+    }
+
+    m_elapsedFrame++;
+    return true;
+}
+
+DescriptorSetStats Device_Null::GetDescriptorSetStats()
+{
+    std::lock_guard<std::mutex> lock(m_descriptorSetLock);
+    return m_descriptorSetStats;
+}
+
+void Device_Null::RequestDescriptorSet(util::Hash contents)
+{
+    std::lock_guard<std::mutex> lock(m_descriptorSetLock);
+    auto [it, inserted] = m_descriptorSets.try_emplace(contents, m_elapsedFrame);
+    it->second = m_elapsedFrame;
+    if (!inserted)
+    {
+        m_descriptorSetStats.hits++;
+        return;
+    }
+
+    // a miss writes a vacant set, or allocates one if none is vacant
+    m_descriptorSetStats.misses++;
+    m_descriptorSetStats.descriptorUpdates++;
+    if (m_vacantDescriptorSets > 0)
+    {
+        m_vacantDescriptorSets--;
+        m_descriptorSetStats.vacantReuses++;
+    }
+    else
+    {
+        m_descriptorSetStats.allocatedSets++;
+    }
+}
+
+void Device_Null::OnWindowResize(const WindowResizeEvent& event)
+{
+    m_frameBufferWidth = event.width;
+    m_frameBufferHeight = event.height;
+    CreatePresentImage();
+}
+
+void Device_Null::CreatePresentImage()
+{
+    ImageDesc desc;
+    desc.width = m_frameBufferWidth;
+    desc.height = m_frameBufferHeight;
+    desc.format = GetPresentImageFormat();
+    desc.usageBits = IMAGE_USAGE_COLOR_ATTACHMENT_BIT | IMAGE_USAGE_CAN_COPY_FROM_BIT;
+    m_presentImage = CreateRef<Image_Null>(desc);
+}
+
+Ref<Buffer> Device_Null::CreateBuffer(const BufferDesc& desc, const void* initialData)
+{
+    QK_CORE_VERIFY(desc.size > 0, "Device_Null::CreateBuffer: size must not be zero")
+    return CreateRef<Buffer_Null>(desc, initialData);
+}
+
+Ref<Image> Device_Null::CreateImage(const ImageDesc& desc, const ImageInitData* init_data)
+{
+    QK_CORE_VERIFY(desc.width > 0 && desc.height > 0 && desc.depth > 0, "Device_Null::CreateImage: extent must not be zero")
+    QK_CORE_VERIFY(isFormatSupported(desc.format))
+    return CreateRef<Image_Null>(desc);
+}
+
+Ref<Shader> Device_Null::CreateShaderFromBytes(ShaderStage stage, const void* byteCode, size_t codeSize)
+{
+    QK_CORE_VERIFY(byteCode != nullptr && codeSize > 0)
+    return CreateRef<Shader_Null>(stage);
+}
+
+Ref<Shader> Device_Null::CreateShaderFromSpvFile(ShaderStage stage, const std::string& file_path)
+{
+    return CreateRef<Shader_Null>(stage);
+}
+
+Ref<PipeLine> Device_Null::CreateGraphicPipeLine(const GraphicPipeLineDesc& desc)
+{
+    QK_CORE_VERIFY(desc.vertShader && desc.vertShader->GetStage() == ShaderStage::STAGE_VERTEX)
+    QK_CORE_VERIFY(desc.fragShader && desc.fragShader->GetStage() == ShaderStage::STAGE_FRAGEMNT)
+    return CreateRef<PipeLine_Null>(desc);
+}
+
+Ref<Sampler> Device_Null::CreateSampler(const SamplerDesc& desc)
+{
+    return CreateRef<Sampler_Null>(desc);
+}
+
+void Device_Null::CopyBuffer(Buffer& dst, const Ref<Buffer>& src, uint64_t size, uint64_t dstOffset, uint64_t srcOffset)
+{
+    QK_CORE_VERIFY(dstOffset + size <= dst.GetDesc().size && srcOffset + size <= src->GetDesc().size)
+    memcpy(ToInternal_Null(&dst).GetData() + dstOffset, ToInternal_Null(src.get()).GetData() + srcOffset, size);
+}
+
+FrameAllocation Device_Null::AllocateFrameData(u64 size)
+{
+    QK_CORE_VERIFY(size > 0, "Device_Null::AllocateFrameData: size must not be zero")
+    return GetCurrentFrame().dataAllocator.Allocate(size);
+}
+
+uint32_t Device_Null::RegisterBindlessImage(const Image& image, const Sampler& sampler)
+{
+    QK_CORE_VERIFY(image.GetDesc().usageBits & IMAGE_USAGE_SAMPLING_BIT, "Device_Null::RegisterBindlessImage: image without IMAGE_USAGE_SAMPLING_BIT")
+
+    std::lock_guard<std::mutex> lock(m_bindlessLock);
+    uint32_t index = (uint32_t)m_bindlessImages.size();
+    if (!m_freeBindlessImages.empty())
+    {
+        index = m_freeBindlessImages.back();
+        m_freeBindlessImages.pop_back();
+        m_bindlessImages[index] = &image;
+    }
+    else
+    {
+        QK_CORE_VERIFY(index < BINDLESS_IMAGE_MAX_NUM, "Device_Null::RegisterBindlessImage: more than BINDLESS_IMAGE_MAX_NUM images")
+        m_bindlessImages.push_back(&image);
+    }
+
+    return index;
+}
+
+void Device_Null::UnregisterBindlessImage(uint32_t index)
+{
+    std::lock_guard<std::mutex> lock(m_bindlessLock);
+    QK_CORE_VERIFY(index < m_bindlessImages.size() && m_bindlessImages[index] != nullptr, "Device_Null::UnregisterBindlessImage: index is not registered")
+    m_bindlessImages[index] = nullptr;
+    GetCurrentFrame().unregisteredBindlessImages.push_back(index);
+}
+
+CommandList* Device_Null::BeginCommandList(QueueType type)
+{
+    std::lock_guard<std::mutex> lock(m_cmdListLock);
+
+    auto& frame = GetCurrentFrame();
+    auto& cmdLists = frame.cmdLists[type];
+    u32 cmd_count = frame.cmdListCount[type]++;
+    if (cmd_count >= cmdLists.size())
+        cmdLists.emplace_back(CreateScope<CommandList_Null>(this, type));
+
+    CommandList_Null* internal_cmdList = cmdLists[cmd_count].get();
+    internal_cmdList->Reset(m_recordCommands);
+
+    return internal_cmdList;
+}
+
+CommandList* Device_Null::BeginSecondaryCommandList(const CommandList& primary)
+{
+    CommandList_Null* internal_cmdList = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_cmdListLock);
+
+        auto& frame = GetCurrentFrame();
+        u32 cmd_count = frame.secondaryCmdListCount++;
+        if (cmd_count >= frame.secondaryCmdLists.size())
+            frame.secondaryCmdLists.emplace_back(CreateScope<CommandList_Null>(this, QUEUE_TYPE_GRAPHICS));
+
+        internal_cmdList = frame.secondaryCmdLists[cmd_count].get();
+    }
+
+    internal_cmdList->ResetSecondary(*static_cast<const CommandList_Null*>(&primary), m_recordCommands);
+    return internal_cmdList;
+}
+
+void Device_Null::SubmitCommandList(CommandList* cmd, CommandList* waitedCmds, uint32_t waitedCmdCounts, bool signal)
+{
+    auto& internal_cmdList = *static_cast<CommandList_Null*>(cmd);
+    if (internal_cmdList.IsSecondary())
+        QK_CORE_LOGE_TAG("RHI", "Device_Null: secondary command list submitted, it must be executed by its primary");
+    else if (internal_cmdList.state == CommandListState_Null::IN_RENDERPASS)
+        QK_CORE_LOGE_TAG("RHI", "Device_Null: command list submitted inside a render pass");
+    else if (internal_cmdList.state != CommandListState_Null::IN_RECORDING)
+        QK_CORE_LOGE_TAG("RHI", "Device_Null: command list submitted twice");
+
+    CommandStats_Null stats = internal_cmdList.GetStats();
+    if (internal_cmdList.IsSecondary() || internal_cmdList.state != CommandListState_Null::IN_RECORDING)
+        stats.validationErrors++;
+    internal_cmdList.state = CommandListState_Null::READY_FOR_SUBMIT;
+
+    std::lock_guard<std::mutex> lock(m_cmdListLock);
+    GetCurrentFrame().submittedCmdListCount++;
+    m_frameStats.Add(stats);
+    m_totalStats.Add(stats);
+
+    const std::vector<byte>& commands = internal_cmdList.GetRecordedCommands();
+    m_recordedCommands.insert(m_recordedCommands.end(), commands.begin(), commands.end());
+}
+
+}
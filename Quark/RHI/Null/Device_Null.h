@@ -0,0 +1,104 @@
+#pragma once
+#include "Quark/Core/Util/Hash.h"
+#include "Quark/RHI/Device.h"
+#include "Quark/RHI/Null/Common_Null.h"
+#include "Quark/RHI/Null/CommandList_Null.h"
+
+namespace quark::rhi {
+
+// A device without a GPU. Everything the renderer records is validated and counted by CommandList_Null, which
+// makes the CPU side of rendering runnable, profileable and testable on machines without a Vulkan driver.
+class Device_Null final : public Device {
+public:
+    // as the Vulkan backend's DescriptorSetAllocator, a cached set not requested for this many frames becomes vacant
+    static constexpr uint32_t DESCRIPTOR_SET_RING_SIZE = 8;
+
+    struct PerFrameData {
+        std::vector<Scope<CommandList_Null>> cmdLists[QUEUE_TYPE_MAX_ENUM];
+        u32 cmdListCount[QUEUE_TYPE_MAX_ENUM] = {}; //  The count of cmd used in this frame. Cleared when a new frame begin
+        u32 submittedCmdListCount = 0;
+        std::vector<Scope<CommandList_Null>> secondaryCmdLists;
+        u32 secondaryCmdListCount = 0;
+        FrameDataAllocator dataAllocator;
+        std::vector<uint32_t> unregisteredBindlessImages;  // free again once this frame slot comes round
+    };
+
+public:
+    Device_Null(uint32_t width = 1280, uint32_t height = 720);
+    ~Device_Null() = default;
+
+    bool Init() override final;
+    void ShutDown() override final;
+    bool BeiginFrame(TimeStep ts) override final;
+    bool EndFrame(TimeStep ts) override final;
+    void OnWindowResize(const WindowResizeEvent& event) override final;
+
+    /*** RESOURCES ***/
+    Ref<Buffer> CreateBuffer(const BufferDesc& desc, const void* initialData = nullptr) override final;
+    Ref<Image> CreateImage(const ImageDesc& desc, const ImageInitData* init_data = nullptr) override final;
+    Ref<Shader> CreateShaderFromBytes(ShaderStage stage, const void* byteCode, size_t codeSize) override final;
+    Ref<Shader> CreateShaderFromSpvFile(ShaderStage stage, const std::string& file_path) override final;
+    Ref<PipeLine> CreateGraphicPipeLine(const GraphicPipeLineDesc& desc) override final;
+    Ref<Sampler> CreateSampler(const SamplerDesc& desc) override final;
+
+    void CopyBuffer(Buffer& dst, const Ref<Buffer>& src, uint64_t size, uint64_t dstOffset = 0, uint64_t srcOffset = 0) override final;
+    FrameAllocation AllocateFrameData(u64 size) override final;
+
+    /*** BINDLESS ***/
+    uint32_t RegisterBindlessImage(const Image& image, const Sampler& sampler) override final;
+    void UnregisterBindlessImage(uint32_t index) override final;
+
+    /*** COMMAND LIST ***/
+    CommandList* BeginCommandList(QueueType type = QueueType::QUEUE_TYPE_GRAPHICS) override final;
+    void SubmitCommandList(CommandList* cmd, CommandList* waitedCmds = nullptr, uint32_t waitedCmdCounts = 0, bool signal = false) override final;
+    CommandList* BeginSecondaryCommandList(const CommandList& primary) override final;
+
+    Image* GetPresentImage() override final { return m_presentImage.get(); }
+    DataFormat GetPresentImageFormat() override final { return DataFormat::B8G8R8A8_UNORM; }
+
+    bool isFormatSupported(DataFormat format) override final { return format != DataFormat::UNDEFINED; }
+    void SetDebugName(const Ref<GpuResource>& resouce, const char* name) override final {}
+
+    DescriptorSetStats GetDescriptorSetStats() override final;
+
+    ///////////////////// Null specific ////////////////////////
+    //////////////////////////////////////////////////////////////
+
+    // Submitted command lists append what they recorded to the device's stream, in submission order
+    void SetRecordCommands(bool enable) { m_recordCommands = enable; }
+    std::vector<byte> TakeRecordedCommands() { return std::move(m_recordedCommands); }
+
+    // Stats of the command lists submitted in the current frame, and in all frames since Init()
+    const CommandStats_Null& GetFrameStats() const { return m_frameStats; }
+    const CommandStats_Null& GetTotalStats() const { return m_totalStats; }
+
+    PerFrameData& GetCurrentFrame() { return m_frames[m_elapsedFrame % MAX_FRAME_NUM_IN_FLIGHT]; }
+
+    // A draw flushes a set with these contents, counted the way the Vulkan backend's cache would find it.
+    // There are no pools, poolAllocations stays 0. Thread safe
+    void RequestDescriptorSet(util::Hash contents);
+
+private:
+    void CreatePresentImage();
+
+    PerFrameData m_frames[MAX_FRAME_NUM_IN_FLIGHT];
+    Ref<Image> m_presentImage;
+
+    std::mutex m_bindlessLock;
+    std::vector<const Image*> m_bindlessImages;
+    std::vector<uint32_t> m_freeBindlessImages;
+
+    std::mutex m_descriptorSetLock;
+    std::unordered_map<util::Hash, uint32_t> m_descriptorSets;  // contents to the frame they were last requested in
+    uint64_t m_vacantDescriptorSets = 0;
+    DescriptorSetStats m_descriptorSetStats;
+
+    // Command lists are begun and submitted from job threads
+    std::mutex m_cmdListLock;
+    bool m_recordCommands = false;
+    std::vector<byte> m_recordedCommands;
+    CommandStats_Null m_frameStats;
+    CommandStats_Null m_totalStats;
+};
+
+}
@@ -0,0 +1,129 @@
+#include "Quark/qkpch.h"
+#include "Quark/RHI/Vulkan/BindlessDescriptorTable.h"
+#include "Quark/RHI/Vulkan/Device_Vulkan.h"
+
+namespace quark::rhi {
+
+bool BindlessDescriptorTable::IsSupported(const VulkanContext& context)
+{
+    // The context enables every feature the physical device reports
+    const VkPhysicalDeviceVulkan12Features& features = context.features12;
+    const VkPhysicalDeviceVulkan12Properties& props = context.properties12;
+
+    return features.runtimeDescriptorArray &&
+        features.descriptorBindingPartiallyBound &&
+        features.descriptorBindingSampledImageUpdateAfterBind &&
+        features.descriptorBindingUpdateUnusedWhilePending &&
+        features.shaderSampledImageArrayNonUniformIndexing &&
+        props.maxPerStageDescriptorUpdateAfterBindSampledImages >= BINDLESS_IMAGE_MAX_NUM &&
+        props.maxPerStageDescriptorUpdateAfterBindSamplers >= BINDLESS_IMAGE_MAX_NUM &&
+        props.maxDescriptorSetUpdateAfterBindSampledImages >= BINDLESS_IMAGE_MAX_NUM &&
+        props.maxDescriptorSetUpdateAfterBindSamplers >= BINDLESS_IMAGE_MAX_NUM;
+}
+
+BindlessDescriptorTable::BindlessDescriptorTable(Device_Vulkan* device)
+    : m_Device(device)
+{
+    QK_CORE_ASSERT(m_Device != nullptr)
+
+    // Create descriptor set layout
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = BINDLESS_IMAGE_MAX_NUM;
+    binding.stageFlags = VK_SHADER_STAGE_ALL;
+
+    VkDescriptorBindingFlags binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO };
+    binding_flags_info.bindingCount = 1;
+    binding_flags_info.pBindingFlags = &binding_flags;
+
+    VkDescriptorSetLayoutCreateInfo layout_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    layout_info.pNext = &binding_flags_info;
+    layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layout_info.bindingCount = 1;
+    layout_info.pBindings = &binding;
+    VK_CHECK(vkCreateDescriptorSetLayout(m_Device->vkDevice, &layout_info, nullptr, &m_Layout))
+
+    // Create the pool and the only set allocated from it
+    VkDescriptorPoolSize pool_size = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BINDLESS_IMAGE_MAX_NUM };
+    VkDescriptorPoolCreateInfo pool_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 1;
+    pool_info.pPoolSizes = &pool_size;
+    VK_CHECK(vkCreateDescriptorPool(m_Device->vkDevice, &pool_info, nullptr, &m_Pool))
+
+    VkDescriptorSetAllocateInfo alloc_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    alloc_info.descriptorPool = m_Pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &m_Layout;
+    VK_CHECK(vkAllocateDescriptorSets(m_Device->vkDevice, &alloc_info, &m_Set))
+
+    QK_CORE_LOGI_TAG("RHI", "Bindless descriptor table created: {} images", BINDLESS_IMAGE_MAX_NUM);
+}
+
+BindlessDescriptorTable::~BindlessDescriptorTable()
+{
+    // the set is freed with its pool
+    vkDestroyDescriptorPool(m_Device->vkDevice, m_Pool, nullptr);
+    vkDestroyDescriptorSetLayout(m_Device->vkDevice, m_Layout, nullptr);
+}
+
+void BindlessDescriptorTable::BeginFrame(uint32_t frame_index)
+{
+    QK_CORE_ASSERT(frame_index < MAX_FRAME_NUM_IN_FLIGHT)
+
+    std::lock_guard<std::mutex> lock(m_Lock);
+    auto& pending = m_PendingFrees[frame_index];
+    m_FreeIndices.insert(m_FreeIndices.end(), pending.begin(), pending.end());
+    pending.clear();
+}
+
+uint32_t BindlessDescriptorTable::Register(VkImageView view, VkSampler sampler)
+{
+    QK_CORE_ASSERT(view != VK_NULL_HANDLE && sampler != VK_NULL_HANDLE)
+
+    // vkUpdateDescriptorSets() needs the set externally synchronized, the write stays under the lock.
+    // No pending draw reads an element that is not handed out, so it needs no GPU synchronization
+    std::lock_guard<std::mutex> lock(m_Lock);
+    uint32_t index;
+    if (!m_FreeIndices.empty())
+    {
+        index = m_FreeIndices.back();
+        m_FreeIndices.pop_back();
+    }
+    else
+    {
+        QK_CORE_VERIFY(m_Count < BINDLESS_IMAGE_MAX_NUM, "Bindless descriptor table is full")
+        index = m_Count++;
+    }
+
+    VkDescriptorImageInfo image_info = {};
+    image_info.imageView = view;
+    image_info.sampler = sampler;
+    image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    write.dstSet = m_Set;
+    write.dstBinding = 0;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &image_info;
+    vkUpdateDescriptorSets(m_Device->vkDevice, 1, &write, 0, nullptr);
+
+    return index;
+}
+
+void BindlessDescriptorTable::Unregister(uint32_t index, uint32_t frame_index)
+{
+    QK_CORE_ASSERT(frame_index < MAX_FRAME_NUM_IN_FLIGHT)
+
+    std::lock_guard<std::mutex> lock(m_Lock);
+    QK_CORE_VERIFY(index < m_Count, "Bindless image index was never registered")
+    m_PendingFrees[frame_index].push_back(index);
+}
+
+}
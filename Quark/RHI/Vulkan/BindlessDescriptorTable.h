@@ -0,0 +1,44 @@
+#pragma once
+#include "Quark/RHI/Vulkan/Common_Vulkan.h"
+
+namespace quark::rhi {
+
+class VulkanContext;
+
+// This class is owned by Device_Vulkan when the device supports descriptor indexing well enough.
+// It can be represented as:
+//* One VkDescriptorSet holding an array of BINDLESS_IMAGE_MAX_NUM combined image samplers, written once per image
+//  by Register() and bound by every command list that samples it. Drawing with it never updates a descriptor.
+//* A free list of array elements. An unregistered element may still be read by the frames in flight, it is
+//  reused once BeginFrame() is called for the frame it was unregistered in again.
+// The set is partially bound and updated after bind, elements no pending draw uses can be written at any time.
+class BindlessDescriptorTable {
+public:
+    static bool IsSupported(const VulkanContext& context);
+
+    BindlessDescriptorTable(Device_Vulkan* device);
+    ~BindlessDescriptorTable();
+
+    void BeginFrame(uint32_t frame_index);
+
+    // Thread safe, resources may be created on worker threads
+    uint32_t Register(VkImageView view, VkSampler sampler);
+    void Unregister(uint32_t index, uint32_t frame_index);
+
+    VkDescriptorSetLayout GetLayout() const { return m_Layout; }
+    VkDescriptorSet GetSet() const { return m_Set; }
+
+private:
+    Device_Vulkan* m_Device;
+    std::mutex m_Lock;
+
+    VkDescriptorSetLayout m_Layout = VK_NULL_HANDLE;
+    VkDescriptorPool m_Pool = VK_NULL_HANDLE;
+    VkDescriptorSet m_Set = VK_NULL_HANDLE;
+
+    uint32_t m_Count = 0;   // elements handed out at least once
+    std::vector<uint32_t> m_FreeIndices;
+    std::vector<uint32_t> m_PendingFrees[MAX_FRAME_NUM_IN_FLIGHT];
+};
+
+}
@@ -84,18 +84,18 @@ Buffer_Vulkan::Buffer_Vulkan(Device_Vulkan* device, const BufferDesc& desc, cons
         else 
         {  // static data uplodaing
 
-            Device_Vulkan::CopyCmdAllocator::CopyCmd copyCmd = m_Device->copyAllocator.allocate(desc.size);
-            memcpy(copyCmd.stageBuffer->GetMappedDataPtr(), init_data, m_desc.size);
+            UploadBatcher::UploadCmd uploadCmd = m_Device->uploader.begin(desc.size);
+            memcpy(uploadCmd.stageData, init_data, m_desc.size);
 
             // copy buffer
             VkBufferCopy copyRegion = {};
             copyRegion.size = desc.size;
-            copyRegion.srcOffset = 0;
+            copyRegion.srcOffset = uploadCmd.stageOffset;
             copyRegion.dstOffset = 0;
-            vkCmdCopyBuffer(copyCmd.transferCmdBuffer, ToInternal(copyCmd.stageBuffer.get()).m_Handle, m_Handle, 1, &copyRegion);
+            vkCmdCopyBuffer(uploadCmd.transferCmdBuffer, uploadCmd.stageBuffer, m_Handle, 1, &copyRegion);
 
-            // Submit this command which would block CPU
-            m_Device->copyAllocator.submit(copyCmd);
+            // Submitted with the other uploads, the CPU does not wait for it
+            m_Device->uploader.end();
         }
     }
 
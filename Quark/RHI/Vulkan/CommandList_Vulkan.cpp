@@ -26,8 +26,8 @@ constexpr VkImageAspectFlags _ConvertImageAspect(ImageAspect value)
     }
 }
 
-CommandList_Vulkan::CommandList_Vulkan(Device_Vulkan* device, QueueType type)
-    : CommandList(type), m_device(device)
+CommandList_Vulkan::CommandList_Vulkan(Device_Vulkan* device, QueueType type, bool secondary)
+    : CommandList(type), m_device(device), m_isSecondary(secondary)
 {
     QK_CORE_ASSERT(m_device != nullptr)
     auto& vulkan_context = m_device->vkContext;
@@ -59,9 +59,13 @@ CommandList_Vulkan::CommandList_Vulkan(Device_Vulkan* device, QueueType type)
     commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     commandBufferInfo.commandBufferCount = 1;
     commandBufferInfo.commandPool = m_cmdPool;
-    commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.level = m_isSecondary ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     VK_CHECK(vkAllocateCommandBuffers(vk_device, &commandBufferInfo, &m_cmdBuffer))
 
+    // secondary command buffers are never submitted, nothing waits on them
+    if (m_isSecondary)
+        return;
+
     VkSemaphoreCreateInfo semCreateInfo = {};
     semCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
     VK_CHECK(vkCreateSemaphore(vk_device, &semCreateInfo, nullptr, &m_cmdCompleteSemaphore))
@@ -88,6 +92,49 @@ void CommandList_Vulkan::ResetAndBeginCmdBuffer()
     ResetBindingState();
 }
 
+void CommandList_Vulkan::ResetAndBeginSecondaryCmdBuffer(const CommandList_Vulkan& primary)
+{
+    QK_CORE_ASSERT(m_isSecondary)
+    QK_CORE_ASSERT(primary.state == CommandListState::IN_RENDERPASS && primary.m_currentRenderPassContents == RenderPassContents::SECONDARY_COMMAND_LISTS)
+
+    const RenderPassInfo2& render_pass_info = primary.m_currentRenderPassInfo;
+    VkFormat color_formats[MAX_COLOR_ATTHACHEMNT_NUM] = {};
+    for (uint32_t i = 0; i < render_pass_info.numColorAttachments; ++i)
+        color_formats[i] = ConvertDataFormat(render_pass_info.colorAttachmentFormats[i]);
+
+    // the secondary buffer continues the primary's dynamic rendering, it has to know the attachment formats
+    VkCommandBufferInheritanceRenderingInfo inheritance_rendering_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO };
+    inheritance_rendering_info.colorAttachmentCount = render_pass_info.numColorAttachments;
+    inheritance_rendering_info.pColorAttachmentFormats = color_formats;
+    inheritance_rendering_info.depthAttachmentFormat = ConvertDataFormat(render_pass_info.depthAttachmentFormat);
+    inheritance_rendering_info.stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+    inheritance_rendering_info.rasterizationSamples = (VkSampleCountFlagBits)render_pass_info.sampleCount;
+
+    VkCommandBufferInheritanceInfo inheritance_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+    inheritance_info.pNext = &inheritance_rendering_info;
+
+    vkResetCommandPool(m_device->vkDevice, m_cmdPool, 0);
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritance_info;
+    VK_CHECK(vkBeginCommandBuffer(m_cmdBuffer, &beginInfo))
+
+    state = CommandListState::IN_RENDERPASS;
+    m_currentRenderPassInfo = render_pass_info;
+    m_currentRenderPassContents = RenderPassContents::INLINE;
+    m_currentPipeline = nullptr;
+    ResetBindingState();
+
+    // dynamic state is not inherited by secondary command buffers
+    m_viewport = primary.m_viewport;
+    m_scissor = primary.m_scissor;
+    if (m_viewport.width != 0.f && m_viewport.height != 0.f)
+        vkCmdSetViewport(m_cmdBuffer, 0, 1, &m_viewport);
+    if (m_scissor.extent.width != 0 && m_scissor.extent.height != 0)
+        vkCmdSetScissor(m_cmdBuffer, 0, 1, &m_scissor);
+}
+
 CommandList_Vulkan::~CommandList_Vulkan()
 {
     vkDestroySemaphore(m_device->vkDevice, m_cmdCompleteSemaphore, nullptr);
@@ -197,7 +244,7 @@ void CommandList_Vulkan::ResetBindingState()
     m_dirtySetRebindMask = 0;
 }
 
-void CommandList_Vulkan::BeginRenderPass(const RenderPassInfo2& renderPassInfo, const FrameBufferInfo& frameBufferInfo)
+void CommandList_Vulkan::BeginRenderPass(const RenderPassInfo2& renderPassInfo, const FrameBufferInfo& frameBufferInfo, RenderPassContents contents)
 {
     QK_CORE_ASSERT(renderPassInfo.numColorAttachments < MAX_COLOR_ATTHACHEMNT_NUM)
         QK_CORE_ASSERT(frameBufferInfo.numResolveAttachments < renderPassInfo.numColorAttachments)
@@ -210,10 +257,13 @@ void CommandList_Vulkan::BeginRenderPass(const RenderPassInfo2& renderPassInfo,
     // Change state
     state = CommandListState::IN_RENDERPASS;
     m_currentRenderPassInfo = renderPassInfo;
+    m_currentRenderPassContents = contents;
     m_currentPipeline = nullptr;
     ResetBindingState();
 
     VkRenderingInfo rendering_info = { VK_STRUCTURE_TYPE_RENDERING_INFO };
+    if (contents == RenderPassContents::SECONDARY_COMMAND_LISTS)
+        rendering_info.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
     rendering_info.layerCount = 1;
     rendering_info.renderArea.offset.x = 0;
     rendering_info.renderArea.offset.y = 0;
@@ -413,9 +463,35 @@ void CommandList_Vulkan::EndRenderPass()
 #endif
     // Set state back to in recording
     state = CommandListState::IN_RECORDING;
+    m_currentRenderPassContents = RenderPassContents::INLINE;
     m_device->vkContext->extendFunction.pVkCmdEndRenderingKHR(m_cmdBuffer);
 }
 
+void CommandList_Vulkan::ExecuteSecondaryCommandLists(CommandList* const* cmds, uint32_t count)
+{
+#if QK_DEBUG_BUILD
+    if (state != CommandListState::IN_RENDERPASS || m_currentRenderPassContents != RenderPassContents::SECONDARY_COMMAND_LISTS)
+        QK_CORE_LOGE_TAG("RHI", "ExecuteSecondaryCommandLists() must be called in a render pass begun with RenderPassContents::SECONDARY_COMMAND_LISTS");
+#endif
+
+    VkCommandBuffer cmd_buffers[64];
+    for (uint32_t first = 0; first < count; first += 64)
+    {
+        const uint32_t batch_count = std::min(count - first, 64u);
+        for (uint32_t i = 0; i < batch_count; ++i)
+        {
+            auto& secondary = ToInternal(cmds[first + i]);
+            QK_CORE_ASSERT(secondary.IsSecondary() && secondary.state == CommandListState::IN_RENDERPASS)
+
+            vkEndCommandBuffer(secondary.GetHandle());
+            secondary.state = CommandListState::READY_FOR_SUBMIT;
+            cmd_buffers[i] = secondary.GetHandle();
+        }
+
+        vkCmdExecuteCommands(m_cmdBuffer, batch_count, cmd_buffers);
+    }
+}
+
 const RenderPassInfo2& CommandList_Vulkan::GetCurrentRenderPassInfo() const
 {
     return m_currentRenderPassInfo;
@@ -651,6 +727,16 @@ void CommandList_Vulkan::BindSampler(uint32_t set, uint32_t binding, const Sampl
     m_dirtySetMask |= 1u << set;
 }
 
+void CommandList_Vulkan::BindBindlessImages(uint32_t set)
+{
+    QK_CORE_ASSERT(set < DESCRIPTOR_SET_MAX_NUM)
+    QK_CORE_ASSERT(m_device->bindlessTable)
+
+    // bound at the next draw whose pipeline has the bindless array at this set
+    if (m_currentSets[set] != m_device->bindlessTable->GetSet())
+        m_dirtySetMask |= 1u << set;
+}
+
 void CommandList_Vulkan::CopyImageToBuffer(const Buffer& buffer, const Image& image, uint64_t buffer_offset, const Offset3D& offset, const Extent3D& extent, uint32_t row_pitch, uint32_t slice_pitch, const ImageSubresourceRange& subresouce)
 {
     auto& internal_buffer = ToInternal(&buffer);
@@ -709,6 +795,10 @@ void CommandList_Vulkan::SetScissor(const Scissor &scissor)
 	m_scissor.offset = { scissor.offset.x, scissor.offset.y };
 	m_scissor.extent = { scissor.extent.width,scissor.extent.height };
 
+    // only kept for the secondary command lists, nothing but them can be recorded in this render pass
+    if (m_currentRenderPassContents == RenderPassContents::SECONDARY_COMMAND_LISTS)
+        return;
+
 	vkCmdSetScissor(m_cmdBuffer, 0, 1, &m_scissor);
 }
 
@@ -721,6 +811,9 @@ void CommandList_Vulkan::SetViewPort(const Viewport &viewport)
 	m_viewport.minDepth = viewport.minDepth;
 	m_viewport.maxDepth = viewport.maxDepth;
 
+    if (m_currentRenderPassContents == RenderPassContents::SECONDARY_COMMAND_LISTS)
+        return;
+
 	vkCmdSetViewport(m_cmdBuffer, 0, 1, &m_viewport);
 }
 
@@ -746,8 +839,8 @@ void CommandList_Vulkan::FlushDescriptorSet(uint32_t set)
                 if (bindings[b.binding + i].buffer.buffer == VK_NULL_HANDLE)
                     QK_CORE_LOGW_TAG("RHI", "Buffer at Set: {}, Binding {} is not bounded. Performance waring!", set, b.binding);
 #endif
+                // the dynamic offset is given when the set is bound, the same set serves every offset into the buffer
                 QK_CORE_ASSERT(num_dynamic_offsets < SET_BINDINGS_MAX_NUM)
-                h.u32(bindings[b.binding + i].dynamicOffset);
                 dynamic_offsets[num_dynamic_offsets++] = bindings[b.binding + i].dynamicOffset;
             }
             break;
@@ -756,6 +849,7 @@ void CommandList_Vulkan::FlushDescriptorSet(uint32_t set)
         {
             for (size_t i = 0; i < b.descriptorCount; ++i) {
                 h.pointer(bindings[b.binding + i].buffer.buffer);
+                h.u64(bindings[b.binding + i].buffer.offset);
                 h.u64(bindings[b.binding + i].buffer.range);
                 QK_CORE_ASSERT(bindings[b.binding + i].buffer.buffer != VK_NULL_HANDLE)
             }
@@ -805,19 +899,16 @@ void CommandList_Vulkan::FlushDescriptorSet(uint32_t set)
         }
     }
     util::Hash hash = h.get();
-    auto allocated = m_currentPipeline->GetLayout()->setAllocators[set]->Find(hash);
+    auto updata_template = m_currentPipeline->GetLayout()->updateTemplate[set];
+    QK_CORE_ASSERT(updata_template)
 
-    // The descriptor set was not successfully cached, rebuild
-    if (!allocated.second) {
-        auto updata_template = m_currentPipeline->GetLayout()->updateTemplate[set];
-        QK_CORE_ASSERT(updata_template)
-        vkUpdateDescriptorSetWithTemplate(m_device->vkDevice, allocated.first, updata_template, bindings);
-    }
+    // The descriptor set is rebuilt if it was not cached
+    VkDescriptorSet allocated = m_currentPipeline->GetLayout()->setAllocators[set]->Request(hash, updata_template, bindings);
 
     vkCmdBindDescriptorSets(m_cmdBuffer, (m_currentPipeline->GetBindingPoint() == PipeLineBindingPoint::GRAPHIC ? VK_PIPELINE_BIND_POINT_GRAPHICS : VK_PIPELINE_BIND_POINT_COMPUTE),
-        m_currentPipeline->GetLayout()->handle, set, 1, &allocated.first, num_dynamic_offsets, dynamic_offsets);
+        m_currentPipeline->GetLayout()->handle, set, 1, &allocated, num_dynamic_offsets, dynamic_offsets);
 
-    m_currentSets[set] = allocated.first;
+    m_currentSets[set] = allocated;
 }  
 
 void CommandList_Vulkan::RebindDescriptorSet(uint32_t set)
@@ -865,10 +956,19 @@ void CommandList_Vulkan::Draw(uint32_t vertex_count, uint32_t instance_count, ui
 void CommandList_Vulkan::FlushRenderState()
 {
     QK_CORE_ASSERT(m_currentPipeline)
+    QK_CORE_ASSERT(m_currentRenderPassContents == RenderPassContents::INLINE, "Draws of this render pass must be recorded in secondary command lists")
     
     const PipeLineLayout* pipeline_layout = m_currentPipeline->GetLayout();
 
-    // 1. flush dirty descriptor set
+    // 1. flush dirty descriptor set, the bindless set is written already and only needs binding
+    uint32_t bindless_sets_need_bind = pipeline_layout->combinedLayout.bindlessSetMask & m_dirtySetMask;
+    util::for_each_bit(bindless_sets_need_bind, [&](uint32_t set) {
+        m_currentSets[set] = m_device->bindlessTable->GetSet();
+        vkCmdBindDescriptorSets(m_cmdBuffer, (m_currentPipeline->GetBindingPoint() == PipeLineBindingPoint::GRAPHIC ? VK_PIPELINE_BIND_POINT_GRAPHICS : VK_PIPELINE_BIND_POINT_COMPUTE),
+            pipeline_layout->handle, set, 1, &m_currentSets[set], 0, nullptr);
+    });
+    m_dirtySetMask &= ~bindless_sets_need_bind;
+
     uint32_t sets_need_update = pipeline_layout->combinedLayout.descriptorSetLayoutMask & m_dirtySetMask;
     util::for_each_bit(sets_need_update, [&](uint32_t set) { FlushDescriptorSet(set); });
     m_dirtySetMask &= ~sets_need_update;
@@ -24,7 +24,7 @@ class CommandList_Vulkan final : public CommandList {
 public:
     CommandListState state = CommandListState::READY_FOR_RECORDING;
 
-    CommandList_Vulkan(Device_Vulkan* device, QueueType type_);
+    CommandList_Vulkan(Device_Vulkan* device, QueueType type_, bool secondary = false);
     ~CommandList_Vulkan();
 
     void PushConstant(const void* data, uint32_t offset, uint32_t size) override final;
@@ -35,6 +35,7 @@ public:
     void BindVertexBuffer(uint32_t binding, const Buffer& buffer, u64 offset) override final;
     void BindIndexBuffer(const Buffer& buffer, u64 offset, const IndexBufferFormat format) override final;
     void BindSampler(uint32_t set, uint32_t binding, const Sampler& sampler) override final;
+    void BindBindlessImages(uint32_t set) override final;
     
     void CopyImageToBuffer(const Buffer& buffer, const Image& image, uint64_t buffer_offset, const Offset3D& offset, const Extent3D& extent, uint32_t row_pitch, uint32_t slice_pitch, const ImageSubresourceRange& subresouce) override final;
     
@@ -46,17 +47,21 @@ public:
 
     void PipeLineBarriers(const PipelineMemoryBarrier* memoryBarriers, uint32_t memoryBarriersCount, const PipelineImageBarrier* imageBarriers, uint32_t iamgeBarriersCount, const PipelineBufferBarrier* bufferBarriers, uint32_t bufferBarriersCount) override final;
     
-    void BeginRenderPass(const RenderPassInfo2& renderPassInfo, const FrameBufferInfo& frameBufferInfo) override final;
+    void BeginRenderPass(const RenderPassInfo2& renderPassInfo, const FrameBufferInfo& frameBufferInfo, RenderPassContents contents = RenderPassContents::INLINE) override final;
     // void BeginRenderPass(const RenderPassInfo& info) override;
     void EndRenderPass() override final;
 
+    void ExecuteSecondaryCommandLists(CommandList* const* cmds, uint32_t count) override final;
+
     const RenderPassInfo2& GetCurrentRenderPassInfo() const override final;
     const PipeLine* GetCurrentGraphicsPipeline() const override final;
 
     ///////////////////////// Vulkan specific /////////////////////////
 
     void ResetAndBeginCmdBuffer();
+    void ResetAndBeginSecondaryCmdBuffer(const CommandList_Vulkan& primary);
     bool IsWaitingForSwapChainImage() const { return m_waitForSwapchainImage; }
+    bool IsSecondary() const { return m_isSecondary; }
 
     const VkCommandBuffer GetHandle() const { return m_cmdBuffer; }
     const VkSemaphore GetCmdCompleteSemaphore() const { return m_cmdCompleteSemaphore; }
@@ -104,11 +109,13 @@ private:
     std::vector<VkBufferMemoryBarrier2> m_bufferBarriers;
     bool m_waitForSwapchainImage = false;
     uint32_t m_swapChainWaitStages = 0;
+    bool m_isSecondary = false;
 
     // Rendering state 
     const PipeLine_Vulkan* m_currentPipeline = nullptr;
     RenderPassInfo2 m_currentRenderPassInfo = {};
     VkDescriptorSet m_currentSets[DESCRIPTOR_SET_MAX_NUM] = {};
+    RenderPassContents m_currentRenderPassContents = RenderPassContents::INLINE;
     VkViewport m_viewport = {};
     VkRect2D m_scissor = {};
     BindingState m_bindingState = {};
@@ -598,6 +598,12 @@ bool VulkanContext::IsPhysicalDeviceSuitable(VkPhysicalDevice device, physicalDe
         QK_CORE_LOGT_TAG("RHI", "  Device do not support descriptor indexing. Skipping.");
         return false;
     }
+    // Require timeline semaphore, uploads are tracked with one
+    if (!features12.timelineSemaphore) 
+    {
+        QK_CORE_LOGT_TAG("RHI", "  Device do not support timeline semaphore. Skipping.");
+        return false;
+    }
     // This GPU is suitable
     return true;
 }
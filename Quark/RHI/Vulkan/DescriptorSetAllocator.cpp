@@ -27,7 +27,9 @@ DescriptorSetAllocator::DescriptorSetAllocator(Device_Vulkan* device, const Desc
 
 void DescriptorSetAllocator::BeginFrame()
 {
+	std::lock_guard<std::mutex> lock(m_Lock);
 	m_SetNodes.BeginFrame();
+	m_FrameMisses = 0;
 }
 DescriptorSetAllocator::~DescriptorSetAllocator()
 {
@@ -46,20 +48,61 @@ DescriptorSetAllocator::~DescriptorSetAllocator()
 	QK_CORE_LOGT_TAG("RHI", "Desctipor set allocator destroyed");
 }
 
+VkDescriptorSet DescriptorSetAllocator::Request(size_t hash, VkDescriptorUpdateTemplate update_template, const void* data)
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+
+	auto allocated = Find(hash);
+	if (!allocated.second)
+	{
+		vkUpdateDescriptorSetWithTemplate(m_Device->vkDevice, allocated.first, update_template, data);
+		m_Stats.descriptorUpdates++;
+	}
+
+	return allocated.first;
+}
+
+DescriptorSetAllocator::Stats DescriptorSetAllocator::GetStats()
+{
+	std::lock_guard<std::mutex> lock(m_Lock);
+	return m_Stats;
+}
+
 std::pair<VkDescriptorSet, bool> DescriptorSetAllocator::Find(size_t hash)
 {
 	auto* node = m_SetNodes.request(hash);
 	if (node)
+	{
+		m_Stats.hits++;
 		return { node->set, true };
+	}
+
+	m_Stats.misses++;
+	m_FrameMisses++;
 
 	node = m_SetNodes.request_vacant(hash);
 	if (node)
+	{
+		m_Stats.vacantReuses++;
 		return { node->set, false };
+	}
 
 	// need to create new descriptor pool and sets
+	AllocatePool();
+	return { m_SetNodes.request_vacant(hash)->set, false };
+}
+
+void DescriptorSetAllocator::AllocatePool()
+{
+	// Every allocated set is cached by a recent frame: double the sets, or more if this frame alone needs more
+	uint32_t demand = std::max((uint32_t)m_Stats.allocatedSets, m_FrameMisses);
+	uint32_t sets_num = DEFAULT_SETS_NUM_PER_POOL;
+	while (sets_num < demand && sets_num < MAX_SETS_NUM_PER_POOL)
+		sets_num *= 2;
+
 	VkDescriptorPool pool;
 	VkDescriptorPoolCreateInfo info = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
-	info.maxSets = setsPerPool;
+	info.maxSets = sets_num;
 
 	std::vector<VkDescriptorPoolSize> poolSizes;
 	if (!m_PoolSizeRatios.empty())
@@ -68,39 +111,32 @@ std::pair<VkDescriptorSet, bool> DescriptorSetAllocator::Find(size_t hash)
 		{
 			poolSizes.push_back(VkDescriptorPoolSize{
 			.type = ratio.type,
-			.descriptorCount = uint32_t(ratio.ratio * setsPerPool)
+			.descriptorCount = uint32_t(ratio.ratio * sets_num)
 				});
 		}
 		info.poolSizeCount = (uint32_t)poolSizes.size();
 		info.pPoolSizes = poolSizes.data();
 	}
 
-	// increment sets count per pool
-	setsPerPool *= 2;
-
-	if (vkCreateDescriptorPool(m_Device->vkDevice, &info, nullptr, &pool) != VK_SUCCESS)
-	{
-		QK_CORE_VERIFY(0, "Failed to create descriptor pool.");
-		return { VK_NULL_HANDLE, false };
-	}
+	QK_CORE_VERIFY(vkCreateDescriptorPool(m_Device->vkDevice, &info, nullptr, &pool) == VK_SUCCESS, "Failed to create descriptor pool.")
 
-	VkDescriptorSet sets[SET_BINDINGS_MAX_NUM];
-	VkDescriptorSetLayout layouts[SET_BINDINGS_MAX_NUM];
-	std::fill(std::begin(layouts), std::end(layouts), m_Layout);
+	// allocate every set the pool has room for, they all go to the vacant list
+	std::vector<VkDescriptorSet> sets(sets_num);
+	std::vector<VkDescriptorSetLayout> layouts(sets_num, m_Layout);
 
 	VkDescriptorSetAllocateInfo alloc = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
 	alloc.descriptorPool = pool;
-	alloc.descriptorSetCount = SET_BINDINGS_MAX_NUM;
-	alloc.pSetLayouts = layouts;
+	alloc.descriptorSetCount = sets_num;
+	alloc.pSetLayouts = layouts.data();
 
-	if (vkAllocateDescriptorSets(m_Device->vkDevice, &alloc, sets) != VK_SUCCESS)
-		QK_CORE_VERIFY(0, "Failed to allocate descriptor sets.");
+	QK_CORE_VERIFY(vkAllocateDescriptorSets(m_Device->vkDevice, &alloc, sets.data()) == VK_SUCCESS, "Failed to allocate descriptor sets.")
 	m_Pools.push_back(pool);
 
 	for (auto set : sets)
 		m_SetNodes.make_vacant(set);
 
-	return { m_SetNodes.request_vacant(hash)->set, false };
-
+	m_Stats.poolAllocations++;
+	m_Stats.allocatedSets += sets_num;
+	QK_CORE_LOGT_TAG("RHI", "Descriptor pool allocated: {} sets, {} sets in {} pools", sets_num, m_Stats.allocatedSets, m_Pools.size());
 }
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "Quark/Core/Util/TemporaryHashMap.h"
+#include "Quark/RHI/Device.h"
 #include "Quark/RHI/Vulkan/Common_Vulkan.h"
 
 namespace quark::rhi {
@@ -35,30 +36,45 @@ struct DescriptorSetLayout {
 //* A temporary hashmap which keeps track of which descriptor sets have been requested recently. 
 //  This allows us to reuse descriptor sets directly. In the ideal case, we almost never actually need to call vkUpdateDescriptorSets. 
 //  We end up with hash -> get VkDescriptorSet -> vkCmdBindDescriptorSets.
+// Pools grow geometrically: a new pool holds at least as many sets as all pools before it, and at least as many as
+// the current frame has missed so far, so a scene with thousands of materials ends up with a few large pools.
 class DescriptorSetAllocator {
 public:
     static constexpr u32 DESCRIPTOR_SET_RING_SIZE = 8;
     static constexpr u32 DEFAULT_SETS_NUM_PER_POOL = 16;
+    static constexpr u32 MAX_SETS_NUM_PER_POOL = 1024;
     struct PoolSizeRatio {
         VkDescriptorType type;
         float ratio;
     };
 
+    using Stats = DescriptorSetStats;   // descriptor updates are vkUpdateDescriptorSetWithTemplate calls
+
     DescriptorSetAllocator(Device_Vulkan* device, const DescriptorSetLayout& layout);
     ~DescriptorSetAllocator();
 
     void BeginFrame();
     VkDescriptorSetLayout GetLayout() const { return m_Layout; }
-    std::pair<VkDescriptorSet, bool> Find(size_t hash);
+
+    // Returns the set cached for hash, a vacant set is written with the template first.
+    // Thread safe, command lists of one frame may be recorded on several threads.
+    VkDescriptorSet Request(size_t hash, VkDescriptorUpdateTemplate update_template, const void* data);
+
+    Stats GetStats();
 
 private:
+    std::pair<VkDescriptorSet, bool> Find(size_t hash);
+    void AllocatePool();
+
     Device_Vulkan* m_Device;
+    std::mutex m_Lock;
 
     VkDescriptorSetLayout m_Layout = VK_NULL_HANDLE;
     std::vector<PoolSizeRatio> m_PoolSizeRatios;
     std::vector<VkDescriptorPool> m_Pools;
 
-    uint32_t setsPerPool = DEFAULT_SETS_NUM_PER_POOL; // default value
+    Stats m_Stats;
+    uint32_t m_FrameMisses = 0; // misses since the last BeginFrame()
 
     struct DescriptorSetNode : util::TemporaryHashmapEnabled<DescriptorSetNode>, util::IntrusiveListEnabled<DescriptorSetNode>
     {
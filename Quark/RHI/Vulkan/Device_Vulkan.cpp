@@ -10,6 +10,8 @@
 
 namespace quark::rhi {
 
+static constexpr const char* PIPELINE_CACHE_PATH = "Cache/PipelineCache_Vulkan.bin";
+
 void Device_Vulkan::CommandQueue::init(Device_Vulkan *device, QueueType type)
 {
     this->device = device;
@@ -35,6 +37,21 @@ void Device_Vulkan::CommandQueue::submit(VkFence fence)
 {
     QK_CORE_ASSERT(!submissions.empty() || fence != VK_NULL_HANDLE)
 
+    // Uploads recorded so far are submitted before the commands that may use them, which wait for them on the GPU
+    if (type != QUEUE_TYPE_ASYNC_TRANSFER && !submissions.empty())
+    {
+        const uint64_t upload_value = device->uploader.flush();
+        if (upload_value > waitedUploadValue)
+        {
+            auto& semaphore_info = submissions.front().waitSemaphoreInfos.emplace_back();
+            semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+            semaphore_info.semaphore = device->uploader.getTimelineSemaphore();
+            semaphore_info.value = upload_value;
+            semaphore_info.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+            waitedUploadValue = upload_value;
+        }
+    }
+
     std::vector<VkSubmitInfo2> submit_infos(submissions.size());
     for (size_t i = 0; i < submissions.size(); ++i) 
     {
@@ -49,6 +66,7 @@ void Device_Vulkan::CommandQueue::submit(VkFence fence)
         info.pWaitSemaphoreInfos = submission.waitSemaphoreInfos.data();
     }
 
+    std::scoped_lock lock(locker);
     device->vkContext->extendFunction.pVkQueueSubmit2KHR(queue, (uint32_t)submit_infos.size(), submit_infos.data(), fence);
     
     // Clear submissions
@@ -68,6 +86,10 @@ void Device_Vulkan::PerFrameData::init(Device_Vulkan *device)
     this->device = device;
     this->vmaAllocator = this->device->vmaAllocator;
 
+    // Any allocation can be bound as a uniform or a storage buffer
+    const DeviceProperties::DeviceLimits& limits = device->GetDeviceProperties().limits;
+    dataAllocator.Init(device, std::max<u64>({ 16, limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment }));
+
     for (size_t i = 0; i < QUEUE_TYPE_MAX_ENUM; i++) {
         // Create a fence per queue
         VkFenceCreateInfo fence_create_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
@@ -119,6 +141,8 @@ void Device_Vulkan::PerFrameData::reset()
 
     for (size_t i = 0; i < QUEUE_TYPE_MAX_ENUM; i++)
         cmdListCount[i] = 0;
+    secondaryCmdListCount = 0;
+    dataAllocator.Reset();
 
     imageAvailableSemaphoreConsumed = false;
 
@@ -138,6 +162,10 @@ void Device_Vulkan::PerFrameData::destroy()
         vkDestroyFence(device->vkDevice, queueFences[i], nullptr);
     }
 
+    for (CommandList_Vulkan* cmd : secondaryCmdLists)
+        delete cmd;
+    secondaryCmdLists.clear();
+
     vkDestroySemaphore(device->vkDevice, imageAvailableSemaphore, nullptr);
     vkDestroySemaphore(device->vkDevice, imageReleaseSemaphore, nullptr);
 
@@ -145,186 +173,6 @@ void Device_Vulkan::PerFrameData::destroy()
 }
 
 
-void Device_Vulkan::CopyCmdAllocator::init(Device_Vulkan *device)
-{
-    m_Device = device;
-}
-
-void Device_Vulkan::CopyCmdAllocator::destroy()
-{   
-    // Make sure all allocated cmd are in free list
-    vkQueueWaitIdle(m_Device->m_queues[QUEUE_TYPE_ASYNC_TRANSFER].queue);
-    for (auto& x : m_FreeList)
-    {
-        vkDestroyCommandPool(m_Device->vkDevice, x.transferCmdPool, nullptr);
-        vkDestroyCommandPool(m_Device->vkDevice, x.transitionCmdPool, nullptr);
-        vkDestroyFence(m_Device->vkDevice, x.fence, nullptr);
-        vkDestroySemaphore(m_Device->vkDevice, x.semaphores[0], nullptr);
-        vkDestroySemaphore(m_Device->vkDevice, x.semaphores[1], nullptr);
-    }
-
-    m_FreeList.clear();
-}
-
-Device_Vulkan::CopyCmdAllocator::CopyCmd Device_Vulkan::CopyCmdAllocator::allocate(VkDeviceSize required_buffer_size)
-{
-    CopyCmd cmd;
-
-    // Try to find a suitable staging buffer in free list
-    m_Locker.lock();
-    for (size_t i = 0; i < m_FreeList.size(); ++i) 
-    {
-        if (m_FreeList[i].stageBuffer->GetDesc().size >= required_buffer_size) 
-        {
-            if (vkGetFenceStatus(m_Device->vkDevice, m_FreeList[i].fence) == VK_SUCCESS)
-            {
-                cmd = std::move(m_FreeList[i]);
-                std::swap(m_FreeList[i], m_FreeList.back());
-                m_FreeList.pop_back();
-                break;
-            }
-        }
-    }
-    m_Locker.unlock();
-
-    if (!cmd.isValid()) // No suitable staging buffer founded
-    { 
-        // Create command pool
-        VkCommandPoolCreateInfo poolInfo = {};
-        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
-        poolInfo.queueFamilyIndex = m_Device->vkContext->transferQueueIndex;
-        VK_CHECK(vkCreateCommandPool(m_Device->vkDevice, &poolInfo, nullptr, &cmd.transferCmdPool))
-
-        poolInfo.queueFamilyIndex = m_Device->vkContext->graphicQueueIndex;
-        VK_CHECK(vkCreateCommandPool(m_Device->vkDevice, &poolInfo, nullptr, &cmd.transitionCmdPool))
-
-        // Allocate command buffer
-        VkCommandBufferAllocateInfo commandBufferInfo = {};
-        commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        commandBufferInfo.commandBufferCount = 1;
-        commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        commandBufferInfo.commandPool = cmd.transferCmdPool;
-        VK_CHECK(vkAllocateCommandBuffers(m_Device->vkDevice, &commandBufferInfo, &cmd.transferCmdBuffer))
-
-        commandBufferInfo.commandPool = cmd.transitionCmdPool;
-        VK_CHECK(vkAllocateCommandBuffers(m_Device->vkDevice, &commandBufferInfo, &cmd.transitionCmdBuffer))
-
-        // Create fence
-        VkFenceCreateInfo fenceInfo = {};
-        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        VK_CHECK(vkCreateFence(m_Device->vkDevice, &fenceInfo, nullptr, &cmd.fence))
-
-        // Create Semaphores
-        VkSemaphoreCreateInfo semaphoreInfo = {};
-        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-        VK_CHECK(vkCreateSemaphore(m_Device->vkDevice, &semaphoreInfo, nullptr, &cmd.semaphores[0]));
-        VK_CHECK(vkCreateSemaphore(m_Device->vkDevice, &semaphoreInfo, nullptr, &cmd.semaphores[1]));
-
-        // Create staging buffer
-        BufferDesc bufferDesc;
-        bufferDesc.domain = BufferMemoryDomain::CPU;
-        bufferDesc.size = math::GetNextPowerOfTwo(required_buffer_size);
-        bufferDesc.size = std::max(bufferDesc.size, uint64_t(65536));
-        bufferDesc.usageBits = BUFFER_USAGE_TRANSFER_FROM_BIT;
-        cmd.stageBuffer = m_Device->CreateBuffer(bufferDesc);
-
-        m_Device->SetDebugName(cmd.stageBuffer, "CopyCmdAllocator staging buffer");
-    }
-
-    // Begin command buffer in valid state:
-	VK_CHECK(vkResetCommandPool(m_Device->vkDevice, cmd.transferCmdPool, 0))
-    VK_CHECK(vkResetCommandPool(m_Device->vkDevice, cmd.transitionCmdPool, 0))
-
-    VkCommandBufferBeginInfo beginInfo = {};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    beginInfo.pInheritanceInfo = nullptr;
-    VK_CHECK(vkBeginCommandBuffer(cmd.transferCmdBuffer, &beginInfo))
-    VK_CHECK(vkBeginCommandBuffer(cmd.transitionCmdBuffer, &beginInfo))
-
-    // Reset fence
-    VK_CHECK(vkResetFences(m_Device->vkDevice, 1, &cmd.fence))
-    return cmd;
-}
-
-void Device_Vulkan::CopyCmdAllocator::submit(CopyCmd cmd)
-{
-    VK_CHECK(vkEndCommandBuffer(cmd.transferCmdBuffer))
-    VK_CHECK(vkEndCommandBuffer(cmd.transitionCmdBuffer))
-
-    VkSubmitInfo2 submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
-
-    VkCommandBufferSubmitInfo cbSubmitInfo = {};
-    cbSubmitInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
-    cbSubmitInfo.commandBuffer = cmd.transferCmdBuffer;
-
-    VkSemaphoreSubmitInfo signalSemaphoreInfo = {};
-    signalSemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
-
-    VkSemaphoreSubmitInfo waitSemaphoreInfo = {};
-    waitSemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
-
-    // Submit to transfer queue
-    {
-        cbSubmitInfo.commandBuffer = cmd.transferCmdBuffer;
-        signalSemaphoreInfo.semaphore = cmd.semaphores[0]; // signal for graphics queue
-        signalSemaphoreInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
-
-        submitInfo.commandBufferInfoCount = 1;
-        submitInfo.pCommandBufferInfos = &cbSubmitInfo;
-        submitInfo.signalSemaphoreInfoCount = 1;
-        submitInfo.pSignalSemaphoreInfos = &signalSemaphoreInfo;
-
-        std::scoped_lock lock(m_Device->m_queues[QUEUE_TYPE_ASYNC_TRANSFER].locker);
-        m_Device->vkContext->extendFunction.pVkQueueSubmit2KHR(
-            m_Device->m_queues[QUEUE_TYPE_ASYNC_TRANSFER].queue, 1, &submitInfo, VK_NULL_HANDLE);
-    }
-
-    // Submit to graphics queue
-    {
-        waitSemaphoreInfo.semaphore = cmd.semaphores[0]; // wait for copy queue
-        waitSemaphoreInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
-
-        cbSubmitInfo.commandBuffer = cmd.transitionCmdBuffer;
-        signalSemaphoreInfo.semaphore = cmd.semaphores[1]; // signal for compute queue
-        signalSemaphoreInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
-
-        submitInfo.waitSemaphoreInfoCount = 1;
-        submitInfo.pWaitSemaphoreInfos = &waitSemaphoreInfo;
-        submitInfo.commandBufferInfoCount = 1;
-        submitInfo.pCommandBufferInfos = &cbSubmitInfo;
-        submitInfo.signalSemaphoreInfoCount = 1;
-        submitInfo.pSignalSemaphoreInfos = &signalSemaphoreInfo;
-
-        std::scoped_lock lock(m_Device->m_queues[QUEUE_TYPE_GRAPHICS].locker);
-        m_Device->vkContext->extendFunction.pVkQueueSubmit2KHR(
-			m_Device->m_queues[QUEUE_TYPE_GRAPHICS].queue, 1, &submitInfo, VK_NULL_HANDLE);
-    }
-
-    // insert semaphore to compute queue to make sure the copy and transition is done
-    // this must be final submit in this function because it will also signal a fence for state tracking by CPU!
-	{
-		waitSemaphoreInfo.semaphore = cmd.semaphores[1]; // wait for graphics queue
-		waitSemaphoreInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
-
-		submitInfo.waitSemaphoreInfoCount = 1;
-		submitInfo.pWaitSemaphoreInfos = &waitSemaphoreInfo;
-        submitInfo.commandBufferInfoCount = 0;
-        submitInfo.pCommandBufferInfos = nullptr;
-		submitInfo.signalSemaphoreInfoCount = 0;
-		submitInfo.pSignalSemaphoreInfos = nullptr;
-
-		std::scoped_lock lock(m_Device->m_queues[QUEUE_TYPE_ASYNC_COMPUTE].locker);
-		m_Device->vkContext->extendFunction.pVkQueueSubmit2KHR(
-			m_Device->m_queues[QUEUE_TYPE_ASYNC_COMPUTE].queue, 1, &submitInfo, cmd.fence);
-	}
-
-    std::scoped_lock lock(m_Locker);
-    m_FreeList.push_back(cmd);
-}
-
 void Device_Vulkan::OnWindowResize(const WindowResizeEvent &event)
 {
     m_frameBufferWidth = event.width;
@@ -348,25 +196,34 @@ bool Device_Vulkan::Init()
 
     // Store device properties in public interface
     m_properties.limits.minUniformBufferOffsetAlignment = vkContext->properties2.properties.limits.minUniformBufferOffsetAlignment;
+    m_properties.limits.minStorageBufferOffsetAlignment = vkContext->properties2.properties.limits.minStorageBufferOffsetAlignment;
     m_features.textureCompressionBC = vkContext->features2.features.textureCompressionBC;
     m_features.textureCompressionASTC_LDR = vkContext->features2.features.textureCompressionASTC_LDR;;
     m_features.textureCompressionETC2 = vkContext->features2.features.textureCompressionETC2;
+    m_features.bindlessImages = BindlessDescriptorTable::IsSupported(*vkContext);
     
+    // Pipelines compiled by earlier runs
+    LoadPipelineCache();
+
     // Create frame data
     for (size_t i = 0; i < MAX_FRAME_NUM_IN_FLIGHT; i++)
         m_frames[i].init(this);
 
+    // Create the bindless image array
+    if (m_features.bindlessImages)
+        bindlessTable = CreateScope<BindlessDescriptorTable>(this);
+
     // Setup command queues
     m_queues[QUEUE_TYPE_GRAPHICS].init(this, QUEUE_TYPE_GRAPHICS);
     m_queues[QUEUE_TYPE_ASYNC_COMPUTE].init(this, QUEUE_TYPE_ASYNC_COMPUTE);
     m_queues[QUEUE_TYPE_ASYNC_TRANSFER].init(this, QUEUE_TYPE_ASYNC_TRANSFER);
 
+    // Init upload batcher, swapchain images may be transitioned with it
+    uploader.init(this);
+
     // Create Swapchain
     ResizeSwapchain();
 
-    // Init copy cmds allocator
-    copyAllocator.init(this);
-
     // Register callback functions
     EventManager::Get().Subscribe<WindowResizeEvent>([this](const WindowResizeEvent& event) { OnWindowResize(event);});
     QK_CORE_LOGI_TAG("RHI", "==========Vulkan Backend Initialized========");
@@ -377,15 +234,30 @@ void Device_Vulkan::ShutDown()
 {
     QK_CORE_LOGI_TAG("RHI", "Shutdown vulkan device...");
     vkDeviceWaitIdle(vkDevice);
+
+    // Write pipeline cache back to disk
+    SavePipelineCache();
+    vkDestroyPipelineCache(vkDevice, vkPipelineCache, nullptr);
+    vkPipelineCache = VK_NULL_HANDLE;
     
     // Destroy cached pipeline layout
     cached_pipelineLayouts.clear();
 
     // Destory cached descriptor allocator
+    DescriptorSetStats set_stats = GetDescriptorSetStats();
+    QK_CORE_LOGI_TAG("RHI", "Descriptor set cache: {} hits, {} misses ({} vacant reuses), {} updates, {} sets in {} pools",
+        set_stats.hits, set_stats.misses, set_stats.vacantReuses, set_stats.descriptorUpdates, set_stats.allocatedSets, set_stats.poolAllocations);
     cached_descriptorSetAllocator.clear();
 
-    // Destroy copy allocator
-    copyAllocator.destroy();
+    // Destroy the bindless image array
+    bindlessTable.reset();
+
+    // Destroy upload batcher
+    uploader.destroy();
+
+    // Frame data buffers go to the garbage of the current frame, destroy them before any frame is destroyed
+    for (size_t i = 0; i < MAX_FRAME_NUM_IN_FLIGHT; i++)
+        m_frames[i].dataAllocator.Destroy();
 
     // Destroy frames data
     for (size_t i = 0; i < MAX_FRAME_NUM_IN_FLIGHT; i++)
@@ -418,8 +290,15 @@ bool Device_Vulkan::BeiginFrame(TimeStep ts)
     frame.reset();
 
     // put unused (more than 8 frames) descriptor set back to vacant pool
-    for (auto& [k, value] : cached_descriptorSetAllocator)
-        value.BeginFrame();   
+    {
+        std::lock_guard<std::mutex> lock(m_descriptorSetAllocatorLock);
+        for (auto& [k, value] : cached_descriptorSetAllocator)
+            value.BeginFrame();
+    }
+
+    // bindless images unregistered when this frame was last recorded are free again
+    if (bindlessTable)
+        bindlessTable->BeginFrame(m_elapsedFrame % MAX_FRAME_NUM_IN_FLIGHT);
 
     // Acquire a swapchain image 
     VkResult result = vkAcquireNextImageKHR(
@@ -528,19 +407,39 @@ Ref<Sampler> Device_Vulkan::CreateSampler(const SamplerDesc &desc)
     return newSamper;
 }
 
-void Device_Vulkan::CopyBuffer(Buffer& dst, Buffer& src, uint64_t size, uint64_t dstOffset, uint64_t srcOffset)
+void Device_Vulkan::CopyBuffer(Buffer& dst, const Ref<Buffer>& src, uint64_t size, uint64_t dstOffset, uint64_t srcOffset)
 {
     auto& dst_internal = ToInternal(&dst);
-    auto& src_internal = ToInternal(&src);
+    auto& src_internal = ToInternal(src.get());
 
     VkBufferCopy copyRegion = {};
     copyRegion.size = size;
     copyRegion.srcOffset = srcOffset;
     copyRegion.dstOffset = dstOffset;
 
-    CopyCmdAllocator::CopyCmd copyCmd = copyAllocator.allocate(0);
-    vkCmdCopyBuffer(copyCmd.transferCmdBuffer, src_internal.GetHandle(), dst_internal.GetHandle(), 1, &copyRegion);
-    copyAllocator.submit(copyCmd);
+    // Done on the GPU with the next batch of uploads, the caller may drop src before then
+    UploadBatcher::UploadCmd uploadCmd = uploader.begin(0);
+    vkCmdCopyBuffer(uploadCmd.transferCmdBuffer, src_internal.GetHandle(), dst_internal.GetHandle(), 1, &copyRegion);
+    uploader.retain(src);
+    uploader.end();
+}
+
+FrameAllocation Device_Vulkan::AllocateFrameData(u64 size)
+{
+    return GetCurrentFrame().dataAllocator.Allocate(size);
+}
+
+uint32_t Device_Vulkan::RegisterBindlessImage(const Image& image, const Sampler& sampler)
+{
+    QK_CORE_VERIFY(bindlessTable, "Device_Vulkan::RegisterBindlessImage: bindless images are not supported")
+    QK_CORE_VERIFY(image.GetDesc().usageBits & IMAGE_USAGE_SAMPLING_BIT)
+    return bindlessTable->Register(ToInternal(&image).GetView(), ToInternal(&sampler).GetHandle());
+}
+
+void Device_Vulkan::UnregisterBindlessImage(uint32_t index)
+{
+    QK_CORE_VERIFY(bindlessTable, "Device_Vulkan::UnregisterBindlessImage: bindless images are not supported")
+    bindlessTable->Unregister(index, m_elapsedFrame % MAX_FRAME_NUM_IN_FLIGHT);
 }
 
 void Device_Vulkan::SetDebugName(const Ref<GpuResource>& resouce, const char* name)
@@ -577,6 +476,8 @@ void Device_Vulkan::SetDebugName(const Ref<GpuResource>& resouce, const char* na
 
 CommandList* Device_Vulkan::BeginCommandList(QueueType type)
 {
+    std::lock_guard<std::mutex> lock(m_cmdListLock);
+
     auto& frame = GetCurrentFrame();
     auto& cmdLists = frame.cmdLists[type];
     u32 cmd_count = frame.cmdListCount[type]++;
@@ -592,13 +493,39 @@ CommandList* Device_Vulkan::BeginCommandList(QueueType type)
     return static_cast<CommandList*>(internal_cmdList);
 }
 
+CommandList* Device_Vulkan::BeginSecondaryCommandList(const CommandList& primary)
+{
+    const auto& internal_primary = ToInternal(&primary);
+    QK_CORE_ASSERT(primary.GetQueueType() == QUEUE_TYPE_GRAPHICS && !internal_primary.IsSecondary())
+
+    CommandList_Vulkan* internal_cmdList = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_cmdListLock);
+
+        auto& frame = GetCurrentFrame();
+        u32 cmd_count = frame.secondaryCmdListCount++;
+        if (cmd_count >= frame.secondaryCmdLists.size())
+            frame.secondaryCmdLists.emplace_back(new CommandList_Vulkan(this, QUEUE_TYPE_GRAPHICS, true));
+
+        internal_cmdList = frame.secondaryCmdLists[cmd_count];
+    }
+
+    // the list is owned by this thread from here, its pool is not shared
+    internal_cmdList->ResetAndBeginSecondaryCmdBuffer(internal_primary);
+
+    return static_cast<CommandList*>(internal_cmdList);
+}
+
 void Device_Vulkan::SubmitCommandList(CommandList* cmd, CommandList* waitedCmds, uint32_t waitedCmdCounts, bool signal)
 {
     auto& internal_cmdList = ToInternal(cmd);
-    auto& queue = m_queues[internal_cmdList.GetQueueType()];
+    QK_CORE_ASSERT(!internal_cmdList.IsSecondary(), "Secondary command lists are executed by their primary, not submitted")
 
     vkEndCommandBuffer(internal_cmdList.GetHandle());
     internal_cmdList.state = CommandListState::READY_FOR_SUBMIT;
+
+    std::lock_guard<std::mutex> lock(m_cmdListLock);
+    auto& queue = m_queues[internal_cmdList.GetQueueType()];
     
     if (queue.submissions.empty()) 
     {
@@ -689,6 +616,75 @@ void Device_Vulkan::ResizeSwapchain()
 
 }
 
+PipelineCacheKey Device_Vulkan::GetPipelineCacheKey() const
+{
+    const VkPhysicalDeviceProperties& props = vkContext->properties2.properties;
+
+    PipelineCacheKey key;
+    key.vendorID = props.vendorID;
+    key.deviceID = props.deviceID;
+    key.driverVersion = props.driverVersion;
+    memcpy(key.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+    memcpy(key.deviceUUID, vkContext->properties11.deviceUUID, VK_UUID_SIZE);
+    memcpy(key.driverUUID, vkContext->properties11.driverUUID, VK_UUID_SIZE);
+    return key;
+}
+
+void Device_Vulkan::LoadPipelineCache()
+{
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    // a cache from another gpu, another driver or a half written file is dropped, not handed to the driver
+    std::vector<byte> initialData;
+    if (FileSystem::Exists(std::string(PIPELINE_CACHE_PATH)))
+    {
+        std::vector<byte> file;
+        if (FileSystem::ReadFileBytes(PIPELINE_CACHE_PATH, file) && !DeserializePipelineCache(GetPipelineCacheKey(), file, initialData))
+            QK_CORE_LOGW_TAG("RHI", "Pipeline cache {} is outdated or damaged, starting with an empty one", PIPELINE_CACHE_PATH);
+    }
+
+    VkPipelineCacheCreateInfo createInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+    createInfo.initialDataSize = initialData.size();
+    createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+    VK_CHECK(vkCreatePipelineCache(vkDevice, &createInfo, nullptr, &vkPipelineCache))
+
+    QK_CORE_LOGI_TAG("RHI", "Pipeline cache loaded: {} bytes in {} ms", initialData.size(),
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+}
+
+void Device_Vulkan::SavePipelineCache()
+{
+    if (vkPipelineCache == VK_NULL_HANDLE)
+        return;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(vkDevice, vkPipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+        return;
+
+    std::vector<byte> data(size);
+    if (vkGetPipelineCacheData(vkDevice, vkPipelineCache, &size, data.data()) != VK_SUCCESS)
+        return;
+
+    // written next to the old file and renamed over it, so a crash never leaves a torn cache behind
+    const std::string tempPath = std::string(PIPELINE_CACHE_PATH) + ".tmp";
+    const std::filesystem::path directory = std::filesystem::path(PIPELINE_CACHE_PATH).parent_path();
+    if (!directory.empty() && !FileSystem::Exists(directory))
+        std::filesystem::create_directories(directory);
+
+    if (!FileSystem::WriteFileBytes(tempPath, SerializePipelineCache(GetPipelineCacheKey(), data.data(), size)))
+        return;
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, PIPELINE_CACHE_PATH, error);
+    if (error)
+    {
+        QK_CORE_LOGW_TAG("RHI", "Failed to write pipeline cache {}: {}", PIPELINE_CACHE_PATH, error.message());
+        return;
+    }
+
+    QK_CORE_LOGI_TAG("RHI", "Pipeline cache saved: {} bytes", size);
+}
+
 DataFormat Device_Vulkan::GetPresentImageFormat()
 {
     VkFormat format = vkContext->surfaceFormat.format;
@@ -724,7 +720,9 @@ PipeLineLayout* Device_Vulkan::Request_PipeLineLayout(const ShaderResourceLayout
     util::hash_combine(hash, combinedLayout.pushConstant.size);
     util::hash_combine(hash, combinedLayout.pushConstant.stageFlags);
     util::hash_combine(hash, combinedLayout.descriptorSetLayoutMask);
+    util::hash_combine(hash, combinedLayout.bindlessSetMask);
 
+    std::lock_guard<std::mutex> lock(m_pipelineLayoutLock);
     auto find = cached_pipelineLayouts.find(hash);
     if (find == cached_pipelineLayouts.end()) {
         // need to create a new pipeline layout
@@ -754,6 +752,7 @@ DescriptorSetAllocator* Device_Vulkan::Request_DescriptorSetAllocator(const Desc
     util::hash_combine(hash, layout.sampler_mask);
     util::hash_combine(hash, layout.input_attachment_mask);
 
+    std::lock_guard<std::mutex> lock(m_descriptorSetAllocatorLock);
     auto find = cached_descriptorSetAllocator.find(hash);
     if (find == cached_descriptorSetAllocator.end()) {
         // need to create a new descriptor set allocator
@@ -765,5 +764,15 @@ DescriptorSetAllocator* Device_Vulkan::Request_DescriptorSetAllocator(const Desc
     }
 
 }
-}
 
+DescriptorSetStats Device_Vulkan::GetDescriptorSetStats()
+{
+    DescriptorSetStats stats;
+
+    std::lock_guard<std::mutex> lock(m_descriptorSetAllocatorLock);
+    for (auto& [k, value] : cached_descriptorSetAllocator)
+        stats.Add(value.GetStats());
+
+    return stats;
+}
+}
@@ -7,49 +7,24 @@
 #include "Quark/RHI/Vulkan/CommandList_Vulkan.h"
 #include "Quark/RHI/Vulkan/PipeLine_Vulkan.h"
 #include "Quark/RHI/Vulkan/DescriptorSetAllocator.h"
+#include "Quark/RHI/Vulkan/PipelineCache_Vulkan.h"
+#include "Quark/RHI/Vulkan/UploadBatcher.h"
+#include "Quark/RHI/Vulkan/BindlessDescriptorTable.h"
 
 namespace quark::rhi {
 
 class Device_Vulkan final: public Device {
 public:
-    // Mostly for static data uploading with dedicated transfer queue
-    class CopyCmdAllocator {
-    public:
-        struct CopyCmd 
-        {   // command buffer for data transfering
-            VkCommandPool transferCmdPool = VK_NULL_HANDLE;
-            VkCommandBuffer transferCmdBuffer = VK_NULL_HANDLE;
-
-            // command buffer for image layout transitioning and image blitting
-            VkCommandPool transitionCmdPool = VK_NULL_HANDLE;
-            VkCommandBuffer transitionCmdBuffer = VK_NULL_HANDLE;
-
-            Ref<Buffer> stageBuffer = nullptr;
-
-            VkSemaphore semaphores[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
-            VkFence fence = VK_NULL_HANDLE;
-
-            bool isValid() const { return transferCmdBuffer && transitionCmdBuffer; }
-        };
-
-        void init(Device_Vulkan* device);
-        void destroy();
-        CopyCmd allocate(VkDeviceSize required_buffer_size);
-        void submit(CopyCmd cmd);
-
-    private:
-        Device_Vulkan* m_Device;
-        std::vector<CopyCmd> m_FreeList;
-        std::mutex m_Locker;
-    };
-
     struct PerFrameData {
         Device_Vulkan* device = nullptr;
         VmaAllocator vmaAllocator = nullptr;
         std::vector<CommandList_Vulkan*> cmdLists[QUEUE_TYPE_MAX_ENUM];
         u32 cmdListCount[QUEUE_TYPE_MAX_ENUM] = {}; //  The count of cmd used in this frame. Cleared when a new frame begin
+        std::vector<CommandList_Vulkan*> secondaryCmdLists; // Each one owns its command pool, so they can be recorded on different threads
+        u32 secondaryCmdListCount = 0;
         VkFence queueFences[QUEUE_TYPE_MAX_ENUM];   // Per queue fence. Signled when all command list submitted from this frame completed.
         std::vector<VkFence> waitedFences;
+        FrameDataAllocator dataAllocator;   // Reset with the fences
 
         VkSemaphore imageAvailableSemaphore;
         VkSemaphore imageReleaseSemaphore;
@@ -72,7 +47,9 @@ public:
     VkDevice vkDevice; // Borrowed from context, no lifetime management here
     VmaAllocator vmaAllocator; // Borrowed from context, no lifetime management here
     Scope<VulkanContext> vkContext;
-    CopyCmdAllocator copyAllocator;
+    UploadBatcher uploader;  // static data of buffers and images created with initial data
+    VkPipelineCache vkPipelineCache = VK_NULL_HANDLE; // Loaded from disk at Init(), written back at ShutDown()
+    Scope<BindlessDescriptorTable> bindlessTable; // Null if DeviceFeatures::bindlessImages is not supported
 
     // Cached objects
     std::unordered_map<size_t, PipeLineLayout> cached_pipelineLayouts;
@@ -96,11 +73,17 @@ public:
     Ref<PipeLine> CreateGraphicPipeLine(const GraphicPipeLineDesc& desc) override final;
     Ref<Sampler> CreateSampler(const SamplerDesc& desc) override final;
 
-    void CopyBuffer(Buffer& dst, Buffer& src, uint64_t size, uint64_t dstOffset = 0, uint64_t srcOffset = 0) override final;
+    void CopyBuffer(Buffer& dst, const Ref<Buffer>& src, uint64_t size, uint64_t dstOffset = 0, uint64_t srcOffset = 0) override final;
+    FrameAllocation AllocateFrameData(u64 size) override final;
+
+    /*** BINDLESS ***/
+    uint32_t RegisterBindlessImage(const Image& image, const Sampler& sampler) override final;
+    void UnregisterBindlessImage(uint32_t index) override final;
     
     /*** COMMAND LIST ***/
     CommandList* BeginCommandList(QueueType type = QueueType::QUEUE_TYPE_GRAPHICS) override final;
     void SubmitCommandList(CommandList* cmd, CommandList* waitedCmds = nullptr, uint32_t waitedCmdCounts = 0, bool signal = false) override final;
+    CommandList* BeginSecondaryCommandList(const CommandList& primary) override final;
 
     Image* GetPresentImage() override final { return m_swapChainImages[m_currentSwapChainImageIdx].get(); }
     DataFormat GetPresentImageFormat() override final;
@@ -108,6 +91,8 @@ public:
     bool isFormatSupported(DataFormat format) override final;
     void SetDebugName(const Ref<GpuResource>& resouce, const char* name) override final;
 
+    DescriptorSetStats GetDescriptorSetStats() override final; // summed over every cached allocator
+
     ///////////////////// Vulkan specific ////////////////////////
     //////////////////////////////////////////////////////////////
 public:
@@ -118,7 +103,12 @@ public:
     PerFrameData& GetCurrentFrame() { return m_frames[m_elapsedFrame % MAX_FRAME_NUM_IN_FLIGHT]; }
 
 private:
+    friend class UploadBatcher; // submits on the transfer and graphics queues
+
     void ResizeSwapchain();
+    void LoadPipelineCache();
+    void SavePipelineCache();
+    PipelineCacheKey GetPipelineCacheKey() const;
 
     // Represent a physical queue
     // Responsible for queuing commad buffers and submit them in batch
@@ -137,6 +127,7 @@ private:
         VkQueue queue = VK_NULL_HANDLE;
         std::vector<Submitssion> submissions;
         std::mutex locker;
+        uint64_t waitedUploadValue = 0; // uploads before this timeline value are visible to this queue
 
         void init(Device_Vulkan* device, QueueType type);
         void submit(VkFence fence = nullptr);
@@ -150,5 +141,12 @@ private:
 
     bool m_recreateSwapchain;
 
+    // pipelines may be created on worker threads, they request layouts and descriptor set allocators from the caches
+    std::mutex m_pipelineLayoutLock;
+    std::mutex m_descriptorSetAllocatorLock;
+
+    // command lists are begun and submitted from job threads
+    std::mutex m_cmdListLock;
+
 };
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Quark/qkpch.h"
+#include <numeric>
 #include "Quark/RHI/Vulkan/Image_Vulkan.h"
 #include "Quark/RHI/Vulkan/Device_Vulkan.h"
 
@@ -29,13 +30,12 @@ Image_Vulkan::Image_Vulkan(const ImageDesc& desc)
 
 }
 
-void Image_Vulkan::PrepareCopy(const ImageDesc& desc, const TextureFormatLayout& layout, const ImageInitData* init_data, Ref<Buffer> stage_buffer, std::vector<VkBufferImageCopy>& copys)
+void Image_Vulkan::PrepareCopy(const ImageDesc& desc, const TextureFormatLayout& layout, const ImageInitData* init_data, void* stage_data, VkDeviceSize stage_offset, std::vector<VkBufferImageCopy>& copys)
 {
     QK_CORE_ASSERT(copys.empty())
-    QK_CORE_ASSERT(stage_buffer->GetDesc().size >= layout.GetRequiredSize())
 
-    // Get mapped data ptr
-    void* mapped = stage_buffer->GetMappedDataPtr();
+    // Mapped data ptr of stage_offset
+    void* mapped = stage_data;
 
     size_t index = 0;
     // Loop per mipmap level to copy data into staging buffer
@@ -64,7 +64,7 @@ void Image_Vulkan::PrepareCopy(const ImageDesc& desc, const TextureFormatLayout&
 
         // Fill copy structs
         VkBufferImageCopy copy;
-        copy.bufferOffset = mip_info.offset;
+        copy.bufferOffset = stage_offset + mip_info.offset;
         copy.bufferRowLength = 0;   // padding has been removed in the above loop
         copy.bufferImageHeight = 0;
         copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -287,12 +287,12 @@ Image_Vulkan::Image_Vulkan(Device_Vulkan* device, const ImageDesc& desc, const I
         TextureFormatLayout layout;
         layout.SetUp2D(desc.format, desc.width, desc.height, desc.arraySize, desc.generateMipMaps? 1 : desc.mipLevels);
 
-        // Allocate a copy cmd with staging buffer
-        Device_Vulkan::CopyCmdAllocator::CopyCmd copyCmd = m_Device->copyAllocator.allocate(layout.GetRequiredSize());
+        // Record into the open upload batch with staging memory, offsets in the staging buffer must be a multiple of the texel block size
+        UploadBatcher::UploadCmd copyCmd = m_Device->uploader.begin(layout.GetRequiredSize(), std::lcm<VkDeviceSize>(16, layout.GetBlockStride()));
 
         // Fill staging buffer and copy structs
         std::vector<VkBufferImageCopy> copys;
-        PrepareCopy(desc, layout, init_data, copyCmd.stageBuffer, copys);
+        PrepareCopy(desc, layout, init_data, copyCmd.stageData, copyCmd.stageOffset, copys);
 
         // Transit image to transfer dst format
         VkImageMemoryBarrier2 barrier{};
@@ -320,7 +320,7 @@ Image_Vulkan::Image_Vulkan(Device_Vulkan* device, const ImageDesc& desc, const I
         vk_context->extendFunction.pVkCmdPipelineBarrier2KHR(copyCmd.transferCmdBuffer, &dependencyInfo);
 
         // Copy to image
-        vkCmdCopyBufferToImage(copyCmd.transferCmdBuffer, ToInternal(copyCmd.stageBuffer.get()).GetHandle(), m_Handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)copys.size(), copys.data());
+        vkCmdCopyBufferToImage(copyCmd.transferCmdBuffer, copyCmd.stageBuffer, m_Handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)copys.size(), copys.data());
         
         // Generate mipmaps? //TODO: change to use graphic queue to generate mipmaps
         if (desc.generateMipMaps) 
@@ -340,11 +340,11 @@ Image_Vulkan::Image_Vulkan(Device_Vulkan* device, const ImageDesc& desc, const I
             vk_context->extendFunction.pVkCmdPipelineBarrier2KHR(copyCmd.transitionCmdBuffer, &dependencyInfo);
         }
 
-        // submit and block cpu
-        m_Device->copyAllocator.submit(copyCmd);
+        // submitted with the other uploads of this frame
+        m_Device->uploader.end();
     }
     else if (desc.initialLayout != ImageLayout::UNDEFINED) {    // Transit layout to required init layout
-        Device_Vulkan::CopyCmdAllocator::CopyCmd transitCmd = m_Device->copyAllocator.allocate(0);
+        UploadBatcher::UploadCmd transitCmd = m_Device->uploader.begin(0);
 
         VkImageMemoryBarrier2 barrier = {};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
@@ -372,7 +372,7 @@ Image_Vulkan::Image_Vulkan(Device_Vulkan* device, const ImageDesc& desc, const I
         dependencyInfo.pImageMemoryBarriers = &barrier;
         vk_context->extendFunction.pVkCmdPipelineBarrier2KHR(transitCmd.transitionCmdBuffer, &dependencyInfo);
 
-        m_Device->copyAllocator.submit(transitCmd);
+        m_Device->uploader.end();
     }
     
 }
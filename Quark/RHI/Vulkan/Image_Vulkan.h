@@ -53,7 +53,7 @@ public:
     bool IsSwapChainImage() const { return m_IsSwapChainImage; }
     
 private:
-    void PrepareCopy(const ImageDesc& desc, const TextureFormatLayout& layout, const ImageInitData* init_data, Ref<Buffer> stage_buffer, std::vector<VkBufferImageCopy>& copys);
+    void PrepareCopy(const ImageDesc& desc, const TextureFormatLayout& layout, const ImageInitData* init_data, void* stage_data, VkDeviceSize stage_offset, std::vector<VkBufferImageCopy>& copys);
     void GenerateMipMap(const ImageDesc& desc, VkCommandBuffer cmd);
 
     Device_Vulkan* m_Device;
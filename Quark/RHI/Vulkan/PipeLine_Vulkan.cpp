@@ -124,6 +124,14 @@ PipeLineLayout::PipeLineLayout(Device_Vulkan* _device, const ShaderResourceLayou
         if ((combinedLayout.descriptorSetLayoutMask & 1u << set) == 0)
             continue;
 
+        if (combinedLayout.bindlessSetMask & 1u << set)
+        {
+            QK_CORE_VERIFY(combinedLayout.descriptorSetLayouts[set].bindings.empty(), "The bindless image array must be alone in its set")
+            QK_CORE_VERIFY(this->device->bindlessTable, "Shader uses bindless images, which the device does not support")
+            vk_descriptorset_layouts.push_back(this->device->bindlessTable->GetLayout());
+            continue;
+        }
+
         setAllocators[set] = this->device->Request_DescriptorSetAllocator(combinedLayout.descriptorSetLayouts[set]);
         vk_descriptorset_layouts.push_back(setAllocators[set]->GetLayout());
     }
@@ -146,10 +154,10 @@ PipeLineLayout::PipeLineLayout(Device_Vulkan* _device, const ShaderResourceLayou
 
     VK_CHECK(vkCreatePipelineLayout(this->device->vkDevice, &pipeline_layout_create_info, nullptr, &handle))
 
-    // Create descriptor set update template
+    // Create descriptor set update template, the bindless set is never updated by command lists
     for (size_t set = 0; set < DESCRIPTOR_SET_MAX_NUM; ++set) 
     {
-        if ((combinedLayout.descriptorSetLayoutMask & (1u << set)) == 0)
+        if ((combinedLayout.descriptorSetLayoutMask & ~combinedLayout.bindlessSetMask & (1u << set)) == 0)
             continue;
 
         VkDescriptorUpdateTemplateEntry update_entries[SET_BINDINGS_MAX_NUM];
@@ -201,7 +209,7 @@ PipeLineLayout::~PipeLineLayout()
 {
     for (size_t set = 0; set < DESCRIPTOR_SET_MAX_NUM; ++set) 
     {
-        if (combinedLayout.descriptorSetLayoutMask & (1u << set)) 
+        if (combinedLayout.descriptorSetLayoutMask & ~combinedLayout.bindlessSetMask & (1u << set)) 
             vkDestroyDescriptorUpdateTemplate(device->vkDevice, updateTemplate[set], nullptr);
     }
 
@@ -228,6 +236,7 @@ PipeLine_Vulkan::PipeLine_Vulkan(Device_Vulkan* device, const GraphicPipeLineDes
                     continue;
 
                 combinedLayout.descriptorSetLayoutMask |= 1u << i;
+                combinedLayout.bindlessSetMask |= shaderResourceLayout.bindlessSetMask & 1u << i;
                 const DescriptorSetLayout& srcSetLayout = shaderResourceLayout.descriptorSetLayouts[i];
                 DescriptorSetLayout& dstSetLayout = combinedLayout.descriptorSetLayouts[i];
                
@@ -504,7 +513,7 @@ PipeLine_Vulkan::PipeLine_Vulkan(Device_Vulkan* device, const GraphicPipeLineDes
     pipeline_create_info.layout = m_layout->handle;
     pipeline_create_info.pNext = &renderingInfo;
     pipeline_create_info.renderPass = nullptr;
-    VK_CHECK(vkCreateGraphicsPipelines(m_device->vkDevice, nullptr, 1, &pipeline_create_info, nullptr, &m_handle))
+    VK_CHECK(vkCreateGraphicsPipelines(m_device->vkDevice, m_device->vkPipelineCache, 1, &pipeline_create_info, nullptr, &m_handle))
 }
 
 PipeLine_Vulkan::~PipeLine_Vulkan()
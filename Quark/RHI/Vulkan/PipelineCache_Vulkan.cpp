@@ -0,0 +1,90 @@
+#include "Quark/qkpch.h"
+#include "Quark/RHI/Vulkan/PipelineCache_Vulkan.h"
+#include "Quark/Core/Util/Hash.h"
+
+namespace quark::rhi {
+
+static constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x43504b51;   // "QKPC"
+static constexpr uint32_t PIPELINE_CACHE_FILE_VERSION = 1;
+
+struct PipelineCacheFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    PipelineCacheKey key;
+    uint32_t headerSize;
+    uint64_t dataSize;
+    uint64_t dataHash;
+};
+
+// every byte of the header is checked, so it must not have padding
+static_assert(sizeof(PipelineCacheFileHeader) == 6 * sizeof(uint32_t) + 3 * VK_UUID_SIZE + 2 * sizeof(uint64_t));
+
+static uint64_t HashCacheData(const byte* data, size_t size)
+{
+    util::Hasher hasher;
+    hasher.data(data, size);
+    return hasher.get();
+}
+
+static bool operator==(const PipelineCacheKey& a, const PipelineCacheKey& b)
+{
+    return a.vendorID == b.vendorID && a.deviceID == b.deviceID && a.driverVersion == b.driverVersion &&
+        memcmp(a.pipelineCacheUUID, b.pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+        memcmp(a.deviceUUID, b.deviceUUID, VK_UUID_SIZE) == 0 &&
+        memcmp(a.driverUUID, b.driverUUID, VK_UUID_SIZE) == 0;
+}
+
+std::vector<byte> SerializePipelineCache(const PipelineCacheKey& key, const void* data, size_t size)
+{
+    PipelineCacheFileHeader header = {};
+    header.magic = PIPELINE_CACHE_MAGIC;
+    header.version = PIPELINE_CACHE_FILE_VERSION;
+    header.key = key;
+    header.headerSize = sizeof(header);
+    header.dataSize = size;
+    header.dataHash = HashCacheData((const byte*)data, size);
+
+    std::vector<byte> file(sizeof(header) + size);
+    memcpy(file.data(), &header, sizeof(header));
+    if (size > 0)
+        memcpy(file.data() + sizeof(header), data, size);
+    return file;
+}
+
+bool DeserializePipelineCache(const PipelineCacheKey& key, const std::vector<byte>& file, std::vector<byte>& out_data)
+{
+    out_data.clear();
+
+    PipelineCacheFileHeader header;
+    if (file.size() < sizeof(header))
+        return false;
+    memcpy(&header, file.data(), sizeof(header));
+
+    if (header.magic != PIPELINE_CACHE_MAGIC || header.version != PIPELINE_CACHE_FILE_VERSION || header.headerSize != sizeof(header))
+        return false;
+
+    // written by another gpu or another driver version
+    if (!(header.key == key))
+        return false;
+
+    const byte* data = file.data() + sizeof(header);
+    if (header.dataSize != file.size() - sizeof(header) || header.dataHash != HashCacheData(data, header.dataSize))
+        return false;
+
+    // the driver's own header has to agree with ours too
+    VkPipelineCacheHeaderVersionOne driverHeader;
+    if (header.dataSize < sizeof(driverHeader))
+        return false;
+    memcpy(&driverHeader, data, sizeof(driverHeader));
+    if (driverHeader.headerSize < sizeof(driverHeader) || driverHeader.headerSize > header.dataSize ||
+        driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        driverHeader.vendorID != key.vendorID || driverHeader.deviceID != key.deviceID ||
+        memcmp(driverHeader.pipelineCacheUUID, key.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        return false;
+
+    out_data.assign(data, data + header.dataSize);
+    return true;
+}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+
+#include "Quark/Core/Base.h"
+
+namespace quark::rhi {
+
+// Identity of the device and driver a pipeline cache was written by.
+// A cache from any other combination is useless at best, drivers are not required to check it.
+struct PipelineCacheKey
+{
+    uint32_t vendorID = 0;
+    uint32_t deviceID = 0;
+    uint32_t driverVersion = 0;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE] = {};
+    uint8_t deviceUUID[VK_UUID_SIZE] = {};
+    uint8_t driverUUID[VK_UUID_SIZE] = {};
+};
+
+// The on disk file is a header with the key, the data size and a hash of the data, followed by what
+// vkGetPipelineCacheData() returned
+std::vector<byte> SerializePipelineCache(const PipelineCacheKey& key, const void* data, size_t size);
+
+// Returns false and leaves out_data empty when the file is truncated, damaged or from another device or driver.
+// What is returned is safe to hand to vkCreatePipelineCache()
+bool DeserializePipelineCache(const PipelineCacheKey& key, const std::vector<byte>& file, std::vector<byte>& out_data);
+
+}
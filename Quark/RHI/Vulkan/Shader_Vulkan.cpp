@@ -84,6 +84,14 @@ Shader_Vulkan::Shader_Vulkan(Device_Vulkan* device, ShaderStage stage, const voi
 
         m_ResourceLayout.descriptorSetLayoutMask |= 1 << set;
 
+        // An unsized sampler array is the bindless image array, its set layout is the device's
+        if (b->descriptor_type == SPV_REFLECT_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER && b->type_description->op == SpvOpTypeRuntimeArray)
+        {
+            QK_CORE_VERIFY(bind_slot == 0, "The bindless image array must be binding 0 of its set")
+            m_ResourceLayout.bindlessSetMask |= 1 << set;
+            continue;
+        }
+
         VkDescriptorSetLayoutBinding& layout_binding = m_ResourceLayout.descriptorSetLayouts[set].bindings.emplace_back();
         layout_binding.binding = bind_slot;
         layout_binding.stageFlags = m_StageInfo.stage;
@@ -9,6 +9,7 @@ struct ShaderResourceLayout {
     DescriptorSetLayout descriptorSetLayouts[DESCRIPTOR_SET_MAX_NUM] = {};
     VkPushConstantRange pushConstant = {};
     uint32_t descriptorSetLayoutMask = 0;
+    uint32_t bindlessSetMask = 0;   // sets holding only the device's bindless image array, a subset of descriptorSetLayoutMask
 };
 
 class Shader_Vulkan : public Shader {
@@ -0,0 +1,283 @@
+#include "Quark/qkpch.h"
+#include "Quark/RHI/Vulkan/UploadBatcher.h"
+#include "Quark/RHI/Vulkan/Buffer_Vulkan.h"
+#include "Quark/RHI/Vulkan/Device_Vulkan.h"
+
+namespace quark::rhi {
+
+void UploadBatcher::init(Device_Vulkan* device)
+{
+    m_Device = device;
+
+    BufferDesc bufferDesc;
+    bufferDesc.domain = BufferMemoryDomain::CPU;
+    bufferDesc.size = STAGING_RING_SIZE;
+    bufferDesc.usageBits = BUFFER_USAGE_TRANSFER_FROM_BIT;
+    m_StageRingBuffer = m_Device->CreateBuffer(bufferDesc);
+    m_StageRing.reset(STAGING_RING_SIZE);
+    m_Device->SetDebugName(m_StageRingBuffer, "UploadBatcher staging ring");
+
+    VkSemaphoreTypeCreateInfo timelineInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+    timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    timelineInfo.initialValue = 0;
+    VkSemaphoreCreateInfo semaphoreInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+    semaphoreInfo.pNext = &timelineInfo;
+    VK_CHECK(vkCreateSemaphore(m_Device->vkDevice, &semaphoreInfo, nullptr, &m_TimelineSemaphore))
+
+    m_SubmittedValue = 0;
+    m_Stats = {};
+}
+
+void UploadBatcher::destroy()
+{
+    // Make sure all batches are retired
+    flush();
+    retireBatches(m_SubmittedValue);
+
+    if (m_BatchOpen)
+        m_FreeBatches.push_back(std::move(m_OpenBatch));
+    m_BatchOpen = false;
+
+    for (auto& x : m_FreeBatches)
+    {
+        vkDestroyCommandPool(m_Device->vkDevice, x.transferCmdPool, nullptr);
+        vkDestroyCommandPool(m_Device->vkDevice, x.transitionCmdPool, nullptr);
+    }
+
+    m_FreeBatches.clear();
+    m_StageRingBuffer.reset();
+    vkDestroySemaphore(m_Device->vkDevice, m_TimelineSemaphore, nullptr);
+    m_TimelineSemaphore = VK_NULL_HANDLE;
+}
+
+UploadBatcher::UploadCmd UploadBatcher::begin(VkDeviceSize staging_size, VkDeviceSize alignment)
+{
+    m_Locker.lock();
+
+    retireBatches(0);
+    if (!m_BatchOpen)
+        openBatch();
+
+    UploadCmd cmd;
+    cmd.transferCmdBuffer = m_OpenBatch.transferCmdBuffer;
+    cmd.transitionCmdBuffer = m_OpenBatch.transitionCmdBuffer;
+    m_OpenBatch.uploadCount++;
+    m_Stats.uploads++;
+    m_Stats.stagedBytes += staging_size;
+
+    if (staging_size == 0)
+        return cmd;
+
+    if (staging_size > DEDICATED_STAGING_SIZE)
+    {
+        // Too big to share the ring, the buffer lives until the batch is retired
+        BufferDesc bufferDesc;
+        bufferDesc.domain = BufferMemoryDomain::CPU;
+        bufferDesc.size = staging_size;
+        bufferDesc.usageBits = BUFFER_USAGE_TRANSFER_FROM_BIT;
+        Ref<Buffer> stageBuffer = m_Device->CreateBuffer(bufferDesc);
+        m_OpenBatch.retainedBuffers.push_back(stageBuffer);
+        m_Stats.dedicatedStagingBuffers++;
+
+        cmd.stageBuffer = ToInternal(stageBuffer.get()).GetHandle();
+        cmd.stageOffset = 0;
+        cmd.stageData = stageBuffer->GetMappedDataPtr();
+        return cmd;
+    }
+
+    uint64_t offset = m_StageRing.allocate(staging_size, alignment);
+    while (offset == util::RingAllocator::INVALID_OFFSET)
+    {
+        // The ring is full of uploads the GPU has not done yet: submit ours, then wait for the oldest batch
+        if (m_StageRing.get_open_size() > 0)
+        {
+            submitBatch();
+            openBatch();
+            m_OpenBatch.uploadCount++;
+            cmd.transferCmdBuffer = m_OpenBatch.transferCmdBuffer;
+            cmd.transitionCmdBuffer = m_OpenBatch.transitionCmdBuffer;
+        }
+
+        QK_CORE_ASSERT(m_StageRing.has_pending())
+        retireBatches(m_StageRing.get_oldest_pending_value());
+        m_Stats.stagingWaits++;
+        offset = m_StageRing.allocate(staging_size, alignment);
+    }
+
+    cmd.stageBuffer = ToInternal(m_StageRingBuffer.get()).GetHandle();
+    cmd.stageOffset = offset;
+    cmd.stageData = static_cast<uint8_t*>(m_StageRingBuffer->GetMappedDataPtr()) + offset;
+    return cmd;
+}
+
+void UploadBatcher::end()
+{
+    m_Locker.unlock();
+}
+
+void UploadBatcher::retain(const Ref<Buffer>& buffer)
+{
+    QK_CORE_ASSERT(m_BatchOpen)
+    m_OpenBatch.retainedBuffers.push_back(buffer);
+}
+
+uint64_t UploadBatcher::flush()
+{
+    std::scoped_lock lock(m_Locker);
+
+    if (m_BatchOpen && m_OpenBatch.uploadCount > 0)
+        submitBatch();
+
+    return m_SubmittedValue;
+}
+
+UploadBatcher::Stats UploadBatcher::getStats()
+{
+    std::scoped_lock lock(m_Locker);
+    return m_Stats;
+}
+
+void UploadBatcher::openBatch()
+{
+    QK_CORE_ASSERT(!m_BatchOpen)
+
+    if (!m_FreeBatches.empty())
+    {
+        m_OpenBatch = std::move(m_FreeBatches.back());
+        m_FreeBatches.pop_back();
+    }
+    else
+    {
+        // Create command pool
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = m_Device->vkContext->transferQueueIndex;
+        VK_CHECK(vkCreateCommandPool(m_Device->vkDevice, &poolInfo, nullptr, &m_OpenBatch.transferCmdPool))
+
+        poolInfo.queueFamilyIndex = m_Device->vkContext->graphicQueueIndex;
+        VK_CHECK(vkCreateCommandPool(m_Device->vkDevice, &poolInfo, nullptr, &m_OpenBatch.transitionCmdPool))
+
+        // Allocate command buffer
+        VkCommandBufferAllocateInfo commandBufferInfo = {};
+        commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferInfo.commandBufferCount = 1;
+        commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferInfo.commandPool = m_OpenBatch.transferCmdPool;
+        VK_CHECK(vkAllocateCommandBuffers(m_Device->vkDevice, &commandBufferInfo, &m_OpenBatch.transferCmdBuffer))
+
+        commandBufferInfo.commandPool = m_OpenBatch.transitionCmdPool;
+        VK_CHECK(vkAllocateCommandBuffers(m_Device->vkDevice, &commandBufferInfo, &m_OpenBatch.transitionCmdBuffer))
+    }
+
+    // Begin command buffer in valid state:
+    VK_CHECK(vkResetCommandPool(m_Device->vkDevice, m_OpenBatch.transferCmdPool, 0))
+    VK_CHECK(vkResetCommandPool(m_Device->vkDevice, m_OpenBatch.transitionCmdPool, 0))
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = nullptr;
+    VK_CHECK(vkBeginCommandBuffer(m_OpenBatch.transferCmdBuffer, &beginInfo))
+    VK_CHECK(vkBeginCommandBuffer(m_OpenBatch.transitionCmdBuffer, &beginInfo))
+
+    m_OpenBatch.uploadCount = 0;
+    m_BatchOpen = true;
+}
+
+void UploadBatcher::submitBatch()
+{
+    QK_CORE_ASSERT(m_BatchOpen)
+
+    VK_CHECK(vkEndCommandBuffer(m_OpenBatch.transferCmdBuffer))
+    VK_CHECK(vkEndCommandBuffer(m_OpenBatch.transitionCmdBuffer))
+
+    // The copies signal the odd value, the transitions waiting for them the even one
+    const uint64_t copyValue = m_SubmittedValue + 1;
+    const uint64_t doneValue = m_SubmittedValue + 2;
+
+    VkSubmitInfo2 submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+
+    VkCommandBufferSubmitInfo cbSubmitInfo = {};
+    cbSubmitInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+
+    VkSemaphoreSubmitInfo signalSemaphoreInfo = {};
+    signalSemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    signalSemaphoreInfo.semaphore = m_TimelineSemaphore;
+    signalSemaphoreInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    VkSemaphoreSubmitInfo waitSemaphoreInfo = {};
+    waitSemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    waitSemaphoreInfo.semaphore = m_TimelineSemaphore;
+    waitSemaphoreInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    // Submit to transfer queue
+    {
+        cbSubmitInfo.commandBuffer = m_OpenBatch.transferCmdBuffer;
+        signalSemaphoreInfo.value = copyValue;
+
+        submitInfo.commandBufferInfoCount = 1;
+        submitInfo.pCommandBufferInfos = &cbSubmitInfo;
+        submitInfo.signalSemaphoreInfoCount = 1;
+        submitInfo.pSignalSemaphoreInfos = &signalSemaphoreInfo;
+
+        std::scoped_lock lock(m_Device->m_queues[QUEUE_TYPE_ASYNC_TRANSFER].locker);
+        m_Device->vkContext->extendFunction.pVkQueueSubmit2KHR(
+            m_Device->m_queues[QUEUE_TYPE_ASYNC_TRANSFER].queue, 1, &submitInfo, VK_NULL_HANDLE);
+    }
+
+    // Submit to graphics queue
+    {
+        waitSemaphoreInfo.value = copyValue; // wait for copy queue
+
+        cbSubmitInfo.commandBuffer = m_OpenBatch.transitionCmdBuffer;
+        signalSemaphoreInfo.value = doneValue;
+
+        submitInfo.waitSemaphoreInfoCount = 1;
+        submitInfo.pWaitSemaphoreInfos = &waitSemaphoreInfo;
+        submitInfo.commandBufferInfoCount = 1;
+        submitInfo.pCommandBufferInfos = &cbSubmitInfo;
+        submitInfo.signalSemaphoreInfoCount = 1;
+        submitInfo.pSignalSemaphoreInfos = &signalSemaphoreInfo;
+
+        std::scoped_lock lock(m_Device->m_queues[QUEUE_TYPE_GRAPHICS].locker);
+        m_Device->vkContext->extendFunction.pVkQueueSubmit2KHR(
+            m_Device->m_queues[QUEUE_TYPE_GRAPHICS].queue, 1, &submitInfo, VK_NULL_HANDLE);
+    }
+
+    m_SubmittedValue = doneValue;
+    m_StageRing.close(doneValue);
+    m_OpenBatch.timelineValue = doneValue;
+    m_InFlightBatches.push_back(std::move(m_OpenBatch));
+    m_OpenBatch = {};
+    m_BatchOpen = false;
+    m_Stats.submissions++;
+}
+
+void UploadBatcher::retireBatches(uint64_t wait_value)
+{
+    if (wait_value > 0)
+    {
+        VkSemaphoreWaitInfo waitInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &m_TimelineSemaphore;
+        waitInfo.pValues = &wait_value;
+        VK_CHECK(vkWaitSemaphores(m_Device->vkDevice, &waitInfo, UINT64_MAX))
+    }
+
+    uint64_t completedValue = 0;
+    VK_CHECK(vkGetSemaphoreCounterValue(m_Device->vkDevice, m_TimelineSemaphore, &completedValue))
+
+    while (!m_InFlightBatches.empty() && m_InFlightBatches.front().timelineValue <= completedValue)
+    {
+        Batch& batch = m_InFlightBatches.front();
+        batch.retainedBuffers.clear();
+        m_FreeBatches.push_back(std::move(batch));
+        m_InFlightBatches.pop_front();
+    }
+
+    m_StageRing.release(completedValue);
+}
+
+}
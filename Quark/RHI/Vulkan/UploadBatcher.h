@@ -0,0 +1,91 @@
+#pragma once
+#include "Quark/Core/Util/RingAllocator.h"
+#include "Quark/RHI/Buffer.h"
+#include "Quark/RHI/Vulkan/Common_Vulkan.h"
+
+namespace quark::rhi {
+
+class Device_Vulkan;
+
+// Static data uploading of buffers and images, with the dedicated transfer queue.
+// Uploads are staged in a persistently mapped ring buffer and recorded into one open batch, which is submitted
+// by flush(): once per frame by the device, or earlier when the staging ring runs out of room.
+// A batch is its copies on the transfer queue, then its layout transitions and mip generation on the graphics
+// queue. Both signal a timeline semaphore, the graphics queue waits for the last value before using the data,
+// the CPU only waits when it needs staging memory back.
+class UploadBatcher {
+public:
+    static constexpr VkDeviceSize STAGING_RING_SIZE = 64 * 1024 * 1024;
+    static constexpr VkDeviceSize DEDICATED_STAGING_SIZE = STAGING_RING_SIZE / 4; // bigger uploads get a staging buffer of their own
+
+    struct UploadCmd
+    {
+        VkCommandBuffer transferCmdBuffer = VK_NULL_HANDLE;     // copies, on the transfer queue
+        VkCommandBuffer transitionCmdBuffer = VK_NULL_HANDLE;   // layout transitions and blits, on the graphics queue after the copies
+
+        VkBuffer stageBuffer = VK_NULL_HANDLE;
+        VkDeviceSize stageOffset = 0;
+        void* stageData = nullptr;  // mapped pointer to stageOffset
+    };
+
+    struct Stats
+    {
+        uint64_t submissions = 0;
+        uint64_t uploads = 0;
+        uint64_t stagedBytes = 0;
+        uint64_t stagingWaits = 0;      // the CPU waited for the GPU to give staging memory back
+        uint64_t dedicatedStagingBuffers = 0;
+    };
+
+    void init(Device_Vulkan* device);
+    void destroy();
+
+    // Returns command buffers of the open batch and staging_size bytes of staging memory.
+    // No other thread can record an upload until end()
+    UploadCmd begin(VkDeviceSize staging_size, VkDeviceSize alignment = 16);
+    void end();
+
+    // Keeps a buffer the open batch reads alive until the batch is retired, between begin() and end()
+    void retain(const Ref<Buffer>& buffer);
+
+    // Submits the open batch. Returns the timeline value signaled once everything recorded so far is done
+    uint64_t flush();
+
+    VkSemaphore getTimelineSemaphore() const { return m_TimelineSemaphore; }
+    Stats getStats();
+
+private:
+    struct Batch
+    {
+        VkCommandPool transferCmdPool = VK_NULL_HANDLE;
+        VkCommandBuffer transferCmdBuffer = VK_NULL_HANDLE;
+        VkCommandPool transitionCmdPool = VK_NULL_HANDLE;
+        VkCommandBuffer transitionCmdBuffer = VK_NULL_HANDLE;
+
+        std::vector<Ref<Buffer>> retainedBuffers;   // dedicated staging buffers and copy sources
+        uint64_t timelineValue = 0;
+        uint32_t uploadCount = 0;
+    };
+
+    void openBatch();
+    void submitBatch();
+    void retireBatches(uint64_t wait_value);
+
+    Device_Vulkan* m_Device = nullptr;
+
+    Ref<Buffer> m_StageRingBuffer;
+    util::RingAllocator m_StageRing;
+
+    VkSemaphore m_TimelineSemaphore = VK_NULL_HANDLE;
+    uint64_t m_SubmittedValue = 0;
+
+    Batch m_OpenBatch;
+    bool m_BatchOpen = false;
+    std::deque<Batch> m_InFlightBatches;
+    std::vector<Batch> m_FreeBatches;
+
+    std::mutex m_Locker;
+    Stats m_Stats;
+};
+
+}
@@ -0,0 +1,153 @@
+#include "Quark/qkpch.h"
+#include "Quark/Render/DrawList.h"
+#include "Quark/Core/JobSystem.h"
+#include "Quark/Core/Util/RadixSort.h"
+
+namespace quark {
+
+// chunks smaller than this cost more to hand to a worker than to sort
+constexpr uint32_t MIN_CHUNK_SIZE = 2048;
+
+static bool IsSameBatch(const RenderObject& A, const RenderObject& B)
+{
+    return A.render_material_id == B.render_material_id && A.render_mesh_id == B.render_mesh_id &&
+        A.start_index == B.start_index && A.index_count == B.index_count;
+}
+
+// Runs func(chunk) for every chunk, on the job system if there is more than one
+static void ForEachChunk(JobSystem* job_system, uint32_t chunk_count, const std::function<void(uint32_t)>& func)
+{
+    if (job_system && chunk_count > 1)
+    {
+        JobSystem::Counter counter{};
+        job_system->Dispatch(chunk_count, 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t chunk = begin; chunk < end; chunk++)
+                func(chunk);
+        }, &counter);
+        job_system->Wait(&counter, 1);
+    }
+    else
+    {
+        for (uint32_t chunk = 0; chunk < chunk_count; chunk++)
+            func(chunk);
+    }
+}
+
+// depth as the top bits of the float, which keep their order for positive values
+static uint32_t QuantizeDepth(float view_distance, uint32_t bits)
+{
+    uint32_t float_bits;
+    float distance = std::max(view_distance, 0.f);
+    std::memcpy(&float_bits, &distance, sizeof(float));
+    return float_bits >> (32 - bits);
+}
+
+uint64_t DrawList::GetSortKey(const RenderObject& obj, float view_distance)
+{
+    auto field = [](uint64_t value, uint32_t bits, uint32_t shift) { return (value & ((1ull << bits) - 1)) << shift; };
+
+    if (!obj.transparent)
+    {
+        const uint32_t geometry = obj.section_index * MESH_LOD_MAX_NUM + obj.lod;
+        return field(0, 2, 62) | field(obj.pipeline_index, DRAW_SORT_PIPELINE_INDEX_BITS, 54) | field(obj.material_sort_index, DRAW_SORT_MATERIAL_INDEX_BITS, 40) |
+            field(obj.mesh_sort_index, DRAW_SORT_MESH_INDEX_BITS, 26) | field(geometry, DRAW_SORT_GEOMETRY_BITS, 16) | field(QuantizeDepth(view_distance, 16), 16, 0);
+    }
+    else
+    {
+        const uint32_t inverted_depth = ~QuantizeDepth(view_distance, 24);
+        return field(1, 2, 62) | field(inverted_depth, 24, 38) | field(obj.pipeline_index, DRAW_SORT_PIPELINE_INDEX_BITS, 30) |
+            field(obj.material_sort_index, DRAW_SORT_MATERIAL_INDEX_BITS, 16) | field(obj.mesh_sort_index, DRAW_SORT_MESH_INDEX_BITS, 0);
+    }
+}
+
+void DrawList::Build(const std::vector<RenderObject>& objects, const std::vector<uint32_t>& object_indexes, const glm::vec3& view_position, JobSystem* job_system)
+{
+    Clear();
+    if (object_indexes.empty())
+        return;
+
+    const uint32_t object_count = (uint32_t)object_indexes.size();
+    uint32_t chunk_count = 1;
+    if (job_system)
+        chunk_count = std::clamp(object_count / MIN_CHUNK_SIZE, 1u, job_system->GetNumWorkerThreads());
+    const uint32_t chunk_size = (object_count + chunk_count - 1) / chunk_count;
+    auto chunk_begin = [&](uint32_t chunk) { return std::min(chunk * chunk_size, object_count); };
+
+    // key and sort every chunk, then merge sorted neighbours in pairs until one run is left.
+    // both sorts are stable, so the order is the same with any number of chunks
+    m_sort_items.resize(object_count);
+    m_sort_buffer.resize(object_count);
+    ForEachChunk(job_system, chunk_count, [&](uint32_t chunk)
+    {
+        const uint32_t begin = chunk_begin(chunk);
+        const uint32_t end = chunk_begin(chunk + 1);
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const RenderObject& obj = objects[object_indexes[i]];
+            const float view_distance = glm::length(glm::vec3(obj.model_matrix[3]) - view_position);
+            m_sort_items[i] = { GetSortKey(obj, view_distance), object_indexes[i] };
+        }
+
+        util::radix_sort(m_sort_items.data() + begin, m_sort_buffer.data() + begin, end - begin, [](const SortItem& item) { return item.key; });
+    });
+
+    for (uint32_t run_size = chunk_size; run_size < object_count; run_size *= 2)
+    {
+        const uint32_t pair_count = (object_count + 2 * run_size - 1) / (2 * run_size);
+        ForEachChunk(job_system, pair_count, [&](uint32_t pair)
+        {
+            const uint32_t begin = pair * 2 * run_size;
+            const uint32_t middle = std::min(begin + run_size, object_count);
+            const uint32_t end = std::min(begin + 2 * run_size, object_count);
+            std::merge(m_sort_items.begin() + begin, m_sort_items.begin() + middle,
+                m_sort_items.begin() + middle, m_sort_items.begin() + end, m_sort_buffer.begin() + begin,
+                [](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+        });
+        m_sort_items.swap(m_sort_buffer);
+    }
+
+    // every chunk copies its instances and finds where its batches start
+    instances.resize(object_count);
+    m_chunk_batch_starts.resize(chunk_count);
+    ForEachChunk(job_system, chunk_count, [&](uint32_t chunk)
+    {
+        std::vector<uint32_t>& starts = m_chunk_batch_starts[chunk];
+        starts.clear();
+        for (uint32_t i = chunk_begin(chunk); i < chunk_begin(chunk + 1); i++)
+        {
+            const RenderObject& obj = objects[m_sort_items[i].object_index];
+            if (i == 0 || !IsSameBatch(objects[m_sort_items[i - 1].object_index], obj))
+                starts.push_back(i);
+
+            instances[i].worldMatrix = obj.model_matrix;
+        }
+    });
+
+    for (const std::vector<uint32_t>& starts : m_chunk_batch_starts)
+    {
+        for (uint32_t start : starts)
+        {
+            if (!batches.empty())
+                batches.back().instance_count = start - batches.back().first_instance;
+
+            const RenderObject& obj = objects[m_sort_items[start].object_index];
+            DrawBatch& batch = batches.emplace_back();
+            batch.render_mesh_id = obj.render_mesh_id;
+            batch.render_material_id = obj.render_material_id;
+            batch.pipeline_index = obj.pipeline_index;
+            batch.start_index = obj.start_index;
+            batch.index_count = obj.index_count;
+            batch.first_instance = start;
+        }
+    }
+    batches.back().instance_count = object_count - batches.back().first_instance;
+}
+
+void DrawList::Clear()
+{
+    batches.clear();
+    instances.clear();
+}
+
+}
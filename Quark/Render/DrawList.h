@@ -0,0 +1,61 @@
+#pragma once
+#include "Quark/Render/RenderTypes.h"
+
+#include <vector>
+
+namespace quark {
+
+class JobSystem;
+
+// Per instance data read by the mesh vertex shaders through gl_InstanceIndex
+struct InstanceData_Model
+{
+    glm::mat4 worldMatrix;
+};
+
+// One instanced draw: every instance shares the mesh, the index range and the material.
+// Mesh and material decide the pipeline, so a batch never needs more than one pipeline bind.
+struct DrawBatch
+{
+    uint64_t render_mesh_id = 0;
+    uint64_t render_material_id = 0;
+    uint32_t pipeline_index = 0;    // same for every object of the batch, it follows from the mesh and the material
+    uint32_t start_index = 0;
+    uint32_t index_count = 0;
+
+    uint32_t first_instance = 0;    // into DrawList::instances
+    uint32_t instance_count = 0;
+};
+
+// CPU side of instanced drawing, built once per frame from the visible render objects.
+// Objects are radix sorted by a 64 bit key, instances of a batch are contiguous.
+struct DrawList
+{
+    std::vector<DrawBatch> batches;
+    std::vector<InstanceData_Model> instances;
+
+    // With a job system the objects are sorted and batched in chunks on the workers, the result is the same
+    void Build(const std::vector<RenderObject>& objects, const std::vector<uint32_t>& object_indexes, const glm::vec3& view_position, JobSystem* job_system = nullptr);
+    void Clear();
+
+    // Opaque objects are drawn first, by pipeline, material, mesh, section and lod, then front to back:
+    //   | pass 2 | pipeline 8 | material 14 | mesh 14 | section and lod 10 | depth 16 |
+    // transparent objects after them back to front, then by state:
+    //   | pass 2 | inverted depth 24 | pipeline 8 | material 14 | unused 2 | mesh 14 |
+    // The index widths are the DRAW_SORT_*_BITS constants, the RenderResourceManager checks them when it hands out an index
+    // and the RenderSystem checks the section index against DRAW_SORT_SECTION_MAX_NUM.
+    static uint64_t GetSortKey(const RenderObject& obj, float view_distance);
+
+private:
+    struct SortItem
+    {
+        uint64_t key;
+        uint32_t object_index;
+    };
+
+    std::vector<SortItem> m_sort_items;
+    std::vector<SortItem> m_sort_buffer;
+    std::vector<std::vector<uint32_t>> m_chunk_batch_starts;   // first sorted index of every batch, per chunk
+};
+
+}
@@ -0,0 +1,258 @@
+#include "Quark/qkpch.h"
+#include "Quark/Render/LightClusters.h"
+#include "Quark/Core/JobSystem.h"
+
+namespace quark {
+
+static bool SphereIntersectsAabb(const glm::vec3& center, float radius, const math::Aabb& aabb)
+{
+    const glm::vec3 closest = glm::clamp(center, aabb.Min(), aabb.Max());
+    const glm::vec3 d = center - closest;
+    return glm::dot(d, d) <= radius * radius;
+}
+
+LightClusters::LightClusters(uint32_t tiles_x, uint32_t tiles_y, uint32_t slice_count, float z_near, float z_far)
+    : m_tiles_x(tiles_x), m_tiles_y(tiles_y), m_slice_count(slice_count), m_z_near(z_near), m_z_far(z_far)
+{
+    QK_CORE_VERIFY(tiles_x > 0 && tiles_y > 0 && slice_count > 0 && z_near > 0.f && z_far > z_near)
+
+    const float log_range = std::log(z_far / z_near);
+    m_uniform_data.grid_size = glm::uvec4(tiles_x, tiles_y, slice_count, 0);
+    m_uniform_data.depth_params = glm::vec4(slice_count / log_range, -(float)slice_count * std::log(z_near) / log_range, z_near, z_far);
+
+    m_cluster_ranges.resize(GetClusterCount(), glm::uvec2(0));
+    m_cluster_bounds.resize(GetClusterCount());
+    m_slice_bins.resize(slice_count);
+    m_slice_offsets.resize(slice_count);
+}
+
+uint32_t LightClusters::GetSlice(float view_depth) const
+{
+    if (view_depth <= m_z_near)
+        return 0;
+
+    const float slice = std::floor(std::log(view_depth) * m_uniform_data.depth_params.x + m_uniform_data.depth_params.y);
+    return (uint32_t)std::clamp(slice, 0.f, (float)(m_slice_count - 1));
+}
+
+float LightClusters::GetSliceDepth(uint32_t slice) const
+{
+    return m_z_near * std::pow(m_z_far / m_z_near, (float)slice / m_slice_count);
+}
+
+math::Aabb LightClusters::GetClusterBounds(uint32_t x, uint32_t y, uint32_t slice) const
+{
+    const float near_depth = slice == 0 ? 0.f : GetSliceDepth(slice);
+    const float far_depth = GetSliceDepth(slice + 1);
+
+    const glm::vec2 ndc_min(2.f * x / m_tiles_x - 1.f, 2.f * y / m_tiles_y - 1.f);
+    const glm::vec2 ndc_max(2.f * (x + 1) / m_tiles_x - 1.f, 2.f * (y + 1) / m_tiles_y - 1.f);
+
+    // a view space point at depth d lands on ndc (x, y) when x = d * (ndc.x + proj[2][0]) / proj[0][0], same for y
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(std::numeric_limits<float>::lowest());
+    for (float depth : { near_depth, far_depth })
+    {
+        for (float nx : { ndc_min.x, ndc_max.x })
+        {
+            for (float ny : { ndc_min.y, ndc_max.y })
+            {
+                const glm::vec3 p(depth * (nx + m_proj[2][0]) / m_proj[0][0], depth * (ny + m_proj[2][1]) / m_proj[1][1], -depth);
+                min = glm::min(min, p);
+                max = glm::max(max, p);
+            }
+        }
+    }
+    return math::Aabb(min, max);
+}
+
+glm::vec4 LightClusters::GetBoundingSphere(const StorageBufferData_Light& light)
+{
+    const glm::vec3 position = glm::vec3(light.position_range);
+    const float range = light.position_range.w;
+    const float cos_angle = light.direction_spot_cos.w;
+    if (cos_angle <= 0.f)
+        return glm::vec4(position, range);
+
+    // a wide cone is bounded by the sphere around its cap, a narrow one by the sphere through its apex and cap rim
+    const glm::vec3 direction = glm::vec3(light.direction_spot_cos);
+    if (cos_angle < 0.70710678f)
+    {
+        const float sin_angle = std::sqrt(1.f - cos_angle * cos_angle);
+        return glm::vec4(position + direction * range * cos_angle, range * sin_angle);
+    }
+
+    const float radius = range / (2.f * cos_angle);
+    return glm::vec4(position + direction * radius, radius);
+}
+
+void LightClusters::SetupLight(const StorageBufferData_Light& light, LightBounds& out_bounds) const
+{
+    const glm::vec4 sphere = GetBoundingSphere(light);
+    out_bounds.center = glm::vec3(m_view * glm::vec4(glm::vec3(sphere), 1.f));
+    out_bounds.radius = sphere.w;
+
+    // behind the camera or past the last slice
+    const float depth = -out_bounds.center.z;
+    const float radius = out_bounds.radius;
+    out_bounds.visible = depth + radius > 0.f && depth - radius < m_z_far;
+    if (!out_bounds.visible)
+        return;
+
+    // one slice more on each side, GetSlice() and the cluster boxes may round apart at slice borders
+    out_bounds.min_slice = GetSlice(depth - radius);
+    out_bounds.max_slice = GetSlice(depth + radius);
+    out_bounds.min_slice = out_bounds.min_slice > 0 ? out_bounds.min_slice - 1 : 0;
+    out_bounds.max_slice = std::min(out_bounds.max_slice + 1, m_slice_count - 1);
+
+    out_bounds.min_x = 0;
+    out_bounds.max_x = m_tiles_x - 1;
+    out_bounds.min_y = 0;
+    out_bounds.max_y = m_tiles_y - 1;
+
+    // a sphere around the camera plane covers the whole screen
+    if (depth - radius <= m_z_near * 0.5f)
+        return;
+
+    // the box around the sphere projects inside the rectangle of its corners
+    glm::vec2 ndc_min(std::numeric_limits<float>::max());
+    glm::vec2 ndc_max(std::numeric_limits<float>::lowest());
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        const glm::vec3 corner = out_bounds.center + glm::vec3(i & 1 ? radius : -radius, i & 2 ? radius : -radius, i & 4 ? radius : -radius);
+        const glm::vec4 clip = m_proj * glm::vec4(corner, 1.f);
+        const glm::vec2 ndc = glm::vec2(clip.x, clip.y) / clip.w;
+        ndc_min = glm::min(ndc_min, ndc);
+        ndc_max = glm::max(ndc_max, ndc);
+    }
+
+    if (ndc_max.x < -1.f || ndc_max.y < -1.f || ndc_min.x > 1.f || ndc_min.y > 1.f)
+    {
+        out_bounds.visible = false;
+        return;
+    }
+
+    // also one tile more on each side
+    auto to_tile = [](float ndc, uint32_t tile_count, int32_t offset)
+    {
+        const int32_t tile = (int32_t)std::floor((ndc * 0.5f + 0.5f) * tile_count) + offset;
+        return (uint32_t)std::clamp(tile, 0, (int32_t)tile_count - 1);
+    };
+    out_bounds.min_x = to_tile(ndc_min.x, m_tiles_x, -1);
+    out_bounds.max_x = to_tile(ndc_max.x, m_tiles_x, 1);
+    out_bounds.min_y = to_tile(ndc_min.y, m_tiles_y, -1);
+    out_bounds.max_y = to_tile(ndc_max.y, m_tiles_y, 1);
+}
+
+void LightClusters::BinSlice(uint32_t slice)
+{
+    const uint32_t tile_count = m_tiles_x * m_tiles_y;
+    const uint32_t first_cluster = slice * tile_count;
+    for (uint32_t y = 0; y < m_tiles_y; y++)
+    {
+        for (uint32_t x = 0; x < m_tiles_x; x++)
+            m_cluster_bounds[GetClusterIndex(x, y, slice)] = GetClusterBounds(x, y, slice);
+    }
+
+    SliceBins& bins = m_slice_bins[slice];
+    bins.pairs.clear();
+    for (uint32_t i = 0; i < (uint32_t)m_light_bounds.size(); i++)
+    {
+        const LightBounds& light = m_light_bounds[i];
+        if (!light.visible || slice < light.min_slice || slice > light.max_slice)
+            continue;
+
+        for (uint32_t y = light.min_y; y <= light.max_y; y++)
+        {
+            for (uint32_t x = light.min_x; x <= light.max_x; x++)
+            {
+                const uint32_t tile = y * m_tiles_x + x;
+                if (SphereIntersectsAabb(light.center, light.radius, m_cluster_bounds[first_cluster + tile]))
+                    bins.pairs.push_back({ tile, i });
+            }
+        }
+    }
+
+    // counting sort by cluster, lights were visited in order so they stay in order
+    bins.counts.assign(tile_count, 0);
+    for (const glm::uvec2& pair : bins.pairs)
+        bins.counts[pair.x]++;
+
+    uint32_t offset = 0;
+    for (uint32_t tile = 0; tile < tile_count; tile++)
+    {
+        m_cluster_ranges[first_cluster + tile] = glm::uvec2(offset, bins.counts[tile]);
+        const uint32_t count = bins.counts[tile];
+        bins.counts[tile] = offset;
+        offset += count;
+    }
+
+    bins.indexes.resize(bins.pairs.size());
+    for (const glm::uvec2& pair : bins.pairs)
+        bins.indexes[bins.counts[pair.x]++] = pair.y;
+}
+
+void LightClusters::Build(const std::vector<StorageBufferData_Light>& lights, const UniformBufferData_Camera& camera, JobSystem* job_system)
+{
+    constexpr uint32_t lights_per_job = 64;
+
+    m_view = camera.view;
+    m_proj = camera.proj;
+    m_uniform_data.grid_size.w = (uint32_t)lights.size();
+
+    const uint32_t light_count = (uint32_t)lights.size();
+    m_light_bounds.resize(light_count);
+
+    auto setup_lights = [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+            SetupLight(lights[i], m_light_bounds[i]);
+    };
+
+    auto bin_slices = [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t slice = begin; slice < end; slice++)
+            BinSlice(slice);
+    };
+
+    // every slice owns its clusters, so each one goes to its own place in the packed index list
+    auto pack_slices = [&](uint32_t begin, uint32_t end)
+    {
+        const uint32_t tile_count = m_tiles_x * m_tiles_y;
+        for (uint32_t slice = begin; slice < end; slice++)
+        {
+            const SliceBins& bins = m_slice_bins[slice];
+            std::copy(bins.indexes.begin(), bins.indexes.end(), m_light_indexes.begin() + m_slice_offsets[slice]);
+            for (uint32_t tile = 0; tile < tile_count; tile++)
+                m_cluster_ranges[slice * tile_count + tile].x += m_slice_offsets[slice];
+        }
+    };
+
+    auto run = [&](uint32_t count, uint32_t group_size, const JobSystem::DispatchFunction& func)
+    {
+        if (job_system && count > group_size)
+        {
+            JobSystem::Counter counter{};
+            job_system->Dispatch(count, group_size, func, &counter);
+            job_system->Wait(&counter, 1);
+        }
+        else if (count > 0)
+        {
+            func(0, count);
+        }
+    };
+
+    run(light_count, lights_per_job, setup_lights);
+    run(m_slice_count, 1, bin_slices);
+
+    uint32_t index_count = 0;
+    for (uint32_t slice = 0; slice < m_slice_count; slice++)
+    {
+        m_slice_offsets[slice] = index_count;
+        index_count += (uint32_t)m_slice_bins[slice].indexes.size();
+    }
+    m_light_indexes.resize(index_count);
+    run(m_slice_count, 1, pack_slices);
+}
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "Quark/Render/RenderTypes.h"
+#include "Quark/Core/Math/Aabb.h"
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace quark {
+
+class JobSystem;
+
+// Point or spot light as the shaders read it (std430, see light_clusters.glsl)
+struct StorageBufferData_Light
+{
+    glm::vec4 position_range = glm::vec4(0.f, 0.f, 0.f, 1.f);      // world space, w: nothing past this distance is lit
+    glm::vec4 color_intensity = glm::vec4(1.f);
+    glm::vec4 direction_spot_cos = glm::vec4(0.f, 0.f, -1.f, -1.f); // w: cos of the outer cone angle, -1 for point lights
+};
+
+struct UniformBufferData_LightClusters
+{
+    glm::uvec4 grid_size;   // tiles x, tiles y, depth slices, light count
+    glm::vec4 depth_params; // slice = log(view depth) * x + y, z: z_near, w: z_far
+};
+
+// Splits the view frustum into froxels, screen tiles times exponential depth slices, and lists the lights that
+// reach each of them, so a pixel only shades the lights of its cluster.
+// Lights are binned by their bounding sphere: first to the slices and tiles of the sphere's screen rectangle,
+// then tested against the view space box of every cluster in that range. Indexes in a cluster are in light order.
+class LightClusters {
+public:
+    // depth slices go from z_near to z_far, the first one starts at the camera and nothing past z_far is lit
+    LightClusters(uint32_t tiles_x = 16, uint32_t tiles_y = 9, uint32_t slice_count = 24, float z_near = 0.1f, float z_far = 1000.f);
+
+    // Bins the lights against the camera's clusters, light setup and every slice run as jobs when a job system is given
+    void Build(const std::vector<StorageBufferData_Light>& lights, const UniformBufferData_Camera& camera, JobSystem* job_system = nullptr);
+
+    // What the shaders read: cluster ranges is an (offset, count) into light indexes per cluster
+    const UniformBufferData_LightClusters& GetUniformData() const { return m_uniform_data; }
+    const std::vector<glm::uvec2>& GetClusterRanges() const { return m_cluster_ranges; }
+    const std::vector<uint32_t>& GetLightIndexes() const { return m_light_indexes; }
+
+    uint32_t GetClusterCount() const { return m_tiles_x * m_tiles_y * m_slice_count; }
+    uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t slice) const { return (slice * m_tiles_y + y) * m_tiles_x + x; }
+    uint32_t GetSlice(float view_depth) const;
+
+    // view space box of a cluster for the last built camera
+    math::Aabb GetClusterBounds(uint32_t x, uint32_t y, uint32_t slice) const;
+
+    // sphere that holds everything the light reaches, world space
+    static glm::vec4 GetBoundingSphere(const StorageBufferData_Light& light);
+
+private:
+    // what a light covers, in view space and clusters
+    struct LightBounds
+    {
+        glm::vec3 center;
+        float radius;
+        uint32_t min_x, max_x, min_y, max_y;
+        uint32_t min_slice, max_slice;
+        bool visible;
+    };
+
+    struct SliceBins
+    {
+        std::vector<glm::uvec2> pairs;   // local cluster in the slice, light
+        std::vector<uint32_t> indexes;
+        std::vector<uint32_t> counts;
+    };
+
+    void SetupLight(const StorageBufferData_Light& light, LightBounds& out_bounds) const;
+    void BinSlice(uint32_t slice);
+    float GetSliceDepth(uint32_t slice) const;  // near end of the slice
+
+    uint32_t m_tiles_x;
+    uint32_t m_tiles_y;
+    uint32_t m_slice_count;
+    float m_z_near;
+    float m_z_far;
+
+    glm::mat4 m_view = glm::mat4(1.f);
+    glm::mat4 m_proj = glm::mat4(1.f);
+
+    UniformBufferData_LightClusters m_uniform_data = {};
+    std::vector<glm::uvec2> m_cluster_ranges;
+    std::vector<uint32_t> m_light_indexes;
+
+    std::vector<math::Aabb> m_cluster_bounds;
+    std::vector<LightBounds> m_light_bounds;
+    std::vector<SliceBins> m_slice_bins;
+    std::vector<uint32_t> m_slice_offsets;
+};
+
+}
@@ -0,0 +1,416 @@
+#include "Quark/qkpch.h"
+#include "Quark/Render/OcclusionBuffer.h"
+#include "Quark/Core/JobSystem.h"
+#include "Quark/Core/Math/SimdFloat.h"
+
+namespace quark {
+
+// an object is only hidden if it is this much behind the occluders, so occluders don't hide themselves
+constexpr float DEPTH_BIAS = 1e-3f;
+
+// how far off its plane a neighbour may be to still share pixels with a triangle, well within DEPTH_BIAS
+constexpr float COPLANAR_EPSILON = 1e-4f;
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height)
+    : m_width(width), m_height(height)
+{
+#ifdef QK_SIMD_FLOAT
+    QK_CORE_VERIFY(width % math::SimdFloat::width == 0, "OcclusionBuffer: the width has to be a multiple of the simd width")
+#endif
+
+    // halve down to a single texel
+    uint32_t levelWidth = width;
+    uint32_t levelHeight = height;
+    while (true)
+    {
+        Level& level = m_levels.emplace_back();
+        level.width = levelWidth;
+        level.height = levelHeight;
+        level.min_depth.resize(levelWidth * levelHeight, 0.f);
+        if (m_levels.size() > 1)
+            level.max_depth.resize(levelWidth * levelHeight, 0.f);
+
+        if (levelWidth == 1 && levelHeight == 1)
+            break;
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+}
+
+void OcclusionBuffer::Rasterize(const std::vector<Occluder>& occluders, const glm::mat4& viewproj, JobSystem* job_system)
+{
+    // a few bands per thread, as the occluders are rarely spread evenly over the screen
+    constexpr uint32_t bands_per_thread = 4;
+
+    m_viewproj = viewproj;
+
+    const uint32_t occluder_count = (uint32_t)occluders.size();
+    if (m_occluder_setups.size() < occluder_count)
+        m_occluder_setups.resize(occluder_count);
+
+    const uint32_t band_count = job_system ? std::min(job_system->GetNumWorkerThreads() * bands_per_thread, m_height) : 1;
+    const uint32_t band_height = (m_height + band_count - 1) / band_count;
+
+    auto setup_occluders = [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+            SetupTriangles(occluders[i], m_occluder_setups[i]);
+    };
+
+    // every band owns its rows, so no two jobs write the same pixel
+    auto rasterize_bands = [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t band = begin; band < end; band++)
+        {
+            const uint32_t row_begin = std::min(band * band_height, m_height);
+            const uint32_t row_end = std::min(row_begin + band_height, m_height);
+            std::fill(m_levels[0].min_depth.begin() + row_begin * m_width, m_levels[0].min_depth.begin() + row_end * m_width, 0.f);
+
+            for (uint32_t i = 0; i < occluder_count; i++)
+                RasterizeRows(m_occluder_setups[i], row_begin, row_end);
+        }
+    };
+
+    if (job_system && band_count > 1)
+    {
+        JobSystem::Counter counter{};
+        job_system->Dispatch(occluder_count, 1, setup_occluders, &counter);
+        job_system->Wait(&counter, 1);
+
+        job_system->Dispatch(band_count, 1, rasterize_bands, &counter);
+        job_system->Wait(&counter, 1);
+    }
+    else
+    {
+        setup_occluders(0, occluder_count);
+        rasterize_bands(0, band_count);
+    }
+
+    BuildHierarchy();
+}
+
+void OcclusionBuffer::SetupTriangles(const Occluder& occluder, std::vector<TriangleSetup>& out_setups) const
+{
+    out_setups.clear();
+
+    const glm::mat4 mvp = m_viewproj * occluder.model_matrix;
+    const uint32_t vertex_count = (uint32_t)occluder.positions.size();
+    const uint32_t triangle_count = (uint32_t)occluder.indices.size() / 3;
+
+    // screen positions are only valid in front of the near plane
+    std::vector<glm::vec4> clip(vertex_count);
+    std::vector<glm::vec3> screen(vertex_count);
+    for (uint32_t v = 0; v < vertex_count; v++)
+    {
+        clip[v] = mvp * glm::vec4(occluder.positions[v], 1.f);
+        if (clip[v].z >= 0.f)
+            screen[v] = ToScreen(clip[v]);
+    }
+
+    // up to two triangles on every edge, a pixel on an edge between two of them may be covered by both together
+    auto edge_key = [](uint32_t a, uint32_t b) { return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a; };
+    std::unordered_map<uint64_t, std::array<uint32_t, 2>> edge_triangles;
+    edge_triangles.reserve(triangle_count * 3);
+    for (uint32_t t = 0; t < triangle_count; t++)
+    {
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            auto [it, inserted] = edge_triangles.try_emplace(edge_key(occluder.indices[t * 3 + (i + 1) % 3], occluder.indices[t * 3 + (i + 2) % 3]), std::array<uint32_t, 2>{ t, ~0u });
+            if (!inserted && it->second[1] == ~0u)
+                it->second[1] = t;
+        }
+    }
+
+    for (uint32_t t = 0; t < triangle_count; t++)
+    {
+        const uint32_t* tri = &occluder.indices[t * 3];
+        if (clip[tri[0]].z >= 0.f && clip[tri[1]].z >= 0.f && clip[tri[2]].z >= 0.f)
+        {
+            // the vertex of a neighbour across every edge
+            const glm::vec3* across[3] = {};
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                const uint32_t a = tri[(i + 1) % 3];
+                const uint32_t b = tri[(i + 2) % 3];
+                const std::array<uint32_t, 2>& triangles = edge_triangles.at(edge_key(a, b));
+                const uint32_t neighbour = triangles[0] != t ? triangles[0] : triangles[1];
+                if (neighbour == ~0u)
+                    continue;
+
+                const uint32_t* other = &occluder.indices[neighbour * 3];
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    if (other[j] != a && other[j] != b && clip[other[j]].z >= 0.f)
+                        across[i] = &screen[other[j]];
+                }
+            }
+
+            const glm::vec3 v[3] = { screen[tri[0]], screen[tri[1]], screen[tri[2]] };
+            SetupTriangle(v, across, out_setups);
+            continue;
+        }
+
+        // clip against the near plane (z = 0), the part behind it would occlude what the camera sees
+        const glm::vec4 in[3] = { clip[tri[0]], clip[tri[1]], clip[tri[2]] };
+        glm::vec4 clipped[4];
+        uint32_t clipped_count = 0;
+        for (uint32_t v = 0; v < 3; v++)
+        {
+            const glm::vec4& a = in[v];
+            const glm::vec4& b = in[(v + 1) % 3];
+            if (a.z >= 0.f)
+                clipped[clipped_count++] = a;
+            if ((a.z >= 0.f) != (b.z >= 0.f))
+                clipped[clipped_count++] = a + (b - a) * (a.z / (a.z - b.z));
+        }
+
+        // every edge counts as an outer one, which only gives up some coverage close to the camera
+        const glm::vec3* none[3] = {};
+        if (clipped_count >= 3)
+        {
+            const glm::vec3 v[3] = { ToScreen(clipped[0]), ToScreen(clipped[1]), ToScreen(clipped[2]) };
+            SetupTriangle(v, none, out_setups);
+        }
+        if (clipped_count == 4)
+        {
+            const glm::vec3 v[3] = { ToScreen(clipped[0]), ToScreen(clipped[2]), ToScreen(clipped[3]) };
+            SetupTriangle(v, none, out_setups);
+        }
+    }
+}
+
+glm::vec3 OcclusionBuffer::ToScreen(const glm::vec4& c) const
+{
+    // pixels with 1/w as depth, which is linear in screen space
+    const float inv_w = 1.f / c.w;
+    return glm::vec3((c.x * inv_w * 0.5f + 0.5f) * m_width, (c.y * inv_w * 0.5f + 0.5f) * m_height, inv_w);
+}
+
+void OcclusionBuffer::SetupTriangle(const glm::vec3 (&screen)[3], const glm::vec3* (&screen_across)[3], std::vector<TriangleSetup>& out_setups) const
+{
+    glm::vec3 v[3] = { screen[0], screen[1], screen[2] };
+    const glm::vec3* across[3] = { screen_across[0], screen_across[1], screen_across[2] };
+
+    float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[1].y - v[0].y) * (v[2].x - v[0].x);
+    if (std::abs(area) < 1e-6f)
+        return;
+
+    // occluders are drawn from both sides, so flip to one winding
+    if (area < 0.f)
+    {
+        std::swap(v[1], v[2]);
+        std::swap(across[1], across[2]);
+        area = -area;
+    }
+
+    TriangleSetup setup;
+    setup.min_x = std::max((int32_t)std::floor(std::min({ v[0].x, v[1].x, v[2].x })), 0);
+    setup.max_x = std::min((int32_t)std::ceil(std::max({ v[0].x, v[1].x, v[2].x })), (int32_t)m_width - 1);
+    setup.min_y = std::max((int32_t)std::floor(std::min({ v[0].y, v[1].y, v[2].y })), 0);
+    setup.max_y = std::min((int32_t)std::ceil(std::max({ v[0].y, v[1].y, v[2].y })), (int32_t)m_height - 1);
+    if (setup.min_x > setup.max_x || setup.min_y > setup.max_y)
+        return;
+
+    // edge from a to b, >= 0 on its left
+    auto edge = [](const glm::vec3& a, const glm::vec3& b, float& out_a, float& out_b, float& out_c)
+    {
+        out_a = a.y - b.y;
+        out_b = b.x - a.x;
+        out_c = a.x * b.y - a.y * b.x;
+    };
+
+    // edge i is opposite to vertex i, its value over the area is the barycentric weight of that vertex
+    float edge_a[3], edge_b[3], edge_c[3];
+    for (uint32_t i = 0; i < 3; i++)
+        edge(v[(i + 1) % 3], v[(i + 2) % 3], edge_a[i], edge_b[i], edge_c[i]);
+
+    const float inv_area = 1.f / area;
+    setup.depth_a = (edge_a[0] * v[0].z + edge_a[1] * v[1].z + edge_a[2] * v[2].z) * inv_area;
+    setup.depth_b = (edge_b[0] * v[0].z + edge_b[1] * v[1].z + edge_b[2] * v[2].z) * inv_area;
+    setup.depth_c = (edge_c[0] * v[0].z + edge_c[1] * v[1].z + edge_c[2] * v[2].z) * inv_area;
+
+    // An edge shared with a neighbour that lies on its other side in the same plane is not an outline: a pixel on it
+    // is covered by the two triangles together, so the neighbour's two other edges bound it instead. Any point within
+    // all the edges is then inside one of the triangles
+    setup.edge_count = 0;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        const glm::vec3& a = v[(i + 1) % 3];
+        const glm::vec3& b = v[(i + 2) % 3];
+        const glm::vec3* w = across[i];
+        const bool joined = w && edge_a[i] * w->x + edge_b[i] * w->y + edge_c[i] < 0.f &&
+            std::abs(setup.depth_a * w->x + setup.depth_b * w->y + setup.depth_c - w->z) <= COPLANAR_EPSILON * w->z;
+        if (joined)
+        {
+            edge(a, *w, setup.edge_a[setup.edge_count], setup.edge_b[setup.edge_count], setup.edge_c[setup.edge_count]);
+            setup.edge_count++;
+            edge(*w, b, setup.edge_a[setup.edge_count], setup.edge_b[setup.edge_count], setup.edge_c[setup.edge_count]);
+            setup.edge_count++;
+        }
+        else
+        {
+            setup.edge_a[setup.edge_count] = edge_a[i];
+            setup.edge_b[setup.edge_count] = edge_b[i];
+            setup.edge_c[setup.edge_count] = edge_c[i];
+            setup.edge_count++;
+        }
+    }
+
+    // Sampled at pixel centers, so every edge is moved inwards by its largest change over half a pixel:
+    // only pixels that are covered entirely pass. The depth is the plane's farthest over the pixel
+    for (uint32_t i = 0; i < setup.edge_count; i++)
+        setup.edge_c[i] -= 0.5f * (std::abs(setup.edge_a[i]) + std::abs(setup.edge_b[i]));
+    setup.depth_c -= 0.5f * (std::abs(setup.depth_a) + std::abs(setup.depth_b));
+
+    out_setups.push_back(setup);
+}
+
+void OcclusionBuffer::RasterizeRows(const std::vector<TriangleSetup>& setups, uint32_t row_begin, uint32_t row_end)
+{
+    float* depth = m_levels[0].min_depth.data();
+
+    for (const TriangleSetup& t : setups)
+    {
+        const int32_t y_begin = std::max(t.min_y, (int32_t)row_begin);
+        const int32_t y_end = std::min(t.max_y + 1, (int32_t)row_end);
+
+        for (int32_t y = y_begin; y < y_end; y++)
+        {
+            // sampled at pixel centers
+            const float py = (float)y + 0.5f;
+            float* row = depth + y * m_width;
+            float e_row[TriangleSetup::EDGE_MAX_NUM];
+            for (uint32_t i = 0; i < t.edge_count; i++)
+                e_row[i] = t.edge_b[i] * py + t.edge_c[i];
+            const float z_row = t.depth_b * py + t.depth_c;
+
+            int32_t x = t.min_x;
+#ifdef QK_SIMD_FLOAT
+            using S = math::SimdFloat;
+            x &= ~(int32_t)(S::width - 1);
+            const S::Type zero = S::zero();
+            for (; x <= t.max_x; x += S::width)
+            {
+                const S::Type px = S::add(S::set1((float)x + 0.5f), S::lane_index());
+                S::Type inside = S::greater_equal(S::add(S::mul(S::set1(t.edge_a[0]), px), S::set1(e_row[0])), zero);
+                for (uint32_t i = 1; i < t.edge_count; i++)
+                    inside = S::bit_and(inside, S::greater_equal(S::add(S::mul(S::set1(t.edge_a[i]), px), S::set1(e_row[i])), zero));
+                if (S::mask(inside) == 0)
+                    continue;
+
+                const S::Type z = S::add(S::mul(S::set1(t.depth_a), px), S::set1(z_row));
+                const S::Type old_depth = S::load(row + x);
+                S::store(row + x, S::select(inside, S::max(old_depth, z), old_depth));
+            }
+#else
+            for (; x <= t.max_x; x++)
+            {
+                const float px = (float)x + 0.5f;
+                bool inside = true;
+                for (uint32_t i = 0; i < t.edge_count && inside; i++)
+                    inside = t.edge_a[i] * px + e_row[i] >= 0.f;
+                if (inside)
+                    row[x] = std::max(row[x], t.depth_a * px + z_row);
+            }
+#endif
+        }
+    }
+}
+
+void OcclusionBuffer::BuildHierarchy()
+{
+    for (uint32_t l = 1; l < (uint32_t)m_levels.size(); l++)
+    {
+        const Level& fine = m_levels[l - 1];
+        Level& coarse = m_levels[l];
+        for (uint32_t y = 0; y < coarse.height; y++)
+        {
+            for (uint32_t x = 0; x < coarse.width; x++)
+            {
+                // odd sizes repeat the last row or column
+                const uint32_t x0 = 2 * x, x1 = std::min(2 * x + 1, fine.width - 1);
+                const uint32_t y0 = 2 * y, y1 = std::min(2 * y + 1, fine.height - 1);
+
+                coarse.min_depth[y * coarse.width + x] = std::min({ GetMinDepth(l - 1, x0, y0), GetMinDepth(l - 1, x1, y0), GetMinDepth(l - 1, x0, y1), GetMinDepth(l - 1, x1, y1) });
+                coarse.max_depth[y * coarse.width + x] = std::max({ GetMaxDepth(l - 1, x0, y0), GetMaxDepth(l - 1, x1, y0), GetMaxDepth(l - 1, x0, y1), GetMaxDepth(l - 1, x1, y1) });
+            }
+        }
+    }
+}
+
+float OcclusionBuffer::GetMaxDepth(uint32_t level, uint32_t x, uint32_t y) const
+{
+    const Level& l = m_levels[level];
+    return level == 0 ? l.min_depth[y * l.width + x] : l.max_depth[y * l.width + x];
+}
+
+bool OcclusionBuffer::IsVisible(const math::Aabb& world_aabb) const
+{
+    const glm::vec3& min = world_aabb.Min();
+    const glm::vec3& max = world_aabb.Max();
+
+    glm::vec2 screen_min(std::numeric_limits<float>::max());
+    glm::vec2 screen_max(std::numeric_limits<float>::lowest());
+    float nearest_depth = 0.f;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        const glm::vec3 corner(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+        const glm::vec4 c = m_viewproj * glm::vec4(corner, 1.f);
+        if (c.z < 0.f)
+            return true;
+
+        const float inv_w = 1.f / c.w;
+        const glm::vec2 screen((c.x * inv_w * 0.5f + 0.5f) * m_width, (c.y * inv_w * 0.5f + 0.5f) * m_height);
+        screen_min = glm::min(screen_min, screen);
+        screen_max = glm::max(screen_max, screen);
+        nearest_depth = std::max(nearest_depth, inv_w);
+    }
+
+    // every pixel the rectangle touches
+    if (screen_max.x < 0.f || screen_max.y < 0.f || screen_min.x >= (float)m_width || screen_min.y >= (float)m_height)
+        return true;
+
+    const uint32_t x0 = (uint32_t)std::max(screen_min.x, 0.f);
+    const uint32_t y0 = (uint32_t)std::max(screen_min.y, 0.f);
+    const uint32_t x1 = (uint32_t)std::min(screen_max.x, (float)m_width - 1.f);
+    const uint32_t y1 = (uint32_t)std::min(screen_max.y, (float)m_height - 1.f);
+
+    // start where the rectangle covers at most 2x2 texels
+    uint32_t level = 0;
+    while (level + 1 < (uint32_t)m_levels.size() && (((x1 >> level) - (x0 >> level)) > 1 || ((y1 >> level) - (y0 >> level)) > 1))
+        level++;
+
+    nearest_depth *= 1.f + DEPTH_BIAS;
+    return !IsRectOccluded(nearest_depth, level, x0 >> level, y0 >> level, x1 >> level, y1 >> level, x0, y0, x1, y1);
+}
+
+bool OcclusionBuffer::IsRectOccluded(float nearest_depth, uint32_t level, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1,
+    uint32_t rect_x0, uint32_t rect_y0, uint32_t rect_x1, uint32_t rect_y1) const
+{
+    for (uint32_t y = y0; y <= y1; y++)
+    {
+        for (uint32_t x = x0; x <= x1; x++)
+        {
+            // behind the farthest occluder of the texel
+            if (nearest_depth < GetMinDepth(level, x, y))
+                continue;
+
+            // in front of the nearest one, or nothing finer to look at
+            if (level == 0 || nearest_depth >= GetMaxDepth(level, x, y))
+                return false;
+
+            // the texel's children that the rectangle touches
+            const uint32_t shift = level - 1;
+            const uint32_t child_x0 = std::max(2 * x, rect_x0 >> shift);
+            const uint32_t child_y0 = std::max(2 * y, rect_y0 >> shift);
+            const uint32_t child_x1 = std::min(2 * x + 1, rect_x1 >> shift);
+            const uint32_t child_y1 = std::min(2 * y + 1, rect_y1 >> shift);
+            if (!IsRectOccluded(nearest_depth, level - 1, child_x0, child_y0, child_x1, child_y1, rect_x0, rect_y0, rect_x1, rect_y1))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "Quark/Core/Math/Aabb.h"
+
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace quark {
+
+class JobSystem;
+
+// Mesh rasterized into the OcclusionBuffer, usually a large object like a wall or a building. It must not stick out
+// of the object, or it hides what is visible
+struct Occluder
+{
+    uint64_t id = 0;    // of the render object
+    std::vector<glm::vec3> positions;   // model space
+    std::vector<uint32_t> indices;
+    glm::mat4 model_matrix = glm::mat4(1.f);
+};
+
+// Low resolution depth buffer filled by rasterizing occluders on the CPU, with a min/max hierarchy over it
+// to test the screen space bounds of objects. Depth is stored as 1/w, so larger is nearer and 0 is empty.
+// Rasterization is conservative: a pixel only takes an occluder's depth if the occluder covers all of it, at the
+// farthest depth the occluder has in it. Triangles are clipped at the near plane, and objects that cross it are always visible.
+class OcclusionBuffer {
+public:
+    OcclusionBuffer(uint32_t width = 256, uint32_t height = 128);
+
+    // Clears the buffer and rasterizes every occluder, in horizontal bands on the job system when one is given
+    void Rasterize(const std::vector<Occluder>& occluders, const glm::mat4& viewproj, JobSystem* job_system = nullptr);
+
+    // False only if the whole box is behind the occluders. Read only, so any number of threads can test at once
+    bool IsVisible(const math::Aabb& world_aabb) const;
+
+    uint32_t GetWidth() const { return m_width; }
+    uint32_t GetHeight() const { return m_height; }
+    uint32_t GetLevelCount() const { return (uint32_t)m_levels.size(); }
+    float GetDepth(uint32_t x, uint32_t y) const { return m_levels[0].min_depth[y * m_width + x]; }
+
+private:
+    // edge functions and depth plane of a triangle in pixels, a pixel is covered where all edges are >= 0 at its center.
+    // Up to two edges per side, as a side shared with a coplanar neighbour is bounded by the neighbour's other two
+    struct TriangleSetup
+    {
+        static constexpr uint32_t EDGE_MAX_NUM = 6;
+        float edge_a[EDGE_MAX_NUM], edge_b[EDGE_MAX_NUM], edge_c[EDGE_MAX_NUM];
+        uint32_t edge_count;
+        float depth_a, depth_b, depth_c;
+        int32_t min_x, max_x, min_y, max_y;
+    };
+
+    struct Level
+    {
+        uint32_t width, height;
+        std::vector<float> min_depth;   // farthest occluder in every texel
+        std::vector<float> max_depth;   // nearest, empty for level 0 where it is the same as min_depth
+    };
+
+    void SetupTriangles(const Occluder& occluder, std::vector<TriangleSetup>& out_setups) const;
+    // screen_across[i] is the third vertex of a neighbour sharing the side opposite to vertex i, if there is one
+    void SetupTriangle(const glm::vec3 (&screen)[3], const glm::vec3* (&screen_across)[3], std::vector<TriangleSetup>& out_setups) const;
+    glm::vec3 ToScreen(const glm::vec4& clip) const;
+    void RasterizeRows(const std::vector<TriangleSetup>& setups, uint32_t row_begin, uint32_t row_end);
+    void BuildHierarchy();
+
+    float GetMinDepth(uint32_t level, uint32_t x, uint32_t y) const { return m_levels[level].min_depth[y * m_levels[level].width + x]; }
+    float GetMaxDepth(uint32_t level, uint32_t x, uint32_t y) const;
+    bool IsRectOccluded(float nearest_depth, uint32_t level, uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, uint32_t rect_x0, uint32_t rect_y0, uint32_t rect_x1, uint32_t rect_y1) const;
+
+    uint32_t m_width;
+    uint32_t m_height;
+    glm::mat4 m_viewproj = glm::mat4(1.f);
+    std::vector<Level> m_levels;
+    std::vector<std::vector<TriangleSetup>> m_occluder_setups;
+};
+
+}
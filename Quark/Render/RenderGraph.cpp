@@ -0,0 +1,512 @@
+#include "Quark/qkpch.h"
+#include "Quark/Render/RenderGraph.h"
+#include "Quark/Core/Util/Hash.h"
+
+namespace quark {
+
+using namespace rhi;
+
+namespace {
+
+// the state an image must be in for a usage
+struct ImageState
+{
+    ImageLayout layout = ImageLayout::UNDEFINED;
+    uint32_t stages = PIPELINE_STAGE_ALL_COMMANDS_BIT;  // whatever ran before on the queue
+    uint32_t access = 0;
+};
+
+constexpr uint32_t WRITE_ACCESS_BITS = BARRIER_ACCESS_SHADER_WRITE_BIT | BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+    BARRIER_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | BARRIER_ACCESS_TRANSFER_WRITE_BIT | BARRIER_ACCESS_HOST_WRITE_BIT | BARRIER_ACCESS_MEMORY_WRITE_BIT;
+
+// a pass toggled on and off for a few frames finds its images still in the pool
+constexpr uint32_t MAX_UNUSED_EXECUTES = 120;
+
+ImageState GetUsageState(RenderGraphImageUsage usage)
+{
+    switch (usage)
+    {
+    case RenderGraphImageUsage::COLOR_ATTACHMENT:
+        return { ImageLayout::COLOR_ATTACHMENT_OPTIMAL, PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            BARRIER_ACCESS_COLOR_ATTACHMENT_READ_BIT | BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+    case RenderGraphImageUsage::DEPTH_ATTACHMENT:
+        return { ImageLayout::DEPTH_STENCIL_ATTACHMENT_OPTIMAL, PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            BARRIER_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | BARRIER_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+    case RenderGraphImageUsage::SHADER_READ:
+        return { ImageLayout::SHADER_READ_ONLY_OPTIMAL, PIPELINE_STAGE_FRAGMENT_SHADER_BIT, BARRIER_ACCESS_SHADER_READ_BIT };
+    case RenderGraphImageUsage::TRANSFER_SRC:
+        return { ImageLayout::TRANSFER_SRC_OPTIMAL, PIPELINE_STAGE_TRANSFER_BIT, BARRIER_ACCESS_TRANSFER_READ_BIT };
+    case RenderGraphImageUsage::PRESENT:
+        return { ImageLayout::PRESENT, PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0 };
+    default:
+        return {};
+    }
+}
+
+uint32_t GetUsageBits(RenderGraphImageUsage usage)
+{
+    switch (usage)
+    {
+    case RenderGraphImageUsage::COLOR_ATTACHMENT: return IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    case RenderGraphImageUsage::DEPTH_ATTACHMENT: return IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    case RenderGraphImageUsage::SHADER_READ: return IMAGE_USAGE_SAMPLING_BIT;
+    case RenderGraphImageUsage::TRANSFER_SRC: return IMAGE_USAGE_CAN_COPY_FROM_BIT;
+    default: return 0;
+    }
+}
+
+bool IsAttachment(RenderGraphImageUsage usage)
+{
+    return usage == RenderGraphImageUsage::COLOR_ATTACHMENT || usage == RenderGraphImageUsage::DEPTH_ATTACHMENT;
+}
+
+bool IsSameDesc(const ImageDesc& a, const ImageDesc& b)
+{
+    return a.width == b.width && a.height == b.height && a.depth == b.depth && a.mipLevels == b.mipLevels &&
+        a.arraySize == b.arraySize && a.type == b.type && a.format == b.format && a.samples == b.samples &&
+        a.initialLayout == b.initialLayout && a.usageBits == b.usageBits && a.generateMipMaps == b.generateMipMaps;
+}
+
+}
+
+RenderGraphPass& RenderGraphPass::AddColorOutput(RenderGraphImage image, LoadOp load_op, const ClearValue& clear_value)
+{
+    AddAccess(image, RenderGraphImageUsage::COLOR_ATTACHMENT, load_op, clear_value);
+    return *this;
+}
+
+RenderGraphPass& RenderGraphPass::SetDepthOutput(RenderGraphImage image, LoadOp load_op, const ClearValue& clear_value)
+{
+    for (const Access& access : m_accesses)
+        QK_CORE_VERIFY(access.usage != RenderGraphImageUsage::DEPTH_ATTACHMENT, "RenderGraph pass {} has two depth outputs", m_name)
+
+    AddAccess(image, RenderGraphImageUsage::DEPTH_ATTACHMENT, load_op, clear_value);
+    return *this;
+}
+
+RenderGraphPass& RenderGraphPass::AddTextureInput(RenderGraphImage image)
+{
+    AddAccess(image, RenderGraphImageUsage::SHADER_READ);
+    return *this;
+}
+
+RenderGraphPass& RenderGraphPass::AddTransferInput(RenderGraphImage image)
+{
+    AddAccess(image, RenderGraphImageUsage::TRANSFER_SRC);
+    return *this;
+}
+
+void RenderGraphPass::AddAccess(RenderGraphImage image, RenderGraphImageUsage usage, LoadOp load_op, const ClearValue& clear_value)
+{
+    // one state per image and pass, an image can't be sampled while it is rendered to
+    for (const Access& access : m_accesses)
+        QK_CORE_VERIFY(access.image != image, "RenderGraph pass {} accesses an image twice", m_name)
+
+    m_accesses.push_back({ image, usage, load_op, clear_value });
+}
+
+RenderGraph::RenderGraph(Device* device)
+    : m_device(device)
+{
+}
+
+void RenderGraph::Reset()
+{
+    m_images.clear();
+    m_passes.clear();
+    m_resolved_images.clear();
+}
+
+RenderGraphImage RenderGraph::CreateImage(const std::string& name, const ImageDesc& desc)
+{
+    ImageResource& resource = m_images.emplace_back();
+    resource.name = name;
+    resource.desc = desc;
+    resource.desc.initialLayout = ImageLayout::UNDEFINED;   // layouts are the graph's business
+    return (RenderGraphImage)m_images.size() - 1;
+}
+
+RenderGraphImage RenderGraph::ImportImage(const std::string& name, Image* image, RenderGraphImageUsage initial_usage, RenderGraphImageUsage final_usage)
+{
+    QK_CORE_VERIFY(image != nullptr)
+
+    ImageResource& resource = m_images.emplace_back();
+    resource.name = name;
+    resource.desc = image->GetDesc();
+    resource.imported = image;
+    resource.initial_usage = initial_usage;
+    resource.final_usage = final_usage;
+    return (RenderGraphImage)m_images.size() - 1;
+}
+
+RenderGraphPass& RenderGraph::AddPass(const std::string& name)
+{
+    m_passes.push_back(RenderGraphPass(name));
+    return m_passes.back();
+}
+
+uint64_t RenderGraph::HashDeclarations() const
+{
+    // the shape of the graph, not the imported images or clear values which may change every frame
+    util::Hasher h;
+    h.u32((uint32_t)m_images.size());
+    for (const ImageResource& image : m_images)
+    {
+        h.u32(image.imported != nullptr);
+        h.u32(image.desc.width);
+        h.u32(image.desc.height);
+        h.u32(image.desc.depth);
+        h.u32(image.desc.mipLevels);
+        h.u32(image.desc.arraySize);
+        h.u32(util::ecast(image.desc.type));
+        h.u32(util::ecast(image.desc.format));
+        h.u32(util::ecast(image.desc.samples));
+        h.u32(image.desc.usageBits);
+        h.u32(image.desc.generateMipMaps);
+        h.u32(util::ecast(image.initial_usage));
+        h.u32(util::ecast(image.final_usage));
+    }
+
+    h.u32((uint32_t)m_passes.size());
+    for (const RenderGraphPass& pass : m_passes)
+    {
+        h.u32((uint32_t)pass.m_accesses.size());
+        for (const RenderGraphPass::Access& access : pass.m_accesses)
+        {
+            h.u32(access.image);
+            h.u32(util::ecast(access.usage));
+            h.u32(util::ecast(access.load_op));
+        }
+        h.u32(pass.m_side_effect);
+        h.u32(util::ecast(pass.m_contents));
+    }
+
+    return h.get();
+}
+
+void RenderGraph::Compile()
+{
+    for (const RenderGraphPass& pass : m_passes)
+    {
+        for (const RenderGraphPass::Access& access : pass.m_accesses)
+            QK_CORE_VERIFY(access.image < m_images.size(), "RenderGraph pass {} accesses an image of another graph", pass.m_name)
+    }
+
+    const uint64_t hash = HashDeclarations();
+    if (hash == m_compiled_hash && m_compiled_passes.size() == m_passes.size())
+    {
+        m_stats.cached_compiles++;
+        return;
+    }
+
+    m_compiled_hash = hash;
+    m_compiled_images.assign(m_images.size(), CompiledImage());
+    m_compiled_passes.assign(m_passes.size(), CompiledPass());
+    m_final_barriers.clear();
+
+    CullPasses();
+    AssignPhysicalImages();
+    BuildBarriers();
+
+    m_stats.passes = (uint32_t)m_passes.size();
+    m_stats.culled_passes = 0;
+    m_stats.barriers = (uint32_t)m_final_barriers.size();
+    for (const CompiledPass& pass : m_compiled_passes)
+    {
+        m_stats.culled_passes += pass.culled;
+        m_stats.barriers += (uint32_t)pass.barriers.size();
+    }
+    m_stats.transient_images = 0;
+    for (RenderGraphImage i = 0; i < m_images.size(); i++)
+        m_stats.transient_images += IsTransient(i) && m_compiled_images[i].physical != UINT32_MAX;
+    m_stats.physical_images = (uint32_t)m_physical_descs.size();
+    m_stats.compiles++;
+}
+
+void RenderGraph::CullPasses()
+{
+    // Walk back from the passes that must run. An image is needed when a pass after the current one reads
+    // its contents, imported images are always needed since they are read outside the graph.
+    std::vector<bool> needed(m_images.size());
+    for (RenderGraphImage i = 0; i < m_images.size(); i++)
+        needed[i] = !IsTransient(i);
+
+    for (size_t p = m_passes.size(); p-- > 0;)
+    {
+        const RenderGraphPass& pass = m_passes[p];
+
+        bool alive = pass.m_side_effect;
+        for (const RenderGraphPass::Access& access : pass.m_accesses)
+            alive |= IsAttachment(access.usage) && needed[access.image];
+
+        if (!alive)
+            continue;
+
+        m_compiled_passes[p].culled = false;
+
+        // a cleared attachment doesn't need what earlier passes wrote, a loaded one does
+        for (const RenderGraphPass::Access& access : pass.m_accesses)
+        {
+            if (IsAttachment(access.usage) && access.load_op != RenderGraphPass::LoadOp::LOAD && IsTransient(access.image))
+                needed[access.image] = false;
+        }
+        for (const RenderGraphPass::Access& access : pass.m_accesses)
+        {
+            if (!IsAttachment(access.usage) || access.load_op == RenderGraphPass::LoadOp::LOAD)
+                needed[access.image] = true;
+        }
+    }
+}
+
+void RenderGraph::AssignPhysicalImages()
+{
+    std::vector<RenderGraphImage> transients;
+    for (uint32_t p = 0; p < m_passes.size(); p++)
+    {
+        if (m_compiled_passes[p].culled)
+            continue;
+
+        for (const RenderGraphPass::Access& access : m_passes[p].m_accesses)
+        {
+            CompiledImage& image = m_compiled_images[access.image];
+            if (image.first_pass == UINT32_MAX && IsTransient(access.image))
+                transients.push_back(access.image);
+
+            image.first_pass = std::min(image.first_pass, p);
+            image.last_pass = std::max(image.last_pass, p);
+            image.usage_bits |= GetUsageBits(access.usage);
+        }
+    }
+
+    // Greedy, in order of first use: an image takes the first physical image of the same description which
+    // no image uses anymore, or a new one
+    m_physical_descs.clear();
+    std::vector<uint32_t> physical_last_pass;
+    for (RenderGraphImage i : transients)
+    {
+        CompiledImage& image = m_compiled_images[i];
+        ImageDesc desc = m_images[i].desc;
+        desc.usageBits |= image.usage_bits;
+
+        for (uint32_t k = 0; k < m_physical_descs.size(); k++)
+        {
+            if (physical_last_pass[k] < image.first_pass && IsSameDesc(m_physical_descs[k], desc))
+            {
+                image.physical = k;
+                break;
+            }
+        }
+
+        if (image.physical == UINT32_MAX)
+        {
+            image.physical = (uint32_t)m_physical_descs.size();
+            m_physical_descs.push_back(desc);
+            physical_last_pass.push_back(0);
+        }
+        physical_last_pass[image.physical] = image.last_pass;
+    }
+}
+
+void RenderGraph::BuildBarriers()
+{
+    // states of imported images, then of physical images
+    std::vector<ImageState> states(m_images.size() + m_physical_descs.size());
+    for (RenderGraphImage i = 0; i < m_images.size(); i++)
+    {
+        if (!IsTransient(i) && m_images[i].initial_usage != RenderGraphImageUsage::NONE)
+            states[i] = GetUsageState(m_images[i].initial_usage);
+    }
+
+    for (uint32_t p = 0; p < m_passes.size(); p++)
+    {
+        CompiledPass& compiled_pass = m_compiled_passes[p];
+        if (compiled_pass.culled)
+            continue;
+
+        for (const RenderGraphPass::Access& access : m_passes[p].m_accesses)
+        {
+            const CompiledImage& image = m_compiled_images[access.image];
+            const bool transient = IsTransient(access.image);
+            ImageState& state = transient ? states[m_images.size() + image.physical] : states[access.image];
+            const ImageState required = GetUsageState(access.usage);
+            const bool read = !IsAttachment(access.usage) || access.load_op == RenderGraphPass::LoadOp::LOAD;
+
+            bool discard = false;
+            if (transient && image.first_pass == p)
+            {
+                // the physical image holds what an aliased image left, or what the last frame left
+                QK_CORE_VERIFY(!read, "RenderGraph pass {} reads image {} before any pass writes it", m_passes[p].m_name, m_images[access.image].name)
+                discard = true;
+            }
+
+            const bool write = (required.access & WRITE_ACCESS_BITS) != 0;
+            if (!discard && state.layout == required.layout && !write && (state.access & WRITE_ACCESS_BITS) == 0)
+            {
+                // read after read in the same layout, later writes wait for every reader
+                state.stages |= required.stages;
+                state.access |= required.access;
+                continue;
+            }
+
+            RenderGraphBarrier& barrier = compiled_pass.barriers.emplace_back();
+            barrier.image = access.image;
+            barrier.barrier.srcStageBits = state.stages;
+            barrier.barrier.srcMemoryAccessBits = state.access & WRITE_ACCESS_BITS;
+            barrier.barrier.dstStageBits = required.stages;
+            barrier.barrier.dstMemoryAccessBits = required.access;
+            barrier.barrier.layoutBefore = discard ? ImageLayout::UNDEFINED : state.layout;
+            barrier.barrier.layoutAfter = required.layout;
+            state = required;
+        }
+
+        // what no later pass reads needn't be written to memory
+        for (const RenderGraphPass::Access& access : m_passes[p].m_accesses)
+        {
+            if (!IsAttachment(access.usage))
+                continue;
+
+            const bool last_use = IsTransient(access.image) && m_compiled_images[access.image].last_pass == p;
+            compiled_pass.store_ops.push_back(last_use ? FrameBufferInfo::AttachmentStoreOp::DONTCARE : FrameBufferInfo::AttachmentStoreOp::STORE);
+        }
+    }
+
+    for (RenderGraphImage i = 0; i < m_images.size(); i++)
+    {
+        if (IsTransient(i) || m_images[i].final_usage == RenderGraphImageUsage::NONE)
+            continue;
+
+        const ImageState& state = states[i];
+        const ImageState required = GetUsageState(m_images[i].final_usage);
+        if (state.layout == required.layout && (state.access & WRITE_ACCESS_BITS) == 0)
+            continue;
+
+        RenderGraphBarrier& barrier = m_final_barriers.emplace_back();
+        barrier.image = i;
+        barrier.barrier.srcStageBits = state.stages;
+        barrier.barrier.srcMemoryAccessBits = state.access & WRITE_ACCESS_BITS;
+        barrier.barrier.dstStageBits = required.stages;
+        barrier.barrier.dstMemoryAccessBits = required.access;
+        barrier.barrier.layoutBefore = state.layout;
+        barrier.barrier.layoutAfter = required.layout;
+    }
+}
+
+void RenderGraph::CreatePhysicalImages()
+{
+    for (PooledImage& pooled : m_image_pool)
+        pooled.used = false;
+
+    // the pool keeps its order, a graph of the same shape gets back the images it had the last time
+    m_physical_images.resize(m_physical_descs.size());
+    for (size_t k = 0; k < m_physical_descs.size(); k++)
+    {
+        auto found = std::find_if(m_image_pool.begin(), m_image_pool.end(), [&](const PooledImage& pooled)
+            { return !pooled.used && IsSameDesc(pooled.image->GetDesc(), m_physical_descs[k]); });
+
+        PooledImage& pooled = found != m_image_pool.end() ? *found : m_image_pool.emplace_back();
+        if (!pooled.image)
+        {
+            pooled.image = m_device->CreateImage(m_physical_descs[k]);
+            m_stats.created_images++;
+        }
+        pooled.used = true;
+        pooled.unused_executes = 0;
+        m_physical_images[k] = pooled.image.get();
+    }
+
+    // in flight frames may still use a released image, the device defers destroying it
+    std::erase_if(m_image_pool, [](PooledImage& pooled)
+        { return !pooled.used && ++pooled.unused_executes > MAX_UNUSED_EXECUTES; });
+}
+
+Image* RenderGraph::GetImage(RenderGraphImage image) const
+{
+    QK_CORE_ASSERT(image < m_resolved_images.size())
+    return m_resolved_images[image];
+}
+
+void RenderGraph::Execute(CommandList* cmd)
+{
+    QK_CORE_ASSERT(m_device != nullptr)
+    QK_CORE_VERIFY(m_compiled_passes.size() == m_passes.size() && m_compiled_images.size() == m_images.size(), "RenderGraph executed without being compiled")
+
+    CreatePhysicalImages();
+
+    m_resolved_images.resize(m_images.size());
+    for (RenderGraphImage i = 0; i < m_images.size(); i++)
+    {
+        const uint32_t physical = m_compiled_images[i].physical;
+        m_resolved_images[i] = !IsTransient(i) ? m_images[i].imported : physical != UINT32_MAX ? m_physical_images[physical] : nullptr;
+    }
+
+    auto record_barriers = [&](const std::vector<RenderGraphBarrier>& barriers)
+    {
+        if (barriers.empty())
+            return;
+
+        m_barrier_scratch.clear();
+        for (const RenderGraphBarrier& barrier : barriers)
+        {
+            m_barrier_scratch.push_back(barrier.barrier);
+            m_barrier_scratch.back().image = m_resolved_images[barrier.image];
+        }
+        cmd->PipeLineBarriers(nullptr, 0, m_barrier_scratch.data(), (uint32_t)m_barrier_scratch.size(), nullptr, 0);
+    };
+
+    for (uint32_t p = 0; p < m_passes.size(); p++)
+    {
+        const RenderGraphPass& pass = m_passes[p];
+        const CompiledPass& compiled_pass = m_compiled_passes[p];
+        if (compiled_pass.culled)
+            continue;
+
+        record_barriers(compiled_pass.barriers);
+
+        RenderPassInfo2 render_pass_info;
+        FrameBufferInfo fb_info = {};
+        uint32_t attachment = 0;
+        for (const RenderGraphPass::Access& access : pass.m_accesses)
+        {
+            if (!IsAttachment(access.usage))
+                continue;
+
+            Image* image = m_resolved_images[access.image];
+            const auto store_op = compiled_pass.store_ops[attachment++];
+            if (access.usage == RenderGraphImageUsage::DEPTH_ATTACHMENT)
+            {
+                render_pass_info.depthAttachmentFormat = image->GetDesc().format;
+                fb_info.depthAttachment = image;
+                fb_info.depthAttachmentLoadOp = access.load_op;
+                fb_info.depthAttachmentStoreOp = store_op;
+                fb_info.clearDepthStencil = access.clear_value;
+            }
+            else
+            {
+                const uint32_t i = render_pass_info.numColorAttachments++;
+                QK_CORE_VERIFY(i < MAX_COLOR_ATTHACHEMNT_NUM, "RenderGraph pass {} has too many color outputs", pass.m_name)
+                render_pass_info.colorAttachmentFormats[i] = image->GetDesc().format;
+                fb_info.colorAttachments[i] = image;
+                fb_info.colorAttatchemtsLoadOp[i] = access.load_op;
+                fb_info.colorAttatchemtsStoreOp[i] = store_op;
+                fb_info.clearColors[i] = access.clear_value;
+            }
+            render_pass_info.sampleCount = image->GetDesc().samples;
+        }
+
+        if (attachment > 0)
+        {
+            cmd->BeginRenderPass(render_pass_info, fb_info, pass.m_contents);
+            if (pass.m_execute)
+                pass.m_execute(cmd);
+            cmd->EndRenderPass();
+        }
+        else if (pass.m_execute)
+        {
+            pass.m_execute(cmd);
+        }
+    }
+
+    record_barriers(m_final_barriers);
+}
+
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include "Quark/RHI/Device.h"
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace quark {
+
+// Image declared in a RenderGraph, an index valid until the graph is reset
+using RenderGraphImage = uint32_t;
+constexpr RenderGraphImage RENDER_GRAPH_IMAGE_NONE = UINT32_MAX;
+
+enum class RenderGraphImageUsage : uint8_t
+{
+    NONE,   // left in the state of its last use
+    COLOR_ATTACHMENT,
+    DEPTH_ATTACHMENT,
+    SHADER_READ,    // sampled by fragment shaders
+    TRANSFER_SRC,
+    PRESENT,
+};
+
+struct RenderGraphBarrier
+{
+    RenderGraphImage image;
+    rhi::PipelineImageBarrier barrier;  // without the image until the graph executes
+};
+
+struct RenderGraphStats
+{
+    uint32_t passes = 0;
+    uint32_t culled_passes = 0;
+    uint32_t barriers = 0;
+    uint32_t transient_images = 0;  // of passes that are not culled
+    uint32_t physical_images = 0;   // transient images alias them when their lifetimes don't overlap
+    uint32_t compiles = 0;
+    uint32_t cached_compiles = 0;   // the graph had the shape of the last compiled one
+    uint32_t created_images = 0;    // by the device, physical images are taken from the pool when one matches
+};
+
+class RenderGraphPass {
+public:
+    using ExecuteFunc = std::function<void(rhi::CommandList* cmd)>;
+    using LoadOp = rhi::FrameBufferInfo::AttachmentLoadOp;
+
+    // A pass with attachments runs in a render pass begun by the graph, with the attachments in declaration order
+    RenderGraphPass& AddColorOutput(RenderGraphImage image, LoadOp load_op = LoadOp::CLEAR, const rhi::ClearValue& clear_value = {});
+    RenderGraphPass& SetDepthOutput(RenderGraphImage image, LoadOp load_op = LoadOp::CLEAR, const rhi::ClearValue& clear_value = { 1.f, 0 });
+    RenderGraphPass& AddTextureInput(RenderGraphImage image);
+    RenderGraphPass& AddTransferInput(RenderGraphImage image);
+
+    // Never culled, the pass has an effect outside the graph like a copy to a buffer the CPU reads
+    RenderGraphPass& SetSideEffect() { m_side_effect = true; return *this; }
+    RenderGraphPass& SetContents(rhi::RenderPassContents contents) { m_contents = contents; return *this; }
+    RenderGraphPass& SetExecute(ExecuteFunc&& func) { m_execute = std::move(func); return *this; }
+
+    const std::string& GetName() const { return m_name; }
+
+private:
+    friend class RenderGraph;
+
+    struct Access
+    {
+        RenderGraphImage image;
+        RenderGraphImageUsage usage;
+        LoadOp load_op = LoadOp::DONTCARE;
+        rhi::ClearValue clear_value = {};
+    };
+
+    RenderGraphPass(const std::string& name) : m_name(name) {}
+    void AddAccess(RenderGraphImage image, RenderGraphImageUsage usage, LoadOp load_op = LoadOp::DONTCARE, const rhi::ClearValue& clear_value = {});
+
+    std::string m_name;
+    std::vector<Access> m_accesses;
+    bool m_side_effect = false;
+    rhi::RenderPassContents m_contents = rhi::RenderPassContents::INLINE;
+    ExecuteFunc m_execute;
+};
+
+// Frame graph above rhi::CommandList. Every frame the images and passes are declared again, in execution order,
+// then Compile() and Execute() record them:
+//* Passes whose outputs no later pass, imported image or side effect needs are culled.
+//* Image barriers are computed from the declared accesses, an imported image ends in its final usage.
+//* Transient images are created by the graph. Two with the same description whose lifetimes don't overlap share one
+//  physical image, the rhi has no memory aliasing so aliasing is at the image level.
+// Compilation only touches CPU data and is skipped when the declarations have the shape of the last compiled graph.
+class RenderGraph {
+public:
+    RenderGraph(rhi::Device* device = nullptr);  // a graph without a device can be compiled but not executed
+
+    void Reset();
+
+    RenderGraphImage CreateImage(const std::string& name, const rhi::ImageDesc& desc);
+    // An initial usage of NONE discards the contents the image had before the graph
+    RenderGraphImage ImportImage(const std::string& name, rhi::Image* image,
+        RenderGraphImageUsage initial_usage = RenderGraphImageUsage::NONE, RenderGraphImageUsage final_usage = RenderGraphImageUsage::NONE);
+    // The reference is valid until the graph is reset
+    RenderGraphPass& AddPass(const std::string& name);
+
+    void Compile();
+    void Execute(rhi::CommandList* cmd);
+
+    // Valid from Execute() to the next Reset()
+    rhi::Image* GetImage(RenderGraphImage image) const;
+
+    // Results of the last Compile()
+    bool IsPassCulled(uint32_t pass) const { return m_compiled_passes[pass].culled; }
+    const std::vector<RenderGraphBarrier>& GetBarriers(uint32_t pass) const { return m_compiled_passes[pass].barriers; }
+    const std::vector<RenderGraphBarrier>& GetFinalBarriers() const { return m_final_barriers; }
+    uint32_t GetPhysicalImageIndex(RenderGraphImage image) const { return m_compiled_images[image].physical; }
+    const RenderGraphStats& GetStats() const { return m_stats; }
+
+private:
+    struct ImageResource
+    {
+        std::string name;
+        rhi::ImageDesc desc;
+        rhi::Image* imported = nullptr;
+        RenderGraphImageUsage initial_usage = RenderGraphImageUsage::NONE;
+        RenderGraphImageUsage final_usage = RenderGraphImageUsage::NONE;
+    };
+
+    struct CompiledImage
+    {
+        uint32_t physical = UINT32_MAX; // transient images only
+        uint32_t first_pass = UINT32_MAX;
+        uint32_t last_pass = 0;
+        uint32_t usage_bits = 0;
+    };
+
+    struct CompiledPass
+    {
+        bool culled = true;
+        std::vector<RenderGraphBarrier> barriers;
+        std::vector<rhi::FrameBufferInfo::AttachmentStoreOp> store_ops;    // of the attachments, in access order
+    };
+
+    uint64_t HashDeclarations() const;
+    void CullPasses();
+    void AssignPhysicalImages();
+    void BuildBarriers();
+    void CreatePhysicalImages();
+    bool IsTransient(RenderGraphImage image) const { return m_images[image].imported == nullptr; }
+
+    rhi::Device* m_device;
+
+    std::vector<ImageResource> m_images;
+    std::deque<RenderGraphPass> m_passes;
+
+    uint64_t m_compiled_hash = 0;
+    std::vector<CompiledImage> m_compiled_images;
+    std::vector<CompiledPass> m_compiled_passes;
+    std::vector<RenderGraphBarrier> m_final_barriers;
+    std::vector<rhi::ImageDesc> m_physical_descs;
+
+    // physical images outlive the graph declarations and compiles, any graph with an image of the same
+    // description reuses it, an image no graph used for a while is released
+    struct PooledImage
+    {
+        Ref<rhi::Image> image;
+        uint32_t unused_executes = 0;
+        bool used = false;
+    };
+    std::vector<PooledImage> m_image_pool;
+    std::vector<rhi::Image*> m_physical_images;
+    std::vector<rhi::Image*> m_resolved_images;
+    std::vector<rhi::PipelineImageBarrier> m_barrier_scratch;
+
+    RenderGraphStats m_stats;
+};
+
+}
@@ -2,9 +2,33 @@
 #include "Quark/Render/RenderResourceManger.h"
 #include "Quark/Asset/AssetManager.h"
 #include "Quark/RHI/Device.h"
+#include "Quark/Core/JobSystem.h"
 
 namespace quark
 {
+    // filled by the job, read once the counter is down to zero
+    struct RenderResourceManager::PendingPipeline
+    {
+        JobSystem* job_system = nullptr;
+        JobSystem::Counter counter = {};
+        Ref<rhi::PipeLine> pipeline;
+    };
+
+    // sort indexes are packed into the draw sort key, a wider one would interleave unrelated draws
+    static uint32_t NextSortIndex(uint32_t& count, uint32_t bits)
+    {
+        QK_CORE_VERIFY(count < (1u << bits), "More than {} sort indexes, the draw sort key has no room for them", 1u << bits)
+        return count++;
+    }
+
+    RenderResourceManager::~RenderResourceManager()
+    {
+        WaitPendingGraphicsPSOs();
+
+        for (const auto& [image, registration] : m_bindless_images)
+            m_device->UnregisterBindlessImage(registration.index);
+    }
+
     RenderResourceManager::RenderResourceManager(Ref<rhi::Device> device)
         : m_device(device)
     {
@@ -12,6 +36,7 @@ namespace quark
 
         QK_CORE_VERIFY(device);
         m_shaderLibrary = CreateScope<ShaderLibrary>();
+        bindless_materials = device->GetDeviceFeatures().bindlessImages;
 
         // depth stencil states
         {
@@ -231,6 +256,8 @@ namespace quark
             default_material.roughnessFactor = 1.f;
             default_material.alphaMode = AlphaMode::MODE_OPAQUE;
             default_material.shaderProgram = GetShaderLibrary().program_staticMesh;
+            default_material.sort_index = NextSortIndex(m_material_sort_index_count, DRAW_SORT_MATERIAL_INDEX_BITS);
+            UpdateBindlessMaterial(default_material);
             default_material_id = uint64_t(UUID());
             m_render_materials[default_material_id] = default_material;
         }
@@ -256,7 +283,7 @@ namespace quark
         index_buffer_desc.domain = rhi::BufferMemoryDomain::GPU;
         new_render_mesh.index_buffer = m_device->CreateBuffer(index_buffer_desc, index_buffer_data);
 
-        // prepare staging buffer
+        // vertex buffers are created with their data, which is staged and copied with the other uploads of the frame
         uint64_t vertex_position_buffer_size = sizeof(glm::vec3) * mesh_asset->vertex_positions.size();
         uint64_t vertex_varying_enable_blending_buffer_size = 0;
         uint64_t vertex_varying_buffer_size = 0;
@@ -268,75 +295,49 @@ namespace quark
         if (!mesh_asset->vertex_uvs.empty())
             vertex_varying_buffer_size += sizeof(glm::vec2) * mesh_asset->vertex_uvs.size();
 
-        rhi::BufferDesc stage_buffer_desc;
-        stage_buffer_desc.size = vertex_position_buffer_size + vertex_varying_enable_blending_buffer_size + vertex_varying_buffer_size;
-        stage_buffer_desc.usageBits = rhi::BUFFER_USAGE_TRANSFER_FROM_BIT;
-        stage_buffer_desc.domain = rhi::BufferMemoryDomain::CPU;
-        Ref<rhi::Buffer> stage_buffer = m_device->CreateBuffer(stage_buffer_desc, nullptr);
-        void* stage_buffer_data = stage_buffer->GetMappedDataPtr();
-        QK_CORE_VERIFY(stage_buffer_data, "Failed to map stage buffer");
-
-        // upload vertex data to staging buffer
-        uint64_t vertex_position_buffer_offset = 0;
-        uint64_t vertex_varying_enable_blending_buffer_offset = vertex_position_buffer_offset + vertex_position_buffer_size;
-        uint64_t vertex_varying_buffer_offset = vertex_varying_enable_blending_buffer_offset + vertex_varying_enable_blending_buffer_size;
-
-        glm::vec3* vertex_positions_buffer_data = reinterpret_cast<glm::vec3*>(reinterpret_cast<uintptr_t>(stage_buffer_data) + vertex_position_buffer_offset);
-        uint8_t* vertex_varying_enable_blending_buffer_data = reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(stage_buffer_data) + vertex_varying_enable_blending_buffer_offset);
-        uint8_t* vertex_varying_buffer_data = reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(stage_buffer_data) + vertex_varying_buffer_offset);
-
+        // normals and tangents are interleaved
+        std::vector<uint8_t> vertex_varying_enable_blending_buffer_data(vertex_varying_enable_blending_buffer_size);
         size_t offset_in_vertex_varying_enable_blending_buffer = 0;
-        size_t offset_in_vertex_varying_buffer = 0;
         for (uint32_t i = 0; i < new_render_mesh.vertex_count; ++i) 
         {
-            vertex_positions_buffer_data[i] = mesh_asset->vertex_positions[i];
-
             if (!mesh_asset->vertex_normals.empty())
             {
-                memcpy(vertex_varying_enable_blending_buffer_data + offset_in_vertex_varying_enable_blending_buffer,
+                memcpy(vertex_varying_enable_blending_buffer_data.data() + offset_in_vertex_varying_enable_blending_buffer,
                      &mesh_asset->vertex_normals[i], sizeof(glm::vec3));
                 offset_in_vertex_varying_enable_blending_buffer += sizeof(glm::vec3);
             }
 
             if (!mesh_asset->vertex_tangents.empty())
             {
-                memcpy(vertex_varying_enable_blending_buffer_data + offset_in_vertex_varying_enable_blending_buffer,
+                memcpy(vertex_varying_enable_blending_buffer_data.data() + offset_in_vertex_varying_enable_blending_buffer,
                      &mesh_asset->vertex_tangents[i], sizeof(glm::vec3));
                 offset_in_vertex_varying_enable_blending_buffer += sizeof(glm::vec3);
             }
-
-            if (! mesh_asset->vertex_uvs.empty())
-            {
-                memcpy(vertex_varying_buffer_data + offset_in_vertex_varying_buffer,
-                     &mesh_asset->vertex_uvs[i], sizeof(glm::vec2));
-                offset_in_vertex_varying_buffer += sizeof(glm::vec2);
-            }
-            
         }
 
-        // copy staging buffer to gpu buffer
         rhi::BufferDesc buffer_desc;
         buffer_desc.domain = rhi::BufferMemoryDomain::GPU;
         buffer_desc.usageBits = rhi::BUFFER_USAGE_VERTEX_BUFFER_BIT | rhi::BUFFER_USAGE_TRANSFER_TO_BIT;
 
         buffer_desc.size = vertex_position_buffer_size;
-        new_render_mesh.vertex_position_buffer = m_device->CreateBuffer(buffer_desc, nullptr);
-        m_device->CopyBuffer(*new_render_mesh.vertex_position_buffer, *stage_buffer, vertex_position_buffer_size, 0, vertex_position_buffer_offset);
+        new_render_mesh.vertex_position_buffer = m_device->CreateBuffer(buffer_desc, mesh_asset->vertex_positions.data());
 
         if (vertex_varying_enable_blending_buffer_size > 0) 
         {
             buffer_desc.size = vertex_varying_enable_blending_buffer_size;
-            new_render_mesh.vertex_varying_enable_blending_buffer = m_device->CreateBuffer(buffer_desc, nullptr);
-            m_device->CopyBuffer(*new_render_mesh.vertex_varying_enable_blending_buffer, *stage_buffer, vertex_varying_enable_blending_buffer_size, 0, vertex_varying_enable_blending_buffer_offset);
+            new_render_mesh.vertex_varying_enable_blending_buffer = m_device->CreateBuffer(buffer_desc, vertex_varying_enable_blending_buffer_data.data());
         }
 
         if (vertex_varying_buffer_size > 0) 
         {
             buffer_desc.size = vertex_varying_buffer_size;
-            new_render_mesh.vertex_varying_buffer = m_device->CreateBuffer(buffer_desc, nullptr);
-            m_device->CopyBuffer(*new_render_mesh.vertex_varying_buffer, *stage_buffer, vertex_varying_buffer_size, 0, vertex_varying_buffer_offset);
+            new_render_mesh.vertex_varying_buffer = m_device->CreateBuffer(buffer_desc, mesh_asset->vertex_uvs.data());
         }
 
+        // a recreated mesh keeps its place in the draw order
+        auto existing = m_render_meshes.find(mesh_asset_id);
+        new_render_mesh.sort_index = existing != m_render_meshes.end() ? existing->second.sort_index : NextSortIndex(m_mesh_sort_index_count, DRAW_SORT_MESH_INDEX_BITS);
+
         m_render_meshes[mesh_asset_id] = new_render_mesh;
     }
 
@@ -373,9 +374,96 @@ namespace quark
         new_render_material.alphaMode = material_asset->alphaMode;
 
         new_render_material.shaderProgram = m_shaderLibrary->GetOrCreateGraphicsProgram(material_asset->vertexShaderPath, material_asset->fragmentShaderPath);
+
+        auto existing = m_render_materials.find(material_asset_id);
+        new_render_material.sort_index = existing != m_render_materials.end() ? existing->second.sort_index : NextSortIndex(m_material_sort_index_count, DRAW_SORT_MATERIAL_INDEX_BITS);
+        new_render_material.bindless_index = existing != m_render_materials.end() ? existing->second.bindless_index : ~0u;
+        UpdateBindlessMaterial(new_render_material);
+
         m_render_materials[material_asset_id] = new_render_material;
     }
 
+    void RenderResourceManager::UpdateBindlessMaterial(RenderPBRMaterial& material)
+    {
+        // materials of other programs bind their textures, one that left the bindless program lets go of its images
+        if (!bindless_materials || (material.shaderProgram != m_shaderLibrary->program_staticMesh &&
+            material.shaderProgram != m_shaderLibrary->program_staticMeshBindless))
+        {
+            if (material.bindless_index != ~0u)
+            {
+                for (const rhi::Image*& image : m_bindless_material_images[material.bindless_index])
+                    ReleaseBindlessImage(std::exchange(image, nullptr));
+            }
+            return;
+        }
+
+        material.shaderProgram = m_shaderLibrary->program_staticMeshBindless;
+        if (material.bindless_index == ~0u)
+        {
+            material.bindless_index = (uint32_t)m_bindless_material_data.size();
+            m_bindless_material_data.emplace_back();
+            m_bindless_material_images.push_back({});
+        }
+
+        // the new images are acquired before the old ones are released, an image the material keeps stays registered
+        StorageBufferData_Material& data = m_bindless_material_data[material.bindless_index];
+        data.colorFactors = material.colorFactors;
+        data.metallicFactor = material.metallicFactor;
+        data.roughnessFactor = material.roughnessFactor;
+        data.baseColorTexture = AcquireBindlessImage(material.base_color_texture_image);
+        data.metallicRoughnessTexture = AcquireBindlessImage(material.metallic_roughness_texture_image);
+
+        std::array<const rhi::Image*, 2>& images = m_bindless_material_images[material.bindless_index];
+        for (const rhi::Image* image : images)
+            ReleaseBindlessImage(image);
+        images = { material.base_color_texture_image.get(), material.metallic_roughness_texture_image.get() };
+        m_bindless_materials_dirty = true;
+    }
+
+    uint32_t RenderResourceManager::AcquireBindlessImage(const Ref<rhi::Image>& image)
+    {
+        BindlessImage& registration = m_bindless_images[image.get()];
+        if (registration.references++ == 0)
+        {
+            // written into the bindless image array once, drawing with it afterwards takes no descriptor work
+            registration.image = image;
+            registration.index = m_device->RegisterBindlessImage(*image, *sampler_linear);
+        }
+        return registration.index;
+    }
+
+    void RenderResourceManager::ReleaseBindlessImage(const rhi::Image* image)
+    {
+        if (!image)
+            return;
+
+        // the device keeps the index out of use until in flight frames that may sample it are done
+        auto it = m_bindless_images.find(image);
+        QK_CORE_ASSERT(it != m_bindless_images.end() && it->second.references > 0)
+        if (--it->second.references == 0)
+        {
+            m_device->UnregisterBindlessImage(it->second.index);
+            m_bindless_images.erase(it);
+        }
+    }
+
+    uint32_t RenderResourceManager::GetPipelineIndex(ShaderProgram& program, uint32_t mesh_attrib_mask, AlphaMode mode)
+    {
+        // the program and the alpha mode are the parts of the pipeline a material decides, the attributes the mesh's part
+        util::Hasher h;
+        h.u64(reinterpret_cast<uintptr_t>(&program));
+        h.u32(mesh_attrib_mask);
+        h.u32(util::ecast(mode));
+
+        auto [it, inserted] = m_pipeline_indexes.try_emplace(h.get(), (uint32_t)m_pipeline_states.size());
+        if (inserted)
+        {
+            QK_CORE_VERIFY(it->second < (1u << DRAW_SORT_PIPELINE_INDEX_BITS), "More than {} pipelines, the draw sort key has no room for them", 1u << DRAW_SORT_PIPELINE_INDEX_BITS)
+            m_pipeline_states.push_back({ &program, mesh_attrib_mask, mode });
+        }
+        return it->second;
+    }
+
     void RenderResourceManager::CreateImageRenderResource(AssetID image_asset_id)
     {
         auto image_asset = AssetManager::Get().GetAsset<ImageAsset>(image_asset_id);
@@ -434,6 +522,69 @@ namespace quark
     }
 
     Ref<rhi::PipeLine> RenderResourceManager::GetOrCreateGraphicsPSO(ShaderProgram& program, const rhi::RenderPassInfo2& rp, uint32_t mesh_attrib_mask, bool enableDepth, AlphaMode mode)
+    {
+        return GetGraphicsPSO(program, rp, mesh_attrib_mask, enableDepth, mode, nullptr);
+    }
+
+    rhi::PipeLine* RenderResourceManager::RequestGraphicsPSO(uint32_t pipeline_index, const rhi::RenderPassInfo2& rp, JobSystem* job_system)
+    {
+        QK_CORE_ASSERT(pipeline_index < m_pipeline_states.size())
+
+        // a frame draws in a handful of passes at most
+        const uint64_t pass_hash = rp.GetHash();
+        PassPipelines* pass = nullptr;
+        for (PassPipelines& p : m_pass_pipelines)
+        {
+            if (p.render_pass_hash == pass_hash)
+            {
+                pass = &p;
+                break;
+            }
+        }
+
+        if (!pass)
+        {
+            pass = &m_pass_pipelines.emplace_back();
+            pass->render_pass_hash = pass_hash;
+        }
+
+        if (pass->pipelines.size() <= pipeline_index)
+            pass->pipelines.resize(m_pipeline_states.size());
+
+        // the full state is only hashed until the pipeline is there
+        Ref<rhi::PipeLine>& pipeline = pass->pipelines[pipeline_index];
+        if (!pipeline)
+        {
+            const PipelineState& state = m_pipeline_states[pipeline_index];
+            pipeline = GetGraphicsPSO(*state.program, rp, state.mesh_attrib_mask, true, state.mode, job_system);
+        }
+        return pipeline.get();
+    }
+
+    void RenderResourceManager::PrecompileGraphicsPSOs(const std::vector<uint32_t>& pipeline_indexes, const rhi::RenderPassInfo2& rp, JobSystem* job_system)
+    {
+        std::vector<bool> used(m_pipeline_states.size(), false);
+        for (const uint32_t pipeline_index : pipeline_indexes)
+            used[pipeline_index] = true;
+
+        for (uint32_t i = 0; i < (uint32_t)used.size(); i++)
+        {
+            if (used[i])
+                RequestGraphicsPSO(i, rp, job_system);
+        }
+    }
+
+    void RenderResourceManager::WaitPendingGraphicsPSOs()
+    {
+        for (auto& [hash, pending] : m_pending_pipelines)
+        {
+            pending->job_system->Wait(&pending->counter, 1);
+            m_cached_pipelines[hash] = pending->pipeline;
+        }
+        m_pending_pipelines.clear();
+    }
+
+    Ref<rhi::PipeLine> RenderResourceManager::GetGraphicsPSO(ShaderProgram& program, const rhi::RenderPassInfo2& rp, uint32_t mesh_attrib_mask, bool enableDepth, AlphaMode mode, JobSystem* job_system)
     {
 
         auto& vertex_layout = GetOrCreateMeshVertexLayout(mesh_attrib_mask);
@@ -495,27 +646,52 @@ namespace quark
         util::Hash hash = h.get();
         auto it = m_cached_pipelines.find(hash);
         if (it != m_cached_pipelines.end())
-        {
             return it->second;
-        }
-        else
+
+        // a job is compiling it or has finished since the last request
+        auto pending_it = m_pending_pipelines.find(hash);
+        if (pending_it != m_pending_pipelines.end())
         {
-            rhi::GraphicPipeLineDesc desc = {};
-            desc.vertShader = programVariant->GetShader(rhi::ShaderStage::STAGE_VERTEX);
-            desc.fragShader = programVariant->GetShader(rhi::ShaderStage::STAGE_FRAGEMNT);
-            desc.depthStencilState = ds;
-            desc.blendState = bs;
-            desc.rasterState = rasterizationState_fill;
-            desc.topologyType = rhi::TopologyType::TRANGLE_LIST;
-            desc.renderPassInfo = rp;
-            if (vertex_layout.isValid())
-                desc.vertexInputLayout = vertex_layout;
+            PendingPipeline& pending = *pending_it->second;
+            if (pending.job_system->IsBusy(pending.counter))
+            {
+                if (job_system)
+                    return nullptr;
+                pending.job_system->Wait(&pending.counter, 1);
+            }
+
+            Ref<rhi::PipeLine> pipeline = pending.pipeline;
+            m_cached_pipelines[hash] = pipeline;
+            m_pending_pipelines.erase(pending_it);
+            return pipeline;
+        }
+
+        rhi::GraphicPipeLineDesc desc = {};
+        desc.vertShader = programVariant->GetShader(rhi::ShaderStage::STAGE_VERTEX);
+        desc.fragShader = programVariant->GetShader(rhi::ShaderStage::STAGE_FRAGEMNT);
+        desc.depthStencilState = ds;
+        desc.blendState = bs;
+        desc.rasterState = rasterizationState_fill;
+        desc.topologyType = rhi::TopologyType::TRANGLE_LIST;
+        desc.renderPassInfo = rp;
+        if (vertex_layout.isValid())
+            desc.vertexInputLayout = vertex_layout;
 
+        if (!job_system)
+        {
             Ref<rhi::PipeLine> newPipeline = m_device->CreateGraphicPipeLine(desc);
             m_cached_pipelines[hash] = newPipeline;
-
             return newPipeline;
         }
+
+        // shader variants are compiled above on this thread, only the driver's pipeline compile runs in the job
+        Scope<PendingPipeline>& pending = m_pending_pipelines[hash];
+        pending = CreateScope<PendingPipeline>();
+        pending->job_system = job_system;
+        PendingPipeline* target = pending.get();
+        rhi::Device* device = m_device.get();
+        job_system->Execute([device, target, desc]() { target->pipeline = device->CreateGraphicPipeLine(desc); }, &target->counter);
+        return nullptr;
     }
 
     Ref<rhi::VertexInputLayout> RenderResourceManager::GetOrCreateVertexInputLayout(uint32_t meshAttributesMask)
@@ -690,14 +866,36 @@ namespace quark
 
     void RenderResourceManager::UpdatePerFrameBuffer(const Ref<RenderScene>& scene)
     {
-        // create scene uniform buffer per frame
-        rhi::BufferDesc desc;
-        desc.domain = rhi::BufferMemoryDomain::CPU;
-        desc.size = sizeof(UniformBufferData_Scene);
-        desc.usageBits = rhi::BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-        ubo_scene = m_device->CreateBuffer(desc);
-
-        UniformBufferData_Scene* mappedData = (UniformBufferData_Scene*)ubo_scene->GetMappedDataPtr();
-        *mappedData = scene->ubo_data_scene;
+        // everything here is rewritten every frame, it lives in the frame's data buffers which are recycled with the frame
+        auto allocate = [&](const void* data, size_t count, size_t stride)
+        {
+            rhi::FrameAllocation allocation = m_device->AllocateFrameData(std::max<size_t>(count, 1) * stride);
+            if (count > 0)
+                memcpy(allocation.data, data, count * stride);
+            return allocation;
+        };
+
+        ubo_scene = allocate(&scene->ubo_data_scene, 1, sizeof(UniformBufferData_Scene));
+
+        const auto& instances = scene->main_camera_visibility.main_camera_draw_list.instances;
+        ssbo_instances = allocate(instances.data(), instances.size(), sizeof(InstanceData_Model));
+
+        const LightClusters& clusters = scene->light_clusters;
+        const UniformBufferData_LightClusters cluster_data = clusters.GetUniformData();
+        ubo_light_clusters = allocate(&cluster_data, 1, sizeof(UniformBufferData_LightClusters));
+        ssbo_lights = allocate(scene->lights.data(), scene->lights.size(), sizeof(StorageBufferData_Light));
+        ssbo_light_clusters = allocate(clusters.GetClusterRanges().data(), clusters.GetClusterRanges().size(), sizeof(glm::uvec2));
+        ssbo_light_indexes = allocate(clusters.GetLightIndexes().data(), clusters.GetLightIndexes().size(), sizeof(uint32_t));
+
+        // materials rarely change, their buffer is static data uploaded with the frame's other uploads
+        if (m_bindless_materials_dirty)
+        {
+            rhi::BufferDesc desc;
+            desc.domain = rhi::BufferMemoryDomain::GPU;
+            desc.size = sizeof(StorageBufferData_Material) * m_bindless_material_data.size();
+            desc.usageBits = rhi::BUFFER_USAGE_STORAGE_BUFFER_BIT | rhi::BUFFER_USAGE_TRANSFER_TO_BIT;
+            ssbo_materials = m_device->CreateBuffer(desc, m_bindless_material_data.data());
+            m_bindless_materials_dirty = false;
+        }
     }
 }
\ No newline at end of file
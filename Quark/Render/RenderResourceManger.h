@@ -52,15 +52,27 @@ namespace quark
 		// default materials
 		uint64_t default_material_id;
 
+		// Materials of program_staticMesh draw with program_staticMeshBindless if the device supports bindless images.
+		// Their textures are registered in the bindless image array and their data is in ssbo_materials, so changing
+		// material is a push constant of its index instead of binding its textures
+		bool bindless_materials = false;
+		Ref<rhi::Buffer> ssbo_materials;	// StorageBufferData_Material by bindless index, recreated when materials change
+
 		// pipelines
 		//Ref<rhi::PipeLine> pipeline_skybox;
 		//Ref<rhi::PipeLine> pipeline_infiniteGrid;
 		Ref<rhi::PipeLine> pipeline_entityID;
 		
-		// buffers
-		Ref<rhi::Buffer> ubo_scene;
+		// per frame buffers, ranges of the device's frame data
+		rhi::FrameAllocation ubo_scene;
+		rhi::FrameAllocation ssbo_instances;	// InstanceData_Model of the main camera's draw list
+		rhi::FrameAllocation ubo_light_clusters;
+		rhi::FrameAllocation ssbo_lights;			// StorageBufferData_Light
+		rhi::FrameAllocation ssbo_light_clusters;	// offset and count into ssbo_light_indexes per cluster
+		rhi::FrameAllocation ssbo_light_indexes;
 
 		RenderResourceManager(Ref<rhi::Device> device);
+		~RenderResourceManager();
 
 		ShaderLibrary& GetShaderLibrary() { return *m_shaderLibrary; }
 
@@ -79,6 +91,19 @@ namespace quark
 		Ref<rhi::Image> GetImage(uint64_t image_id);
 
     	Ref<rhi::PipeLine> GetOrCreateGraphicsPSO(ShaderProgram& program, const rhi::RenderPassInfo2& rp, const uint32_t mesh_attrib_mask, bool enableDepth, AlphaMode mode);
+
+		// Small index of what a render object decides about its pipeline, resolved once when the object is created.
+		// The render pass is the only other part, pipelines are looked up by index per pass
+		uint32_t GetPipelineIndex(ShaderProgram& program, uint32_t mesh_attrib_mask, AlphaMode mode);
+
+		// Depth tested pipeline of a pipeline index in this pass. One that isn't compiled yet is compiled by a job instead
+		// of blocking the caller, nullptr is returned until that job is done and the caller skips what needs it for now
+		rhi::PipeLine* RequestGraphicsPSO(uint32_t pipeline_index, const rhi::RenderPassInfo2& rp, JobSystem* job_system);
+
+		// Queues a compile job for each of these pipeline indexes in this render pass, repeated indexes are requested once
+		void PrecompileGraphicsPSOs(const std::vector<uint32_t>& pipeline_indexes, const rhi::RenderPassInfo2& rp, JobSystem* job_system);
+		uint32_t GetPendingGraphicsPSOCount() const { return (uint32_t)m_pending_pipelines.size(); }
+		void WaitPendingGraphicsPSOs();
 		Ref<rhi::VertexInputLayout> GetOrCreateVertexInputLayout(uint32_t meshAttributesMask);
 		rhi::VertexInputLayout& GetOrCreateMeshVertexLayout(uint32_t meshAttributesMask);
 
@@ -86,6 +111,28 @@ namespace quark
 		void UpdateMeshRenderResource(AssetID mesh_id);
 
 	private:
+		struct PendingPipeline;
+
+		struct PipelineState
+		{
+			ShaderProgram* program;
+			uint32_t mesh_attrib_mask;
+			AlphaMode mode;
+		};
+
+		struct PassPipelines
+		{
+			uint64_t render_pass_hash = 0;
+			std::vector<Ref<rhi::PipeLine>> pipelines;	// by pipeline index, null until compiled
+		};
+
+		Ref<rhi::PipeLine> GetGraphicsPSO(ShaderProgram& program, const rhi::RenderPassInfo2& rp, uint32_t mesh_attrib_mask, bool enableDepth, AlphaMode mode, JobSystem* job_system);
+
+		// switches a material of program_staticMesh to the bindless program and writes its data, keeping its bindless index
+		void UpdateBindlessMaterial(RenderPBRMaterial& material);
+		uint32_t AcquireBindlessImage(const Ref<rhi::Image>& image);
+		void ReleaseBindlessImage(const rhi::Image* image);
+
 		Ref<rhi::Device> m_device;
 		Scope<ShaderLibrary> m_shaderLibrary;
 
@@ -95,8 +142,30 @@ namespace quark
 		std::unordered_map<uint64_t, rhi::VertexInputLayout> m_mesh_vertex_layouts;
 		std::unordered_map<uint64_t, Ref<rhi::Image>> m_images;
 		std::unordered_map<uint64_t, Ref<rhi::PipeLine>> m_cached_pipelines;
+		std::unordered_map<uint64_t, Scope<PendingPipeline>> m_pending_pipelines;	// by the same hash, compiled by jobs
     	std::unordered_map<uint64_t, Ref<rhi::VertexInputLayout>> m_cached_vertexInputLayouts;
 
+		// sort indexes for the draw order
+		uint32_t m_mesh_sort_index_count = 0;
+		uint32_t m_material_sort_index_count = 0;
+
+		// pipeline indexes
+		std::vector<PipelineState> m_pipeline_states;
+		std::unordered_map<uint64_t, uint32_t> m_pipeline_indexes;
+		std::vector<PassPipelines> m_pass_pipelines;
+
+		// bindless materials, an image stays registered and alive while a material's data refers to it
+		struct BindlessImage
+		{
+			Ref<rhi::Image> image;
+			uint32_t index = 0;
+			uint32_t references = 0;
+		};
+		std::unordered_map<const rhi::Image*, BindlessImage> m_bindless_images;
+		std::vector<StorageBufferData_Material> m_bindless_material_data;
+		std::vector<std::array<const rhi::Image*, 2>> m_bindless_material_images;	// by bindless index, what its data refers to
+		bool m_bindless_materials_dirty = false;
+
 		// 
 	};
 
@@ -1,5 +1,9 @@
 #include "Quark/qkpch.h"
 #include "Quark/Render/RenderScene.h"
+#include "Quark/Core/Util/Hash.h"
+#include "Quark/Core/JobSystem.h"
+
+#include <glm/gtc/matrix_transform.hpp>
 
 namespace quark 
 {
@@ -14,62 +18,417 @@ namespace quark
         ubo_data_scene.sunlightColor = sunlightColor;
     }
     
+    uint64_t RenderScene::GetRenderObjectID(uint64_t entity_id, uint64_t section_index)
+    {
+        util::Hasher hasher;
+        hasher.u64(entity_id);
+        hasher.u64(section_index);
+        return hasher.get();
+    }
+
     void RenderScene::DeleteRenderObjectsByEntityID(uint64_t entity_id)
     {
-        std::vector<uint64_t> to_delete_entity_ids;
-        for (auto it = render_object_to_entity.begin(); it != render_object_to_entity.end();)
+        // removing the head moves the last object into its place, which may be another section of this entity
+        while (const uint32_t* head = entity_to_first_offset.find(entity_id))
+            RemoveRenderObject(*head);
+    }
+
+    void RenderScene::AddOrUpdateRenderObject(const RenderObject& obj, uint64_t entity_id)
+    {
+        if (const uint32_t* find = render_object_to_offset.find(obj.id))
         {
-            if (it->second == entity_id)
-            {
-                uint64_t render_entity_id = it->first;
-                size_t offset = render_object_to_offset[render_entity_id];
-                render_objects[offset] = render_objects.back();
-                render_object_to_offset[render_objects.back().id] = offset;
-                render_objects.pop_back();
-                render_object_to_offset.erase(render_entity_id);
-                it = render_object_to_entity.erase(it);
-            }
-            else
-                ++it;
+            RenderObject& dst = render_objects[*find];
+            QK_CORE_ASSERT(dst.entity_id == entity_id, "RenderScene: a render object can't change its entity")
+            const uint32_t bvh_proxy = dst.bvh_proxy;
+            const uint32_t prev_in_entity = dst.prev_in_entity;
+            const uint32_t next_in_entity = dst.next_in_entity;
+            dst = obj;
+            dst.entity_id = entity_id;
+            dst.bvh_proxy = bvh_proxy;
+            dst.prev_in_entity = prev_in_entity;
+            dst.next_in_entity = next_in_entity;
+            UpdateBounds(*find);
+        }
+        else
+        {
+            const uint32_t offset = (uint32_t)render_objects.size();
+            const math::Aabb world_aabb = obj.aabb.Transform(obj.model_matrix);
+            RenderObject& dst = render_objects.emplace_back(obj);
+            dst.entity_id = entity_id;
+            dst.bvh_proxy = bvh.CreateProxy(world_aabb, offset);
+            render_object_bounds.PushBack(world_aabb);
+            render_object_to_offset[obj.id] = offset;
+            LinkToEntity(offset);
         }
     }
 
-    void RenderScene::AddOrUpdateRenderObject(const RenderObject& obj, uint64_t entity_id)
+    void RenderScene::UpdateRenderObjectsTransform(uint64_t entity_id, const glm::mat4& transform)
     {
-        auto find = render_object_to_offset.find(obj.id);
-        if (find != render_object_to_offset.end())
+        const uint32_t* head = entity_to_first_offset.find(entity_id);
+        for (uint32_t offset = head ? *head : ~0u; offset != ~0u; offset = render_objects[offset].next_in_entity)
         {
-            render_objects[find->second] = obj;
+            render_objects[offset].model_matrix = transform;
+            UpdateBounds(offset);
+
+            if (const uint32_t* occluder = occluder_to_offset.find(render_objects[offset].id))
+                occluders[*occluder].model_matrix = transform;
         }
+    }
+
+    void RenderScene::AddOrUpdateOccluder(const Occluder& occluder)
+    {
+        if (const uint32_t* find = occluder_to_offset.find(occluder.id))
+        {
+            occluders[*find] = occluder;
+        }
+        else
+        {
+            occluder_to_offset[occluder.id] = (uint32_t)occluders.size();
+            occluders.push_back(occluder);
+        }
+    }
+
+    void RenderScene::DeleteOccluder(uint64_t render_object_id)
+    {
+        const uint32_t* find = occluder_to_offset.find(render_object_id);
+        if (!find)
+            return;
+
+        const uint32_t offset = *find;
+        occluder_to_offset.erase(render_object_id);
+        if (offset != occluders.size() - 1)
+        {
+            occluders[offset] = std::move(occluders.back());
+            occluder_to_offset[occluders[offset].id] = offset;
+        }
+        occluders.pop_back();
+    }
+
+    void RenderScene::LinkToEntity(uint32_t offset)
+    {
+        RenderObject& obj = render_objects[offset];
+        const uint32_t* head = entity_to_first_offset.find(obj.entity_id);
+        obj.prev_in_entity = ~0u;
+        obj.next_in_entity = head ? *head : ~0u;
+        if (head)
+            render_objects[*head].prev_in_entity = offset;
+        entity_to_first_offset[obj.entity_id] = offset;
+    }
+
+    void RenderScene::UnlinkFromEntity(uint32_t offset)
+    {
+        RenderObject& obj = render_objects[offset];
+        if (obj.prev_in_entity != ~0u)
+            render_objects[obj.prev_in_entity].next_in_entity = obj.next_in_entity;
+        else if (obj.next_in_entity != ~0u)
+            entity_to_first_offset[obj.entity_id] = obj.next_in_entity;
         else
+            entity_to_first_offset.erase(obj.entity_id);
+
+        if (obj.next_in_entity != ~0u)
+            render_objects[obj.next_in_entity].prev_in_entity = obj.prev_in_entity;
+        obj.prev_in_entity = ~0u;
+        obj.next_in_entity = ~0u;
+    }
+
+    void RenderScene::RemoveRenderObject(uint32_t offset)
+    {
+        RenderObject& obj = render_objects[offset];
+        DeleteOccluder(obj.id);
+        UnlinkFromEntity(offset);
+        bvh.DestroyProxy(obj.bvh_proxy);
+        render_object_to_offset.erase(obj.id);
+
+        // swap the last object in and point everything that knew its offset at the new one
+        const uint32_t last = (uint32_t)render_objects.size() - 1;
+        if (offset != last)
         {
-            render_objects.push_back(obj);
-            render_object_to_offset[obj.id] = render_objects.size() - 1;
-            render_object_to_entity[obj.id] = entity_id;
+            RenderObject& moved = render_objects[offset];
+            moved = render_objects[last];
+            render_object_to_offset[moved.id] = offset;
+            bvh.SetUserData(moved.bvh_proxy, offset);
+
+            if (moved.prev_in_entity != ~0u)
+                render_objects[moved.prev_in_entity].next_in_entity = offset;
+            else
+                entity_to_first_offset[moved.entity_id] = offset;
+            if (moved.next_in_entity != ~0u)
+                render_objects[moved.next_in_entity].prev_in_entity = offset;
         }
+
+        render_object_bounds.RemoveSwapBack(offset);
+        render_objects.pop_back();
     }
 
-    void RenderScene::UpdateVisibility(Visibility& out_vis, const UniformBufferData_Camera& cameraData)
+    math::Aabb RenderScene::GetWorldAabb(uint32_t offset) const
     {
-        out_vis.main_camera_visible_object_indexes.clear();
+        const RenderObject& obj = render_objects[offset];
+        return obj.aabb.Transform(obj.model_matrix);
+    }
+
+    void RenderScene::UpdateBounds(uint32_t offset)
+    {
+        const math::Aabb world_aabb = GetWorldAabb(offset);
+        render_object_bounds.Set(offset, world_aabb);
+        bvh.MoveProxy(render_objects[offset].bvh_proxy, world_aabb);
+    }
+
+    void RenderScene::UpdateVisibility(Visibility& out_vis, const UniformBufferData_Camera& cameraData, JobSystem* job_system)
+    {
+        // more subtrees than threads, as some of them are mostly outside and finish early
+        constexpr uint32_t chunks_per_thread = 4;
+
         out_vis.camera_ubo_data = cameraData;
         out_vis.frustum.Build(glm::inverse(cameraData.viewproj));
 
-        auto is_visible = [&](const RenderObject& obj)
+        // occluders first, every culling job reads the finished buffer
+        const bool occlusion_culling = enable_occlusion_culling && !occluders.empty();
+        if (occlusion_culling)
+            occlusion_buffer.Rasterize(occluders, cameraData.viewproj, job_system);
+
+        const uint32_t chunk_count = job_system ? job_system->GetNumWorkerThreads() * chunks_per_thread : 1;
+        bvh.SplitQuery(out_vis.frustum, chunk_count, m_cull_roots);
+
+        const uint32_t root_count = (uint32_t)m_cull_roots.size();
+        const uint32_t roots_per_chunk = std::max((root_count + chunk_count - 1) / chunk_count, 1u);
+        m_cull_chunks.resize((root_count + roots_per_chunk - 1) / roots_per_chunk);
+
+        auto cull_roots = [&](uint32_t begin, uint32_t end)
         {
-            math::Aabb transformed_aabb = obj.aabb.Transform(obj.model_matrix);
-            if (out_vis.frustum.CheckSphere(transformed_aabb))
-                return true;
-            else
-                return false;
+            CullChunk& chunk = m_cull_chunks[begin / roots_per_chunk];
+            chunk.visible.clear();
+            chunk.candidates.clear();
+
+            // leaves of subtrees fully inside are visible, the others are tested in batches afterwards
+            for (uint32_t i = begin; i < end; i++)
+            {
+                bvh.Query(out_vis.frustum, m_cull_roots[i], [&](uint32_t index, bool fully_inside)
+                {
+                    if (fully_inside)
+                        chunk.visible.push_back(index);
+                    else
+                        chunk.candidates.push_back(index);
+                });
+            }
+
+            const size_t inside_count = chunk.visible.size();
+            chunk.visible.resize(inside_count + chunk.candidates.size());
+            uint32_t count = math::CullIndexedAabbs(out_vis.frustum, render_object_bounds, chunk.candidates.data(), (uint32_t)chunk.candidates.size(), chunk.visible.data() + inside_count);
+            chunk.visible.resize(inside_count + count);
+
+            chunk.occluded_count = 0;
+            if (occlusion_culling)
+            {
+                auto occluded = std::remove_if(chunk.visible.begin(), chunk.visible.end(), [&](uint32_t index)
+                {
+                    return !occlusion_buffer.IsVisible(render_object_bounds.Get(index));
+                });
+                chunk.occluded_count = (uint32_t)(chunk.visible.end() - occluded);
+                chunk.visible.erase(occluded, chunk.visible.end());
+            }
         };
 
-        for (size_t i = 0; i < render_objects.size(); i++)
+        if (job_system && m_cull_chunks.size() > 1)
+        {
+            JobSystem::Counter counter{};
+            job_system->Dispatch(root_count, roots_per_chunk, cull_roots, &counter);
+            job_system->Wait(&counter, 1);
+        }
+        else if (root_count > 0)
+        {
+            cull_roots(0, root_count);
+        }
+
+        // every chunk owns its range of the output, so no locking is needed
+        std::vector<uint32_t>& visible = out_vis.main_camera_visible_object_indexes;
+        size_t visible_count = 0;
+        out_vis.main_camera_occluded_count = 0;
+        for (const CullChunk& chunk : m_cull_chunks)
+        {
+            visible_count += chunk.visible.size();
+            out_vis.main_camera_occluded_count += chunk.occluded_count;
+        }
+
+        visible.resize(visible_count);
+        size_t offset = 0;
+        for (const CullChunk& chunk : m_cull_chunks)
         {
-            if (is_visible(render_objects[i]))
-                out_vis.main_camera_visible_object_indexes.push_back((uint32_t)i);
+            std::copy(chunk.visible.begin(), chunk.visible.end(), visible.begin() + offset);
+            offset += chunk.visible.size();
         }
-		
+    }
+
+    void RenderScene::CullViews(const math::Frustum* frusta, uint32_t view_count, std::vector<uint32_t>* out_visible_lists, JobSystem* job_system)
+    {
+        for (uint32_t first = 0; first < view_count; first += math::AabbTree::MAX_MULTI_QUERY_FRUSTA)
+        {
+            const uint32_t count = std::min(view_count - first, math::AabbTree::MAX_MULTI_QUERY_FRUSTA);
+            CullViewGroup(frusta + first, count, out_visible_lists + first, job_system);
+        }
+    }
+
+    void RenderScene::CullViewGroup(const math::Frustum* frusta, uint32_t view_count, std::vector<uint32_t>* out_visible_lists, JobSystem* job_system)
+    {
+        constexpr uint32_t chunks_per_thread = 4;
+
+        const uint32_t chunk_count = job_system ? job_system->GetNumWorkerThreads() * chunks_per_thread : 1;
+        bvh.SplitMultiQuery(frusta, view_count, chunk_count, m_multi_cull_roots);
+
+        const uint32_t root_count = (uint32_t)m_multi_cull_roots.size();
+        const uint32_t roots_per_chunk = std::max((root_count + chunk_count - 1) / chunk_count, 1u);
+        m_multi_cull_chunks.resize((root_count + roots_per_chunk - 1) / roots_per_chunk);
+
+        auto cull_roots = [&](uint32_t begin, uint32_t end)
+        {
+            MultiCullChunk& chunk = m_multi_cull_chunks[begin / roots_per_chunk];
+            chunk.visible.resize(view_count);
+            chunk.candidates.resize(view_count);
+            for (uint32_t view = 0; view < view_count; view++)
+            {
+                chunk.visible[view].clear();
+                chunk.candidates[view].clear();
+            }
+
+            for (uint32_t i = begin; i < end; i++)
+            {
+                bvh.MultiQuery(frusta, m_multi_cull_roots[i], [&](uint32_t index, uint32_t partial_mask, uint32_t inside_mask)
+                {
+                    util::for_each_bit(inside_mask, [&](uint32_t view) { chunk.visible[view].push_back(index); });
+                    util::for_each_bit(partial_mask, [&](uint32_t view) { chunk.candidates[view].push_back(index); });
+                });
+            }
+
+            // then the leaves in batches, view by view
+            for (uint32_t view = 0; view < view_count; view++)
+            {
+                std::vector<uint32_t>& visible = chunk.visible[view];
+                const std::vector<uint32_t>& candidates = chunk.candidates[view];
+                const size_t inside_count = visible.size();
+                visible.resize(inside_count + candidates.size());
+                uint32_t count = math::CullIndexedAabbs(frusta[view], render_object_bounds, candidates.data(), (uint32_t)candidates.size(), visible.data() + inside_count);
+                visible.resize(inside_count + count);
+            }
+        };
+
+        if (job_system && m_multi_cull_chunks.size() > 1)
+        {
+            JobSystem::Counter counter{};
+            job_system->Dispatch(root_count, roots_per_chunk, cull_roots, &counter);
+            job_system->Wait(&counter, 1);
+        }
+        else if (root_count > 0)
+        {
+            cull_roots(0, root_count);
+        }
+
+        for (uint32_t view = 0; view < view_count; view++)
+        {
+            std::vector<uint32_t>& visible = out_visible_lists[view];
+            size_t visible_count = 0;
+            for (const MultiCullChunk& chunk : m_multi_cull_chunks)
+                visible_count += chunk.visible[view].size();
+
+            visible.resize(visible_count);
+            size_t offset = 0;
+            for (const MultiCullChunk& chunk : m_multi_cull_chunks)
+            {
+                std::copy(chunk.visible[view].begin(), chunk.visible[view].end(), visible.begin() + offset);
+                offset += chunk.visible[view].size();
+            }
+        }
+    }
+
+    void RenderScene::UpdateDirectionalLightVisibility(Visibility& out_vis, const glm::mat4* cascade_viewprojs, uint32_t cascade_count, JobSystem* job_system)
+    {
+        m_light_frusta.resize(cascade_count);
+        for (uint32_t i = 0; i < cascade_count; i++)
+            m_light_frusta[i].Build(glm::inverse(cascade_viewprojs[i]));
+
+        out_vis.directional_light_visible_object_indexes.resize(cascade_count);
+        CullViews(m_light_frusta.data(), cascade_count, out_vis.directional_light_visible_object_indexes.data(), job_system);
+    }
+
+    void RenderScene::UpdatePointLightVisibility(Visibility& out_vis, const glm::vec3* light_positions, const float* light_ranges, uint32_t light_count, JobSystem* job_system)
+    {
+        const uint32_t view_count = light_count * 6;
+        m_light_frusta.resize(view_count);
+        for (uint32_t i = 0; i < view_count; i++)
+            m_light_frusta[i].Build(glm::inverse(GetPointLightFaceViewProj(light_positions[i / 6], light_ranges[i / 6], i % 6)));
+
+        out_vis.point_lights_visible_object_indexes.resize(view_count);
+        CullViews(m_light_frusta.data(), view_count, out_vis.point_lights_visible_object_indexes.data(), job_system);
+    }
+
+    glm::mat4 RenderScene::GetPointLightFaceViewProj(const glm::vec3& light_position, float light_range, uint32_t face)
+    {
+        // cube map face order and up vectors
+        static const glm::vec3 directions[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        static const glm::vec3 ups[6] = { { 0, -1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, -1, 0 }, { 0, -1, 0 } };
+
+        const glm::mat4 view = glm::lookAt(light_position, light_position + directions[face], ups[face]);
+        const glm::mat4 proj = glm::perspective(glm::radians(90.f), 1.f, light_range * 1e-3f, light_range);
+        return proj * view;
+    }
+
+    void RenderScene::UpdateLods(const Visibility& vis, JobSystem* job_system)
+    {
+        constexpr uint32_t group_size = 512;
+
+        const std::vector<uint32_t>& object_indexes = vis.main_camera_visible_object_indexes;
+        const glm::vec3 view_position = glm::vec3(glm::inverse(vis.camera_ubo_data.view)[3]);
+        const float proj_scale = std::abs(vis.camera_ubo_data.proj[1][1]);   // y is flipped for vulkan
+
+        auto select_lods = [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                RenderObject& obj = render_objects[object_indexes[i]];
+                if (obj.lod_count <= 1)
+                    continue;
+
+                const uint32_t offset = object_indexes[i];
+                const glm::vec3 center(render_object_bounds.center_x[offset], render_object_bounds.center_y[offset], render_object_bounds.center_z[offset]);
+                float screen_size = GetScreenSize(center, render_object_bounds.radius[offset], view_position, proj_scale);
+                obj.lod = SelectLod(obj, screen_size, lod_hysteresis);
+                obj.start_index = obj.lods[obj.lod].start_index;
+                obj.index_count = obj.lods[obj.lod].index_count;
+            }
+        };
+
+        // every job writes its own objects only
+        const uint32_t object_count = (uint32_t)object_indexes.size();
+        if (job_system && object_count > group_size)
+        {
+            JobSystem::Counter counter{};
+            job_system->Dispatch(object_count, group_size, select_lods, &counter);
+            job_system->Wait(&counter, 1);
+        }
+        else
+        {
+            select_lods(0, object_count);
+        }
+    }
+
+    float RenderScene::GetScreenSize(const glm::vec3& center, float radius, const glm::vec3& view_position, float proj_scale)
+    {
+        const float distance = std::max(glm::length(center - view_position), radius);
+        if (distance <= 0.f)
+            return std::numeric_limits<float>::max();
+
+        return radius * proj_scale / distance;
+    }
+
+    uint32_t RenderScene::SelectLod(const RenderObject& obj, float screen_size, float hysteresis)
+    {
+        uint32_t lod = std::min(obj.lod, obj.lod_count - 1);
+
+        // coarser as soon as the size is under the next threshold, finer only once it is clearly above the current one
+        while (lod + 1 < obj.lod_count && screen_size < obj.lods[lod + 1].screen_size)
+            lod++;
+        while (lod > 0 && screen_size > obj.lods[lod].screen_size * (1.f + hysteresis))
+            lod--;
+
+        return lod;
     }
 
 }
\ No newline at end of file
@@ -1,9 +1,16 @@
 #pragma once
 #include "Quark/Render/RenderTypes.h"
+#include "Quark/Render/DrawList.h"
+#include "Quark/Render/OcclusionBuffer.h"
+#include "Quark/Render/LightClusters.h"
 #include "Quark/Core/Math/Frustum.h"
+#include "Quark/Core/Math/AabbTree.h"
+#include "Quark/Core/Math/FrustumCulling.h"
+#include "Quark/Core/Util/FlatHashMap.h"
 
 namespace quark
 {
+	class JobSystem;
 	class RenderScene;
 	struct Visibility
 	{
@@ -11,8 +18,12 @@ namespace quark
 
 		// visible objects (updated per frame)
 		std::vector<uint32_t> main_camera_visible_object_indexes;
-		std::vector<uint32_t> directional_light_visible_object_indexes;
-		std::vector<uint32_t> point_lights_visible_object_indexes;
+		std::vector<std::vector<uint32_t>> directional_light_visible_object_indexes;	// per shadow cascade
+		std::vector<std::vector<uint32_t>> point_lights_visible_object_indexes;		// 6 cube faces per light, +x -x +y -y +z -z
+		uint32_t main_camera_occluded_count = 0;	// in the frustum but hidden by occluders
+
+		// instanced draws of the visible objects (updated per frame)
+		DrawList main_camera_draw_list;
 
 		UniformBufferData_Camera camera_ubo_data;
 		math::Frustum frustum;
@@ -34,21 +45,94 @@ namespace quark
 		UniformBufferData_Scene ubo_data_scene;
 
 		// cache
-		std::unordered_map<uint64_t, size_t> render_object_to_offset;
-		std::unordered_map<uint64_t, uint64_t> render_object_to_entity;
+		util::FlatHashMap<uint64_t, uint32_t> render_object_to_offset;
+		util::FlatHashMap<uint64_t, uint32_t> entity_to_first_offset;	// head of the entity's list through render_objects
+
+		// world bounds of render_objects, same offsets
+		math::BoundsSoA render_object_bounds;
+
+		// over render_object_bounds, user data is the offset in render_objects
+		math::AabbTree bvh;
 
 		Visibility main_camera_visibility;
 
+		// occluders are rasterized into the occlusion buffer before every visibility update
+		std::vector<Occluder> occluders;
+		util::FlatHashMap<uint64_t, uint32_t> occluder_to_offset;	// by render object id
+		OcclusionBuffer occlusion_buffer;
+		bool enable_occlusion_culling = true;
+
+		// there are no light components yet, whoever owns the lights fills this before the frame is processed
+		std::vector<StorageBufferData_Light> lights;
+		LightClusters light_clusters;
+
+		// a finer lod is only picked again once the screen size is this much above its threshold, which stops popping
+		float lod_hysteresis = 0.1f;
+
 		RenderScene();
 		
+		// a render object is created for every section of an entity's mesh
+		static uint64_t GetRenderObjectID(uint64_t entity_id, uint64_t section_index);
+
 		void DeleteRenderObjectsByEntityID(uint64_t entity_id);
 		void AddOrUpdateRenderObject(const RenderObject& entity, uint64_t entity_id);
+		void UpdateRenderObjectsTransform(uint64_t entity_id, const glm::mat4& transform);
+
+		// the occluder's id is the one of its render object, which moves it along
+		void AddOrUpdateOccluder(const Occluder& occluder);
+		void DeleteOccluder(uint64_t render_object_id);
+
+		// culls a few subtrees of the bvh per job when a job system is given
+		void UpdateVisibility(Visibility& out_vis, const UniformBufferData_Camera& cameraData, JobSystem* job_system = nullptr);
 
-		void UpdateVisibility(Visibility& out_vis, const UniformBufferData_Camera& cameraData);
+		// culls against several views in one walk of the bvh, out_visible_lists[i] gets the objects frusta[i] sees.
+		// Views are taken 32 at a time, on the job system when one is given
+		void CullViews(const math::Frustum* frusta, uint32_t view_count, std::vector<uint32_t>* out_visible_lists, JobSystem* job_system = nullptr);
+
+		// shadow casters of every cascade of the directional light
+		void UpdateDirectionalLightVisibility(Visibility& out_vis, const glm::mat4* cascade_viewprojs, uint32_t cascade_count, JobSystem* job_system = nullptr);
+
+		// shadow casters of the 6 cube faces of every point light
+		void UpdatePointLightVisibility(Visibility& out_vis, const glm::vec3* light_positions, const float* light_ranges, uint32_t light_count, JobSystem* job_system = nullptr);
+		static glm::mat4 GetPointLightFaceViewProj(const glm::vec3& light_position, float light_range, uint32_t face);
+
+		// picks the lod of every visible object from its projected size, runs on the job system when one is given
+		void UpdateLods(const Visibility& vis, JobSystem* job_system = nullptr);
+
+		// projected bounding sphere diameter / viewport height, proj_scale is proj[1][1]
+		static float GetScreenSize(const glm::vec3& center, float radius, const glm::vec3& view_position, float proj_scale);
+		static uint32_t SelectLod(const RenderObject& obj, float screen_size, float hysteresis);
 
 	private:
-		void UpdateMainCameraVisibility(const UniformBufferData_Camera& cameraData);
-		void UpdateDirectionalLightVisibility();
-		void UpdatePointLightVisibility();
+		math::Aabb GetWorldAabb(uint32_t offset) const;
+		void UpdateBounds(uint32_t offset);
+
+		// the entity lists and the bvh point at offsets, so moving an object patches them too
+		void LinkToEntity(uint32_t offset);
+		void UnlinkFromEntity(uint32_t offset);
+		void RemoveRenderObject(uint32_t offset);
+
+		// output of one culling job, merged into the visibility afterwards
+		struct CullChunk
+		{
+			std::vector<uint32_t> visible;
+			std::vector<uint32_t> candidates;	// bvh leaves that still need their own bounds tested
+			uint32_t occluded_count = 0;
+		};
+
+		// same for CullViews(), with a list per view
+		struct MultiCullChunk
+		{
+			std::vector<std::vector<uint32_t>> visible;
+			std::vector<std::vector<uint32_t>> candidates;
+		};
+
+		std::vector<math::AabbTree::QueryRoot> m_cull_roots;
+		std::vector<CullChunk> m_cull_chunks;
+		std::vector<math::AabbTree::MultiQueryRoot> m_multi_cull_roots;
+		std::vector<MultiCullChunk> m_multi_cull_chunks;
+		std::vector<math::Frustum> m_light_frusta;
+
+		void CullViewGroup(const math::Frustum* frusta, uint32_t view_count, std::vector<uint32_t>* out_visible_lists, JobSystem* job_system);
 	};
 }
\ No newline at end of file
@@ -3,12 +3,87 @@
 
 namespace quark 
 {
+    void RenderSwapContext::SetPipelined(bool pipelined)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        QK_CORE_ASSERT(m_renderFrameState != RenderFrameState::RENDERING)
+        m_pipelined = pipelined;
+        m_exitRequested = false;
+        m_renderFrameState = RenderFrameState::IDLE;
+    }
+
     void RenderSwapContext::SwapLogicRenderData()
     {
-        if (IsReadyToSwap()) 
+        if (!m_pipelined)
+        {
+            if (IsReadyToSwap())
+                Swap();
+
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_renderFrameState == RenderFrameState::IDLE || m_exitRequested; });
+
+            if (m_exitRequested)
+                return;
+
+            // The render side may have skipped ProcessSwapData (e.g. device failed to begin a frame),
+            // in which case we keep accumulating into the logic data just like the serial path does
+            if (IsReadyToSwap())
+                Swap();
+
+            m_renderFrameState = RenderFrameState::PUBLISHED;
+        }
+
+        m_condition.notify_all();
+    }
+
+    void RenderSwapContext::WaitForRenderIdle()
+    {
+        if (!m_pipelined)
+            return;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this] { return m_renderFrameState == RenderFrameState::IDLE || m_exitRequested; });
+    }
+
+    bool RenderSwapContext::BeginRenderFrame()
+    {
+        QK_CORE_ASSERT(m_pipelined)
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this] { return m_renderFrameState == RenderFrameState::PUBLISHED || m_exitRequested; });
+
+        if (m_exitRequested)
+            return false;
+
+        m_renderFrameState = RenderFrameState::RENDERING;
+        return true;
+    }
+
+    void RenderSwapContext::EndRenderFrame()
+    {
+        QK_CORE_ASSERT(m_pipelined)
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            QK_CORE_ASSERT(m_renderFrameState == RenderFrameState::RENDERING)
+            m_renderFrameState = RenderFrameState::IDLE;
+        }
+
+        m_condition.notify_all();
+    }
+
+    void RenderSwapContext::RequestExit()
+    {
         {
-            Swap();
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_exitRequested = true;
         }
+
+        m_condition.notify_all();
     }
 
     void RenderSwapContext::Swap()
@@ -19,6 +94,7 @@ namespace quark
     bool RenderSwapContext::IsReadyToSwap() const
     {
         return (m_swapData[m_render_swap_data_index].dirty_static_mesh_render_proxies.empty() &&
+            m_swapData[m_render_swap_data_index].dirty_transforms.empty() &&
             m_swapData[m_render_swap_data_index].to_delete_entities.empty() &&
             !m_swapData[m_render_swap_data_index].camera_swap_data.has_value());
     }
@@ -1,11 +1,22 @@
 #pragma once
 #include "Quark/Asset/Asset.h"
+#include "Quark/Asset/MeshAsset.h"
 #include "Quark/Core/Math/Aabb.h"
+#include "Quark/Core/Util/LinearAllocator.h"
 
 #include <glm/glm.hpp>
+#include <mutex>
+#include <condition_variable>
 
 namespace quark 
 {
+    struct MeshSectionLodDesc
+    {
+        uint32_t index_offset;
+        uint32_t index_count;
+        float screen_size;  // used under this projected size
+    };
+
     struct MeshSectionDesc 
     {
         uint32_t index_offset;
@@ -13,6 +24,10 @@ namespace quark
 
         math::Aabb aabb;
         AssetID material_asset_id;;
+
+        // coarser levels, lods[i] is level i + 1
+        MeshSectionLodDesc lods[MESH_LOD_MAX_NUM - 1];
+        uint32_t lod_count;     // including level 0
     };
 
     struct StaticMeshRenderProxy 
@@ -21,7 +36,18 @@ namespace quark
         AssetID mesh_asset_id = 0;
         glm::mat4 transform;
 
-        std::vector<MeshSectionDesc> mesh_sections;
+        // Flat array allocated from the owning RenderSwapData's arena, valid until the render side has consumed it
+        const MeshSectionDesc* mesh_sections = nullptr;
+        uint32_t mesh_section_count = 0;
+
+        bool is_occluder = false;
+    };
+
+    // Entities whose mesh and materials are unchanged only send their new world matrix
+    struct TransformSwapData
+    {
+        uint64_t entity_id = 0;
+        glm::mat4 transform;
     };
 
     struct CameraSwapData 
@@ -32,11 +58,21 @@ namespace quark
 
     struct RenderSwapData 
     {
+        // The containers are cleared but never shrunk after being consumed, 
+        // so filling them only allocates while the scene is still growing
         std::vector<StaticMeshRenderProxy> dirty_static_mesh_render_proxies;
+        std::vector<TransformSwapData> dirty_transforms;    // applied after dirty_static_mesh_render_proxies
         std::vector<uint64_t> to_delete_entities;
         std::optional<CameraSwapData> camera_swap_data;
+
+        util::LinearAllocator arena;    // backs the variable sized proxy data, reset together with dirty_static_mesh_render_proxies
     };  
 
+    // Double buffered logic -> render data.
+    // In serial mode the logic and render stage run back to back on the main thread and the swap is a plain index flip.
+    // In pipelined mode the render stage runs on its own thread, and this class is the only synchronization point
+    // between the two stages: the logic thread publishes a frame with SwapLogicRenderData(), 
+    // the render thread picks it up with BeginRenderFrame() and hands it back with EndRenderFrame().
     class RenderSwapContext 
     {
     public:
@@ -50,7 +86,19 @@ namespace quark
         RenderSwapData& GetLogicSwapData() { return m_swapData[m_logic_swap_data_index]; }
         RenderSwapData& GetRenderSwapData() { return m_swapData[m_render_swap_data_index]; }
 
-        void SwapLogicRenderData();
+        // Only while no render thread is running, switching to pipelined mode can follow an exit request
+        void SetPipelined(bool pipelined);
+        bool IsPipelined() const { return m_pipelined; }
+
+        // Logic side
+        void SwapLogicRenderData();     // pipelined mode: blocks until the render side is idle, then publishes a new frame
+        void WaitForRenderIdle();       // blocks until the render side has finished the last published frame
+
+        // Render side (pipelined mode only)
+        bool BeginRenderFrame();        // blocks until a frame is published, returns false when exit is requested
+        void EndRenderFrame();
+
+        void RequestExit();
 
     private:
         void Swap();
@@ -60,7 +108,20 @@ namespace quark
         uint8_t m_render_swap_data_index = RenderSwapDataType;
         RenderSwapData m_swapData[SwapDataTypeCount];
 
+        // pipelining
+        enum class RenderFrameState : uint8_t
+        {
+            IDLE,
+            PUBLISHED,
+            RENDERING
+        };
+
+        bool m_pipelined = false;
+        bool m_exitRequested = false;
+        RenderFrameState m_renderFrameState = RenderFrameState::IDLE;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
     };
 
 
-}
\ No newline at end of file
+}
@@ -9,11 +9,32 @@
 #include "Quark/Scene/Components/TransformCmpt.h"
 #include "Quark/Scene/Components/MeshRendererCmpt.h"
 #include "Quark/Core/Util/Hash.h"
+#include "Quark/Core/Application.h"
 
 namespace quark {
 
 using namespace rhi;
 
+// a mesh section with only the vertices it uses. Always the full detail one: simplified lods move the surface
+// outwards as well as inwards, and an occluder that sticks out of its mesh hides what is visible
+static void BuildOccluder(const MeshAsset& mesh, const MeshSectionDesc& section_desc, Occluder& out_occluder)
+{
+    const uint32_t index_offset = section_desc.index_offset;
+    const uint32_t index_count = section_desc.index_count;
+
+    std::unordered_map<uint32_t, uint32_t> remap;
+    out_occluder.positions.clear();
+    out_occluder.indices.resize(index_count);
+    for (uint32_t i = 0; i < index_count; i++)
+    {
+        const uint32_t vertex = mesh.indices[index_offset + i];
+        auto [it, inserted] = remap.try_emplace(vertex, (uint32_t)out_occluder.positions.size());
+        if (inserted)
+            out_occluder.positions.push_back(mesh.vertex_positions[vertex]);
+        out_occluder.indices[i] = it->second;
+    }
+}
+
 RenderSystem::RenderSystem(Ref<rhi::Device> device)
     : m_device(device)
 {
@@ -38,16 +59,11 @@ void RenderSystem::ProcessSwapData()
     {
         for (const auto& renderProxy : renderSwapData.dirty_static_mesh_render_proxies)
         {
-            for (size_t section_index = 0; section_index < renderProxy.mesh_sections.size(); section_index++)
+            for (uint32_t section_index = 0; section_index < renderProxy.mesh_section_count; section_index++)
             {   
                 const MeshSectionDesc& section_desc = renderProxy.mesh_sections[section_index];
                 RenderObject new_entity;
-
-                // calculate entity's hash id
-                util::Hasher hasher;
-                hasher.u64(renderProxy.entity_id);
-                hasher.u64(section_index);
-                new_entity.id = hasher.get();
+                new_entity.id = RenderScene::GetRenderObjectID(renderProxy.entity_id, section_index);
 
                 new_entity.model_matrix = renderProxy.transform;
                 new_entity.aabb = section_desc.aabb;
@@ -56,6 +72,14 @@ void RenderSystem::ProcessSwapData()
                 new_entity.index_count = section_desc.index_count;
                 new_entity.start_index = section_desc.index_offset;
 
+                new_entity.lod_count = section_desc.lod_count;
+                new_entity.lods[0] = { section_desc.index_offset, section_desc.index_count, 0.f };
+                for (uint32_t lod = 1; lod < section_desc.lod_count; lod++)
+                {
+                    const MeshSectionLodDesc& lod_desc = section_desc.lods[lod - 1];
+                    new_entity.lods[lod] = { lod_desc.index_offset, lod_desc.index_count, lod_desc.screen_size };
+                }
+
                 // create render resources
                 if (!m_renderResourceManager->IsMeshAssetRegisterd(renderProxy.mesh_asset_id)) 
                     m_renderResourceManager->CreateMeshRenderResouce(renderProxy.mesh_asset_id);
@@ -71,24 +95,53 @@ void RenderSystem::ProcessSwapData()
                     if (!m_renderResourceManager->IsMaterialAssetRegisterd(section_desc.material_asset_id))
                         m_renderResourceManager->CreateMaterialRenderResource(section_desc.material_asset_id);
                 }
-                
+
+                // pipeline and draw order
+                RenderPBRMaterial& render_material = m_renderResourceManager->GetRenderMaterial(new_entity.render_material_id);
+                const RenderMesh& render_mesh = m_renderResourceManager->GetRenderMesh(new_entity.render_mesh_id);
+                new_entity.pipeline_index = (uint16_t)m_renderResourceManager->GetPipelineIndex(*render_material.shaderProgram, render_mesh.mesh_attribute_mask, render_material.alphaMode);
+                new_entity.material_sort_index = (uint16_t)render_material.sort_index;
+                new_entity.mesh_sort_index = (uint16_t)render_mesh.sort_index;
+                QK_CORE_VERIFY(section_index < DRAW_SORT_SECTION_MAX_NUM, "More than {} mesh sections, the draw sort key has no room for them", DRAW_SORT_SECTION_MAX_NUM)
+                new_entity.section_index = (uint16_t)section_index;
+                new_entity.transparent = render_material.alphaMode == AlphaMode::MODE_TRANSPARENT;
+                m_updatedPipelineIndexes.push_back(new_entity.pipeline_index);
+
                 // add to render scene
-                auto find = m_renderScene->render_object_to_offset.find(new_entity.id);
-                if (find != m_renderScene->render_object_to_offset.end())
+                m_renderScene->AddOrUpdateRenderObject(new_entity, renderProxy.entity_id);
+
+                Ref<MeshAsset> mesh = renderProxy.is_occluder ? AssetManager::Get().GetAsset<MeshAsset>(renderProxy.mesh_asset_id) : nullptr;
+                if (mesh)
                 {
-                    m_renderScene->render_objects[find->second] = new_entity;
+                    Occluder occluder;
+                    occluder.id = new_entity.id;
+                    occluder.model_matrix = new_entity.model_matrix;
+                    BuildOccluder(*mesh, section_desc, occluder);
+                    m_renderScene->AddOrUpdateOccluder(occluder);
                 }
                 else
                 {
-                    m_renderScene->render_objects.push_back(new_entity);
-                    m_renderScene->render_object_to_offset[new_entity.id] = m_renderScene->render_objects.size() - 1;
-                    m_renderScene->render_object_to_entity[new_entity.id] = renderProxy.entity_id;
+                    m_renderScene->DeleteOccluder(new_entity.id);
                 }
-
             }
         }
         
         renderSwapData.dirty_static_mesh_render_proxies.clear();
+        renderSwapData.arena.reset();
+
+        // new meshes and materials start compiling now rather than when they first show up on screen, only the
+        // batch's objects can draw with a pipeline that isn't requested yet
+        m_renderResourceManager->PrecompileGraphicsPSOs(m_updatedPipelineIndexes, m_renderResourceManager->renderPassInfo_simpleMainPass, Application::Get().GetJobSystem().get());
+        m_updatedPipelineIndexes.clear();
+    }
+
+    // update transforms
+    if (!renderSwapData.dirty_transforms.empty())
+    {
+        for (const auto& transformData : renderSwapData.dirty_transforms)
+            m_renderScene->UpdateRenderObjectsTransform(transformData.entity_id, transformData.transform);
+
+        renderSwapData.dirty_transforms.clear();
     }
 
     // delete render entities
@@ -100,6 +153,10 @@ void RenderSystem::ProcessSwapData()
         renderSwapData.to_delete_entities.clear();
     }
 
+    // culling, lods and the draw list are timed together, they are what the visible object count costs
+    const auto visibility_start = std::chrono::high_resolution_clock::now();
+    JobSystem* job_system = Application::Get().GetJobSystem().get();
+
     // update camera
     if (renderSwapData.camera_swap_data.has_value())
     {
@@ -107,10 +164,25 @@ void RenderSystem::ProcessSwapData()
         m_renderScene->ubo_data_scene.cameraUboData.proj = renderSwapData.camera_swap_data->proj;
         m_renderScene->ubo_data_scene.cameraUboData.viewproj = renderSwapData.camera_swap_data->proj * renderSwapData.camera_swap_data->view;
         // update visibility TODO: Remove this
-        m_renderScene->UpdateVisibility(m_renderScene->main_camera_visibility, m_renderScene->ubo_data_scene.cameraUboData);
+        m_renderScene->UpdateVisibility(m_renderScene->main_camera_visibility, m_renderScene->ubo_data_scene.cameraUboData, job_system);
         renderSwapData.camera_swap_data.reset();
     }
 
+    // lods follow the camera and every moved object
+    m_renderScene->UpdateLods(m_renderScene->main_camera_visibility, job_system);
+
+    // instance transforms are copied, so the draw list follows every object update
+    Visibility& main_camera_visibility = m_renderScene->main_camera_visibility;
+    const glm::vec3 view_position = glm::vec3(glm::inverse(main_camera_visibility.camera_ubo_data.view)[3]);
+    main_camera_visibility.main_camera_draw_list.Build(m_renderScene->render_objects, main_camera_visibility.main_camera_visible_object_indexes, view_position, job_system);
+
+    m_stats.occluded_objects = main_camera_visibility.main_camera_occluded_count;
+    m_stats.visibility_time_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - visibility_start).count();
+
+    // lights are binned against the main camera every frame, they move without telling us
+    const auto light_cluster_start = std::chrono::high_resolution_clock::now();
+    m_renderScene->light_clusters.Build(m_renderScene->lights, main_camera_visibility.camera_ubo_data, job_system);
+    m_stats.light_cluster_time_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - light_cluster_start).count();
 
     m_renderResourceManager->UpdatePerFrameBuffer(m_renderScene);
 
@@ -243,7 +315,8 @@ void RenderSystem::DrawSkybox(uint64_t env_map_id, rhi::CommandList* cmd)
         m_renderResourceManager->mesh_attrib_mask_skybox,
         false, AlphaMode::MODE_OPAQUE);
 
-    cmd->BindUniformBuffer(0, 0, *m_renderResourceManager->ubo_scene, 0, sizeof(UniformBufferData_Scene));
+    const rhi::FrameAllocation& ubo_scene = m_renderResourceManager->ubo_scene;
+    cmd->BindUniformBuffer(0, 0, *ubo_scene.buffer, ubo_scene.offset, ubo_scene.size);
 
     cmd->BindImage(1, 0, *envMap, ImageLayout::SHADER_READ_ONLY_OPTIMAL);
     cmd->BindSampler(1, 0, *m_renderResourceManager->sampler_cube);
@@ -260,97 +333,213 @@ void RenderSystem::DrawGrid(rhi::CommandList* cmd)
         *m_renderResourceManager->GetShaderLibrary().staticProgram_infiniteGrid,
         cmd->GetCurrentRenderPassInfo(), 0, true, AlphaMode::MODE_OPAQUE);
     
-    cmd->BindUniformBuffer(0, 0, *m_renderResourceManager->ubo_scene, 0, sizeof(UniformBufferData_Scene));
+    const rhi::FrameAllocation& ubo_scene = m_renderResourceManager->ubo_scene;
+    cmd->BindUniformBuffer(0, 0, *ubo_scene.buffer, ubo_scene.offset, ubo_scene.size);
 
     cmd->BindPipeLine(*infiniteGrid_pipeline);
     cmd->Draw(6, 1, 0, 0);
 }
 
-void RenderSystem::DrawScene(const RenderScene& scene, const Visibility& vis, rhi::CommandList* cmd)
-{   
-    uint16_t lastMaterialID = 0;
-    uint16_t lastMeshID = 0;
+void RenderSystem::RequestBatchPipelines(const DrawList& draw_list, const rhi::RenderPassInfo2& render_pass_info)
+{
+    // pipelines no one has seen yet are compiled by jobs, batches that need them are skipped until they are done
+    JobSystem* job_system = Application::Get().GetJobSystem().get();
+
+    m_batchPipelines.resize(draw_list.batches.size());
+    uint32_t lastPipelineIndex = ~0u;
+    rhi::PipeLine* pipeline = nullptr;
+    for (size_t i = 0; i < draw_list.batches.size(); i++)
+    {
+        // the index was resolved when the render object was created
+        if (draw_list.batches[i].pipeline_index != lastPipelineIndex)
+        {
+            lastPipelineIndex = draw_list.batches[i].pipeline_index;
+            pipeline = m_renderResourceManager->RequestGraphicsPSO(lastPipelineIndex, render_pass_info, job_system);
+        }
+        m_batchPipelines[i] = pipeline;
+    }
+}
+
+void RenderSystem::DrawBatches(const DrawBatch* batches, rhi::PipeLine* const* pipelines, uint32_t count, rhi::CommandList* cmd, RenderStats& stats)
+{
+    uint64_t lastMaterialID = 0;
+    uint64_t lastMeshID = 0;
     RenderPBRMaterial* lastMaterial = nullptr;
     RenderMesh* lastMesh = nullptr;
+    rhi::PipeLine* lastPipeline = nullptr;
 
-    std::vector<uint32_t> visible_object_indexes = vis.main_camera_visible_object_indexes;
-    std::sort(visible_object_indexes.begin(), visible_object_indexes.end(), [&](const uint32_t& iA, const uint32_t& iB)
+    const rhi::FrameAllocation& ubo_scene = m_renderResourceManager->ubo_scene;
+    cmd->BindUniformBuffer(0, 0, *ubo_scene.buffer, ubo_scene.offset, ubo_scene.size);
+    const rhi::FrameAllocation& ssbo_instances = m_renderResourceManager->ssbo_instances;
+    cmd->BindStorageBuffer(0, 1, *ssbo_instances.buffer, ssbo_instances.offset, ssbo_instances.size);
+
+    // bindless materials read the material buffer and the bindless image array, both bound once
+    bool bindlessImagesBound = false;
+    if (m_renderResourceManager->bindless_materials)
     {
-        const RenderObject& A = scene.render_objects[iA];
-        const RenderObject& B = scene.render_objects[iB];
-        if (A.render_material_id == B.render_material_id)
-            return A.render_mesh_id < B.render_mesh_id;
-        else
-            return A.render_material_id < B.render_material_id;
-    });
-
-    cmd->BindUniformBuffer(0, 0, *m_renderResourceManager->ubo_scene, 0, sizeof(UniformBufferData_Scene));
-    auto draw = [&](const RenderObject& obj)
+        const Ref<rhi::Buffer>& ssbo_materials = m_renderResourceManager->ssbo_materials;
+        cmd->BindStorageBuffer(0, 6, *ssbo_materials, 0, ssbo_materials->GetDesc().size);
+    }
+
+    for (uint32_t i = 0; i < count; i++)
     {
+        const DrawBatch& batch = batches[i];
+
         // rebind material
-        if (obj.render_material_id != lastMaterialID)
+        if (batch.render_material_id != lastMaterialID)
         {
-            lastMaterialID = obj.render_material_id;
-            lastMaterial = &m_renderResourceManager->GetRenderMaterial(obj.render_material_id);
-            // (deprecated)cmd_list->BindUniformBuffer(1, 0, *lastMaterial->uniformBuffer, lastMaterial->uniformBufferOffset, sizeof(Material::UniformBufferBlock));
-            cmd->BindImage(1, 1, *lastMaterial->base_color_texture_image, ImageLayout::SHADER_READ_ONLY_OPTIMAL);
-            cmd->BindSampler(1, 1, *m_renderResourceManager->sampler_linear);
-            cmd->BindImage(1, 2, *lastMaterial->metallic_roughness_texture_image, ImageLayout::SHADER_READ_ONLY_OPTIMAL);
-            cmd->BindSampler(1, 2, *m_renderResourceManager->sampler_linear);
-
-            PushConstants_Material materialPushConstants;
-            materialPushConstants.colorFactors = lastMaterial->colorFactors;
-            materialPushConstants.metallicFactor = lastMaterial->metallicFactor;
-            materialPushConstants.roughnessFactor = lastMaterial->roughnessFactor;
-            cmd->PushConstant(&materialPushConstants, sizeof(glm::mat4), sizeof(PushConstants_Material));
+            lastMaterialID = batch.render_material_id;
+            lastMaterial = &m_renderResourceManager->GetRenderMaterial(batch.render_material_id);
+            if (lastMaterial->bindless_index != ~0u)
+            {
+                // set 1 is the bindless image array, changing material changes no descriptor set
+                if (!bindlessImagesBound)
+                {
+                    cmd->BindBindlessImages(1);
+                    bindlessImagesBound = true;
+                }
+
+                PushConstants_BindlessMaterial materialPushConstants;
+                materialPushConstants.materialIndex = lastMaterial->bindless_index;
+                cmd->PushConstant(&materialPushConstants, sizeof(glm::mat4), sizeof(PushConstants_BindlessMaterial));
+            }
+            else
+            {
+                cmd->BindImage(1, 1, *lastMaterial->base_color_texture_image, ImageLayout::SHADER_READ_ONLY_OPTIMAL);
+                cmd->BindSampler(1, 1, *m_renderResourceManager->sampler_linear);
+                cmd->BindImage(1, 2, *lastMaterial->metallic_roughness_texture_image, ImageLayout::SHADER_READ_ONLY_OPTIMAL);
+                cmd->BindSampler(1, 2, *m_renderResourceManager->sampler_linear);
+                bindlessImagesBound = false;
+
+                PushConstants_Material materialPushConstants;
+                materialPushConstants.colorFactors = lastMaterial->colorFactors;
+                materialPushConstants.metallicFactor = lastMaterial->metallicFactor;
+                materialPushConstants.roughnessFactor = lastMaterial->roughnessFactor;
+                cmd->PushConstant(&materialPushConstants, sizeof(glm::mat4), sizeof(PushConstants_Material));
+            }
+            stats.material_binds++;
         }
+
         // rebind mesh buffers
-        if (obj.render_mesh_id != lastMeshID)
-		{
-			lastMeshID = obj.render_mesh_id;
-			lastMesh = &m_renderResourceManager->GetRenderMesh(obj.render_mesh_id);
-			cmd->BindVertexBuffer(0, *lastMesh->vertex_position_buffer, 0);
-			cmd->BindVertexBuffer(1, *lastMesh->vertex_varying_enable_blending_buffer, 0);
+        if (batch.render_mesh_id != lastMeshID)
+        {
+            lastMeshID = batch.render_mesh_id;
+            lastMesh = &m_renderResourceManager->GetRenderMesh(batch.render_mesh_id);
+            cmd->BindVertexBuffer(0, *lastMesh->vertex_position_buffer, 0);
+            cmd->BindVertexBuffer(1, *lastMesh->vertex_varying_enable_blending_buffer, 0);
             cmd->BindVertexBuffer(2, *lastMesh->vertex_varying_buffer, 0);
-			cmd->BindIndexBuffer(*lastMesh->index_buffer, 0, IndexBufferFormat::UINT32);
-		}
+            cmd->BindIndexBuffer(*lastMesh->index_buffer, 0, IndexBufferFormat::UINT32);
+            stats.mesh_binds++;
+        }
 
-        // push model constant
-        PushConstants_Model push_constant;
-        push_constant.worldMatrix = obj.model_matrix;
+        // rebind pipeline
+        rhi::PipeLine* pipeline = pipelines[i];
+        if (!pipeline)
+        {
+            stats.skipped_draw_calls++;
+            continue;
+        }
 
-        cmd->PushConstant(&push_constant, 0, 64);  // only push model matrix
+        if (pipeline != lastPipeline)
+        {
+            lastPipeline = pipeline;
+            cmd->BindPipeLine(*pipeline);
+            stats.pipeline_binds++;
+        }
 
-        // rebind Pipeline
-        Ref<rhi::PipeLine> pipeline = m_renderResourceManager->GetOrCreateGraphicsPSO(
-            *lastMaterial->shaderProgram, cmd->GetCurrentRenderPassInfo(),
-            lastMesh->mesh_attribute_mask, true, lastMaterial->alphaMode);
-        cmd->BindPipeLine(*pipeline);
+        // instance transforms are read with gl_InstanceIndex, which starts at first_instance
+        cmd->DrawIndexed(batch.index_count, batch.instance_count, batch.start_index, 0, batch.first_instance);
+        stats.draw_calls++;
+        stats.triangles += (batch.index_count / 3) * batch.instance_count;
+    }
+}
 
-        cmd->DrawIndexed(obj.index_count, 1, obj.start_index, 0, 0);
-    };
+void RenderSystem::DrawScene(const RenderScene& scene, const Visibility& vis, rhi::CommandList* cmd)
+{   
+    const auto start = std::chrono::high_resolution_clock::now();
+    const DrawList& draw_list = vis.main_camera_draw_list;
+
+    RenderStats stats;
+    RequestBatchPipelines(draw_list, cmd->GetCurrentRenderPassInfo());
+    DrawBatches(draw_list.batches.data(), m_batchPipelines.data(), (uint32_t)draw_list.batches.size(), cmd, stats);
+    StoreDrawStats(draw_list, &stats, 1, 0, start);
+}
+
+void RenderSystem::DrawSceneParallel(const RenderScene& scene, const Visibility& vis, rhi::CommandList* cmd)
+{
+    // a chunk is big enough for its rebinding at the start and the cost of a secondary command list not to matter
+    constexpr uint32_t min_batches_per_chunk = 256;
 
-    for (auto obj : vis.main_camera_visible_object_indexes)
-        draw(scene.render_objects[obj]);
+    const auto start = std::chrono::high_resolution_clock::now();
+    const DrawList& draw_list = vis.main_camera_draw_list;
+    JobSystem* job_system = Application::Get().GetJobSystem().get();
+
+    RequestBatchPipelines(draw_list, cmd->GetCurrentRenderPassInfo());
+
+    const uint32_t batch_count = (uint32_t)draw_list.batches.size();
+    const uint32_t max_chunks = job_system->GetNumWorkerThreads() + 1;
+    const uint32_t chunk_count = std::max(1u, std::min(max_chunks, batch_count / min_batches_per_chunk));
+    const uint32_t batches_per_chunk = (batch_count + chunk_count - 1) / chunk_count;
+
+    std::vector<rhi::CommandList*> secondaries(chunk_count);
+    std::vector<RenderStats> chunk_stats(chunk_count);
+    JobSystem::Counter counter{};
+    job_system->Dispatch(chunk_count, 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const uint32_t first = std::min(i * batches_per_chunk, batch_count);
+            const uint32_t count = std::min(first + batches_per_chunk, batch_count) - first;
+            secondaries[i] = m_device->BeginSecondaryCommandList(*cmd);
+            DrawBatches(draw_list.batches.data() + first, m_batchPipelines.data() + first, count, secondaries[i], chunk_stats[i]);
+        }
+    }, &counter);
+    job_system->Wait(&counter, 1);
+
+    // executed in chunk order, the draws keep their sort order
+    cmd->ExecuteSecondaryCommandLists(secondaries.data(), chunk_count);
+    StoreDrawStats(draw_list, chunk_stats.data(), chunk_count, chunk_count, start);
+}
+
+void RenderSystem::StoreDrawStats(const DrawList& draw_list, const RenderStats* chunk_stats, uint32_t chunk_count, uint32_t secondary_cmd_lists, std::chrono::high_resolution_clock::time_point start)
+{
+    m_stats.draw_calls = 0;
+    m_stats.instances = (uint32_t)draw_list.instances.size();
+    m_stats.triangles = 0;
+    m_stats.pipeline_binds = 0;
+    m_stats.material_binds = 0;
+    m_stats.mesh_binds = 0;
+    m_stats.skipped_draw_calls = 0;
+    for (uint32_t i = 0; i < chunk_count; i++)
+    {
+        m_stats.draw_calls += chunk_stats[i].draw_calls;
+        m_stats.triangles += chunk_stats[i].triangles;
+        m_stats.pipeline_binds += chunk_stats[i].pipeline_binds;
+        m_stats.material_binds += chunk_stats[i].material_binds;
+        m_stats.mesh_binds += chunk_stats[i].mesh_binds;
+        m_stats.skipped_draw_calls += chunk_stats[i].skipped_draw_calls;
+    }
+    m_stats.secondary_cmd_lists = secondary_cmd_lists;
+    m_stats.pending_pipelines = m_renderResourceManager->GetPendingGraphicsPSOCount();
+    m_stats.record_time_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
 }
 
 void RenderSystem::DrawEntityID(const RenderScene& scene, const Visibility& vis, rhi::CommandList* cmd)
 {
     QK_CORE_ASSERT(cmd->GetCurrentRenderPassInfo().colorAttachmentFormats[0] == rhi::DataFormat::R32G32_UINT);
     
-    cmd->BindUniformBuffer(0, 0, *m_renderResourceManager->ubo_scene, 0, sizeof(UniformBufferData_Scene));
+    const rhi::FrameAllocation& ubo_scene = m_renderResourceManager->ubo_scene;
+    cmd->BindUniformBuffer(0, 0, *ubo_scene.buffer, ubo_scene.offset, ubo_scene.size);
     cmd->BindPipeLine(*m_renderResourceManager->pipeline_entityID);
 
     for (const uint32_t idx : vis.main_camera_visible_object_indexes)
     {
         const RenderObject& obj = scene.render_objects[idx];
         RenderMesh& render_mesh = m_renderResourceManager->GetRenderMesh(obj.render_mesh_id);
-        auto find = scene.render_object_to_entity.find(obj.id);
-        QK_CORE_ASSERT(find != scene.render_object_to_entity.end());
         cmd->BindVertexBuffer(0, *render_mesh.vertex_position_buffer, 0);
         cmd->BindIndexBuffer(*render_mesh.index_buffer, 0, IndexBufferFormat::UINT32);
         cmd->PushConstant(&obj.model_matrix, 0, 64);
-        cmd->PushConstant(&find->second, 64, 8);
+        cmd->PushConstant(&obj.entity_id, 64, 8);
 
         cmd->DrawIndexed(obj.index_count, 1, obj.start_index, 0, 0);
     }
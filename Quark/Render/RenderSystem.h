@@ -5,11 +5,32 @@
 #include "Quark/RHI/Device.h"
 #include "Quark/Core/Util/Singleton.h"
 #include "Quark/Core/Math/Frustum.h"
+#include <chrono>
 
 
 namespace quark {
 class Scene;
 
+struct RenderStats
+{
+    // last DrawScene() only
+    uint32_t draw_calls = 0;
+    uint32_t instances = 0;
+    uint64_t triangles = 0;
+    uint32_t pipeline_binds = 0;
+    uint32_t material_binds = 0;
+    uint32_t mesh_binds = 0;
+    uint32_t skipped_draw_calls = 0;    // their pipeline is still compiling
+    uint32_t pending_pipelines = 0;
+    uint32_t secondary_cmd_lists = 0;   // 0 if the batches were recorded inline
+    double record_time_ms = 0.0;
+
+    // last ProcessSwapData(): culling, lod selection and draw list building
+    uint32_t occluded_objects = 0;
+    double visibility_time_ms = 0.0;
+    double light_cluster_time_ms = 0.0;
+};
+
 // 1. high level rendering api
 // 2. a collection of graphics technique implentations and functions 
 // to draw a scene, shadows, post processes and other things.
@@ -22,6 +43,7 @@ public:
     RenderResourceManager& GetRenderResourceManager() { return *m_renderResourceManager; }
     RenderSwapContext& GetSwapContext() { return m_swapContext; }
     Ref<RenderScene> GetRenderScene() { return m_renderScene; }
+    const RenderStats& GetStats() const { return m_stats; }
 
     void ProcessSwapData();
 
@@ -35,9 +57,18 @@ public:
     void DrawSkybox(uint64_t env_map_id, rhi::CommandList* cmd);
     void DrawGrid(rhi::CommandList* cmd);
     void DrawScene(const RenderScene& scene, const Visibility& vis, rhi::CommandList* cmd);
+    // Same draws as DrawScene(), the batches are split in chunks recorded in secondary command lists on the job system.
+    // cmd must be in a render pass begun with RenderPassContents::SECONDARY_COMMAND_LISTS
+    void DrawSceneParallel(const RenderScene& scene, const Visibility& vis, rhi::CommandList* cmd);
     void DrawEntityID(const RenderScene& scene, const Visibility& vis, rhi::CommandList* cmd);
    
 private:
+    // pipelines are resolved per batch on the calling thread, requesting them is not thread safe
+    void RequestBatchPipelines(const DrawList& draw_list, const rhi::RenderPassInfo2& render_pass_info);
+    void DrawBatches(const DrawBatch* batches, rhi::PipeLine* const* pipelines, uint32_t count, rhi::CommandList* cmd, RenderStats& stats);
+    // sums the draw stats of the chunks a draw list was recorded in, secondary_cmd_lists is 0 if it was one inline chunk
+    void StoreDrawStats(const DrawList& draw_list, const RenderStats* chunk_stats, uint32_t chunk_count, uint32_t secondary_cmd_lists, std::chrono::high_resolution_clock::time_point start);
+
     Ref<rhi::Device> m_device;
 
     Scope<RenderResourceManager> m_renderResourceManager;
@@ -46,5 +77,9 @@ private:
 
     Ref<RenderScene> m_renderScene;
 
+    RenderStats m_stats;
+    std::vector<rhi::PipeLine*> m_batchPipelines;
+    std::vector<uint32_t> m_updatedPipelineIndexes;  // of the render objects a proxy batch added or changed
+
 };
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Quark/RHI/Common.h"
 #include "Quark/Render/ShaderLibrary.h"
 #include "Quark/Asset/MaterialAsset.h"
+#include "Quark/Asset/MeshAsset.h"
 #include <glm/glm.hpp>
 
 namespace quark {
@@ -38,6 +39,21 @@ struct PushConstants_Material
     float roughnessFactor = 1.f;
 };
 
+// A material of RenderResourceManager::ssbo_materials, see include/material_data.glsl
+struct StorageBufferData_Material
+{
+    glm::vec4 colorFactors = glm::vec4(1.f);
+    float metallicFactor = 1.f;
+    float roughnessFactor = 1.f;
+    uint32_t baseColorTexture = 0;  // indexes of the device's bindless image array
+    uint32_t metallicRoughnessTexture = 0;
+};
+
+struct PushConstants_BindlessMaterial
+{
+    uint32_t materialIndex = 0;
+};
+
 struct RenderMesh 
 {
     Ref<rhi::Buffer> vertex_position_buffer;
@@ -51,6 +67,8 @@ struct RenderMesh
     uint32_t mesh_attribute_mask;
 
     bool isDynamic = false;
+
+    uint32_t sort_index = 0;    // small and unique, for draw sort keys
 };
 
 struct RenderPBRMaterial 
@@ -66,20 +84,61 @@ struct RenderPBRMaterial
 
     ShaderProgram* shaderProgram;
     AlphaMode alphaMode;
+
+    // small and unique, for draw sort keys
+    uint32_t sort_index = 0;
+
+    // index in RenderResourceManager::ssbo_materials, ~0u if the material binds its textures when drawn
+    uint32_t bindless_index = ~0u;
+};
+
+// Widths of the indexes in the draw sort key
+constexpr uint32_t DRAW_SORT_PIPELINE_INDEX_BITS = 8;
+constexpr uint32_t DRAW_SORT_MATERIAL_INDEX_BITS = 14;
+constexpr uint32_t DRAW_SORT_MESH_INDEX_BITS = 14;
+constexpr uint32_t DRAW_SORT_GEOMETRY_BITS = 10;   // section * MESH_LOD_MAX_NUM + lod
+constexpr uint32_t DRAW_SORT_SECTION_MAX_NUM = (1u << DRAW_SORT_GEOMETRY_BITS) / MESH_LOD_MAX_NUM;
+
+struct RenderObjectLod
+{
+    uint32_t start_index;
+    uint32_t index_count;
+    float screen_size;  // used under this projected size, unused for level 0
 };
 
 struct RenderObject
 {
     uint64_t id;
+    uint64_t entity_id = 0;
     glm::mat4 model_matrix;
 
-    // mesh
+    // mesh, start_index and index_count are the ones of the selected lod
     uint64_t render_mesh_id;
     uint32_t start_index;
     uint32_t index_count;
     math::Aabb aabb;
+    uint32_t bvh_proxy = ~0u;   // leaf in RenderScene::bvh
+
+    // offsets of the other sections of the entity in RenderScene::render_objects, ~0u ends the list
+    uint32_t prev_in_entity = ~0u;
+    uint32_t next_in_entity = ~0u;
 
     // material
     uint64_t render_material_id;
+
+    // small indexes of the pipeline, material and mesh, packed into the draw sort key (see DrawList::GetSortKey())
+    // the pipeline index also picks the pipeline when drawing, see RenderResourceManager::GetPipelineIndex()
+    // the RenderResourceManager never hands out an index wider than its DRAW_SORT_*_BITS field,
+    // and the RenderSystem never adds a section at or past DRAW_SORT_SECTION_MAX_NUM
+    uint16_t pipeline_index = 0;
+    uint16_t material_sort_index = 0;
+    uint16_t mesh_sort_index = 0;
+    uint16_t section_index = 0;
+    bool transparent = false;
+
+    // lod chain, lods[0] is the full resolution mesh
+    RenderObjectLod lods[MESH_LOD_MAX_NUM];
+    uint32_t lod_count = 1;
+    uint32_t lod = 0;
 };
 }
\ No newline at end of file
@@ -95,6 +95,9 @@ ShaderLibrary::ShaderLibrary()
 	program_staticMesh = GetOrCreateGraphicsProgram("BuiltInResources/Shaders/static_mesh.vert",
 		"BuiltInResources/Shaders/static_mesh.frag");
 
+	program_staticMeshBindless = GetOrCreateGraphicsProgram("BuiltInResources/Shaders/static_mesh.vert",
+		"BuiltInResources/Shaders/static_mesh_bindless.frag");
+
 	program_staticMeshEditor = GetOrCreateGraphicsProgram("BuiltInResources/Shaders/editor_scene.vert",
 		"BuiltInResources/Shaders/editor_scene.frag");
 
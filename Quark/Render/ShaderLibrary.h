@@ -87,6 +87,7 @@ class ShaderLibrary
 {
 public:
 	ShaderProgram* program_staticMesh;
+	ShaderProgram* program_staticMeshBindless;	// program_staticMesh with the material indexed, see RenderResourceManager::bindless_materials
 	ShaderProgram* program_staticMeshEditor;
 	ShaderProgram* staticProgram_skybox;
 	ShaderProgram* staticProgram_infiniteGrid;
@@ -9,6 +9,7 @@ void MeshRendererCmpt::SetMesh(const Ref<MeshAsset>& mesh)
 	m_mesh = mesh;
 	m_material_ids.resize(mesh->subMeshes.size());
 	m_graphicsPipeLines.resize(mesh->subMeshes.size());
+	m_dirty = true;
 }
 
 void MeshRendererCmpt::SetMaterial(uint32_t index, AssetID id)
@@ -17,6 +18,7 @@ void MeshRendererCmpt::SetMaterial(uint32_t index, AssetID id)
 	{
 		m_material_ids[index] = id;
 		m_dirtyMaterialMask |= 1 << index;
+		m_dirty = true;
 	}
 	else
 		QK_CORE_LOGW_TAG("Scene", "MeshRendererCmpt::SetMaterial: Index out of range");
@@ -65,6 +67,15 @@ AssetID MeshRendererCmpt::GetMaterialID(uint32_t index)
 //
 //}
 
+void MeshRendererCmpt::SetOccluder(bool occluder)
+{
+	if (m_occluder == occluder)
+		return;
+
+	m_occluder = occluder;
+	m_dirty = true;
+}
+
 void MeshRendererCmpt::SetDirty(bool dirty)
 {
 	m_dirty = dirty;
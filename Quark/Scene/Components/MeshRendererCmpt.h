@@ -17,12 +17,22 @@ public:
 	void SetDirty(bool dirty);
 	bool IsRenderStateDirty() const { return m_dirty; }
 
+	// Only the owner's world matrix changed, the render proxy doesn't need to be rebuilt
+	void SetTransformDirty(bool dirty) { m_transformDirty = dirty; }
+	bool IsTransformDirty() const { return m_transformDirty; }
+
 	AssetID GetMaterialID(uint32_t index);
+
+	// Occluders are rasterized on the CPU to hide what is behind them, meant for large solid meshes like walls
+	void SetOccluder(bool occluder);
+	bool IsOccluder() const { return m_occluder; }
 	
 private:
 	Ref<MeshAsset> m_mesh;
 	
 	bool m_dirty = true;
+	bool m_transformDirty = false;
+	bool m_occluder = false;
 
 	// The count of materials should be equal to the count of submeshes in the mesh
 	std::vector<AssetID>  m_material_ids;
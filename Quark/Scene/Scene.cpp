@@ -36,7 +36,15 @@ void Scene::DeleteEntity(Entity* entity)
     for (auto* c: children)
         DeleteEntity(c);
 
+    // Render objects are removed by the next FillMeshSwapData
+    if (entity->HasComponent<MeshRendererCmpt>())
+        m_DeletedRenderEntities.push_back(entity->GetComponent<IdCmpt>()->id);
+
+    if (entity == m_MainCameraEntity)
+        m_MainCameraEntity = nullptr;
+
     // Delete entity
+    m_EntityIdMap.erase(entity->GetComponent<IdCmpt>()->id);
     m_Registry.DeleteEntity(entity);
 }
 
@@ -95,6 +103,12 @@ Entity* Scene::CreateEntityWithID(UUID id, const std::string& name, Entity* pare
     return newEntity;
 }
 
+void Scene::ReserveEntities(size_t count)
+{
+    m_Registry.Reserve(count);
+    m_EntityIdMap.reserve(count);
+}
+
 Entity* Scene::GetEntityWithID(UUID id)
 {
     auto find = m_EntityIdMap.find(id);
@@ -148,46 +162,77 @@ void Scene::RunTransformUpdateSystem()
         {
             auto* renderCmpt = t->GetEntity()->GetComponent<MeshRendererCmpt>();
             if (renderCmpt)
-                renderCmpt->SetDirty(true);
+                renderCmpt->SetTransformDirty(true);
         }
     }
 }
 
 void Scene::FillMeshSwapData()
 {
-    auto& swapData = RenderSystem::Get().GetSwapContext().GetLogicSwapData();
+    FillMeshSwapData(RenderSystem::Get().GetSwapContext().GetLogicSwapData());
+}
+
+void Scene::FillMeshSwapData(RenderSwapData& swapData)
+{
+    if (!m_DeletedRenderEntities.empty())
+    {
+        swapData.to_delete_entities.insert(swapData.to_delete_entities.end(), m_DeletedRenderEntities.begin(), m_DeletedRenderEntities.end());
+        m_DeletedRenderEntities.clear();
+    }
 
     const auto& cmpts = GetComponents<IdCmpt, MeshCmpt, MeshRendererCmpt, TransformCmpt>();
     for (const auto [id_cmpt, mesh_cmpt, mesh_renderer_cmpt, transform_cmpt] : cmpts)
     {
-        if (!mesh_renderer_cmpt->IsRenderStateDirty())
-            continue;
-        
-        mesh_renderer_cmpt->SetDirty(false);
-
-        auto* mesh = mesh_cmpt->uniqueMesh ? mesh_cmpt->uniqueMesh.get() : mesh_cmpt->sharedMesh.get();
-        if (!mesh) 
-            continue;
-        
-        StaticMeshRenderProxy newRenderProxy;
-        newRenderProxy.entity_id = id_cmpt->id;
-        newRenderProxy.mesh_asset_id = mesh->GetAssetID();
-        newRenderProxy.transform = transform_cmpt->GetWorldMatrix();
-
-        for (uint32_t i = 0; i < mesh->subMeshes.size(); ++i) {
-            const auto& submesh = mesh->subMeshes[i];
-            MeshSectionDesc newSectionDesc;
-            
-            newSectionDesc.aabb = submesh.aabb;
-            newSectionDesc.index_count = submesh.count;
-            newSectionDesc.index_offset = submesh.startIndex;
-            newSectionDesc.material_asset_id = mesh_renderer_cmpt->GetMaterialID(i);
-            newRenderProxy.mesh_sections.push_back(newSectionDesc);
+        if (mesh_renderer_cmpt->IsRenderStateDirty())
+        {
+            mesh_renderer_cmpt->SetDirty(false);
+            mesh_renderer_cmpt->SetTransformDirty(false);
+
+            auto* mesh = mesh_cmpt->uniqueMesh ? mesh_cmpt->uniqueMesh.get() : mesh_cmpt->sharedMesh.get();
+            if (!mesh) 
+                continue;
+
+            const uint32_t sectionCount = (uint32_t)mesh->subMeshes.size();
+            MeshSectionDesc* sections = swapData.arena.allocate_array<MeshSectionDesc>(sectionCount);
+            for (uint32_t i = 0; i < sectionCount; ++i) 
+            {
+                const auto& submesh = mesh->subMeshes[i];
+                MeshSectionDesc& sectionDesc = sections[i];
+                
+                sectionDesc.aabb = submesh.aabb;
+                sectionDesc.index_count = submesh.count;
+                sectionDesc.index_offset = submesh.startIndex;
+                sectionDesc.material_asset_id = mesh_renderer_cmpt->GetMaterialID(i);
+
+                const uint32_t lodCount = (uint32_t)std::min(submesh.lods.size(), mesh->lodScreenSizes.size()) + 1;
+                sectionDesc.lod_count = std::min(lodCount, MESH_LOD_MAX_NUM);
+                for (uint32_t lod = 1; lod < sectionDesc.lod_count; lod++)
+                {
+                    sectionDesc.lods[lod - 1].index_offset = submesh.lods[lod - 1].startIndex;
+                    sectionDesc.lods[lod - 1].index_count = submesh.lods[lod - 1].count;
+                    sectionDesc.lods[lod - 1].screen_size = mesh->lodScreenSizes[lod - 1];
+                }
+            }
+
+            StaticMeshRenderProxy& newRenderProxy = swapData.dirty_static_mesh_render_proxies.emplace_back();
+            newRenderProxy.entity_id = id_cmpt->id;
+            newRenderProxy.mesh_asset_id = mesh->GetAssetID();
+            newRenderProxy.transform = transform_cmpt->GetWorldMatrix();
+            newRenderProxy.mesh_sections = sections;
+            newRenderProxy.mesh_section_count = sectionCount;
+            newRenderProxy.is_occluder = mesh_renderer_cmpt->IsOccluder();
+
+            // The transform stream is applied after the proxies. If the render side skipped a frame, an older
+            // transform of this entity may still be queued in it, so queue the latest one too
+            if (!swapData.dirty_transforms.empty())
+                swapData.dirty_transforms.push_back({ id_cmpt->id, newRenderProxy.transform });
+        }
+        else if (mesh_renderer_cmpt->IsTransformDirty())
+        {
+            mesh_renderer_cmpt->SetTransformDirty(false);
+            swapData.dirty_transforms.push_back({ id_cmpt->id, transform_cmpt->GetWorldMatrix() });
         }
-
-        swapData.dirty_static_mesh_render_proxies.push_back(newRenderProxy);
     }
-
 }
 
 void Scene::FillCameraSwapData()
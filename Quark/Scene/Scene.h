@@ -10,6 +10,7 @@ namespace quark {
 
 struct CameraCmpt;
 struct Texture;
+struct RenderSwapData;
 
 class Scene {
 public:
@@ -26,6 +27,7 @@ public:
 
     // fill swap Data
     void FillMeshSwapData();
+    void FillMeshSwapData(RenderSwapData& swapData);
     void FillCameraSwapData();
     
     // entity
@@ -34,6 +36,7 @@ public:
     Entity* GetEntityWithID(UUID id);
 
     void DeleteEntity(Entity* entity);
+    void ReserveEntities(size_t count);
 
     std::vector<Entity*>& GetEntities() { return m_Registry.GetEntities(); }
 
@@ -68,6 +71,7 @@ private:
     EntityRegistry m_Registry;
     Entity* m_MainCameraEntity;
     std::unordered_map<uint64_t, Entity*> m_EntityIdMap;
+    std::vector<uint64_t> m_DeletedRenderEntities;
 
     friend class GLTFLoader;
     friend class MeshLoader;
@@ -0,0 +1,107 @@
+#include "Quark/qkpch.h"
+#include "Quark/Scene/SceneBinaryFormat.h"
+#include "Quark/Core/Util/EnumCast.h"
+
+namespace quark {
+
+template<typename T>
+static bool GetBinarySceneColumn(const byte* data, const BinarySceneSection* section, BinarySceneFile::Column<T>& outColumn)
+{
+    outColumn = {};
+    if (!section || section->elementCount == 0)
+        return true;
+
+    if (section->elementSize != sizeof(T))
+        return false;
+
+    outColumn.data = reinterpret_cast<const T*>(data + section->offset);
+    outColumn.count = section->elementCount;
+    return true;
+}
+
+bool BinarySceneFile::Open(const std::filesystem::path& filepath)
+{
+    if (!m_file.Open(filepath))
+    {
+        QK_CORE_LOGE_TAG("Scene", "Failed to load .qkbscene file : {}", filepath.string());
+        return false;
+    }
+
+    const byte* data = m_file.GetData();
+    const size_t size = m_file.GetSize();
+
+    // Validate header and section table before touching anything else
+    const auto* header = reinterpret_cast<const BinarySceneHeader*>(data);
+    if (size < sizeof(BinarySceneHeader) || header->magic != BINARY_SCENE_MAGIC)
+    {
+        QK_CORE_LOGE_TAG("Scene", "{} is not a binary scene file", filepath.string());
+        return false;
+    }
+
+    if (header->version != BINARY_SCENE_VERSION)
+    {
+        QK_CORE_LOGE_TAG("Scene", "Binary scene {} has version {}, expected {}. Re-export it from the .qkscene file", 
+            filepath.string(), header->version, BINARY_SCENE_VERSION);
+        return false;
+    }
+
+    if (size < sizeof(BinarySceneHeader) + header->sectionCount * sizeof(BinarySceneSection))
+    {
+        QK_CORE_LOGE_TAG("Scene", "Binary scene {} is truncated", filepath.string());
+        return false;
+    }
+
+    const BinarySceneSection* sections[util::ecast(BinarySceneSectionType::MAX_ENUM)] = {};
+    const auto* sectionTable = reinterpret_cast<const BinarySceneSection*>(data + sizeof(BinarySceneHeader));
+    for (uint32_t i = 0; i < header->sectionCount; i++)
+    {
+        const BinarySceneSection& section = sectionTable[i];
+        if (section.offset % BINARY_SCENE_SECTION_ALIGNMENT != 0 || section.offset > size || 
+            section.elementSize == 0 || section.elementCount > (size - section.offset) / section.elementSize)
+        {
+            QK_CORE_LOGE_TAG("Scene", "Binary scene {} has a corrupted section table", filepath.string());
+            return false;
+        }
+
+        // Skip section types this build doesn't know about
+        if (util::ecast(section.type) < util::ecast(BinarySceneSectionType::MAX_ENUM))
+            sections[util::ecast(section.type)] = &section;
+    }
+
+    auto section = [&](BinarySceneSectionType type) { return sections[util::ecast(type)]; };
+
+    Column<char> sceneNameChars;
+    bool valid = GetBinarySceneColumn(data, section(BinarySceneSectionType::SCENE_NAME), sceneNameChars);
+    valid &= GetBinarySceneColumn(data, section(BinarySceneSectionType::ENTITY_IDS), ids);
+    valid &= GetBinarySceneColumn(data, section(BinarySceneSectionType::TRANSFORMS), transforms);
+    valid &= GetBinarySceneColumn(data, section(BinarySceneSectionType::CHILD_COUNTS), childCounts);
+    valid &= GetBinarySceneColumn(data, section(BinarySceneSectionType::CHILD_INDEXES), childIndexes);
+    valid &= GetBinarySceneColumn(data, section(BinarySceneSectionType::NAMES), names);
+    valid &= GetBinarySceneColumn(data, section(BinarySceneSectionType::NAME_CHARS), nameChars);
+    valid &= GetBinarySceneColumn(data, section(BinarySceneSectionType::CAMERAS), cameras);
+    valid &= GetBinarySceneColumn(data, section(BinarySceneSectionType::MESHES), meshes);
+    valid &= GetBinarySceneColumn(data, section(BinarySceneSectionType::MESH_RENDERERS), meshRenderers);
+    valid &= GetBinarySceneColumn(data, section(BinarySceneSectionType::MATERIAL_IDS), materialIds);
+    valid &= GetBinarySceneColumn(data, section(BinarySceneSectionType::OCCLUDERS), occluders);
+
+    entityCount = header->entityCount;
+    if (!valid || ids.count != entityCount || transforms.count != entityCount || childCounts.count != entityCount)
+    {
+        QK_CORE_LOGE_TAG("Scene", "Binary scene {} has missing or mismatching sections", filepath.string());
+        return false;
+    }
+
+    sceneName = std::string_view(sceneNameChars.data, sceneNameChars.count);
+    return true;
+}
+
+void BinarySceneFile::Prefetch() const
+{
+    constexpr size_t pageSize = 4096;
+
+    volatile byte sink = 0;
+    for (size_t offset = 0; offset < m_file.GetSize(); offset += pageSize)
+        sink = sink + m_file.GetData()[offset];
+}
+
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include <string_view>
+#include <filesystem>
+#include <glm/glm.hpp>
+
+#include "Quark/Core/MappedFile.h"
+
+namespace quark {
+
+// Binary scene layout (.qkbscene)
+//
+//   [BinarySceneHeader][BinarySceneSection * sectionCount][section data...]
+//
+// Every section is a tightly packed array of one of the POD records below, starting at a 16 byte aligned
+// file offset, so a memory mapped file is read in place, one component type at a time.
+// Per entity sections are indexed by the entity's position in ENTITY_IDS, sparse component sections
+// store that index in their records. All values are little endian.
+constexpr uint32_t BINARY_SCENE_MAGIC = 0x53424B51; // "QKBS"
+constexpr uint32_t BINARY_SCENE_VERSION = 2;
+constexpr uint32_t BINARY_SCENE_SECTION_ALIGNMENT = 16;
+constexpr uint32_t BINARY_SCENE_INVALID_INDEX = ~0u;
+
+enum class BinarySceneSectionType : uint32_t
+{
+    SCENE_NAME = 0,     // char
+    ENTITY_IDS,         // uint64_t, one per entity
+    TRANSFORMS,         // BinaryTransformRecord, one per entity
+    CHILD_COUNTS,       // uint32_t, one per entity
+    CHILD_INDEXES,      // uint32_t, children of all entities concatenated in entity order
+    NAMES,              // BinaryNameRecord
+    NAME_CHARS,         // char, referenced by NAMES
+    CAMERAS,            // BinaryCameraRecord
+    MESHES,             // BinaryMeshRecord
+    MESH_RENDERERS,     // BinaryMeshRendererRecord
+    MATERIAL_IDS,       // uint64_t, referenced by MESH_RENDERERS
+    OCCLUDERS,          // uint32_t, entity index of every mesh renderer that is an occluder
+    MAX_ENUM
+};
+
+struct BinarySceneHeader
+{
+    uint32_t magic = BINARY_SCENE_MAGIC;
+    uint32_t version = BINARY_SCENE_VERSION;
+    uint32_t entityCount = 0;
+    uint32_t sectionCount = 0;
+};
+
+struct BinarySceneSection
+{
+    BinarySceneSectionType type;
+    uint32_t elementSize;   // lets the reader reject sections whose record layout changed
+    uint64_t elementCount;
+    uint64_t offset;        // from the beginning of the file
+};
+
+struct BinaryTransformRecord
+{
+    glm::vec3 position;
+    glm::vec4 rotation;     // quaternion stored as xyzw, independent of glm's quat layout
+    glm::vec3 scale;
+};
+
+struct BinaryNameRecord
+{
+    uint32_t entityIndex;
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct BinaryCameraRecord
+{
+    uint32_t entityIndex;
+    float fov;
+    float aspect;
+    float zNear;
+    float zFar;
+};
+
+struct BinaryMeshRecord
+{
+    uint32_t entityIndex;
+    uint32_t padding;
+    uint64_t meshAssetId;
+    uint64_t uniqueMeshAssetId; // 0 if the entity has no unique mesh
+};
+
+struct BinaryMeshRendererRecord
+{
+    uint32_t entityIndex;
+    uint32_t materialOffset;
+    uint32_t materialCount;
+};
+
+static_assert(sizeof(BinarySceneHeader) == 16);
+static_assert(sizeof(BinarySceneSection) == 24);
+static_assert(sizeof(BinaryTransformRecord) == 40);
+static_assert(sizeof(BinaryMeshRecord) == 24);
+static_assert(std::is_trivially_copyable_v<BinaryTransformRecord>);
+
+// A mapped and validated .qkbscene file, the columns point straight into the mapping.
+// Opening doesn't touch the ECS, so it is safe on any thread.
+class BinarySceneFile
+{
+public:
+    template<typename T>
+    struct Column
+    {
+        const T* data = nullptr;
+        size_t count = 0;
+
+        const T& operator[](size_t i) const { return data[i]; }
+    };
+
+    bool Open(const std::filesystem::path& filepath);
+
+    // Touches every page so the instantiating thread doesn't stall on page faults
+    void Prefetch() const;
+
+    size_t GetFileSize() const { return m_file.GetSize(); }
+
+    uint32_t entityCount = 0;
+    std::string_view sceneName;
+    Column<uint64_t> ids;
+    Column<BinaryTransformRecord> transforms;
+    Column<uint32_t> childCounts;
+    Column<uint32_t> childIndexes;
+    Column<BinaryNameRecord> names;
+    Column<char> nameChars;
+    Column<BinaryCameraRecord> cameras;
+    Column<BinaryMeshRecord> meshes;
+    Column<BinaryMeshRendererRecord> meshRenderers;
+    Column<uint64_t> materialIds;
+    Column<uint32_t> occluders;
+
+private:
+    MappedFile m_file;
+};
+
+}
@@ -0,0 +1,245 @@
+#include "Quark/qkpch.h"
+#include "Quark/Scene/SceneJournal.h"
+#include "Quark/Core/Util/Hash.h"
+#include "Quark/Scene/Scene.h"
+#include "Quark/Scene/Components/CommonCmpts.h"
+#include "Quark/Scene/Components/TransformCmpt.h"
+#include "Quark/Scene/Components/CameraCmpt.h"
+#include "Quark/Scene/Components/RelationshipCmpt.h"
+#include "Quark/Scene/Components/MeshCmpt.h"
+#include "Quark/Scene/Components/MeshRendererCmpt.h"
+
+namespace quark {
+
+SceneJournal::SceneJournal(const Ref<Scene>& scene, JobSystem& jobSystem, const SceneJournalSpecification& specs)
+    : m_scene(scene), m_jobSystem(jobSystem), m_specs(specs)
+{
+}
+
+SceneJournal::~SceneJournal()
+{
+    WaitForCompaction();
+}
+
+void SceneJournal::WaitForCompaction()
+{
+    m_jobSystem.Wait(&m_jobCounter, 1);
+}
+
+void SceneJournal::Begin(const std::filesystem::path& filepath)
+{
+    // The compaction may still be working on the previous file
+    WaitForCompaction();
+
+    m_filepath = filepath;
+    m_snapshots.clear();
+    m_snapshots.reserve(m_scene->GetEntities().size());
+    m_saveIndex = 0;
+
+    for (auto* entity : m_scene->GetAllEntitiesWith<IdCmpt, RelationshipCmpt>())
+        HashComponents(entity, m_snapshots[entity->GetComponent<IdCmpt>()->id].hashes);
+
+    std::error_code ec;
+    m_stats = {};
+    m_stats.journalSize = std::filesystem::exists(SceneSerializer::GetJournalPath(filepath), ec) ? std::filesystem::file_size(SceneSerializer::GetJournalPath(filepath), ec) : 0;
+}
+
+void SceneJournal::HashComponents(Entity* entity, ComponentHashes& outHashes)
+{
+    // Bits of SceneComponentFlagBit, in order. Present components never hash to 0
+    outHashes = {};
+
+    {
+        auto* relationshipCmpt = entity->GetComponent<RelationshipCmpt>();
+        util::Hasher h;
+        h.u64(relationshipCmpt->GetParentEntity() ? relationshipCmpt->GetParentEntity()->GetComponent<IdCmpt>()->id : UUID(0));
+        for (auto* child : relationshipCmpt->GetChildEntities())
+            h.u64(child->GetComponent<IdCmpt>()->id);
+        outHashes[0] = h.get() | 1;
+    }
+
+    if (auto* nameCmpt = entity->GetComponent<NameCmpt>())
+    {
+        util::Hasher h;
+        h.string(nameCmpt->name);
+        outHashes[1] = h.get() | 1;
+    }
+
+    if (auto* transformCmpt = entity->GetComponent<TransformCmpt>())
+    {
+        glm::vec3 position = transformCmpt->GetLocalPosition();
+        glm::quat rotation = transformCmpt->GetLocalRotate();
+        glm::vec3 scale = transformCmpt->GetLocalScale();
+
+        util::Hasher h;
+        h.f32(position.x);
+        h.f32(position.y);
+        h.f32(position.z);
+        h.f32(rotation.x);
+        h.f32(rotation.y);
+        h.f32(rotation.z);
+        h.f32(rotation.w);
+        h.f32(scale.x);
+        h.f32(scale.y);
+        h.f32(scale.z);
+        outHashes[2] = h.get() | 1;
+    }
+
+    if (auto* cameraCmpt = entity->GetComponent<CameraCmpt>())
+    {
+        util::Hasher h;
+        h.f32(cameraCmpt->fov);
+        h.f32(cameraCmpt->zNear);
+        h.f32(cameraCmpt->zFar);
+        h.f32(cameraCmpt->aspect);
+        outHashes[3] = h.get() | 1;
+    }
+
+    auto* meshCmpt = entity->GetComponent<MeshCmpt>();
+    if (meshCmpt)
+    {
+        util::Hasher h;
+        h.u64(meshCmpt->sharedMesh ? meshCmpt->sharedMesh->GetAssetID() : AssetID(0));
+        h.u64(meshCmpt->uniqueMesh ? meshCmpt->uniqueMesh->GetAssetID() : AssetID(0));
+        outHashes[4] = h.get() | 1;
+    }
+
+    if (auto* meshRendererCmpt = entity->GetComponent<MeshRendererCmpt>())
+    {
+        Ref<MeshAsset> mesh = meshCmpt ? (meshCmpt->uniqueMesh ? meshCmpt->uniqueMesh : meshCmpt->sharedMesh) : nullptr;
+        uint32_t sectionCount = mesh ? (uint32_t)mesh->subMeshes.size() : 0;
+
+        util::Hasher h;
+        h.u32(sectionCount);
+        for (uint32_t i = 0; i < sectionCount; i++)
+            h.u64(meshRendererCmpt->GetMaterialID(i));
+        h.u32(meshRendererCmpt->IsOccluder() ? 1 : 0);
+        outHashes[5] = h.get() | 1;
+    }
+}
+
+bool SceneJournal::Save()
+{
+    QK_CORE_ASSERT(!m_filepath.empty())
+
+    m_saveIndex++;
+    m_changes.clear();
+    m_pendingHashes.clear();
+    m_deletedEntities.clear();
+
+    ComponentHashes hashes;
+    uint32_t hashedEntities = 0;
+    for (auto* entity : m_scene->GetAllEntitiesWith<IdCmpt, RelationshipCmpt>())
+    {
+        HashComponents(entity, hashes);
+        hashedEntities++;
+
+        // New entities start with an empty snapshot, so all of their components are written
+        EntitySnapshot& snapshot = m_snapshots[entity->GetComponent<IdCmpt>()->id];
+        snapshot.saveIndex = m_saveIndex;
+
+        SceneComponentFlags changed = 0;
+        SceneComponentFlags removed = 0;
+        for (uint32_t i = 0; i < s_ComponentCount; i++)
+        {
+            if (hashes[i] == snapshot.hashes[i])
+                continue;
+
+            if (hashes[i])
+                changed |= 1u << i;
+            else
+                removed |= 1u << i;
+        }
+
+        if (changed || removed)
+        {
+            m_changes.push_back({ entity, changed, removed });
+            m_pendingHashes.push_back({ &snapshot, hashes });
+        }
+    }
+
+    // Entities that weren't visited are gone
+    if (m_snapshots.size() != hashedEntities)
+    {
+        for (const auto& [id, snapshot] : m_snapshots)
+        {
+            if (snapshot.saveIndex != m_saveIndex)
+                m_deletedEntities.push_back(id);
+        }
+    }
+
+    m_stats.changedEntities = (uint32_t)m_changes.size();
+    m_stats.deletedEntities = (uint32_t)m_deletedEntities.size();
+    if (m_changes.empty() && m_deletedEntities.empty())
+        return true;
+
+    {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+
+        SceneSerializer serializer(m_scene);
+        if (!serializer.AppendJournal(m_filepath, m_changes, m_deletedEntities))
+        {
+            // Keep the snapshot, so the next save writes these changes again
+            QK_CORE_LOGE_TAG("Scene", "Failed to append to scene journal: {}", SceneSerializer::GetJournalPath(m_filepath).string());
+            return false;
+        }
+
+        std::error_code ec;
+        m_stats.journalSize = std::filesystem::file_size(SceneSerializer::GetJournalPath(m_filepath), ec);
+    }
+
+    for (auto& [snapshot, newHashes] : m_pendingHashes)
+        snapshot->hashes = newHashes;
+
+    for (uint64_t id : m_deletedEntities)
+        m_snapshots.erase(id);
+
+    if (m_stats.journalSize > m_specs.compactionSize && !IsCompacting())
+        StartCompaction();
+
+    return true;
+}
+
+void SceneJournal::StartCompaction()
+{
+    m_compacting.store(true, std::memory_order_relaxed);
+    m_stats.compactions++;
+
+    const size_t journalSize = m_stats.journalSize;
+    m_jobSystem.Execute([this, filepath = m_filepath, journalSize]()
+    {
+        const std::filesystem::path journalPath = SceneSerializer::GetJournalPath(filepath);
+        const std::filesystem::path compactedPath = filepath.string() + ".compacted";
+
+        // Saves keep appending while the scene file is merged
+        if (SceneSerializer::CompactJournal(filepath, journalSize, compactedPath))
+        {
+            std::lock_guard<std::mutex> lock(m_fileMutex);
+
+            std::string remaining;
+            {
+                std::ifstream fin(journalPath, std::ios::binary);
+                fin.seekg(journalSize);
+                remaining.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+            }
+
+            // Replaying deltas that are already merged is harmless, so a crash between the two renames loses nothing
+            std::error_code ec;
+            std::filesystem::rename(compactedPath, filepath, ec);
+            if (!ec)
+            {
+                const std::filesystem::path remainingPath = journalPath.string() + ".tmp";
+                {
+                    std::ofstream fout(remainingPath, std::ios::binary);
+                    fout << remaining;
+                }
+                std::filesystem::rename(remainingPath, journalPath, ec);
+                QK_CORE_LOGI_TAG("Scene", "Compacted scene journal of {}", filepath.string());
+            }
+        }
+
+        m_compacting.store(false, std::memory_order_release);
+    }, &m_jobCounter);
+}
+
+}
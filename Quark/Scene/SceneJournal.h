@@ -0,0 +1,81 @@
+#pragma once
+#include "Quark/Core/JobSystem.h"
+#include "Quark/Scene/SceneSerializer.h"
+
+#include <array>
+#include <mutex>
+#include <filesystem>
+
+namespace quark {
+
+class Scene;
+
+struct SceneJournalSpecification
+{
+    size_t compactionSize = 4ull << 20;     // the journal is merged into the scene file in the background once it grows past this
+};
+
+struct SceneJournalStats
+{
+    // last Save() only
+    uint32_t changedEntities = 0;
+    uint32_t deletedEntities = 0;
+
+    size_t journalSize = 0;
+    uint32_t compactions = 0;
+};
+
+// Incremental saves of a YAML scene file.
+// Save() finds the entities and components that changed since the last save by comparing per component hashes
+// against a snapshot, and appends only those to the scene's journal. Once the journal is big enough it is merged
+// into the scene file on the JobSystem, which only works on the files and never touches the scene.
+class SceneJournal
+{
+public:
+    SceneJournal(const Ref<Scene>& scene, JobSystem& jobSystem, const SceneJournalSpecification& specs = {});
+    ~SceneJournal();
+
+    // Takes the current state of the scene as what is saved in filepath, call after loading or fully saving the scene
+    void Begin(const std::filesystem::path& filepath);
+
+    bool Save();
+
+    bool IsCompacting() const { return m_compacting.load(std::memory_order_acquire); }
+    void WaitForCompaction();
+
+    const std::filesystem::path& GetFilePath() const { return m_filepath; }
+    const SceneJournalStats& GetStats() const { return m_stats; }
+
+private:
+    static constexpr uint32_t s_ComponentCount = 6;
+    using ComponentHashes = std::array<uint64_t, s_ComponentCount>; // 0 when the entity doesn't have the component
+
+    struct EntitySnapshot
+    {
+        ComponentHashes hashes = {};
+        uint32_t saveIndex = 0;
+    };
+
+    static void HashComponents(Entity* entity, ComponentHashes& outHashes);
+    void StartCompaction();
+
+    Ref<Scene> m_scene;
+    JobSystem& m_jobSystem;
+    SceneJournalSpecification m_specs;
+
+    std::filesystem::path m_filepath;
+    std::unordered_map<uint64_t, EntitySnapshot> m_snapshots;
+    uint32_t m_saveIndex = 0;
+
+    // Reused by every save
+    std::vector<SceneEntityDelta> m_changes;
+    std::vector<std::pair<EntitySnapshot*, ComponentHashes>> m_pendingHashes;
+    std::vector<uint64_t> m_deletedEntities;
+
+    std::mutex m_fileMutex;     // appends and the end of a compaction
+    std::atomic<bool> m_compacting = false;
+    JobSystem::Counter m_jobCounter{};
+    SceneJournalStats m_stats;
+};
+
+}
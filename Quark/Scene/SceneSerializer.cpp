@@ -4,6 +4,7 @@
 #include "Quark/Core/Util/SerializationUtils.h"
 #include "Quark/Asset/AssetManager.h"
 #include "Quark/Scene/Scene.h"
+#include "Quark/Scene/SceneBinaryFormat.h"
 #include "Quark/Scene/Components/CommonCmpts.h"
 #include "Quark/Scene/Components/TransformCmpt.h"
 #include "Quark/Scene/Components/CameraCmpt.h"
@@ -13,12 +14,26 @@
 
 namespace quark {
 	
-static void SerializeEntity(YAML::Emitter& out, Entity* entity)
+// YAML keys of the components, the relationship is written as Parent and Children
+static const char* GetComponentKey(SceneComponentFlagBit bit)
+{
+	switch (bit)
+	{
+	case SCENE_COMPONENT_NAME_BIT: return "NameComponent";
+	case SCENE_COMPONENT_TRANSFORM_BIT: return "TransformComponent";
+	case SCENE_COMPONENT_CAMERA_BIT: return "CameraComponent";
+	case SCENE_COMPONENT_MESH_BIT: return "MeshComponent";
+	case SCENE_COMPONENT_MESH_RENDERER_BIT: return "MeshRendererComponent";
+	default: return nullptr;
+	}
+}
+
+static void SerializeEntity(YAML::Emitter& out, Entity* entity, SceneComponentFlags components = SCENE_COMPONENT_ALL_BITS, SceneComponentFlags removedComponents = 0)
 {
 	out << YAML::BeginMap; // Entity
 	out << YAML::Key << "Entity" << YAML::Value << entity->GetComponent<IdCmpt>()->id;
 
-	if (entity->HasComponent<RelationshipCmpt>()) 
+	if ((components & SCENE_COMPONENT_RELATIONSHIP_BIT) && entity->HasComponent<RelationshipCmpt>()) 
 	{
 		auto* relationshipCmpt = entity->GetComponent<RelationshipCmpt>();
 		out << YAML::Key << "Parent";
@@ -41,13 +56,13 @@ static void SerializeEntity(YAML::Emitter& out, Entity* entity)
 		out << YAML::EndSeq;
 	}
 
-	if (entity->HasComponent<NameCmpt>()) 
+	if ((components & SCENE_COMPONENT_NAME_BIT) && entity->HasComponent<NameCmpt>()) 
 	{
 		out << YAML::Key << "NameComponent";
 		out << YAML::Value << entity->GetComponent<NameCmpt>()->name;
 	}
 
-	if (entity->HasComponent<TransformCmpt>())
+	if ((components & SCENE_COMPONENT_TRANSFORM_BIT) && entity->HasComponent<TransformCmpt>())
 	{
 		out << YAML::Key << "TransformComponent";
 		out << YAML::BeginMap; // TransformComponent
@@ -60,7 +75,7 @@ static void SerializeEntity(YAML::Emitter& out, Entity* entity)
 		out << YAML::EndMap; // TransformComponent
 	}
 
-	if (entity->HasComponent<CameraCmpt>())
+	if ((components & SCENE_COMPONENT_CAMERA_BIT) && entity->HasComponent<CameraCmpt>())
 	{
 		out << YAML::Key << "CameraComponent";
 		out << YAML::BeginMap; // CameraComponent
@@ -74,17 +89,19 @@ static void SerializeEntity(YAML::Emitter& out, Entity* entity)
 		out << YAML::EndMap; // CameraComponent
 	}
 
-	if (entity->HasComponent<MeshCmpt>())
+	if ((components & SCENE_COMPONENT_MESH_BIT) && entity->HasComponent<MeshCmpt>())
 	{
 		auto* meshCmpt = entity->GetComponent<MeshCmpt>();
 		out << YAML::Key << "MeshComponent";
 
 		out << YAML::BeginMap; 
 		out << YAML::Key << "AssetID" << YAML::Value << meshCmpt->sharedMesh->GetAssetID();
+		if (meshCmpt->uniqueMesh)
+			out << YAML::Key << "UniqueAssetID" << YAML::Value << meshCmpt->uniqueMesh->GetAssetID();
 		out << YAML::EndMap;
 	}
 		
-	if (entity->HasComponent<MeshRendererCmpt>())
+	if ((components & SCENE_COMPONENT_MESH_RENDERER_BIT) && entity->HasComponent<MeshRendererCmpt>())
 	{
 		auto* meshRendererCmpt = entity->GetComponent<MeshRendererCmpt>();
 		auto* meshCmpt = entity->GetComponent<MeshCmpt>();
@@ -105,11 +122,98 @@ static void SerializeEntity(YAML::Emitter& out, Entity* entity)
 		}
 
 		out << YAML::EndSeq;
+
+		QK_SERIALIZE_PROPERTY(Occluder, meshRendererCmpt->IsOccluder(), out);
 		out << YAML::EndMap; // MeshRendererComponent
 	}
+
+	// Only in journal deltas
+	if (removedComponents)
+	{
+		out << YAML::Key << "Removed" << YAML::Value << YAML::Flow << YAML::BeginSeq;
+		for (uint32_t bit = 1; bit <= removedComponents; bit <<= 1)
+		{
+			if (const char* key = (removedComponents & bit) ? GetComponentKey((SceneComponentFlagBit)bit) : nullptr)
+				out << key;
+		}
+		out << YAML::EndSeq;
+	}
+
 	out << YAML::EndMap; // Entity
 }
 
+// Adds the components of an entity node to the entity, components that already exist are overwritten
+static void DeserializeComponents(Entity* entity, const YAML::Node& node)
+{
+	auto nameComponent = node["NameComponent"];
+	if (nameComponent)
+	{
+		auto* nc = entity->GetComponent<NameCmpt>();
+		if (nc)
+			nc->name = nameComponent.as<std::string>();
+		else
+			entity->AddComponent<NameCmpt>(nameComponent.as<std::string>());
+	}
+
+	auto transformCmpt = node["TransformComponent"];
+	if (transformCmpt)
+	{
+		// Entity always has transform component
+		auto* tc = entity->GetComponent<TransformCmpt>();
+		tc->SetLocalPosition(transformCmpt["Position"].as<glm::vec3>());
+		tc->SetLocalRotate(glm::quat(glm::radians(transformCmpt["Rotation"].as<glm::vec3>())));
+		tc->SetLocalScale(transformCmpt["Scale"].as<glm::vec3>());
+	}
+
+	auto cameraCmpt = node["CameraComponent"];
+	if (cameraCmpt)
+	{
+		auto* cc = entity->HasComponent<CameraCmpt>() ? entity->GetComponent<CameraCmpt>() : entity->AddComponent<CameraCmpt>();
+		cc->fov = cameraCmpt["Fov"].as<float>();
+		cc->zNear = cameraCmpt["Near"].as<float>();
+		cc->zFar = cameraCmpt["Far"].as<float>();
+		cc->aspect = cameraCmpt["Aspect"].as<float>();
+	}
+
+	auto meshCmpt = node["MeshComponent"];
+	if (meshCmpt)
+	{
+		auto* mc = entity->HasComponent<MeshCmpt>() ? entity->GetComponent<MeshCmpt>() : entity->AddComponent<MeshCmpt>();
+		uint64_t assetId = meshCmpt["AssetID"].as<uint64_t>();
+		auto mesh = AssetManager::Get().GetAsset<MeshAsset>(assetId);
+		
+		mc->sharedMesh = mesh;
+		mc->uniqueMesh = nullptr;
+		if (auto uniqueAssetId = meshCmpt["UniqueAssetID"])
+			mc->uniqueMesh = AssetManager::Get().GetAsset<MeshAsset>(uniqueAssetId.as<uint64_t>());
+	}
+
+	auto meshRendererCmpt = node["MeshRendererComponent"];
+	if (meshRendererCmpt)
+	{
+		auto* mrc = entity->HasComponent<MeshRendererCmpt>() ? entity->GetComponent<MeshRendererCmpt>() : entity->AddComponent<MeshRendererCmpt>();
+		auto* mc = entity->GetComponent<MeshCmpt>();
+		QK_CORE_ASSERT(mc)
+
+		Ref<MeshAsset> mesh = mc->uniqueMesh ? mc->uniqueMesh : mc->sharedMesh;
+		mrc->SetMesh(mesh);
+
+		auto materials = meshRendererCmpt["Materials"];
+		uint32_t i = 0;
+		for (auto mat : materials)
+		{
+			AssetID assetId = mat["AssetID"].as<AssetID>();
+			mrc->SetMaterial(i, assetId);
+			i++;
+		}
+		QK_CORE_ASSERT(i == mesh->subMeshes.size())
+
+		bool occluder = false;
+		QK_DESERIALIZE_PROPERTY(Occluder, occluder, meshRendererCmpt, false)
+		mrc->SetOccluder(occluder);
+	}
+}
+
 SceneSerializer::SceneSerializer(Ref<Scene>& scene)
 	: m_Scene(scene)
 {
@@ -133,18 +237,14 @@ void SceneSerializer::Serialize(const std::filesystem::path& filepath)
 	std::ofstream fout(filepath);
 	fout << out.c_str();
 
-
+	// A full save supersedes the deltas of incremental saves
+	std::filesystem::remove(GetJournalPath(filepath));
 }
 
-void SceneSerializer::SerializeBinary(AssetID scene)
-{
-	// Not implemented
-	QK_CORE_VERIFY(false);
-}
 
 bool SceneSerializer::Deserialize(const std::filesystem::path& filepath)
 {
-	YAML::Node data = YAML::LoadFile(filepath.string());
+	YAML::Node data;
 
 	try 
 	{
@@ -180,58 +280,7 @@ bool SceneSerializer::Deserialize(const std::filesystem::path& filepath)
 			QK_CORE_LOGT_TAG("Scene", "Deserializing entity with ID: {0} and name: {1}", uuid, name);
 
 			Entity* deserializedEntity = m_Scene->CreateEntityWithID(uuid, name);
-
-			auto transformCmpt = entity["TransformComponent"];
-			if (transformCmpt)
-			{
-				// Entity always has transform component
-				auto* tc = deserializedEntity->GetComponent<TransformCmpt>();
-				tc->SetLocalPosition(transformCmpt["Position"].as<glm::vec3>());
-				tc->SetLocalRotate(glm::quat(glm::radians(transformCmpt["Rotation"].as<glm::vec3>())));
-				tc->SetLocalScale(transformCmpt["Scale"].as<glm::vec3>());
-			}
-
-			auto cameraCmpt = entity["CameraComponent"];
-			if (cameraCmpt)
-			{
-				auto* cc = deserializedEntity->AddComponent<CameraCmpt>();
-				cc->fov = cameraCmpt["Fov"].as<float>();
-				cc->zNear = cameraCmpt["Near"].as<float>();
-				cc->zFar = cameraCmpt["Far"].as<float>();
-				cc->aspect = cameraCmpt["Aspect"].as<float>();
-			}
-
-			auto meshCmpt = entity["MeshComponent"];
-			if (meshCmpt)
-			{
-				auto* mc = deserializedEntity->AddComponent<MeshCmpt>();
-				uint64_t assetId = meshCmpt["AssetID"].as<uint64_t>();
-				auto mesh = AssetManager::Get().GetAsset<MeshAsset>(assetId);
-				
-				mc->sharedMesh = mesh;
-				mc->uniqueMesh = nullptr;
-			}
-
-			auto meshRendererCmpt = entity["MeshRendererComponent"];
-			if (meshRendererCmpt)
-			{
-				auto* mrc = deserializedEntity->AddComponent<MeshRendererCmpt>();
-				auto* mc = deserializedEntity->GetComponent<MeshCmpt>();
-				QK_CORE_ASSERT(mc)
-
-				Ref<MeshAsset> mesh = mc->uniqueMesh ? mc->uniqueMesh : mc->sharedMesh;
-				mrc->SetMesh(mesh);
-
-				auto materials = meshRendererCmpt["Materials"];
-				uint32_t i = 0;
-				for (auto mat : materials)
-				{
-					AssetID assetId = mat["AssetID"].as<AssetID>();
-					mrc->SetMaterial(i, assetId);
-					i++;
-				}
-				QK_CORE_ASSERT(i == mesh->subMeshes.size())
-			}
+			DeserializeComponents(deserializedEntity, entity);
 		}
 
 		// Loop agein to establish parent-child relationship
@@ -253,15 +302,602 @@ bool SceneSerializer::Deserialize(const std::filesystem::path& filepath)
 		}
 	}
 
+	// Incremental saves since the last full save
+	if (std::filesystem::exists(GetJournalPath(filepath)))
+		return ReplayJournal(filepath);
+
+	return true;
+}
+
+
+struct BinarySectionData
+{
+	BinarySceneSectionType type;
+	uint32_t elementSize;
+	uint64_t elementCount;
+	const void* data;
+};
+
+template<typename T>
+static BinarySectionData MakeBinarySection(BinarySceneSectionType type, const std::vector<T>& column)
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	return { type, (uint32_t)sizeof(T), column.size(), column.data() };
+}
+
+static uint64_t AlignBinarySectionOffset(uint64_t offset)
+{
+	return (offset + BINARY_SCENE_SECTION_ALIGNMENT - 1) & ~uint64_t(BINARY_SCENE_SECTION_ALIGNMENT - 1);
+}
+
+static bool IsBinarySceneFile(const std::filesystem::path& filepath)
+{
+	return filepath.extension() == SceneSerializer::s_BinaryExtension;
+}
+
+bool SceneSerializer::SerializeBinary(const std::filesystem::path& filepath)
+{
+	return SerializeBinary(filepath, m_Scene->GetAllEntitiesWith<IdCmpt, RelationshipCmpt>());
+}
+
+bool SceneSerializer::SerializeBinary(const std::filesystem::path& filepath, const std::vector<Entity*>& entities)
+{
+	std::unordered_map<const Entity*, uint32_t> entityIndexes;
+	entityIndexes.reserve(entities.size());
+	for (uint32_t i = 0; i < entities.size(); i++)
+		entityIndexes[entities[i]] = i;
+
+	// Gather the columns
+	std::vector<uint64_t> ids(entities.size());
+	std::vector<BinaryTransformRecord> transforms(entities.size());
+	std::vector<uint32_t> childCounts(entities.size());
+	std::vector<uint32_t> childIndexes;
+	std::vector<BinaryNameRecord> names;
+	std::vector<char> nameChars;
+	std::vector<BinaryCameraRecord> cameras;
+	std::vector<BinaryMeshRecord> meshes;
+	std::vector<BinaryMeshRendererRecord> meshRenderers;
+	std::vector<uint64_t> materialIds;
+	std::vector<uint32_t> occluders;
+
+	for (uint32_t i = 0; i < entities.size(); i++)
+	{
+		Entity* entity = entities[i];
+		ids[i] = entity->GetComponent<IdCmpt>()->id;
+
+		auto* transformCmpt = entity->GetComponent<TransformCmpt>();
+		const glm::quat rotation = transformCmpt->GetLocalRotate();
+		transforms[i].position = transformCmpt->GetLocalPosition();
+		transforms[i].rotation = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+		transforms[i].scale = transformCmpt->GetLocalScale();
+
+		for (auto* child : entity->GetComponent<RelationshipCmpt>()->GetChildEntities())
+		{
+			auto find = entityIndexes.find(child);
+			QK_CORE_VERIFY(find != entityIndexes.end(), "SerializeBinary: the children of every entity have to be serialized too")
+			childIndexes.push_back(find->second);
+			childCounts[i]++;
+		}
+
+		if (auto* nameCmpt = entity->GetComponent<NameCmpt>())
+		{
+			names.push_back({ i, (uint32_t)nameChars.size(), (uint32_t)nameCmpt->name.size() });
+			nameChars.insert(nameChars.end(), nameCmpt->name.begin(), nameCmpt->name.end());
+		}
+
+		if (auto* cameraCmpt = entity->GetComponent<CameraCmpt>())
+			cameras.push_back({ i, cameraCmpt->fov, cameraCmpt->aspect, cameraCmpt->zNear, cameraCmpt->zFar });
+
+		if (auto* meshCmpt = entity->GetComponent<MeshCmpt>())
+		{
+			meshes.push_back({ i, 0, meshCmpt->sharedMesh ? (uint64_t)meshCmpt->sharedMesh->GetAssetID() : 0,
+				meshCmpt->uniqueMesh ? (uint64_t)meshCmpt->uniqueMesh->GetAssetID() : 0 });
+
+			auto* meshRendererCmpt = entity->GetComponent<MeshRendererCmpt>();
+			Ref<MeshAsset> mesh = meshCmpt->uniqueMesh ? meshCmpt->uniqueMesh : meshCmpt->sharedMesh;
+			if (meshRendererCmpt && mesh)
+			{
+				meshRenderers.push_back({ i, (uint32_t)materialIds.size(), (uint32_t)mesh->subMeshes.size() });
+				for (uint32_t j = 0; j < mesh->subMeshes.size(); j++)
+					materialIds.push_back(meshRendererCmpt->GetMaterialID(j));
+				if (meshRendererCmpt->IsOccluder())
+					occluders.push_back(i);
+			}
+		}
+	}
+
+	const BinarySectionData sections[] = {
+		{ BinarySceneSectionType::SCENE_NAME, 1, m_Scene->sceneName.size(), m_Scene->sceneName.data() },
+		MakeBinarySection(BinarySceneSectionType::ENTITY_IDS, ids),
+		MakeBinarySection(BinarySceneSectionType::TRANSFORMS, transforms),
+		MakeBinarySection(BinarySceneSectionType::CHILD_COUNTS, childCounts),
+		MakeBinarySection(BinarySceneSectionType::CHILD_INDEXES, childIndexes),
+		MakeBinarySection(BinarySceneSectionType::NAMES, names),
+		MakeBinarySection(BinarySceneSectionType::NAME_CHARS, nameChars),
+		MakeBinarySection(BinarySceneSectionType::CAMERAS, cameras),
+		MakeBinarySection(BinarySceneSectionType::MESHES, meshes),
+		MakeBinarySection(BinarySceneSectionType::MESH_RENDERERS, meshRenderers),
+		MakeBinarySection(BinarySceneSectionType::MATERIAL_IDS, materialIds),
+		MakeBinarySection(BinarySceneSectionType::OCCLUDERS, occluders),
+	};
+	constexpr uint32_t sectionCount = sizeof(sections) / sizeof(sections[0]);
+
+	// Lay out and write the file
+	BinarySceneHeader header;
+	header.entityCount = (uint32_t)entities.size();
+	header.sectionCount = sectionCount;
+
+	BinarySceneSection sectionTable[sectionCount];
+	uint64_t offset = AlignBinarySectionOffset(sizeof(BinarySceneHeader) + sizeof(sectionTable));
+	for (uint32_t i = 0; i < sectionCount; i++)
+	{
+		sectionTable[i].type = sections[i].type;
+		sectionTable[i].elementSize = sections[i].elementSize;
+		sectionTable[i].elementCount = sections[i].elementCount;
+		sectionTable[i].offset = offset;
+		offset = AlignBinarySectionOffset(offset + sections[i].elementSize * sections[i].elementCount);
+	}
+
+	std::ofstream fout(filepath, std::ios::binary);
+	if (!fout)
+	{
+		QK_CORE_LOGE_TAG("Scene", "Failed to open {} for writing", filepath.string());
+		return false;
+	}
+
+	const char padding[BINARY_SCENE_SECTION_ALIGNMENT] = {};
+	fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	fout.write(reinterpret_cast<const char*>(sectionTable), sizeof(sectionTable));
+	for (uint32_t i = 0; i < sectionCount; i++)
+	{
+		fout.write(padding, sectionTable[i].offset - (uint64_t)fout.tellp());
+		fout.write(static_cast<const char*>(sections[i].data), sections[i].elementSize * sections[i].elementCount);
+	}
+	fout.write(padding, offset - (uint64_t)fout.tellp());
+
+	return fout.good();
+}
+
+bool SceneSerializer::DeserializeBinary(const std::filesystem::path& filepath)
+{
+	BinarySceneFile file;
+	if (!file.Open(filepath))
+		return false;
+
+	m_Scene->sceneName = std::string(file.sceneName);
+	QK_CORE_LOGI_TAG("Scene", "Deserializing binary scene: {} with {} entities", m_Scene->sceneName, file.entityCount);
+
+	return InstantiateBinary(file);
+}
+
+bool SceneSerializer::InstantiateBinary(const BinarySceneFile& file, std::vector<Entity*>* outEntities)
+{
+	const uint32_t entityCount = file.entityCount;
+
+	// A corrupted hierarchy is rejected before anything is added to the scene
+	std::vector<size_t> childOffsets(entityCount);
+	size_t childIndexCount = 0;
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		if (file.childCounts[i] > file.childIndexes.count - childIndexCount)
+		{
+			QK_CORE_LOGE_TAG("Scene", "Binary scene has a corrupted hierarchy");
+			return false;
+		}
+		childOffsets[i] = childIndexCount;
+		childIndexCount += file.childCounts[i];
+	}
+
+	for (size_t i = 0; i < childIndexCount; i++)
+	{
+		if (file.childIndexes[i] >= entityCount)
+		{
+			QK_CORE_LOGE_TAG("Scene", "Binary scene has a corrupted hierarchy");
+			return false;
+		}
+	}
+
+	// An entity whose id is already in the scene is skipped together with its children in the file, the scene keeps
+	// the live one. A streamed cell's root reparented out of it outlives the cell's unload and is found again on reload
+	std::vector<uint8_t> skipped(entityCount, 0);
+	std::vector<uint32_t> stack;
+	uint32_t skippedCount = 0;
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		if (skipped[i] || !m_Scene->GetEntityWithID(file.ids[i]))
+			continue;
+
+		stack.push_back(i);
+		while (!stack.empty())
+		{
+			const uint32_t e = stack.back();
+			stack.pop_back();
+			if (skipped[e])
+				continue;
+
+			skipped[e] = 1;
+			skippedCount++;
+			for (uint32_t j = 0; j < file.childCounts[e]; j++)
+				stack.push_back(file.childIndexes[childOffsets[e] + j]);
+		}
+	}
+
+	if (skippedCount > 0)
+		QK_CORE_LOGW_TAG("Scene", "Binary scene: skipped {} entities already in the scene", skippedCount);
+
+	// Entities and the per entity columns, nullptr for the skipped ones
+	std::vector<Entity*> entities(entityCount);
+	m_Scene->ReserveEntities(m_Scene->GetEntities().size() + entityCount - skippedCount);
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		if (!skipped[i])
+			entities[i] = m_Scene->CreateEntityWithID(file.ids[i]);
+	}
+
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		if (!entities[i])
+			continue;
+
+		const BinaryTransformRecord& record = file.transforms[i];
+		auto* tc = entities[i]->GetComponent<TransformCmpt>();
+		tc->SetLocalPosition(record.position);
+		tc->SetLocalRotate(glm::quat(record.rotation.w, record.rotation.x, record.rotation.y, record.rotation.z));
+		tc->SetLocalScale(record.scale);
+	}
+
+	// Sparse component columns, records that point outside the file are skipped
+	for (size_t i = 0; i < file.names.count; i++)
+	{
+		const BinaryNameRecord& record = file.names[i];
+		if (record.entityIndex < entityCount && entities[record.entityIndex] && record.offset <= file.nameChars.count && record.length <= file.nameChars.count - record.offset)
+			entities[record.entityIndex]->AddComponent<NameCmpt>(std::string(file.nameChars.data + record.offset, record.length));
+	}
+
+	for (size_t i = 0; i < file.cameras.count; i++)
+	{
+		const BinaryCameraRecord& record = file.cameras[i];
+		if (record.entityIndex >= entityCount || !entities[record.entityIndex])
+			continue;
+
+		auto* cc = entities[record.entityIndex]->AddComponent<CameraCmpt>();
+		cc->fov = record.fov;
+		cc->zNear = record.zNear;
+		cc->zFar = record.zFar;
+		cc->aspect = record.aspect;
+	}
+
+	// Most entities share a handful of meshes, look each one up once
+	std::unordered_map<uint64_t, Ref<MeshAsset>> meshCache;
+	for (size_t i = 0; i < file.meshes.count; i++)
+	{
+		const BinaryMeshRecord& record = file.meshes[i];
+		if (record.entityIndex >= entityCount || !entities[record.entityIndex])
+			continue;
+
+		auto [it, inserted] = meshCache.try_emplace(record.meshAssetId);
+		if (inserted && record.meshAssetId != 0)
+			it->second = AssetManager::Get().GetAsset<MeshAsset>(record.meshAssetId);
+
+		auto* mc = entities[record.entityIndex]->AddComponent<MeshCmpt>();
+		mc->sharedMesh = it->second;
+		mc->uniqueMesh = record.uniqueMeshAssetId != 0 ? AssetManager::Get().GetAsset<MeshAsset>(record.uniqueMeshAssetId) : nullptr;
+	}
+
+	for (size_t i = 0; i < file.meshRenderers.count; i++)
+	{
+		const BinaryMeshRendererRecord& record = file.meshRenderers[i];
+		if (record.entityIndex >= entityCount || !entities[record.entityIndex] || record.materialOffset > file.materialIds.count || record.materialCount > file.materialIds.count - record.materialOffset)
+			continue;
+
+		auto* mc = entities[record.entityIndex]->GetComponent<MeshCmpt>();
+		Ref<MeshAsset> mesh = mc ? (mc->uniqueMesh ? mc->uniqueMesh : mc->sharedMesh) : nullptr;
+		if (!mesh)
+		{
+			QK_CORE_LOGW_TAG("Scene", "Binary scene: entity {} has a mesh renderer but no mesh", file.ids[record.entityIndex]);
+			continue;
+		}
+
+		if (record.materialCount != mesh->subMeshes.size())
+		{
+			QK_CORE_LOGW_TAG("Scene", "Binary scene: entity {} has {} materials for {} submeshes", 
+				file.ids[record.entityIndex], record.materialCount, mesh->subMeshes.size());
+			continue;
+		}
+
+		auto* mrc = entities[record.entityIndex]->AddComponent<MeshRendererCmpt>();
+		mrc->SetMesh(mesh);
+		for (uint32_t j = 0; j < record.materialCount; j++)
+			mrc->SetMaterial(j, file.materialIds[record.materialOffset + j]);
+	}
+
+	for (size_t i = 0; i < file.occluders.count; i++)
+	{
+		const uint32_t entityIndex = file.occluders[i];
+		if (entityIndex >= entityCount || !entities[entityIndex])
+			continue;
+
+		if (auto* mrc = entities[entityIndex]->GetComponent<MeshRendererCmpt>())
+			mrc->SetOccluder(true);
+	}
+
+	// Parent-child relationship, validated above. Children of a skipped entity are skipped too, a skipped child
+	// stays where it lives now
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		if (!entities[i])
+			continue;
+
+		auto* relationshipCmpt = entities[i]->GetComponent<RelationshipCmpt>();
+		for (uint32_t j = 0; j < file.childCounts[i]; j++)
+		{
+			if (Entity* child = entities[file.childIndexes[childOffsets[i] + j]])
+				relationshipCmpt->AddChildEntity(child);
+		}
+	}
+
+	if (outEntities)
+	{
+		for (Entity* entity : entities)
+		{
+			if (entity)
+				outEntities->push_back(entity);
+		}
+	}
+
 	return true;
 }
 
+bool SceneSerializer::SerializeAuto(const std::filesystem::path& filepath)
+{
+	if (IsBinarySceneFile(filepath))
+		return SerializeBinary(filepath);
+
+	Serialize(filepath);
+	return true;
+}
+
+bool SceneSerializer::DeserializeAuto(const std::filesystem::path& filepath)
+{
+	if (IsBinarySceneFile(filepath))
+		return DeserializeBinary(filepath);
+	else
+		return Deserialize(filepath);
+}
+
+bool SceneSerializer::Convert(const std::filesystem::path& srcFilepath, const std::filesystem::path& dstFilepath)
+{
+	Ref<Scene> scene = CreateRef<Scene>("");
+	SceneSerializer serializer(scene);
+	if (!serializer.DeserializeAuto(srcFilepath))
+		return false;
+
+	if (IsBinarySceneFile(dstFilepath))
+		return serializer.SerializeBinary(dstFilepath);
+
+	serializer.Serialize(dstFilepath);
+	return true;
+}
+
+
+std::filesystem::path SceneSerializer::GetJournalPath(const std::filesystem::path& filepath)
+{
+	return filepath.string() + std::string(s_JournalExtension);
+}
+
+bool SceneSerializer::AppendJournal(const std::filesystem::path& filepath, const std::vector<SceneEntityDelta>& changes, const std::vector<uint64_t>& deletedEntities)
+{
+	YAML::Emitter out;
+	out << YAML::BeginDoc << YAML::BeginMap;
+	out << YAML::Key << "Scene" << YAML::Value << m_Scene->sceneName;
+
+	if (!deletedEntities.empty())
+	{
+		out << YAML::Key << "Deleted" << YAML::Value << YAML::Flow << YAML::BeginSeq;
+		for (uint64_t id : deletedEntities)
+			out << id;
+		out << YAML::EndSeq;
+	}
+
+	out << YAML::Key << "Entities" << YAML::Value << YAML::BeginSeq;
+	for (const auto& change : changes)
+		SerializeEntity(out, change.entity, change.changedComponents, change.removedComponents);
+	out << YAML::EndSeq;
+	out << YAML::EndMap;
+
+	std::ofstream fout(GetJournalPath(filepath), std::ios::app | std::ios::binary);
+	fout << out.c_str() << '\n';
+	fout.flush();
+
+	return fout.good();
+}
+
+static void ApplySceneDelta(Scene& scene, const YAML::Node& delta)
+{
+	if (delta["Scene"])
+		scene.sceneName = delta["Scene"].as<std::string>();
+
+	for (auto id : delta["Deleted"])
+	{
+		// Children of a deleted entity are deleted with it and listed after it
+		if (Entity* entity = scene.GetEntityWithID(id.as<uint64_t>()))
+			scene.DeleteEntity(entity);
+	}
+
+	auto entities = delta["Entities"];
+	for (auto node : entities)
+	{
+		uint64_t uuid = node["Entity"].as<uint64_t>();
+		Entity* entity = scene.GetEntityWithID(uuid);
+		if (!entity)
+			entity = scene.CreateEntityWithID(uuid);
+
+		DeserializeComponents(entity, node);
+
+		for (auto removed : node["Removed"])
+		{
+			std::string key = removed.as<std::string>();
+			if (key == GetComponentKey(SCENE_COMPONENT_NAME_BIT))
+				entity->RemoveComponent<NameCmpt>();
+			else if (key == GetComponentKey(SCENE_COMPONENT_CAMERA_BIT))
+				entity->RemoveComponent<CameraCmpt>();
+			else if (key == GetComponentKey(SCENE_COMPONENT_MESH_BIT))
+				entity->RemoveComponent<MeshCmpt>();
+			else if (key == GetComponentKey(SCENE_COMPONENT_MESH_RENDERER_BIT))
+				entity->RemoveComponent<MeshRendererCmpt>();
+		}
+	}
+
+	// Hierarchy changes once every entity of the delta exists.
+	// A moved entity is listed in the Children of its new parent, entities that became roots have Parent 0.
+	for (auto node : entities)
+	{
+		if (node["Parent"] && node["Parent"].as<uint64_t>() == 0)
+			scene.DetachChild(scene.GetEntityWithID(node["Entity"].as<uint64_t>()));
+	}
+
+	for (auto node : entities)
+	{
+		Entity* entity = scene.GetEntityWithID(node["Entity"].as<uint64_t>());
+		for (auto child : node["Children"])
+		{
+			Entity* childEntity = scene.GetEntityWithID(child["Id"].as<uint64_t>());
+			if (childEntity && childEntity->GetComponent<RelationshipCmpt>()->GetParentEntity() != entity)
+				scene.AttachChild(childEntity, entity);
+		}
+	}
+
+	// Restore the saved sibling order
+	std::vector<Entity*> orderedChildren;
+	for (auto node : entities)
+	{
+		auto children = node["Children"];
+		if (!children)
+			continue;
+
+		Entity* entity = scene.GetEntityWithID(node["Entity"].as<uint64_t>());
+		orderedChildren.clear();
+		for (auto child : children)
+		{
+			if (Entity* childEntity = scene.GetEntityWithID(child["Id"].as<uint64_t>()))
+				orderedChildren.push_back(childEntity);
+		}
+
+		auto& childEntities = entity->GetComponent<RelationshipCmpt>()->GetChildEntities();
+		if (orderedChildren.size() == childEntities.size())
+			childEntities = orderedChildren;
+	}
+}
+
+bool SceneSerializer::ReplayJournal(const std::filesystem::path& filepath)
+{
+	std::vector<YAML::Node> deltas;
+	try
+	{
+		deltas = YAML::LoadAllFromFile(GetJournalPath(filepath).string());
+	}
+	catch (const YAML::Exception& e)
+	{
+		QK_CORE_LOGE_TAG("Scene", "Failed to load scene journal : {}", GetJournalPath(filepath).string());
+		return false;
+	}
+
+	for (const auto& delta : deltas)
+		ApplySceneDelta(*m_Scene, delta);
 
-bool SceneSerializer::DeserializeBinary(AssetID scene)
+	QK_CORE_LOGI_TAG("Scene", "Replayed {} incremental saves of scene: {}", deltas.size(), m_Scene->sceneName);
+	return true;
+}
+
+bool SceneSerializer::CompactJournal(const std::filesystem::path& filepath, size_t journalSize, const std::filesystem::path& outFilepath)
 {
-	// Not implemented
-	QK_CORE_ASSERT(false);
-	return false;
+	YAML::Node base;
+	std::vector<YAML::Node> deltas;
+	try
+	{
+		base = YAML::LoadFile(filepath.string());
+
+		std::string journal(journalSize, '\0');
+		std::ifstream fin(GetJournalPath(filepath), std::ios::binary);
+		if (!fin.read(journal.data(), journalSize))
+		{
+			QK_CORE_LOGE_TAG("Scene", "Failed to read scene journal : {}", GetJournalPath(filepath).string());
+			return false;
+		}
+
+		deltas = YAML::LoadAll(journal);
+	}
+	catch (const YAML::Exception& e)
+	{
+		QK_CORE_LOGE_TAG("Scene", "Failed to compact scene journal : {}", GetJournalPath(filepath).string());
+		return false;
+	}
+
+	// Merge on the YAML nodes, no scene is involved
+	std::string sceneName = base["Scene"].as<std::string>();
+	std::vector<YAML::Node> entities;
+	std::unordered_map<uint64_t, size_t> entityIndexes;
+	for (auto node : base["Entities"])
+	{
+		entityIndexes[node["Entity"].as<uint64_t>()] = entities.size();
+		entities.push_back(node);
+	}
+
+	for (const auto& delta : deltas)
+	{
+		if (delta["Scene"])
+			sceneName = delta["Scene"].as<std::string>();
+
+		for (auto id : delta["Deleted"])
+		{
+			auto find = entityIndexes.find(id.as<uint64_t>());
+			if (find != entityIndexes.end())
+			{
+				entities[find->second] = YAML::Node();
+				entityIndexes.erase(find);
+			}
+		}
+
+		for (auto node : delta["Entities"])
+		{
+			uint64_t uuid = node["Entity"].as<uint64_t>();
+			auto find = entityIndexes.find(uuid);
+			if (find == entityIndexes.end())
+			{
+				entityIndexes[uuid] = entities.size();
+				entities.push_back(node);
+				continue;
+			}
+
+			YAML::Node& entity = entities[find->second];
+			for (auto component : node)
+			{
+				std::string key = component.first.as<std::string>();
+				if (key != "Entity" && key != "Removed")
+					entity[key] = component.second;
+			}
+
+			for (auto removed : node["Removed"])
+				entity.remove(removed.as<std::string>());
+		}
+	}
+
+	YAML::Emitter out;
+	out << YAML::BeginMap;
+	out << YAML::Key << "Scene" << YAML::Value << sceneName;
+	out << YAML::Key << "Entities" << YAML::Value << YAML::BeginSeq;
+	for (const auto& entity : entities)
+	{
+		if (!entity.IsNull())
+			out << entity;
+	}
+	out << YAML::EndSeq;
+	out << YAML::EndMap;
+
+	std::ofstream fout(outFilepath);
+	fout << out.c_str();
+
+	return fout.good();
 }
 
 }
\ No newline at end of file
@@ -5,20 +5,68 @@
 
 namespace quark {
 class Scene;
+class Entity;
+class BinarySceneFile;
+
+enum SceneComponentFlagBit
+{
+	SCENE_COMPONENT_RELATIONSHIP_BIT = 1 << 0,
+	SCENE_COMPONENT_NAME_BIT = 1 << 1,
+	SCENE_COMPONENT_TRANSFORM_BIT = 1 << 2,
+	SCENE_COMPONENT_CAMERA_BIT = 1 << 3,
+	SCENE_COMPONENT_MESH_BIT = 1 << 4,
+	SCENE_COMPONENT_MESH_RENDERER_BIT = 1 << 5,
+	SCENE_COMPONENT_ALL_BITS = (1 << 6) - 1
+};
+using SceneComponentFlags = uint32_t;
+
+// One entity of an incremental save
+struct SceneEntityDelta
+{
+	Entity* entity = nullptr;
+	SceneComponentFlags changedComponents = 0;	// written in full
+	SceneComponentFlags removedComponents = 0;
+};
+
 class SceneSerializer
 {
 public:
 	SceneSerializer(Ref<Scene>& scene);
 
+	// YAML, kept as the human readable interchange format
 	void Serialize(const std::filesystem::path& filepath);
-	void SerializeBinary(AssetID scene);
-
 	bool Deserialize(const std::filesystem::path& filepath);
-	bool DeserializeBinary(AssetID scene);
+
+	// Columnar binary format, see SceneBinaryFormat.h
+	bool SerializeBinary(const std::filesystem::path& filepath);
+	bool SerializeBinary(const std::filesystem::path& filepath, const std::vector<Entity*>& entities); // entities must include all their children
+	bool DeserializeBinary(const std::filesystem::path& filepath);
+
+	// Adds the entities of an already opened binary scene to the scene, main thread only
+	bool InstantiateBinary(const BinarySceneFile& file, std::vector<Entity*>* outEntities = nullptr);
+
+	// Pick the format from the file extension
+	bool SerializeAuto(const std::filesystem::path& filepath);
+	bool DeserializeAuto(const std::filesystem::path& filepath);
+
+	// Delta journal of incremental saves next to a YAML scene file, see SceneJournal.
+	// Deserialize() replays it, Serialize() deletes it.
+	static std::filesystem::path GetJournalPath(const std::filesystem::path& filepath);
+	bool AppendJournal(const std::filesystem::path& filepath, const std::vector<SceneEntityDelta>& changes, const std::vector<uint64_t>& deletedEntities);
+	bool ReplayJournal(const std::filesystem::path& filepath);
+
+	// Writes the scene file merged with the first journalSize bytes of its journal to outFilepath.
+	// Only touches files, so it is safe on any thread.
+	static bool CompactJournal(const std::filesystem::path& filepath, size_t journalSize, const std::filesystem::path& outFilepath);
+
+	// Converts a scene file to the other format, the format of each file is picked from its extension
+	static bool Convert(const std::filesystem::path& srcFilepath, const std::filesystem::path& dstFilepath);
 
 public:
 	inline static std::string_view s_FileFilter = "Quark Scene (*.qkscene)\0*.qkscene\0";
 	inline static std::string_view s_DefaultExtension = ".qkscene";
+	inline static std::string_view s_BinaryExtension = ".qkbscene";
+	inline static std::string_view s_JournalExtension = ".journal";
 
 private:
 	Ref<Scene> m_Scene;
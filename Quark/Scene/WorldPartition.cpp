@@ -0,0 +1,372 @@
+#include "Quark/qkpch.h"
+#include "Quark/Scene/WorldPartition.h"
+#include "Quark/Core/Util/SerializationUtils.h"
+#include "Quark/Scene/Scene.h"
+#include "Quark/Scene/SceneSerializer.h"
+#include "Quark/Scene/Components/CommonCmpts.h"
+#include "Quark/Scene/Components/TransformCmpt.h"
+#include "Quark/Scene/Components/RelationshipCmpt.h"
+
+namespace quark {
+
+static uint64_t GetCellKey(int x, int z)
+{
+    return ((uint64_t)(uint32_t)x << 32) | (uint64_t)(uint32_t)z;
+}
+
+// Rough ECS footprint of an entity with the components every entity has, used for the memory budget
+static constexpr size_t s_EstimatedEntitySize = sizeof(Entity) + sizeof(IdCmpt) + sizeof(TransformCmpt) + sizeof(RelationshipCmpt) + 128;
+
+WorldPartition::WorldPartition(const Ref<Scene>& scene, JobSystem& jobSystem, const WorldPartitionSpecification& specs)
+    : m_scene(scene), m_jobSystem(jobSystem), m_specs(specs)
+{
+    QK_CORE_ASSERT(m_specs.unloadRadius >= m_specs.loadRadius)
+}
+
+WorldPartition::~WorldPartition()
+{
+    // Jobs write into the cells
+    m_jobSystem.Wait(&m_jobCounter, 1);
+}
+
+bool WorldPartition::Build(Ref<Scene> scene, const std::filesystem::path& manifestPath, float cellSize)
+{
+    QK_CORE_ASSERT(cellSize > 0.f)
+
+    // Group the hierarchies by the cell of their root
+    std::map<std::pair<int, int>, std::vector<Entity*>> cellEntities;
+    for (auto* entity : scene->GetAllEntitiesWith<IdCmpt, RelationshipCmpt>())
+    {
+        if (entity->GetComponent<RelationshipCmpt>()->GetParentEntity())
+            continue;
+
+        glm::vec3 position = entity->GetComponent<TransformCmpt>()->GetLocalPosition();
+        std::pair<int, int> coord = { (int)std::floor(position.x / cellSize), (int)std::floor(position.z / cellSize) };
+
+        auto& entities = cellEntities[coord];
+        std::vector<Entity*> stack = { entity };
+        while (!stack.empty())
+        {
+            Entity* e = stack.back();
+            stack.pop_back();
+            entities.push_back(e);
+
+            const auto& children = e->GetComponent<RelationshipCmpt>()->GetChildEntities();
+            stack.insert(stack.end(), children.begin(), children.end());
+        }
+    }
+
+    const std::filesystem::path cellDirectory = manifestPath.parent_path() / (manifestPath.stem().string() + "_cells");
+    std::filesystem::create_directories(cellDirectory);
+
+    SceneSerializer serializer(scene);
+
+    YAML::Emitter out;
+    out << YAML::BeginMap;
+    out << YAML::Key << "World" << YAML::Value << scene->sceneName;
+    out << YAML::Key << "CellSize" << YAML::Value << cellSize;
+    out << YAML::Key << "Cells" << YAML::Value << YAML::BeginSeq;
+
+    for (const auto& [coord, entities] : cellEntities)
+    {
+        std::string fileName = "cell_" + std::to_string(coord.first) + "_" + std::to_string(coord.second) + std::string(SceneSerializer::s_BinaryExtension);
+        if (!serializer.SerializeBinary(cellDirectory / fileName, entities))
+            return false;
+
+        size_t memorySize = std::filesystem::file_size(cellDirectory / fileName) + entities.size() * s_EstimatedEntitySize;
+
+        out << YAML::BeginMap;
+        out << YAML::Key << "Coord" << YAML::Value << YAML::Flow << YAML::BeginSeq << coord.first << coord.second << YAML::EndSeq;
+        out << YAML::Key << "File" << YAML::Value << (cellDirectory.filename() / fileName).generic_string();
+        out << YAML::Key << "Entities" << YAML::Value << entities.size();
+        out << YAML::Key << "MemorySize" << YAML::Value << memorySize;
+        out << YAML::EndMap;
+    }
+
+    out << YAML::EndSeq;
+    out << YAML::EndMap;
+
+    std::ofstream fout(manifestPath);
+    fout << out.c_str();
+
+    QK_CORE_LOGI_TAG("Scene", "Built world partition {} with {} cells", manifestPath.string(), cellEntities.size());
+    return fout.good();
+}
+
+bool WorldPartition::Open(const std::filesystem::path& manifestPath)
+{
+    QK_CORE_ASSERT(m_cells.empty())
+
+    YAML::Node data;
+    try
+    {
+        data = YAML::LoadFile(manifestPath.string());
+    }
+    catch (const YAML::Exception& e)
+    {
+        QK_CORE_LOGE_TAG("Scene", "Failed to load .qkworld file : {}", manifestPath.string());
+        return false;
+    }
+
+    if (!data["World"] || !data["CellSize"])
+    {
+        QK_CORE_LOGE_TAG("Scene", "World file: {} does not contain World or CellSize key", manifestPath.string());
+        return false;
+    }
+
+    m_scene->sceneName = data["World"].as<std::string>();
+    m_cellSize = data["CellSize"].as<float>();
+
+    for (auto cellNode : data["Cells"])
+    {
+        auto cell = CreateScope<Cell>();
+        cell->coord = glm::ivec2(cellNode["Coord"][0].as<int>(), cellNode["Coord"][1].as<int>());
+        cell->filepath = manifestPath.parent_path() / cellNode["File"].as<std::string>();
+        cell->entityCount = cellNode["Entities"].as<uint32_t>();
+        cell->memorySize = cellNode["MemorySize"].as<size_t>();
+
+        m_cellLookup[GetCellKey(cell->coord.x, cell->coord.y)] = cell.get();
+        m_cells.push_back(std::move(cell));
+    }
+
+    QK_CORE_LOGI_TAG("Scene", "Opened world partition: {} with {} cells", m_scene->sceneName, m_cells.size());
+    return true;
+}
+
+void WorldPartition::Update(const glm::vec3& viewerPosition)
+{
+    m_stats.createdEntities = 0;
+    m_stats.deletedEntities = 0;
+    m_stats.budgetLimited = false;
+
+    CommitLoadedCells(viewerPosition);
+
+    // Stream out
+    for (size_t i = 0; i < m_activeCells.size();)
+    {
+        Cell& cell = *m_activeCells[i];
+        if (cell.state == CellState::RESIDENT && DistanceToCell(cell, viewerPosition) > m_specs.unloadRadius)
+        {
+            UnloadCell(cell);
+            m_activeCells[i] = m_activeCells.back();
+            m_activeCells.pop_back();
+        }
+        else
+            i++;
+    }
+
+    RequestLoads(viewerPosition);
+
+    m_stats.residentCells = 0;
+    m_stats.loadingCells = 0;
+    m_stats.usedMemory = 0;
+    for (const Cell* cell : m_activeCells)
+    {
+        if (cell->state == CellState::RESIDENT)
+            m_stats.residentCells++;
+        else
+            m_stats.loadingCells++;
+
+        m_stats.usedMemory += cell->memorySize;
+    }
+}
+
+void WorldPartition::Flush(const glm::vec3& viewerPosition)
+{
+    do
+    {
+        m_jobSystem.Wait(&m_jobCounter, 1);
+        Update(viewerPosition);
+    }
+    while (m_stats.loadingCells > 0);
+}
+
+float WorldPartition::DistanceToCell(const Cell& cell, const glm::vec3& viewerPosition) const
+{
+    // Distance on the XZ plane to the closest point of the cell
+    glm::vec2 min = glm::vec2((float)cell.coord.x, (float)cell.coord.y) * m_cellSize;
+    float dx = std::max({ min.x - viewerPosition.x, 0.f, viewerPosition.x - (min.x + m_cellSize) });
+    float dz = std::max({ min.y - viewerPosition.z, 0.f, viewerPosition.z - (min.y + m_cellSize) });
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+WorldPartition::Cell* WorldPartition::FindCell(int x, int z)
+{
+    auto find = m_cellLookup.find(GetCellKey(x, z));
+    return find != m_cellLookup.end() ? find->second : nullptr;
+}
+
+void WorldPartition::CommitLoadedCells(const glm::vec3& viewerPosition)
+{
+    SceneSerializer serializer(m_scene);
+
+    for (size_t i = 0; i < m_activeCells.size();)
+    {
+        Cell& cell = *m_activeCells[i];
+        if (cell.state.load(std::memory_order_acquire) != CellState::LOADED)
+        {
+            i++;
+            continue;
+        }
+
+        // Keep the rest for the next frame boundary once the creation budget is spent
+        const bool wanted = cell.file && DistanceToCell(cell, viewerPosition) <= m_specs.unloadRadius;
+        if (wanted && m_stats.createdEntities > 0 && m_stats.createdEntities + cell.entityCount > m_specs.maxEntitiesPerFrame)
+        {
+            i++;
+            continue;
+        }
+
+        if (wanted)
+        {
+            std::vector<Entity*> entities;
+            entities.reserve(cell.file->entityCount);
+            if (serializer.InstantiateBinary(*cell.file, &entities))
+            {
+                for (auto* e : entities)
+                {
+                    if (!e->GetComponent<RelationshipCmpt>()->GetParentEntity())
+                        cell.roots.push_back(e->GetComponent<IdCmpt>()->id);
+                }
+
+                m_stats.createdEntities += (uint32_t)entities.size();
+                cell.file.reset();
+                cell.state = CellState::RESIDENT;
+                i++;
+                continue;
+            }
+
+            // Rejected before anything was added to the scene, it would be rejected again
+            cell.file.reset();
+        }
+
+        if (!cell.file)
+        {
+            QK_CORE_LOGE_TAG("Scene", "World partition failed to load cell ({}, {})", cell.coord.x, cell.coord.y);
+            cell.loadFailed = true;
+            m_stats.failedCells++;
+        }
+
+        cell.file.reset();
+        cell.state = CellState::UNLOADED;
+        m_activeCells[i] = m_activeCells.back();
+        m_activeCells.pop_back();
+    }
+}
+
+static uint32_t CountHierarchy(Entity* entity)
+{
+    uint32_t count = 1;
+    for (auto* child : entity->GetComponent<RelationshipCmpt>()->GetChildEntities())
+        count += CountHierarchy(child);
+    return count;
+}
+
+void WorldPartition::UnloadCell(Cell& cell)
+{
+    if (m_unloadCallback)
+        m_unloadCallback();
+
+    // Roots deleted since the cell was loaded are gone, reparented ones now belong to another hierarchy
+    for (UUID id : cell.roots)
+    {
+        Entity* root = m_scene->GetEntityWithID(id);
+        if (!root || root->GetComponent<RelationshipCmpt>()->GetParentEntity())
+            continue;
+
+        m_stats.deletedEntities += CountHierarchy(root);
+        m_scene->DeleteEntity(root);
+    }
+
+    cell.roots.clear();
+    cell.state = CellState::UNLOADED;
+}
+
+void WorldPartition::RequestLoads(const glm::vec3& viewerPosition)
+{
+    uint32_t loadsInFlight = 0;
+    size_t usedMemory = 0;
+    for (const Cell* cell : m_activeCells)
+    {
+        if (cell->state == CellState::LOADING)
+            loadsInFlight++;
+        usedMemory += cell->memorySize;
+    }
+
+    // Cells inside the load radius that aren't loaded yet, nearest first
+    std::vector<std::pair<float, Cell*>> candidates;
+    const int minX = (int)std::floor((viewerPosition.x - m_specs.loadRadius) / m_cellSize);
+    const int maxX = (int)std::floor((viewerPosition.x + m_specs.loadRadius) / m_cellSize);
+    const int minZ = (int)std::floor((viewerPosition.z - m_specs.loadRadius) / m_cellSize);
+    const int maxZ = (int)std::floor((viewerPosition.z + m_specs.loadRadius) / m_cellSize);
+    for (int z = minZ; z <= maxZ; z++)
+    {
+        for (int x = minX; x <= maxX; x++)
+        {
+            Cell* cell = FindCell(x, z);
+            if (!cell || cell->loadFailed || cell->state != CellState::UNLOADED)
+                continue;
+
+            float distance = DistanceToCell(*cell, viewerPosition);
+            if (distance <= m_specs.loadRadius)
+                candidates.push_back({ distance, cell });
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (auto [distance, cell] : candidates)
+    {
+        if (loadsInFlight >= m_specs.maxLoadsInFlight)
+            break;
+
+        // Make room by evicting the farthest resident cells that are already outside the load radius
+        while (usedMemory + cell->memorySize > m_specs.memoryBudget)
+        {
+            auto farthest = m_activeCells.end();
+            float farthestDistance = m_specs.loadRadius;
+            for (auto it = m_activeCells.begin(); it != m_activeCells.end(); it++)
+            {
+                float d = DistanceToCell(**it, viewerPosition);
+                if ((*it)->state == CellState::RESIDENT && d > farthestDistance)
+                {
+                    farthest = it;
+                    farthestDistance = d;
+                }
+            }
+
+            if (farthest == m_activeCells.end())
+                break;
+
+            usedMemory -= (*farthest)->memorySize;
+            UnloadCell(**farthest);
+            *farthest = m_activeCells.back();
+            m_activeCells.pop_back();
+        }
+
+        if (usedMemory + cell->memorySize > m_specs.memoryBudget)
+        {
+            m_stats.budgetLimited = true;
+            break;
+        }
+
+        cell->state = CellState::LOADING;
+        m_activeCells.push_back(cell);
+        usedMemory += cell->memorySize;
+        loadsInFlight++;
+
+        m_jobSystem.Execute([cell]()
+        {
+            auto file = CreateScope<BinarySceneFile>();
+            if (file->Open(cell->filepath))
+            {
+                file->Prefetch();
+                cell->file = std::move(file);
+            }
+
+            cell->state.store(CellState::LOADED, std::memory_order_release);
+        }, &m_jobCounter);
+    }
+}
+
+}
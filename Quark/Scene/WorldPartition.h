@@ -0,0 +1,110 @@
+#pragma once
+#include "Quark/Core/JobSystem.h"
+#include "Quark/Core/UUID.h"
+#include "Quark/Scene/SceneBinaryFormat.h"
+
+#include <glm/glm.hpp>
+#include <filesystem>
+
+namespace quark {
+
+class Scene;
+class Entity;
+
+struct WorldPartitionSpecification
+{
+    float loadRadius = 256.f;               // cells closer than this to the viewer are streamed in
+    float unloadRadius = 320.f;             // cells farther than this are streamed out, keep it above loadRadius to avoid thrashing
+    size_t memoryBudget = 512ull << 20;     // estimated bytes of all resident and in flight cells
+    uint32_t maxLoadsInFlight = 4;
+    uint32_t maxEntitiesPerFrame = 20000;   // entity creation budget of one frame boundary, at least one cell is committed per frame
+};
+
+struct WorldPartitionStats
+{
+    uint32_t residentCells = 0;
+    uint32_t loadingCells = 0;
+    size_t usedMemory = 0;
+    uint32_t failedCells = 0;               // cells that couldn't be opened or instantiated, they aren't requested again
+
+    // last Update() only
+    uint32_t createdEntities = 0;
+    uint32_t deletedEntities = 0;
+    bool budgetLimited = false;             // a cell inside loadRadius was not requested because of the memory budget
+};
+
+// World partition mode of a scene.
+// The world is split into a grid of cells on the XZ plane, every cell is a .qkbscene file listed in a .qkworld manifest.
+// Cells are streamed in and out around a viewer: files are mapped and prefetched on the JobSystem,
+// and their entities are created in Update() at the frame boundary, so the ECS is only ever touched on the main thread.
+class WorldPartition
+{
+public:
+    WorldPartition(const Ref<Scene>& scene, JobSystem& jobSystem, const WorldPartitionSpecification& specs = {});
+    ~WorldPartition();
+
+    // Offline: writes every root entity, together with its children, into the cell containing its position
+    static bool Build(Ref<Scene> scene, const std::filesystem::path& manifestPath, float cellSize);
+
+    bool Open(const std::filesystem::path& manifestPath);
+
+    // Call once per frame at the frame boundary, before the scene's entities are updated
+    void Update(const glm::vec3& viewerPosition);
+
+    // Blocks until everything that should be resident around viewerPosition is loaded, for the first frame or teleports
+    void Flush(const glm::vec3& viewerPosition);
+
+    // Called before a cell's entities are deleted, so whoever holds Entity pointers can drop them
+    void SetUnloadCallback(std::function<void()>&& callback) { m_unloadCallback = std::move(callback); }
+
+    const WorldPartitionStats& GetStats() const { return m_stats; }
+    float GetCellSize() const { return m_cellSize; }
+    size_t GetCellCount() const { return m_cells.size(); }
+
+public:
+    inline static std::string_view s_DefaultExtension = ".qkworld";
+
+private:
+    enum class CellState : uint8_t
+    {
+        UNLOADED,
+        LOADING,    // a job is opening the file
+        LOADED,     // file is ready, waiting for the frame boundary
+        RESIDENT    // entities live in the scene
+    };
+
+    struct Cell
+    {
+        glm::ivec2 coord;
+        std::filesystem::path filepath;
+        uint32_t entityCount = 0;
+        size_t memorySize = 0;
+        bool loadFailed = false;
+
+        std::atomic<CellState> state = CellState::UNLOADED;
+        Scope<BinarySceneFile> file;    // written by the loading job before state becomes LOADED
+        std::vector<UUID> roots;        // while RESIDENT, the editor may delete or reparent them meanwhile
+    };
+
+    float DistanceToCell(const Cell& cell, const glm::vec3& viewerPosition) const;
+    Cell* FindCell(int x, int z);
+
+    void CommitLoadedCells(const glm::vec3& viewerPosition);
+    void UnloadCell(Cell& cell);
+    void RequestLoads(const glm::vec3& viewerPosition);
+
+    Ref<Scene> m_scene;
+    JobSystem& m_jobSystem;
+    WorldPartitionSpecification m_specs;
+
+    float m_cellSize = 64.f;
+    std::vector<Scope<Cell>> m_cells;
+    std::unordered_map<uint64_t, Cell*> m_cellLookup;
+    std::vector<Cell*> m_activeCells;   // every cell that isn't UNLOADED
+
+    JobSystem::Counter m_jobCounter{};
+    WorldPartitionStats m_stats;
+    std::function<void()> m_unloadCallback;
+};
+
+}
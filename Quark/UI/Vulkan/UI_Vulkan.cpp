@@ -127,6 +127,10 @@ void UI_Vulkan::Init(rhi::Device* device, const UiSpecification& specs)
 void UI_Vulkan::Finalize()
 {
     vkDeviceWaitIdle(m_device->vkDevice);
+    for (ImDrawList* list : m_drawData.CmdLists)
+        IM_DELETE(list);
+    m_drawData.Clear();
+
     ImGui_ImplVulkan_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -153,22 +157,37 @@ void UI_Vulkan::EndFrame()
 {
     // Make imgui calculate internal draw structures
     ImGui::Render();
+    CopyDrawData();
+
+    // Platform windows are created, moved and presented through the windowing system and ImGui's own swapchains,
+    // so they are handled here on the main thread. EndFrame() runs while the render side is idle.
+    if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+    {
+        ImGui::UpdatePlatformWindows();
+        ImGui::RenderPlatformWindowsDefault();
+    }
 }
 
 void UI_Vulkan::OnRender(rhi::CommandList* cmd)
 {
     auto& internal = rhi::ToInternal(cmd);
 
-    auto* data = ImGui::GetDrawData();
-    if (data) {
-        ImGui_ImplVulkan_RenderDrawData(data, internal.GetHandle());
-    }
+    if (m_drawData.Valid)
+        ImGui_ImplVulkan_RenderDrawData(&m_drawData, internal.GetHandle());
+}
 
-    if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-	{
-		ImGui::UpdatePlatformWindows();
-		ImGui::RenderPlatformWindowsDefault();
-	}
+void UI_Vulkan::CopyDrawData()
+{
+    for (ImDrawList* list : m_drawData.CmdLists)
+        IM_DELETE(list);
+    m_drawData.Clear();
+
+    if (ImDrawData* data = ImGui::GetDrawData())
+    {
+        m_drawData = *data;
+        for (ImDrawList*& list : m_drawData.CmdLists)
+            list = list->CloneOutput();
+    }
 }
 
 ImTextureID UI_Vulkan::GetOrCreateTextureId(const Ref<rhi::Image>& image, const Ref<rhi::Sampler>& sampler)
@@ -20,13 +20,18 @@ public:
     ImTextureID GetOrCreateTextureId(const Ref<rhi::Image>& image, const Ref<rhi::Sampler>& sampler) override;
 
 private:
+    void CopyDrawData();
+
     rhi::Device_Vulkan* m_device;
 
     VkDescriptorPool m_descriptorPool;
     VkFormat m_colorFormat;
 
     std::unordered_map<uint64_t, ImTextureID> m_textureIdMap;
-    
+
+    // Copy of the main viewport's draw data taken by EndFrame(), OnRender() may run on the render thread
+    // while the main thread already feeds ImGui the input of the next frame
+    ImDrawData m_drawData;
 
 };
 
@@ -0,0 +1,153 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/JobSystem.h>
+#include <Quark/Render/RenderScene.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+
+// Frustum culling test: scatters objects over a large world and compares the visibility from RenderScene's bvh
+// with testing every object, on a static scene and while a part of the objects moves every frame, on one thread
+// and on the JobSystem.
+// Usage: Culling_Test [object count]
+
+constexpr float WORLD_SIZE = 4000.f;
+constexpr uint32_t FRAME_COUNT = 20;
+constexpr float MOVING_FRACTION = 0.01f;
+
+static UniformBufferData_Camera CreateCamera()
+{
+	// looking over the world from one corner, sees about 5% of it
+	UniformBufferData_Camera camera;
+	camera.view = glm::lookAt(glm::vec3(0.f, 50.f, 0.f), glm::vec3(WORLD_SIZE, 0.f, WORLD_SIZE), glm::vec3(0.f, 1.f, 0.f));
+	camera.proj = glm::perspective(glm::radians(30.f), 16.f / 9.f, 0.1f, 1200.f);
+	camera.proj[1][1] *= -1;
+	camera.viewproj = camera.proj * camera.view;
+	return camera;
+}
+
+static glm::vec3 RandomPosition(mt19937& rng)
+{
+	uniform_real_distribution<float> xz(0.f, WORLD_SIZE);
+	uniform_real_distribution<float> y(0.f, 20.f);
+	return glm::vec3(xz(rng), y(rng), xz(rng));
+}
+
+// every object against every plane
+static vector<uint32_t> CullAll(const RenderScene& scene, const math::Frustum& frustum)
+{
+	vector<uint32_t> result(scene.render_objects.size());
+	result.resize(math::CullAabbs(frustum, scene.render_object_bounds, 0, (uint32_t)result.size(), result.data()));
+	return result;
+}
+
+static void VerifySameVisibility(const RenderScene& scene, const Visibility& vis)
+{
+	vector<uint32_t> expected = CullAll(scene, vis.frustum);
+	vector<uint32_t> visible = vis.main_camera_visible_object_indexes;
+	sort(visible.begin(), visible.end());
+	QK_CORE_VERIFY(visible == expected)
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+
+	uint32_t objectCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 1000000;
+	mt19937 rng(11);
+
+	RenderScene scene;
+	scene.render_objects.reserve(objectCount);
+	{
+		auto t = timer("Insert " + to_string(objectCount) + " objects");
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			RenderObject obj;
+			obj.id = RenderScene::GetRenderObjectID(i, 0);
+			obj.model_matrix = glm::translate(glm::mat4(1.f), RandomPosition(rng));
+			obj.aabb = math::Aabb(glm::vec3(-1.f), glm::vec3(1.f));
+			obj.render_mesh_id = 1;
+			obj.render_material_id = 1;
+			obj.start_index = 0;
+			obj.index_count = 36;
+			scene.AddOrUpdateRenderObject(obj, i);
+		}
+	}
+	QK_CORE_VERIFY(scene.bvh.Validate())
+	QK_CORE_VERIFY(scene.bvh.GetProxyCount() == objectCount)
+	cout << "Bvh height: " << scene.bvh.GetHeight() << endl;
+
+	UniformBufferData_Camera camera = CreateCamera();
+	Visibility& vis = scene.main_camera_visibility;
+
+	// the old path: every aabb transformed and tested as a sphere
+	{
+		math::Frustum frustum(glm::inverse(camera.viewproj));
+		uint32_t visible = 0;
+		auto t = timer("Linear culling");
+		for (const RenderObject& obj : scene.render_objects)
+			visible += frustum.CheckSphere(obj.aabb.Transform(obj.model_matrix)) ? 1 : 0;
+		cout << "Linear visible: " << visible << endl;
+	}
+
+	{
+		auto t = timer("Bvh culling");
+		scene.UpdateVisibility(vis, camera);
+	}
+	cout << "Bvh visible: " << vis.main_camera_visible_object_indexes.size() << " ("
+		<< 100.0 * vis.main_camera_visible_object_indexes.size() / objectCount << "%)" << endl;
+	VerifySameVisibility(scene, vis);
+
+	JobSystem jobSystem(4);
+	Visibility parallelVis;
+	scene.UpdateVisibility(parallelVis, camera, &jobSystem);
+	{
+		auto t = timer("Bvh culling on " + to_string(jobSystem.GetNumWorkerThreads()) + " worker threads");
+		scene.UpdateVisibility(parallelVis, camera, &jobSystem);
+	}
+	VerifySameVisibility(scene, parallelVis);
+
+	// a part of the objects moves at a steady speed
+	const uint32_t movingCount = (uint32_t)(objectCount * MOVING_FRACTION);
+	double updateMs = 0, cullMs = 0;
+	for (uint32_t frame = 0; frame < FRAME_COUNT; frame++)
+	{
+		auto start = chrono::high_resolution_clock::now();
+		for (uint32_t i = 0; i < movingCount; i++)
+		{
+			uint32_t entity = i * (objectCount / movingCount);
+			glm::vec3 position = glm::vec3(scene.render_objects[entity].model_matrix[3]);
+			position += glm::vec3(0.3f, 0.f, 0.1f);
+			scene.UpdateRenderObjectsTransform(entity, glm::translate(glm::mat4(1.f), position));
+		}
+		auto updated = chrono::high_resolution_clock::now();
+		scene.UpdateVisibility(vis, camera);
+		auto culled = chrono::high_resolution_clock::now();
+
+		updateMs += chrono::duration<double, milli>(updated - start).count();
+		cullMs += chrono::duration<double, milli>(culled - updated).count();
+	}
+	cout << "Moving " << movingCount << " objects per frame, average bvh update: " << updateMs / FRAME_COUNT
+		<< " ms, average culling: " << cullMs / FRAME_COUNT << " ms" << endl;
+	QK_CORE_VERIFY(scene.bvh.Validate())
+	VerifySameVisibility(scene, vis);
+	scene.UpdateVisibility(parallelVis, camera, &jobSystem);
+	VerifySameVisibility(scene, parallelVis);
+
+	// removals keep the offsets of the bvh leaves right
+	for (uint32_t i = 0; i < objectCount; i += objectCount / 100)
+		scene.DeleteRenderObjectsByEntityID(i);
+	QK_CORE_VERIFY(scene.bvh.Validate())
+	QK_CORE_VERIFY(scene.bvh.GetProxyCount() == scene.render_objects.size())
+	for (uint32_t i = 0; i < scene.render_objects.size(); i++)
+		QK_CORE_VERIFY(scene.bvh.GetUserData(scene.render_objects[i].bvh_proxy) == i)
+
+	scene.UpdateVisibility(vis, camera);
+	VerifySameVisibility(scene, vis);
+}
@@ -0,0 +1,279 @@
+#include <iostream>
+#include <string>
+#include <set>
+#include <tuple>
+#include <random>
+#include <unordered_map>
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/JobSystem.h>
+#include <Quark/Render/DrawList.h>
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+
+// Instanced batching test: a field of props made of a few meshes, sections and materials is grouped into a DrawList.
+// Checks that every batch holds exactly the objects of one (mesh, section, material) and compares the number of
+// draw calls and the CPU time against drawing every object on its own, and builds the same list on the JobSystem.
+// Also counts the state changes of the sort key order against the old order by asset ids, and checks that
+// transparent objects come last, back to front, and that the widest sort indexes keep their order.
+// Usage: DrawList_Test [prop count]
+
+constexpr uint32_t MESH_COUNT = 64;
+constexpr uint32_t SECTIONS_PER_MESH = 3;
+constexpr uint32_t MATERIAL_COUNT = 32;
+constexpr uint32_t PIPELINE_COUNT = 4;
+
+using BatchKey = tuple<uint64_t, uint64_t, uint32_t, uint32_t>;
+
+static BatchKey GetKey(const RenderObject& obj)
+{
+	return { obj.render_material_id, obj.render_mesh_id, obj.start_index, obj.index_count };
+}
+
+// asset ids are random uuids, the sort indexes are given in creation order like the RenderResourceManager does
+struct Assets
+{
+	vector<uint64_t> mesh_ids;
+	vector<uint64_t> material_ids;
+	unordered_map<uint64_t, uint32_t> material_pipelines;
+};
+
+static Assets CreateAssets(mt19937_64& rng)
+{
+	Assets assets;
+	for (uint32_t i = 0; i < MESH_COUNT; i++)
+		assets.mesh_ids.push_back(rng());
+	for (uint32_t i = 0; i < MATERIAL_COUNT; i++)
+	{
+		assets.material_ids.push_back(rng());
+		assets.material_pipelines[assets.material_ids.back()] = i % PIPELINE_COUNT;
+	}
+	return assets;
+}
+
+static vector<RenderObject> CreateProps(uint32_t propCount, const Assets& assets)
+{
+	mt19937 rng(7);
+	vector<RenderObject> objects;
+	objects.reserve(propCount * SECTIONS_PER_MESH);
+
+	for (uint32_t i = 0; i < propCount; i++)
+	{
+		uint32_t mesh = rng() % MESH_COUNT;
+		for (uint32_t section = 0; section < SECTIONS_PER_MESH; section++)
+		{
+			uint32_t material = (mesh + section) % MATERIAL_COUNT;
+
+			RenderObject& obj = objects.emplace_back();
+			obj.id = (uint64_t(i) << 32) | section;
+			obj.model_matrix = glm::mat4(1.f);
+			obj.model_matrix[3] = glm::vec4((float)i, (float)section, 0.f, 1.f);
+			obj.render_mesh_id = assets.mesh_ids[mesh];
+			obj.start_index = section * 300;
+			obj.index_count = 300;
+			obj.render_material_id = assets.material_ids[material];
+
+			obj.pipeline_index = (uint16_t)(material % PIPELINE_COUNT);
+			obj.material_sort_index = (uint16_t)material;
+			obj.mesh_sort_index = (uint16_t)mesh;
+			obj.section_index = (uint16_t)section;
+		}
+	}
+
+	return objects;
+}
+
+struct StateChanges
+{
+	uint32_t pipelines = 0;
+	uint32_t materials = 0;
+	uint32_t meshes = 0;
+};
+
+// rebinding the way RenderSystem::DrawScene() does, in the order of the batches
+static StateChanges CountStateChanges(const vector<DrawBatch>& batches, const Assets& assets)
+{
+	StateChanges changes;
+	uint32_t lastPipeline = ~0u;
+	uint64_t lastMaterial = 0, lastMesh = 0;
+	for (const DrawBatch& batch : batches)
+	{
+		uint32_t pipeline = assets.material_pipelines.at(batch.render_material_id);
+		changes.pipelines += pipeline != lastPipeline ? 1 : 0;
+		changes.materials += batch.render_material_id != lastMaterial ? 1 : 0;
+		changes.meshes += batch.render_mesh_id != lastMesh ? 1 : 0;
+		lastPipeline = pipeline;
+		lastMaterial = batch.render_material_id;
+		lastMesh = batch.render_mesh_id;
+	}
+	return changes;
+}
+
+static void PrintStateChanges(const string& name, const StateChanges& changes)
+{
+	cout << name << ": " << changes.pipelines << " pipeline, " << changes.materials << " material, " << changes.meshes << " mesh changes" << endl;
+}
+
+static void VerifyDrawList(const DrawList& drawList, const vector<RenderObject>& objects, const vector<uint32_t>& visible, const set<BatchKey>& keys)
+{
+	QK_CORE_VERIFY(drawList.batches.size() == keys.size())
+	QK_CORE_VERIFY(drawList.instances.size() == visible.size())
+
+	// batches are unique, contiguous and cover every instance once
+	set<BatchKey> batchKeys;
+	uint32_t nextInstance = 0;
+	for (const DrawBatch& batch : drawList.batches)
+	{
+		QK_CORE_VERIFY(batch.first_instance == nextInstance)
+		QK_CORE_VERIFY(batch.instance_count > 0)
+		nextInstance += batch.instance_count;
+
+		BatchKey key = { batch.render_material_id, batch.render_mesh_id, batch.start_index, batch.index_count };
+		QK_CORE_VERIFY(batchKeys.insert(key).second)
+	}
+	QK_CORE_VERIFY(nextInstance == drawList.instances.size())
+
+	// every visible object is an instance of the batch with its key, found back through its unique translation
+	for (uint32_t i : visible)
+	{
+		const RenderObject& obj = objects[i];
+		bool found = false;
+		for (const DrawBatch& batch : drawList.batches)
+		{
+			if (GetKey(obj) != BatchKey(batch.render_material_id, batch.render_mesh_id, batch.start_index, batch.index_count))
+				continue;
+
+			// the draw loop binds pipelines by the batch's index alone
+			QK_CORE_VERIFY(batch.pipeline_index == obj.pipeline_index)
+
+			for (uint32_t j = batch.first_instance; j < batch.first_instance + batch.instance_count && !found; j++)
+				found = drawList.instances[j].worldMatrix == obj.model_matrix;
+			break;
+		}
+		QK_CORE_VERIFY(found)
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+
+	uint32_t propCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 50000;
+	mt19937_64 rng(3);
+	Assets assets = CreateAssets(rng);
+	vector<RenderObject> objects = CreateProps(propCount, assets);
+	const glm::vec3 viewPosition(0.f, 10.f, -10.f);
+
+	// every other object is visible
+	vector<uint32_t> visible;
+	for (uint32_t i = 0; i < objects.size(); i += 2)
+		visible.push_back(i);
+
+	set<BatchKey> keys;
+	for (uint32_t i : visible)
+		keys.insert(GetKey(objects[i]));
+
+	DrawList drawList;
+	drawList.Build(objects, visible, viewPosition);
+	{
+		auto t = timer("Build draw list of " + to_string(visible.size()) + " objects");
+		drawList.Build(objects, visible, viewPosition);
+	}
+	VerifyDrawList(drawList, objects, visible, keys);
+
+	// sorted and batched in chunks, the batches come out the same
+	JobSystem jobSystem(4);
+	DrawList parallelDrawList;
+	parallelDrawList.Build(objects, visible, viewPosition, &jobSystem);
+	{
+		auto t = timer("Build draw list on " + to_string(jobSystem.GetNumWorkerThreads()) + " worker threads");
+		parallelDrawList.Build(objects, visible, viewPosition, &jobSystem);
+	}
+	VerifyDrawList(parallelDrawList, objects, visible, keys);
+	QK_CORE_VERIFY(parallelDrawList.batches.size() == drawList.batches.size())
+	for (size_t i = 0; i < drawList.batches.size(); i++)
+	{
+		QK_CORE_VERIFY(parallelDrawList.batches[i].first_instance == drawList.batches[i].first_instance)
+		QK_CORE_VERIFY(parallelDrawList.batches[i].instance_count == drawList.batches[i].instance_count)
+	}
+
+	cout << "Draw calls before: " << visible.size() << ", after: " << keys.size() << endl;
+
+	// the same batches in the old order, by asset ids
+	vector<DrawBatch> idOrder = drawList.batches;
+	sort(idOrder.begin(), idOrder.end(), [](const DrawBatch& a, const DrawBatch& b)
+	{
+		return tie(a.render_material_id, a.render_mesh_id, a.start_index, a.index_count) <
+			tie(b.render_material_id, b.render_mesh_id, b.start_index, b.index_count);
+	});
+	StateChanges before = CountStateChanges(idOrder, assets);
+	StateChanges after = CountStateChanges(drawList.batches, assets);
+	PrintStateChanges("Sorted by asset ids", before);
+	PrintStateChanges("Sorted by key", after);
+	QK_CORE_VERIFY(after.pipelines == PIPELINE_COUNT)
+	QK_CORE_VERIFY(after.pipelines <= before.pipelines && after.materials <= before.materials)
+
+	// a transparent material: drawn after every opaque object, the farthest first
+	const uint64_t glassMaterial = assets.material_ids[0];
+	vector<uint32_t> transparent;
+	for (uint32_t i : visible)
+	{
+		if (objects[i].render_material_id != glassMaterial)
+			continue;
+		objects[i].transparent = true;
+		transparent.push_back(i);
+	}
+	drawList.Build(objects, visible, viewPosition);
+
+	const size_t opaqueInstanceCount = visible.size() - transparent.size();
+	float lastDistance = numeric_limits<float>::max();
+	for (size_t i = 0; i < drawList.instances.size(); i++)
+	{
+		glm::vec3 position = glm::vec3(drawList.instances[i].worldMatrix[3]);
+		bool isTransparent = find_if(transparent.begin(), transparent.end(), [&](uint32_t index) { return objects[index].model_matrix[3] == glm::vec4(position, 1.f); }) != transparent.end();
+		QK_CORE_VERIFY(isTransparent == (i >= opaqueInstanceCount))
+		if (!isTransparent)
+			continue;
+
+		float distance = glm::length(position - viewPosition);
+		QK_CORE_VERIFY(distance <= lastDistance)
+		lastDistance = distance;
+	}
+
+	// the widest indexes the RenderResourceManager and the RenderSystem hand out keep their order and don't spill into the pass bits
+	for (bool transparent : { false, true })
+	{
+		RenderObject widest;
+		widest.transparent = transparent;
+		widest.pipeline_index = (1u << DRAW_SORT_PIPELINE_INDEX_BITS) - 1;
+		widest.material_sort_index = (1u << DRAW_SORT_MATERIAL_INDEX_BITS) - 1;
+		widest.mesh_sort_index = (1u << DRAW_SORT_MESH_INDEX_BITS) - 1;
+		widest.section_index = DRAW_SORT_SECTION_MAX_NUM - 1;
+		widest.lod = MESH_LOD_MAX_NUM - 1;
+		const uint64_t widestKey = DrawList::GetSortKey(widest, 1.f);
+		QK_CORE_VERIFY((widestKey >> 62) == (transparent ? 1u : 0u))
+
+		for (uint16_t RenderObject::* index : { &RenderObject::pipeline_index, &RenderObject::material_sort_index, &RenderObject::mesh_sort_index })
+		{
+			RenderObject below = widest;
+			below.*index -= 1;
+			QK_CORE_VERIFY(DrawList::GetSortKey(below, 1.f) < widestKey)
+		}
+
+		// only opaque objects sort by section and lod
+		if (!transparent)
+		{
+			RenderObject below = widest;
+			below.section_index -= 1;
+			QK_CORE_VERIFY(DrawList::GetSortKey(below, 1.f) < widestKey)
+			below = widest;
+			below.lod -= 1;
+			QK_CORE_VERIFY(DrawList::GetSortKey(below, 1.f) < widestKey)
+		}
+	}
+
+	// nothing visible, nothing drawn
+	drawList.Build(objects, {}, viewPosition);
+	QK_CORE_VERIFY(drawList.batches.empty() && drawList.instances.empty())
+}
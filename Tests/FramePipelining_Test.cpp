@@ -0,0 +1,246 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <cmath>
+#include <Quark/Core/Application.h>
+#include <Quark/Core/Logger.h>
+#include <Quark/Asset/AssetManager.h>
+#include <Quark/Scene/Scene.h>
+#include <Quark/Scene/Components/CommonCmpts.h>
+#include <Quark/Scene/Components/TransformCmpt.h>
+#include <Quark/Scene/Components/MeshCmpt.h>
+#include <Quark/Scene/Components/MeshRendererCmpt.h>
+#include <Quark/Render/RenderSystem.h>
+#include <Quark/RHI/Null/Device_Null.h>
+
+using namespace std;
+using namespace quark;
+
+// Headless benchmark of the logic/render frame pipelining, driven by Application on the Null device.
+// OnUpdate() animates a scene and fills the swap data like EditorApp::OnUpdate(), OnRender() is the real
+// RenderSystem::ProcessSwapData() and DrawScene(). The frames run serially, then pipelined on the render thread,
+// then switched between the two every few frames like the editor toggle does. Meshes keep being registered and
+// resolved through AssetManager on the logic side while the render side loads the ones it hasn't seen yet.
+// The run has to end with the render scene matching the scene.
+// Usage: FramePipelining_Test [entity count]
+
+constexpr uint32_t FRAME_COUNT = 120;      // per phase
+constexpr uint32_t PHASE_COUNT = 3;
+constexpr uint32_t SWITCH_INTERVAL = 16;
+constexpr uint32_t SPAWN_INTERVAL = 8;
+constexpr uint32_t SPAWN_COUNT = 64;
+constexpr uint32_t MESH_COUNT = 16;
+constexpr uint32_t SECTION_COUNT = 2;
+constexpr uint32_t VERTEX_COUNT = 256;
+constexpr uint32_t INDEX_COUNT = 3 * 256;
+constexpr uint32_t OCCLUDER_INTERVAL = 64;
+
+// points spread over the unit sphere, every section indexes all of them
+static Ref<MeshAsset> CreateMesh(uint32_t seed)
+{
+	auto mesh = CreateRef<MeshAsset>();
+	mesh->vertex_positions.resize(VERTEX_COUNT);
+	mesh->vertex_normals.resize(VERTEX_COUNT);
+	mesh->vertex_uvs.resize(VERTEX_COUNT);
+	for (uint32_t v = 0; v < VERTEX_COUNT; v++)
+	{
+		const float a = (v + seed) * 0.61803f * 6.2831f;
+		const float h = (float)v / (VERTEX_COUNT - 1) * 2.f - 1.f;
+		const float r = std::sqrt(1.f - h * h);
+		mesh->vertex_positions[v] = glm::vec3(r * std::cos(a), h, r * std::sin(a));
+		mesh->vertex_normals[v] = mesh->vertex_positions[v];
+		mesh->vertex_uvs[v] = glm::vec2(a, h);
+	}
+
+	mesh->indices.resize(SECTION_COUNT * INDEX_COUNT);
+	mesh->subMeshes.resize(SECTION_COUNT);
+	for (uint32_t section = 0; section < SECTION_COUNT; section++)
+	{
+		for (uint32_t i = 0; i < INDEX_COUNT; i++)
+			mesh->indices[section * INDEX_COUNT + i] = (i * 7 + section) % VERTEX_COUNT;
+
+		mesh->subMeshes[section].startIndex = section * INDEX_COUNT;
+		mesh->subMeshes[section].count = INDEX_COUNT;
+		mesh->subMeshes[section].aabb = { glm::vec3(-1.f), glm::vec3(1.f) };
+	}
+
+	return mesh;
+}
+
+class FramePipeliningApp : public Application {
+public:
+	FramePipeliningApp(const ApplicationSpecification& specs, uint32_t entityCount)
+		: Application(specs)
+	{
+		m_scene = CreateRef<Scene>("FramePipelining_Test");
+		m_scene->ReserveEntities(entityCount + FRAME_COUNT * PHASE_COUNT / SPAWN_INTERVAL * SPAWN_COUNT);
+		for (uint32_t i = 0; i < MESH_COUNT; i++)
+			m_meshes.push_back(RegisterMesh());
+		for (uint32_t i = 0; i < entityCount; i++)
+			SpawnEntity(m_meshes[i % MESH_COUNT]);
+
+		auto& resourceManager = RenderSystem::Get().GetRenderResourceManager();
+		rhi::ImageDesc imageDesc;
+		imageDesc.width = specs.width;
+		imageDesc.height = specs.height;
+		imageDesc.format = resourceManager.format_colorAttachment_main;
+		imageDesc.usageBits = rhi::IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		m_color = m_graphicDevice->CreateImage(imageDesc);
+		imageDesc.format = resourceManager.format_depthAttachment_main;
+		imageDesc.usageBits = rhi::IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		m_depth = m_graphicDevice->CreateImage(imageDesc);
+	}
+
+	void OnUpdate(TimeStep ts) override
+	{
+		if (m_frame % FRAME_COUNT == 0)
+			m_phaseStart[m_frame / FRAME_COUNT] = chrono::high_resolution_clock::now(); // the last one ends the run
+
+		if (m_frame == FRAME_COUNT * PHASE_COUNT)
+		{
+			OnWindowClose(WindowCloseEvent());
+			return;
+		}
+
+		// the way a streamed cell comes in: a new mesh is registered, resolved by id and instantiated
+		if (m_frame % SPAWN_INTERVAL == 0)
+		{
+			Ref<MeshAsset> mesh = AssetManager::Get().GetAsset<MeshAsset>(RegisterMesh()->GetAssetID());
+			QK_CORE_VERIFY(mesh)
+			for (uint32_t i = 0; i < SPAWN_COUNT; i++)
+				SpawnEntity(mesh);
+		}
+
+		uint32_t i = 0;
+		for (auto [transform_cmpt] : m_scene->GetComponents<TransformCmpt>())
+		{
+			if ((i++ + m_frame) % 4 == 0)
+			{
+				glm::vec3 position = transform_cmpt->GetLocalPosition();
+				transform_cmpt->SetLocalPosition(glm::vec3(position.x, std::sin(m_frame * 0.1f + i), position.z));
+			}
+		}
+		m_scene->OnUpdate();
+
+		RenderSwapData& swapData = RenderSystem::Get().GetSwapContext().GetLogicSwapData();
+		m_scene->FillMeshSwapData(swapData);
+		CameraSwapData camera;
+		camera.view = glm::lookAt(glm::vec3(128.f, 40.f, -40.f), glm::vec3(128.f, 0.f, 64.f), glm::vec3(0.f, 1.f, 0.f));
+		camera.proj = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 1000.f);
+		swapData.camera_swap_data = camera;
+
+		// takes effect before the next frame
+		m_frame++;
+		const uint32_t phase = m_frame / FRAME_COUNT;
+		SetFramePipelining(phase == 1 || (phase == 2 && (m_frame / SWITCH_INTERVAL) % 2 == 1));
+	}
+
+	void OnRender(TimeStep ts) override
+	{
+		auto& renderSystem = RenderSystem::Get();
+		auto renderScene = renderSystem.GetRenderScene();
+		renderSystem.ProcessSwapData();
+
+		if (m_graphicDevice->BeiginFrame(ts))
+		{
+			rhi::CommandList* cmd = m_graphicDevice->BeginCommandList();
+
+			rhi::FrameBufferInfo frameBufferInfo = {};
+			frameBufferInfo.colorAttachments[0] = m_color.get();
+			frameBufferInfo.depthAttachment = m_depth.get();
+			cmd->BeginRenderPass(renderSystem.GetRenderResourceManager().renderPassInfo_simpleMainPass, frameBufferInfo);
+			renderSystem.DrawScene(*renderScene, renderScene->main_camera_visibility, cmd);
+			cmd->EndRenderPass();
+
+			m_graphicDevice->SubmitCommandList(cmd);
+			m_graphicDevice->EndFrame(ts);
+			m_renderedFrames++;
+		}
+	}
+
+	// The render side ends with the scene's last published state
+	void Verify()
+	{
+		const auto& device = static_cast<const rhi::Device_Null&>(*m_graphicDevice);
+		QK_CORE_VERIFY(m_renderedFrames >= FRAME_COUNT * PHASE_COUNT)
+		QK_CORE_VERIFY(device.GetTotalStats().validationErrors == 0)
+
+		const RenderScene& renderScene = *RenderSystem::Get().GetRenderScene();
+		QK_CORE_VERIFY(renderScene.render_objects.size() == m_scene->GetEntities().size() * SECTION_COUNT)
+		for (const auto [id_cmpt, transform_cmpt] : m_scene->GetComponents<IdCmpt, TransformCmpt>())
+		{
+			for (uint32_t section = 0; section < SECTION_COUNT; section++)
+			{
+				const uint32_t* offset = renderScene.render_object_to_offset.find(RenderScene::GetRenderObjectID(id_cmpt->id, section));
+				QK_CORE_VERIFY(offset)
+				QK_CORE_VERIFY(renderScene.render_objects[*offset].model_matrix == transform_cmpt->GetWorldMatrix())
+			}
+		}
+	}
+
+	void PrintTimes()
+	{
+		const string names[PHASE_COUNT] = { "Serial frames", "Pipelined frames", "Switched every " + to_string(SWITCH_INTERVAL) + " frames" };
+		double ms[PHASE_COUNT];
+		for (uint32_t phase = 0; phase < PHASE_COUNT; phase++)
+		{
+			ms[phase] = chrono::duration<double, milli>(m_phaseStart[phase + 1] - m_phaseStart[phase]).count();
+			cout << names[phase] << ": " << ms[phase] << " milliseconds, " << (ms[phase] / FRAME_COUNT) << " milliseconds per frame" << endl;
+		}
+		cout << "Pipelined frame time: " << 100.0 * ms[1] / ms[0] << "% of serial" << endl;
+	}
+
+private:
+	Ref<MeshAsset> RegisterMesh()
+	{
+		Ref<MeshAsset> mesh = CreateMesh(m_meshCount++);
+		AssetManager::Get().AddMemoryOnlyAsset(mesh);
+		return mesh;
+	}
+
+	void SpawnEntity(const Ref<MeshAsset>& mesh)
+	{
+		const uint32_t i = m_entityCount++;
+		Entity* entity = m_scene->CreateEntity();
+		entity->GetComponent<TransformCmpt>()->SetLocalPosition(glm::vec3((float)(i % 256), 0.f, (float)(i / 256)));
+		entity->AddComponent<MeshCmpt>()->sharedMesh = mesh;
+		auto* meshRenderer = entity->AddComponent<MeshRendererCmpt>();
+		meshRenderer->SetMesh(mesh);
+		for (uint32_t section = 0; section < SECTION_COUNT; section++)
+			meshRenderer->SetMaterial(section, 0); // default material
+		meshRenderer->SetOccluder(i % OCCLUDER_INTERVAL == 0);
+	}
+
+	Ref<Scene> m_scene;
+	vector<Ref<MeshAsset>> m_meshes;
+	uint32_t m_meshCount = 0;
+	uint32_t m_entityCount = 0;
+
+	Ref<rhi::Image> m_color;
+	Ref<rhi::Image> m_depth;
+
+	uint32_t m_frame = 0;               // logic side
+	uint32_t m_renderedFrames = 0;      // render side
+	chrono::high_resolution_clock::time_point m_phaseStart[PHASE_COUNT + 1];
+};
+
+int main(int argc, char** argv)
+{
+	uint32_t entityCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 4000;
+
+	ApplicationSpecification specs;
+	specs.title = "FramePipelining_Test";
+	specs.workingDirectory = QUARK_ROOT_DIR; // built-in shaders and meshes
+	specs.headless = true;
+	specs.enableFramePipelining = false;
+
+	auto* app = new FramePipeliningApp(specs, entityCount);
+	cout << "Entities: " << entityCount << ", render objects: " << entityCount * SECTION_COUNT << endl;
+	cout << "Hardware threads: " << thread::hardware_concurrency() << ", the stages only overlap with more than one" << endl;
+
+	app->Run();
+	app->PrintTimes();
+	app->Verify();
+	delete app;
+}
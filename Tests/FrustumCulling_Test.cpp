@@ -0,0 +1,120 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <random>
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/Math/FrustumCulling.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace std;
+using namespace quark;
+
+// Checks the batched frustum culling kernels against Frustum::CheckSphere() and Frustum::CheckAabb()
+// and compares their throughput.
+// Usage: FrustumCulling_Test [object count]
+
+constexpr uint32_t REPEAT_COUNT = 10;
+
+static double MeasureMs(const function<void()>& func)
+{
+	auto start = chrono::high_resolution_clock::now();
+	for (uint32_t i = 0; i < REPEAT_COUNT; i++)
+		func();
+	auto end = chrono::high_resolution_clock::now();
+	return chrono::duration<double, milli>(end - start).count() / REPEAT_COUNT;
+}
+
+static void PrintThroughput(const string& name, double ms, uint32_t objectCount)
+{
+	cout << name << ": " << ms << " milliseconds, " << objectCount / ms << " objects per millisecond" << endl;
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+
+	uint32_t objectCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 1000000;
+	mt19937 rng(7);
+	uniform_real_distribution<float> position(-500.f, 500.f);
+	uniform_real_distribution<float> size(0.1f, 10.f);
+
+	vector<math::Aabb> aabbs;
+	math::BoundsSoA bounds;
+	aabbs.reserve(objectCount);
+	bounds.Reserve(objectCount);
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		glm::vec3 center(position(rng), position(rng), position(rng));
+		glm::vec3 extents(size(rng), size(rng), size(rng));
+		aabbs.emplace_back(center - extents, center + extents);
+		bounds.PushBack(aabbs.back());
+	}
+
+	glm::mat4 view = glm::lookAt(glm::vec3(0.f), glm::vec3(1.f, 0.2f, 1.f), glm::vec3(0.f, 1.f, 0.f));
+	glm::mat4 proj = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 400.f);
+	math::Frustum frustum(glm::inverse(proj * view));
+
+	// exactness
+	vector<uint32_t> expectedSpheres, expectedAabbs;
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		if (frustum.CheckSphere(aabbs[i]))
+			expectedSpheres.push_back(i);
+		if (frustum.CheckAabb(aabbs[i]) != math::Frustum::Intersection::OUTSIDE)
+			expectedAabbs.push_back(i);
+	}
+	cout << "Visible spheres: " << expectedSpheres.size() << ", visible aabbs: " << expectedAabbs.size() << endl;
+
+	vector<uint32_t> out(objectCount);
+	out.resize(math::CullSpheres(frustum, bounds, 0, objectCount, out.data()));
+	QK_CORE_VERIFY(out == expectedSpheres)
+
+	out.resize(objectCount);
+	out.resize(math::CullAabbs(frustum, bounds, 0, objectCount, out.data()));
+	QK_CORE_VERIFY(out == expectedAabbs)
+
+	// a range that doesn't start or end on a batch
+	const uint32_t begin = 3, end = objectCount - 5;
+	out.resize(objectCount);
+	out.resize(math::CullAabbs(frustum, bounds, begin, end, out.data()));
+	vector<uint32_t> expectedRange;
+	for (uint32_t i : expectedAabbs)
+		if (i >= begin && i < end)
+			expectedRange.push_back(i);
+	QK_CORE_VERIFY(out == expectedRange)
+
+	// every other object through the index list, culled in place
+	vector<uint32_t> indexes, expectedIndexed;
+	for (uint32_t i = 0; i < objectCount; i += 2)
+		indexes.push_back(i);
+	for (uint32_t i : expectedAabbs)
+		if (i % 2 == 0)
+			expectedIndexed.push_back(i);
+	indexes.resize(math::CullIndexedAabbs(frustum, bounds, indexes.data(), (uint32_t)indexes.size(), indexes.data()));
+	QK_CORE_VERIFY(indexes == expectedIndexed)
+
+	// throughput
+	uint32_t visible = 0;
+	PrintThroughput("Scalar spheres", MeasureMs([&]()
+	{
+		visible = 0;
+		for (const math::Aabb& aabb : aabbs)
+			visible += frustum.CheckSphere(aabb) ? 1 : 0;
+	}), objectCount);
+	QK_CORE_VERIFY(visible == expectedSpheres.size())
+
+	PrintThroughput("Scalar aabbs", MeasureMs([&]()
+	{
+		visible = 0;
+		for (const math::Aabb& aabb : aabbs)
+			visible += frustum.CheckAabb(aabb) != math::Frustum::Intersection::OUTSIDE ? 1 : 0;
+	}), objectCount);
+	QK_CORE_VERIFY(visible == expectedAabbs.size())
+
+	out.resize(objectCount);
+	PrintThroughput("Batched spheres", MeasureMs([&]() { visible = math::CullSpheres(frustum, bounds, 0, objectCount, out.data()); }), objectCount);
+	QK_CORE_VERIFY(visible == expectedSpheres.size())
+
+	PrintThroughput("Batched aabbs", MeasureMs([&]() { visible = math::CullAabbs(frustum, bounds, 0, objectCount, out.data()); }), objectCount);
+	QK_CORE_VERIFY(visible == expectedAabbs.size())
+}
@@ -5,6 +5,7 @@
 #include <Quark/Core/JobSystem.h>
 #include <Quark/RHI/Vulkan/Device_Vulkan.h>
 #include <Quark/Asset/GLTFImporter.h>
+#include "TestTimer.h"
 
 using namespace std;
 using namespace quark;
@@ -22,19 +23,6 @@ void Spin(float milliseconds)
 	}
 }
 
-struct timer
-{
-	string name;
-	chrono::high_resolution_clock::time_point start;
-
-	timer(const string& name) : name(name), start(chrono::high_resolution_clock::now()) {}
-	~timer()
-	{
-		auto end = chrono::high_resolution_clock::now();
-		cout << name << ": " << chrono::duration_cast<chrono::milliseconds>(end - start).count() << " milliseconds" << endl;
-	}
-};
-
 int main()
 {
 	Logger::Init();
@@ -0,0 +1,177 @@
+#include <iostream>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/JobSystem.h>
+#include <Quark/Render/LightClusters.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+
+// Light cluster test: bins random point and spot lights against a camera's clusters, checks the lists against the cluster
+// boxes and against the lights that reach random points in the view, and times the binning on one thread and on the JobSystem.
+// Usage: LightClusters_Test [light count]
+
+constexpr float WORLD_SIZE = 400.f;
+constexpr uint32_t FRAME_COUNT = 20;
+constexpr uint32_t SAMPLE_COUNT = 20000;
+
+static UniformBufferData_Camera CreateCamera()
+{
+	UniformBufferData_Camera camera;
+	camera.view = glm::lookAt(glm::vec3(0.f, 20.f, 0.f), glm::vec3(WORLD_SIZE, 0.f, WORLD_SIZE), glm::vec3(0.f, 1.f, 0.f));
+	camera.proj = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 1000.f);
+	camera.proj[1][1] *= -1;
+	camera.viewproj = camera.proj * camera.view;
+	return camera;
+}
+
+static StorageBufferData_Light PointLight(const glm::vec3& position, float range)
+{
+	StorageBufferData_Light light;
+	light.position_range = glm::vec4(position, range);
+	return light;
+}
+
+// every cluster lists, in light order, only lights whose sphere touches its box, and a point anywhere in the view is
+// lit by no light missing from the list of its cluster
+static void VerifyClusters(const LightClusters& clusters, const vector<StorageBufferData_Light>& lights, const UniformBufferData_Camera& camera)
+{
+	const glm::uvec4 grid = clusters.GetUniformData().grid_size;
+	QK_CORE_VERIFY(grid.w == lights.size())
+
+	vector<glm::vec4> spheres;
+	for (const StorageBufferData_Light& light : lights)
+	{
+		const glm::vec4 sphere = LightClusters::GetBoundingSphere(light);
+		spheres.push_back(glm::vec4(glm::vec3(camera.view * glm::vec4(glm::vec3(sphere), 1.f)), sphere.w));
+	}
+
+	const vector<glm::uvec2>& ranges = clusters.GetClusterRanges();
+	const vector<uint32_t>& indexes = clusters.GetLightIndexes();
+	for (uint32_t slice = 0; slice < grid.z; slice++)
+	{
+		for (uint32_t y = 0; y < grid.y; y++)
+		{
+			for (uint32_t x = 0; x < grid.x; x++)
+			{
+				const math::Aabb bounds = clusters.GetClusterBounds(x, y, slice);
+				const glm::uvec2 range = ranges[clusters.GetClusterIndex(x, y, slice)];
+				QK_CORE_VERIFY(range.x + range.y <= indexes.size())
+				for (uint32_t i = range.x; i < range.x + range.y; i++)
+				{
+					QK_CORE_VERIFY(i == range.x || indexes[i - 1] < indexes[i])
+					const glm::vec3 center = glm::vec3(spheres[indexes[i]]);
+					const glm::vec3 d = center - glm::clamp(center, bounds.Min(), bounds.Max());
+					QK_CORE_VERIFY(glm::dot(d, d) <= spheres[indexes[i]].w * spheres[indexes[i]].w)
+				}
+			}
+		}
+	}
+
+	const float z_near = clusters.GetUniformData().depth_params.z;
+	const float z_far = clusters.GetUniformData().depth_params.w;
+	mt19937 rng(3);
+	uniform_real_distribution<float> ndc(-1.f, 1.f);
+	uniform_real_distribution<float> depth_t(0.f, 1.f);
+	for (uint32_t sample = 0; sample < SAMPLE_COUNT; sample++)
+	{
+		const glm::vec2 n(ndc(rng), ndc(rng));
+		const float depth = z_near * pow(z_far / z_near, depth_t(rng));
+		const glm::vec3 p(depth * (n.x + camera.proj[2][0]) / camera.proj[0][0], depth * (n.y + camera.proj[2][1]) / camera.proj[1][1], -depth);
+
+		const uint32_t x = min((uint32_t)((n.x * 0.5f + 0.5f) * grid.x), grid.x - 1);
+		const uint32_t y = min((uint32_t)((n.y * 0.5f + 0.5f) * grid.y), grid.y - 1);
+		const glm::uvec2 range = ranges[clusters.GetClusterIndex(x, y, clusters.GetSlice(depth))];
+		for (uint32_t i = 0; i < (uint32_t)spheres.size(); i++)
+		{
+			if (glm::length(p - glm::vec3(spheres[i])) > spheres[i].w)
+				continue;
+			QK_CORE_VERIFY(binary_search(indexes.begin() + range.x, indexes.begin() + range.x + range.y, i))
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+
+	const UniformBufferData_Camera camera = CreateCamera();
+
+	// a small light right in front of the camera lands in the center tiles, one behind it nowhere
+	{
+		LightClusters clusters;
+		const glm::vec3 forward = glm::normalize(glm::vec3(WORLD_SIZE, -20.f, WORLD_SIZE));
+		vector<StorageBufferData_Light> lights = { PointLight(glm::vec3(0.f, 20.f, 0.f) + forward * 30.f, 0.5f), PointLight(glm::vec3(0.f, 20.f, 0.f) - forward * 30.f, 5.f) };
+		clusters.Build(lights, camera);
+		VerifyClusters(clusters, lights, camera);
+
+		const uint32_t slice = clusters.GetSlice(30.f);
+		const glm::uvec2 center = clusters.GetClusterRanges()[clusters.GetClusterIndex(8, 4, slice)];
+		QK_CORE_VERIFY(center.y == 1 && clusters.GetLightIndexes()[center.x] == 0)
+		QK_CORE_VERIFY(clusters.GetLightIndexes().size() < 16)
+		for (uint32_t index : clusters.GetLightIndexes())
+			QK_CORE_VERIFY(index == 0)
+	}
+
+	// the sphere of a spot light holds its apex and the rim of its cap
+	for (float angle : { 10.f, 30.f, 45.f, 60.f, 80.f })
+	{
+		StorageBufferData_Light spot = PointLight(glm::vec3(1.f, 2.f, 3.f), 10.f);
+		const glm::vec3 direction = glm::normalize(glm::vec3(1.f, -1.f, 0.5f));
+		spot.direction_spot_cos = glm::vec4(direction, cos(glm::radians(angle)));
+
+		const glm::vec4 sphere = LightClusters::GetBoundingSphere(spot);
+		QK_CORE_VERIFY(sphere.w <= 10.f + 1e-4f)
+		const glm::vec3 side = glm::normalize(glm::cross(direction, glm::vec3(0.f, 1.f, 0.f)));
+		const glm::vec3 rim = glm::vec3(1.f, 2.f, 3.f) + (direction * cos(glm::radians(angle)) + side * sin(glm::radians(angle))) * 10.f;
+		QK_CORE_VERIFY(glm::length(glm::vec3(1.f, 2.f, 3.f) - glm::vec3(sphere)) <= sphere.w + 1e-4f)
+		QK_CORE_VERIFY(glm::length(rim - glm::vec3(sphere)) <= sphere.w + 1e-4f)
+		QK_CORE_VERIFY(glm::length(glm::vec3(1.f, 2.f, 3.f) + direction * 10.f - glm::vec3(sphere)) <= sphere.w + 1e-4f)
+	}
+
+	uint32_t lightCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 4096;
+	mt19937 rng(7);
+	uniform_real_distribution<float> xz(-50.f, WORLD_SIZE);
+	uniform_real_distribution<float> y(0.f, 30.f);
+	uniform_real_distribution<float> range(1.f, 20.f);
+	uniform_real_distribution<float> unit(-1.f, 1.f);
+
+	vector<StorageBufferData_Light> lights;
+	for (uint32_t i = 0; i < lightCount; i++)
+	{
+		StorageBufferData_Light light = PointLight(glm::vec3(xz(rng), y(rng), xz(rng)), range(rng));
+		if (i % 3 == 0)
+			light.direction_spot_cos = glm::vec4(glm::normalize(glm::vec3(unit(rng), -1.f, unit(rng))), 0.5f + 0.5f * (unit(rng) * 0.5f + 0.5f));
+		lights.push_back(light);
+	}
+
+	LightClusters clusters;
+	clusters.Build(lights, camera);
+	VerifyClusters(clusters, lights, camera);
+	cout << lightCount << " lights, " << clusters.GetClusterCount() << " clusters, " << clusters.GetLightIndexes().size() << " light indexes" << endl;
+
+	{
+		auto t = timer("Binning on one thread");
+		for (uint32_t frame = 0; frame < FRAME_COUNT; frame++)
+			clusters.Build(lights, camera);
+	}
+
+	JobSystem jobSystem(4);
+	LightClusters parallelClusters;
+	{
+		auto t = timer("Binning on " + to_string(jobSystem.GetNumWorkerThreads()) + " worker threads");
+		for (uint32_t frame = 0; frame < FRAME_COUNT; frame++)
+			parallelClusters.Build(lights, camera, &jobSystem);
+	}
+	QK_CORE_VERIFY(parallelClusters.GetClusterRanges() == clusters.GetClusterRanges())
+	QK_CORE_VERIFY(parallelClusters.GetLightIndexes() == clusters.GetLightIndexes())
+
+	// fewer lights than last frame leave nothing behind
+	lights.resize(lightCount / 2);
+	parallelClusters.Build(lights, camera, &jobSystem);
+	VerifyClusters(parallelClusters, lights, camera);
+}
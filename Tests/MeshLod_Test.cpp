@@ -0,0 +1,162 @@
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/JobSystem.h>
+#include <Quark/Render/RenderScene.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+
+// Lod selection test: checks the hysteresis of RenderScene::SelectLod() at a threshold, then walks a camera away from
+// a field of props and compares the lods picked serially and on the JobSystem, printing the triangle counts.
+// Usage: MeshLod_Test [prop count]
+
+constexpr uint32_t LOD_COUNT = 3;
+constexpr uint32_t LOD0_INDEX_COUNT = 3000;
+constexpr float LOD_SCREEN_SIZES[LOD_COUNT] = { 0.f, 0.1f, 0.02f };
+
+static RenderObject CreateProp(uint32_t i, const glm::vec3& position)
+{
+	RenderObject obj;
+	obj.id = i;
+	obj.model_matrix = glm::translate(glm::mat4(1.f), position);
+	obj.render_mesh_id = 1;
+	obj.render_material_id = 2;
+	obj.aabb = math::Aabb(glm::vec3(-1.f), glm::vec3(1.f));
+
+	// every level has a fifth of the triangles of the previous one, stored after it in the index buffer
+	uint32_t start_index = 0;
+	uint32_t index_count = LOD0_INDEX_COUNT;
+	obj.lod_count = LOD_COUNT;
+	for (uint32_t lod = 0; lod < LOD_COUNT; lod++)
+	{
+		obj.lods[lod] = { start_index, index_count, LOD_SCREEN_SIZES[lod] };
+		start_index += index_count;
+		index_count /= 5;
+	}
+
+	obj.start_index = obj.lods[0].start_index;
+	obj.index_count = obj.lods[0].index_count;
+	return obj;
+}
+
+static UniformBufferData_Camera CreateCamera(float distance)
+{
+	UniformBufferData_Camera camera;
+	camera.view = glm::lookAt(glm::vec3(0.f, 0.f, distance), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+	camera.proj = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 10000.f);
+	camera.proj[1][1] *= -1;
+	camera.viewproj = camera.proj * camera.view;
+	return camera;
+}
+
+static uint64_t CountTriangles(const RenderScene& scene, const Visibility& vis)
+{
+	uint64_t triangles = 0;
+	for (uint32_t i : vis.main_camera_visible_object_indexes)
+		triangles += scene.render_objects[i].index_count / 3;
+	return triangles;
+}
+
+static void TestHysteresis()
+{
+	RenderObject obj = CreateProp(0, glm::vec3(0.f));
+	const float threshold = LOD_SCREEN_SIZES[1];
+
+	// far above and far below the thresholds
+	QK_CORE_VERIFY(RenderScene::SelectLod(obj, 1.f, 0.1f) == 0)
+	QK_CORE_VERIFY(RenderScene::SelectLod(obj, 0.001f, 0.1f) == 2)
+
+	// jitter around the threshold: without hysteresis every frame switches, with it only the first one does
+	uint32_t switches[2] = {};
+	const float hysteresis[2] = { 0.f, 0.1f };
+	for (uint32_t h = 0; h < 2; h++)
+	{
+		obj.lod = 0;
+		for (uint32_t frame = 0; frame < 100; frame++)
+		{
+			float screen_size = threshold * (frame % 2 ? 1.03f : 0.97f);
+			uint32_t lod = RenderScene::SelectLod(obj, screen_size, hysteresis[h]);
+			switches[h] += lod != obj.lod ? 1 : 0;
+			obj.lod = lod;
+		}
+	}
+	QK_CORE_VERIFY(switches[0] == 100)
+	QK_CORE_VERIFY(switches[1] == 1)
+
+	// a clear step back up still goes finer
+	obj.lod = 1;
+	QK_CORE_VERIFY(RenderScene::SelectLod(obj, threshold * 1.2f, 0.1f) == 0)
+
+	// a single object never goes past its chain
+	RenderObject single = obj;
+	single.lod_count = 1;
+	single.lod = 0;
+	QK_CORE_VERIFY(RenderScene::SelectLod(single, 0.f, 0.1f) == 0)
+
+	// the size halves when the distance doubles
+	float near_size = RenderScene::GetScreenSize(glm::vec3(0.f), 1.f, glm::vec3(0.f, 0.f, 50.f), 1.f);
+	float far_size = RenderScene::GetScreenSize(glm::vec3(0.f), 1.f, glm::vec3(0.f, 0.f, 100.f), 1.f);
+	QK_CORE_VERIFY(std::abs(near_size - 2.f * far_size) < 1e-5f)
+	QK_CORE_VERIFY(RenderScene::GetScreenSize(glm::vec3(0.f), 1.f, glm::vec3(0.f), 1.f) >= 1.f)
+
+	cout << "Lod switches at a jittering threshold, without hysteresis: " << switches[0] << ", with: " << switches[1] << endl;
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+	TestHysteresis();
+
+	uint32_t propCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 50000;
+
+	// a block of props in front of the camera, going away from it
+	RenderScene serialScene, parallelScene;
+	for (uint32_t i = 0; i < propCount; i++)
+	{
+		RenderObject obj = CreateProp(i, glm::vec3((float)(i % 100) - 50.f, (float)(i / 100 % 20) - 10.f, -(float)(i / 2000) * 10.f));
+		serialScene.AddOrUpdateRenderObject(obj, i);
+		parallelScene.AddOrUpdateRenderObject(obj, i);
+	}
+
+	JobSystem jobSystem;
+	const float distances[] = { 20.f, 100.f, 1600.f };
+	for (float distance : distances)
+	{
+		UniformBufferData_Camera camera = CreateCamera(distance);
+		serialScene.UpdateVisibility(serialScene.main_camera_visibility, camera);
+		parallelScene.UpdateVisibility(parallelScene.main_camera_visibility, camera);
+		QK_CORE_VERIFY(!serialScene.main_camera_visibility.main_camera_visible_object_indexes.empty())
+
+		{
+			auto t = timer("Serial lod selection at " + to_string((int)distance));
+			serialScene.UpdateLods(serialScene.main_camera_visibility);
+		}
+		{
+			auto t = timer("Parallel lod selection at " + to_string((int)distance));
+			parallelScene.UpdateLods(parallelScene.main_camera_visibility, &jobSystem);
+		}
+
+		const Visibility& vis = serialScene.main_camera_visibility;
+		uint32_t lodHistogram[LOD_COUNT] = {};
+		for (uint32_t i : vis.main_camera_visible_object_indexes)
+		{
+			const RenderObject& a = serialScene.render_objects[i];
+			const RenderObject& b = parallelScene.render_objects[i];
+			QK_CORE_VERIFY(a.lod == b.lod && a.start_index == b.start_index && a.index_count == b.index_count)
+			QK_CORE_VERIFY(a.index_count == a.lods[a.lod].index_count)
+			lodHistogram[a.lod]++;
+		}
+
+		uint64_t fullTriangles = (uint64_t)vis.main_camera_visible_object_indexes.size() * (LOD0_INDEX_COUNT / 3);
+		cout << "Distance " << distance << ": lod0 " << lodHistogram[0] << ", lod1 " << lodHistogram[1] << ", lod2 " << lodHistogram[2]
+			<< ", triangles " << CountTriangles(serialScene, vis) << " of " << fullTriangles << endl;
+	}
+
+	// everything is coarse far away
+	const RenderObject& farthest = serialScene.render_objects.back();
+	QK_CORE_VERIFY(farthest.lod == LOD_COUNT - 1)
+}
@@ -0,0 +1,165 @@
+#include <iostream>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/JobSystem.h>
+#include <Quark/Render/RenderScene.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+
+// Multi-view culling test: culls a large world against the main camera, the cascades of a directional light and the
+// cube faces of a few point lights in one walk of the bvh, checks every view against testing every object, and compares
+// the time with culling the views one by one, on one thread and on the JobSystem.
+// Usage: MultiViewCulling_Test [object count]
+
+constexpr float WORLD_SIZE = 4000.f;
+constexpr uint32_t CASCADE_COUNT = 4;
+constexpr uint32_t POINT_LIGHT_COUNT = 4;
+constexpr uint32_t FRAME_COUNT = 10;
+
+// the main camera and the views of the lights around it
+static vector<glm::mat4> CreateViews()
+{
+	vector<glm::mat4> viewprojs;
+
+	const glm::vec3 eye(200.f, 50.f, 200.f);
+	const glm::mat4 view = glm::lookAt(eye, glm::vec3(WORLD_SIZE, 0.f, WORLD_SIZE), glm::vec3(0.f, 1.f, 0.f));
+	viewprojs.push_back(glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 1000.f) * view);
+
+	// cascades of growing size along the camera, seen from a sun above
+	const glm::vec3 forward = glm::normalize(glm::vec3(1.f, 0.f, 1.f));
+	float cascade_end = 50.f;
+	for (uint32_t i = 0; i < CASCADE_COUNT; i++, cascade_end *= 3.f)
+	{
+		const glm::vec3 center = eye + forward * cascade_end * 0.5f;
+		const glm::mat4 light_view = glm::lookAt(center + glm::vec3(0.f, 500.f, 100.f), center, glm::vec3(0.f, 1.f, 0.f));
+		const float half_size = cascade_end * 0.6f;
+		viewprojs.push_back(glm::ortho(-half_size, half_size, -half_size, half_size, 1.f, 1000.f) * light_view);
+	}
+
+	for (uint32_t i = 0; i < POINT_LIGHT_COUNT; i++)
+	{
+		const glm::vec3 position = eye + forward * (100.f + 80.f * i) + glm::vec3(0.f, -40.f, 0.f);
+		for (uint32_t face = 0; face < 6; face++)
+			viewprojs.push_back(RenderScene::GetPointLightFaceViewProj(position, 60.f, face));
+	}
+	return viewprojs;
+}
+
+static void VerifyViews(const RenderScene& scene, const vector<math::Frustum>& frusta, const vector<vector<uint32_t>>& lists)
+{
+	for (size_t view = 0; view < frusta.size(); view++)
+	{
+		vector<uint32_t> expected(scene.render_objects.size());
+		expected.resize(math::CullAabbs(frusta[view], scene.render_object_bounds, 0, (uint32_t)expected.size(), expected.data()));
+
+		vector<uint32_t> visible = lists[view];
+		sort(visible.begin(), visible.end());
+		QK_CORE_VERIFY(visible == expected)
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+
+	uint32_t objectCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 1000000;
+	mt19937 rng(13);
+	uniform_real_distribution<float> xz(0.f, WORLD_SIZE);
+	uniform_real_distribution<float> y(0.f, 20.f);
+
+	RenderScene scene;
+	scene.render_objects.reserve(objectCount);
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		RenderObject obj;
+		obj.id = RenderScene::GetRenderObjectID(i, 0);
+		obj.model_matrix = glm::translate(glm::mat4(1.f), glm::vec3(xz(rng), y(rng), xz(rng)));
+		obj.aabb = math::Aabb(glm::vec3(-1.f), glm::vec3(1.f));
+		scene.AddOrUpdateRenderObject(obj, i);
+	}
+
+	const vector<glm::mat4> viewprojs = CreateViews();
+	vector<math::Frustum> frusta;
+	for (const glm::mat4& viewproj : viewprojs)
+		frusta.emplace_back(glm::inverse(viewproj));
+	const uint32_t viewCount = (uint32_t)frusta.size();
+
+	vector<vector<uint32_t>> lists(viewCount);
+	scene.CullViews(frusta.data(), viewCount, lists.data());
+	VerifyViews(scene, frusta, lists);
+
+	size_t visibleCount = 0;
+	for (const vector<uint32_t>& list : lists)
+		visibleCount += list.size();
+	cout << objectCount << " objects, " << viewCount << " views, " << visibleCount << " visible in total" << endl;
+
+	{
+		auto t = timer("Views one by one");
+		for (uint32_t frame = 0; frame < FRAME_COUNT; frame++)
+		{
+			for (uint32_t view = 0; view < viewCount; view++)
+				scene.CullViews(&frusta[view], 1, &lists[view]);
+		}
+	}
+	VerifyViews(scene, frusta, lists);
+
+	{
+		auto t = timer("Views in one walk");
+		for (uint32_t frame = 0; frame < FRAME_COUNT; frame++)
+			scene.CullViews(frusta.data(), viewCount, lists.data());
+	}
+	VerifyViews(scene, frusta, lists);
+
+	JobSystem jobSystem(4);
+	vector<vector<uint32_t>> parallelLists(viewCount);
+	{
+		auto t = timer("Views in one walk on " + to_string(jobSystem.GetNumWorkerThreads()) + " worker threads");
+		for (uint32_t frame = 0; frame < FRAME_COUNT; frame++)
+			scene.CullViews(frusta.data(), viewCount, parallelLists.data(), &jobSystem);
+	}
+	VerifyViews(scene, frusta, parallelLists);
+
+	// more views than fit in one walk are culled in groups
+	vector<math::Frustum> manyFrusta;
+	for (uint32_t i = 0; i < 3; i++)
+		manyFrusta.insert(manyFrusta.end(), frusta.begin(), frusta.end());
+	vector<vector<uint32_t>> manyLists(manyFrusta.size());
+	scene.CullViews(manyFrusta.data(), (uint32_t)manyFrusta.size(), manyLists.data(), &jobSystem);
+	VerifyViews(scene, manyFrusta, manyLists);
+
+	// the light helpers fill the visibility's lists
+	Visibility& vis = scene.main_camera_visibility;
+	scene.UpdateDirectionalLightVisibility(vis, &viewprojs[1], CASCADE_COUNT);
+	QK_CORE_VERIFY(vis.directional_light_visible_object_indexes.size() == CASCADE_COUNT)
+	for (uint32_t i = 0; i < CASCADE_COUNT; i++)
+		QK_CORE_VERIFY(vis.directional_light_visible_object_indexes[i].size() == lists[1 + i].size())
+
+	const glm::vec3 lightPosition(400.f, 10.f, 400.f);
+	const float lightRange = 60.f;
+	scene.UpdatePointLightVisibility(vis, &lightPosition, &lightRange, 1);
+	QK_CORE_VERIFY(vis.point_lights_visible_object_indexes.size() == 6)
+
+	// every object in the light's range shows up in at least one face
+	size_t inRange = 0, inFaces = 0;
+	vector<bool> seen(scene.render_objects.size(), false);
+	for (const vector<uint32_t>& face : vis.point_lights_visible_object_indexes)
+	{
+		for (uint32_t index : face)
+			seen[index] = true;
+	}
+	for (uint32_t i = 0; i < scene.render_objects.size(); i++)
+	{
+		const glm::vec3 position = glm::vec3(scene.render_objects[i].model_matrix[3]);
+		if (glm::length(position - lightPosition) < lightRange * 0.5f)
+		{
+			inRange++;
+			inFaces += seen[i] ? 1 : 0;
+		}
+	}
+	QK_CORE_VERIFY(inRange > 0 && inFaces == inRange)
+}
@@ -0,0 +1,727 @@
+#include <iostream>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <tuple>
+#include <cstring>
+#include <unordered_map>
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/JobSystem.h>
+#include <Quark/RHI/Null/Device_Null.h>
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+using namespace quark::rhi;
+
+// Null device test: records a scene of draws the way RenderSystem::DrawScene() does, on a device without a GPU.
+// Compares the state changes and the CPU time of draws in sort key order against draws in submission order,
+// and of pipelines picked by their index against pipelines looked up by a hash of their state,
+// checks that misuse is caught, that a recorded stream replays to the same commands and stats, and that command
+// lists can be recorded on several threads at once, and that per frame data is aligned and lives as long as its frame.
+// Counts the descriptor sets flushed with materials binding their textures against materials indexing bindless ones,
+// and how the device's descriptor set cache finds the flushed sets frame to frame.
+// Usage: NullDevice_Test [draw count]
+
+constexpr uint32_t MESH_COUNT = 256;
+constexpr uint32_t MATERIAL_COUNT = 64;
+constexpr uint32_t PIPELINE_COUNT = 8;
+constexpr uint32_t INDEX_COUNT = 3 * 512;
+
+struct SceneDraw
+{
+	uint32_t pipeline;
+	uint32_t material;
+	uint32_t mesh;
+};
+
+struct Scene
+{
+	Ref<Buffer> ubo;
+	Ref<Buffer> ssbo;
+	Ref<Buffer> positions[MESH_COUNT];
+	Ref<Buffer> indexes[MESH_COUNT];
+	Ref<Image> textures[MATERIAL_COUNT];
+	Ref<Sampler> sampler;
+	Ref<PipeLine> pipelines[PIPELINE_COUNT];
+	Ref<Image> color;
+	Ref<Image> depth;
+	RenderPassInfo2 renderPassInfo;
+};
+
+static Scene CreateScene(Device& device)
+{
+	Scene scene;
+
+	BufferDesc desc;
+	desc.domain = BufferMemoryDomain::CPU;
+	desc.size = 1024;
+	desc.usageBits = BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+	scene.ubo = device.CreateBuffer(desc);
+	desc.size = 1 << 20;
+	desc.usageBits = BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	scene.ssbo = device.CreateBuffer(desc);
+
+	desc.domain = BufferMemoryDomain::GPU;
+	for (uint32_t i = 0; i < MESH_COUNT; i++)
+	{
+		desc.size = 4096;
+		desc.usageBits = BUFFER_USAGE_VERTEX_BUFFER_BIT;
+		scene.positions[i] = device.CreateBuffer(desc);
+		desc.size = INDEX_COUNT * sizeof(uint32_t);
+		desc.usageBits = BUFFER_USAGE_INDEX_BUFFER_BIT;
+		scene.indexes[i] = device.CreateBuffer(desc);
+	}
+
+	ImageDesc imageDesc;
+	imageDesc.width = 64;
+	imageDesc.height = 64;
+	imageDesc.usageBits = IMAGE_USAGE_SAMPLING_BIT;
+	for (uint32_t i = 0; i < MATERIAL_COUNT; i++)
+		scene.textures[i] = device.CreateImage(imageDesc);
+
+	SamplerDesc samplerDesc;
+	samplerDesc.minFilter = SamplerFilter::LINEAR;
+	samplerDesc.magFliter = SamplerFilter::LINEAR;
+	scene.sampler = device.CreateSampler(samplerDesc);
+
+	imageDesc.width = device.GetResolutionWidth();
+	imageDesc.height = device.GetResolutionHeight();
+	imageDesc.usageBits = IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	scene.color = device.CreateImage(imageDesc);
+	imageDesc.format = DataFormat::D32_SFLOAT;
+	imageDesc.usageBits = IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	scene.depth = device.CreateImage(imageDesc);
+
+	scene.renderPassInfo.numColorAttachments = 1;
+	scene.renderPassInfo.colorAttachmentFormats[0] = DataFormat::R8G8B8A8_UNORM;
+	scene.renderPassInfo.depthAttachmentFormat = DataFormat::D32_SFLOAT;
+
+	const uint32_t code = 0x07230203;
+	GraphicPipeLineDesc pipelineDesc;
+	pipelineDesc.vertShader = device.CreateShaderFromBytes(ShaderStage::STAGE_VERTEX, &code, sizeof(code));
+	pipelineDesc.vertexInputLayout.vertexBindInfos.push_back({ 0, sizeof(float) * 3, VertexInputLayout::VertexBindInfo::INPUT_RATE_VERTEX });
+	pipelineDesc.vertexInputLayout.vertexAttribInfos.push_back({ 0, 0, 0, VertexInputLayout::VertexAttribInfo::ATTRIB_FORMAT_VEC3 });
+	pipelineDesc.renderPassInfo = scene.renderPassInfo;
+	for (uint32_t i = 0; i < PIPELINE_COUNT; i++)
+	{
+		pipelineDesc.fragShader = device.CreateShaderFromBytes(ShaderStage::STAGE_FRAGEMNT, &code, sizeof(code)); // a variant per pipeline
+		pipelineDesc.rasterState.cullMode = i % 2 ? CullMode::BACK : CullMode::NONE;
+		scene.pipelines[i] = device.CreateGraphicPipeLine(pipelineDesc);
+	}
+
+	return scene;
+}
+
+static void BeginMainPass(const Scene& scene, CommandList* cmd, RenderPassContents contents = RenderPassContents::INLINE)
+{
+	FrameBufferInfo frameBufferInfo = {};
+	frameBufferInfo.colorAttachments[0] = scene.color.get();
+	frameBufferInfo.depthAttachment = scene.depth.get();
+	cmd->BeginRenderPass(scene.renderPassInfo, frameBufferInfo, contents);
+}
+
+// same rebinding on change as RenderSystem::DrawScene()
+static void RecordDraws(const Scene& scene, const SceneDraw* draws, uint32_t count, uint32_t firstInstance, CommandList* cmd)
+{
+	cmd->BindUniformBuffer(0, 0, *scene.ubo, 0, scene.ubo->GetDesc().size);
+	cmd->BindStorageBuffer(0, 1, *scene.ssbo, 0, scene.ssbo->GetDesc().size);
+
+	uint32_t lastPipeline = ~0u;
+	uint32_t lastMaterial = ~0u;
+	uint32_t lastMesh = ~0u;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const SceneDraw& draw = draws[i];
+		if (draw.material != lastMaterial)
+		{
+			lastMaterial = draw.material;
+			cmd->BindImage(1, 1, *scene.textures[draw.material], ImageLayout::SHADER_READ_ONLY_OPTIMAL);
+			cmd->BindSampler(1, 1, *scene.sampler);
+			const float factors[4] = { 1.f, 1.f, 1.f, (float)draw.material };
+			cmd->PushConstant(factors, 64, sizeof(factors));
+		}
+
+		if (draw.mesh != lastMesh)
+		{
+			lastMesh = draw.mesh;
+			cmd->BindVertexBuffer(0, *scene.positions[draw.mesh], 0);
+			cmd->BindIndexBuffer(*scene.indexes[draw.mesh], 0, IndexBufferFormat::UINT32);
+		}
+
+		if (draw.pipeline != lastPipeline)
+		{
+			lastPipeline = draw.pipeline;
+			cmd->BindPipeLine(*scene.pipelines[draw.pipeline]);
+		}
+
+		cmd->DrawIndexed(INDEX_COUNT, 1, 0, 0, firstInstance + i);
+	}
+}
+
+// the pipeline state hashed the way RenderResourceManager::GetOrCreateGraphicsPSO() hashes it
+static util::Hash HashPipelineState(const GraphicPipeLineDesc& desc, const RenderPassInfo2& renderPassInfo)
+{
+	util::Hasher h;
+	h.u64(reinterpret_cast<uintptr_t>(desc.vertShader.get()));
+	h.u64(reinterpret_cast<uintptr_t>(desc.fragShader.get()));
+	h.u64(renderPassInfo.GetHash());
+
+	h.u32(static_cast<uint32_t>(desc.depthStencilState.enableDepthTest));
+	h.u32(static_cast<uint32_t>(desc.depthStencilState.enableDepthWrite));
+	h.u32(util::ecast(desc.depthStencilState.depthCompareOp));
+
+	h.u32(uint32_t(desc.blendState.enable_independent_blend));
+	for (uint32_t i = 0; i < renderPassInfo.numColorAttachments; i++)
+	{
+		const auto& att = desc.blendState.attachments[desc.blendState.enable_independent_blend ? i : 0];
+		h.u32(static_cast<uint32_t>(att.enable_blend));
+		if (att.enable_blend)
+		{
+			h.u32(util::ecast(att.colorBlendOp));
+			h.u32(util::ecast(att.srcColorBlendFactor));
+			h.u32(util::ecast(att.dstColorBlendFactor));
+			h.u32(util::ecast(att.alphaBlendOp));
+			h.u32(util::ecast(att.srcAlphaBlendFactor));
+			h.u32(util::ecast(att.dstAlphaBlendFactor));
+		}
+	}
+
+	for (const auto& attrib : desc.vertexInputLayout.vertexAttribInfos)
+	{
+		h.u32(util::ecast(attrib.format));
+		h.u32(attrib.offset);
+		h.u32(attrib.binding);
+	}
+
+	for (const auto& b : desc.vertexInputLayout.vertexBindInfos)
+	{
+		h.u32(b.binding);
+		h.u32(b.stride);
+	}
+
+	h.u32(util::ecast(desc.rasterState.cullMode));
+	h.u32(util::ecast(desc.rasterState.polygonMode));
+	h.u32(util::ecast(desc.topologyType));
+	return h.get();
+}
+
+// the pipelines of the scene by their state hash, as the PSO cache finds them
+using PipelineCache = unordered_map<util::Hash, PipeLine*>;
+
+static PipelineCache CreatePipelineCache(const Scene& scene)
+{
+	PipelineCache cache;
+	for (const Ref<PipeLine>& pipeline : scene.pipelines)
+		cache[HashPipelineState(static_cast<const PipeLine_Null&>(*pipeline).GetDesc(), scene.renderPassInfo)] = pipeline.get();
+	return cache;
+}
+
+// RenderSystem::DrawScene() before draws carried a pipeline index: every material or mesh change hashed the
+// pipeline state again and looked it up. The pipeline state is what scene.pipelines[draw.pipeline] was created with
+static void RecordDrawsHashingPipelines(const Scene& scene, const PipelineCache& cache, const vector<SceneDraw>& draws, CommandList* cmd)
+{
+	cmd->BindUniformBuffer(0, 0, *scene.ubo, 0, scene.ubo->GetDesc().size);
+	cmd->BindStorageBuffer(0, 1, *scene.ssbo, 0, scene.ssbo->GetDesc().size);
+
+	uint32_t lastMaterial = ~0u;
+	uint32_t lastMesh = ~0u;
+	PipeLine* lastPipeline = nullptr;
+	for (uint32_t i = 0; i < (uint32_t)draws.size(); i++)
+	{
+		const SceneDraw& draw = draws[i];
+		bool stateChanged = false;
+		if (draw.material != lastMaterial)
+		{
+			lastMaterial = draw.material;
+			cmd->BindImage(1, 1, *scene.textures[draw.material], ImageLayout::SHADER_READ_ONLY_OPTIMAL);
+			cmd->BindSampler(1, 1, *scene.sampler);
+			const float factors[4] = { 1.f, 1.f, 1.f, (float)draw.material };
+			cmd->PushConstant(factors, 64, sizeof(factors));
+			stateChanged = true;
+		}
+
+		if (draw.mesh != lastMesh)
+		{
+			lastMesh = draw.mesh;
+			cmd->BindVertexBuffer(0, *scene.positions[draw.mesh], 0);
+			cmd->BindIndexBuffer(*scene.indexes[draw.mesh], 0, IndexBufferFormat::UINT32);
+			stateChanged = true;
+		}
+
+		if (stateChanged)
+		{
+			const GraphicPipeLineDesc& desc = static_cast<const PipeLine_Null&>(*scene.pipelines[draw.pipeline]).GetDesc();
+			PipeLine* pipeline = cache.at(HashPipelineState(desc, cmd->GetCurrentRenderPassInfo()));
+			if (pipeline != lastPipeline)
+			{
+				lastPipeline = pipeline;
+				cmd->BindPipeLine(*pipeline);
+			}
+		}
+
+		cmd->DrawIndexed(INDEX_COUNT, 1, 0, 0, i);
+	}
+}
+
+// same rebinding as RenderSystem::DrawScene() with bindless materials, a material change is a push constant
+static void RecordBindlessDraws(const Scene& scene, const vector<SceneDraw>& draws, CommandList* cmd)
+{
+	cmd->BindUniformBuffer(0, 0, *scene.ubo, 0, scene.ubo->GetDesc().size);
+	cmd->BindStorageBuffer(0, 1, *scene.ssbo, 0, scene.ssbo->GetDesc().size);
+	cmd->BindStorageBuffer(0, 6, *scene.ssbo, 0, MATERIAL_COUNT * 32);
+	cmd->BindBindlessImages(1);
+
+	uint32_t lastPipeline = ~0u;
+	uint32_t lastMaterial = ~0u;
+	uint32_t lastMesh = ~0u;
+	for (uint32_t i = 0; i < (uint32_t)draws.size(); i++)
+	{
+		const SceneDraw& draw = draws[i];
+		if (draw.material != lastMaterial)
+		{
+			lastMaterial = draw.material;
+			cmd->PushConstant(&draw.material, 64, sizeof(draw.material));
+		}
+
+		if (draw.mesh != lastMesh)
+		{
+			lastMesh = draw.mesh;
+			cmd->BindVertexBuffer(0, *scene.positions[draw.mesh], 0);
+			cmd->BindIndexBuffer(*scene.indexes[draw.mesh], 0, IndexBufferFormat::UINT32);
+		}
+
+		if (draw.pipeline != lastPipeline)
+		{
+			lastPipeline = draw.pipeline;
+			cmd->BindPipeLine(*scene.pipelines[draw.pipeline]);
+		}
+
+		cmd->DrawIndexed(INDEX_COUNT, 1, 0, 0, i);
+	}
+}
+
+static void DrawScene(const Scene& scene, const vector<SceneDraw>& draws, CommandList* cmd)
+{
+	BeginMainPass(scene, cmd);
+	RecordDraws(scene, draws.data(), (uint32_t)draws.size(), 0, cmd);
+	cmd->EndRenderPass();
+}
+
+// the draws split in chunks recorded in secondary command lists on the job system, executed in order
+static CommandStats_Null RecordFrameInSecondaries(Device_Null& device, JobSystem& jobSystem, const Scene& scene, const vector<SceneDraw>& draws, uint32_t chunkCount)
+{
+	const uint32_t drawCount = (uint32_t)draws.size();
+	const uint32_t drawsPerChunk = (drawCount + chunkCount - 1) / chunkCount;
+	vector<CommandList*> secondaries(chunkCount);
+
+	device.BeiginFrame(TimeStep(0.f));
+	CommandList* cmd = device.BeginCommandList();
+	BeginMainPass(scene, cmd, RenderPassContents::SECONDARY_COMMAND_LISTS);
+
+	JobSystem::Counter counter;
+	jobSystem.Dispatch(chunkCount, 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const uint32_t first = min(i * drawsPerChunk, drawCount);
+			secondaries[i] = device.BeginSecondaryCommandList(*cmd);
+			RecordDraws(scene, draws.data() + first, min(first + drawsPerChunk, drawCount) - first, first, secondaries[i]);
+		}
+	}, &counter);
+	jobSystem.Wait(&counter, 1);
+
+	cmd->ExecuteSecondaryCommandLists(secondaries.data(), chunkCount);
+	cmd->EndRenderPass();
+	device.SubmitCommandList(cmd);
+	const CommandStats_Null stats = device.GetFrameStats();
+	device.EndFrame(TimeStep(0.f));
+	return stats;
+}
+
+static uint32_t CountRuns(const vector<SceneDraw>& draws, uint32_t SceneDraw::* key)
+{
+	uint32_t runs = 0;
+	for (size_t i = 0; i < draws.size(); i++)
+		runs += (i == 0 || draws[i].*key != draws[i - 1].*key) ? 1 : 0;
+	return runs;
+}
+
+static CommandStats_Null RecordFrame(Device_Null& device, const Scene& scene, const vector<SceneDraw>& draws)
+{
+	device.BeiginFrame(TimeStep(0.f));
+	CommandList* cmd = device.BeginCommandList();
+	DrawScene(scene, draws, cmd);
+	device.SubmitCommandList(cmd);
+	const CommandStats_Null stats = device.GetFrameStats();
+	device.EndFrame(TimeStep(0.f));
+	return stats;
+}
+
+static bool SameStats(const CommandStats_Null& a, const CommandStats_Null& b)
+{
+	return a.renderPasses == b.renderPasses && a.pipelineBinds == b.pipelineBinds && a.GetStateChanges() == b.GetStateChanges() &&
+		a.barriers == b.barriers && a.draws == b.draws && a.indexedDraws == b.indexedDraws && a.vertices == b.vertices &&
+		a.indices == b.indices && a.instances == b.instances && a.validationErrors == b.validationErrors;
+}
+
+static void PrintStats(const string& name, const CommandStats_Null& stats)
+{
+	cout << name << ": " << stats.indexedDraws << " draws, " << stats.GetStateChanges() << " state changes, " << stats.pipelineBinds << " pipeline binds, "
+		<< stats.imageBinds << " material binds, " << stats.indexBufferBinds << " mesh binds" << endl;
+}
+
+// one frame of misuse, returns the validation errors it was charged
+template<typename Func>
+static uint32_t CountErrors(Device_Null& device, Func func)
+{
+	device.BeiginFrame(TimeStep(0.f));
+	CommandList* cmd = device.BeginCommandList();
+	func(cmd);
+	device.SubmitCommandList(cmd);
+	device.EndFrame(TimeStep(0.f));
+	return device.GetFrameStats().validationErrors;
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+
+	uint32_t drawCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 50000;
+
+	Device_Null device;
+	QK_CORE_VERIFY(device.Init())
+	const Scene scene = CreateScene(device);
+
+	mt19937 rng(11);
+	vector<SceneDraw> draws(drawCount);
+	for (SceneDraw& draw : draws)
+		draw = { (uint32_t)(rng() % PIPELINE_COUNT), (uint32_t)(rng() % MATERIAL_COUNT), (uint32_t)(rng() % MESH_COUNT) };
+
+	vector<SceneDraw> sortedDraws = draws;
+	sort(sortedDraws.begin(), sortedDraws.end(), [](const SceneDraw& a, const SceneDraw& b)
+	{
+		return tie(a.pipeline, a.material, a.mesh) < tie(b.pipeline, b.material, b.mesh);
+	});
+
+	// every command is counted, and a well formed frame has no errors
+	const CommandStats_Null unsortedStats = RecordFrame(device, scene, draws);
+	const CommandStats_Null sortedStats = RecordFrame(device, scene, sortedDraws);
+	for (const auto& [stats, order] : { make_pair(unsortedStats, &draws), make_pair(sortedStats, &sortedDraws) })
+	{
+		QK_CORE_VERIFY(stats.validationErrors == 0)
+		QK_CORE_VERIFY(stats.renderPasses == 1 && stats.indexedDraws == drawCount && stats.draws == 0)
+		QK_CORE_VERIFY(stats.indices == (uint64_t)drawCount * INDEX_COUNT && stats.instances == drawCount)
+		QK_CORE_VERIFY(stats.pipelineBinds == CountRuns(*order, &SceneDraw::pipeline) && stats.redundantPipelineBinds == 0)
+		QK_CORE_VERIFY(stats.imageBinds == CountRuns(*order, &SceneDraw::material) && stats.imageBinds == stats.pushConstants)
+		QK_CORE_VERIFY(stats.indexBufferBinds == CountRuns(*order, &SceneDraw::mesh))
+	}
+	QK_CORE_VERIFY(sortedStats.pipelineBinds == PIPELINE_COUNT)
+	QK_CORE_VERIFY(sortedStats.GetStateChanges() < unsortedStats.GetStateChanges())
+	QK_CORE_VERIFY(device.GetTotalStats().indexedDraws == 2 * drawCount)
+	PrintStats("Submission order", unsortedStats);
+	PrintStats("Sort key order", sortedStats);
+
+	{
+		auto t = timer("Recording " + to_string(drawCount) + " draws in submission order");
+		RecordFrame(device, scene, draws);
+	}
+	{
+		auto t = timer("Recording " + to_string(drawCount) + " draws in sort key order");
+		RecordFrame(device, scene, sortedDraws);
+	}
+
+	// the pipeline index against the pipeline state hashed on every material or mesh change, same commands
+	{
+		const PipelineCache pipelineCache = CreatePipelineCache(scene);
+		QK_CORE_VERIFY(pipelineCache.size() == PIPELINE_COUNT)
+
+		CommandStats_Null hashedStats;
+		{
+			auto t = timer("Recording " + to_string(drawCount) + " draws in sort key order, pipelines looked up by state hash");
+			device.BeiginFrame(TimeStep(0.f));
+			CommandList* cmd = device.BeginCommandList();
+			BeginMainPass(scene, cmd);
+			RecordDrawsHashingPipelines(scene, pipelineCache, sortedDraws, cmd);
+			cmd->EndRenderPass();
+			device.SubmitCommandList(cmd);
+			hashedStats = device.GetFrameStats();
+			device.EndFrame(TimeStep(0.f));
+		}
+		QK_CORE_VERIFY(SameStats(hashedStats, sortedStats))
+	}
+
+	// misuse is logged and counted, one error each
+	cout << "The next validation errors are expected" << endl;
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd) { BeginMainPass(scene, cmd); cmd->DrawIndexed(3, 1, 0, 0, 0); cmd->EndRenderPass(); }) > 0)
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd) { cmd->BindPipeLine(*scene.pipelines[0]); cmd->Draw(3, 1, 0, 0); }) == 4)
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd) { cmd->EndRenderPass(); }) == 1)
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd) { BeginMainPass(scene, cmd); }) == 1)
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd) { cmd->BindUniformBuffer(0, 0, *scene.ubo, 64, 64); }) == 1)
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd) { cmd->BindUniformBuffer(0, 0, *scene.ssbo, 0, 64); }) == 1)
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd) { cmd->BindStorageBuffer(0, 1, *scene.ssbo, 256, scene.ssbo->GetDesc().size); }) == 1)
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd) { cmd->PushConstant(&drawCount, PUSH_CONSTANT_DATA_SIZE - 2, sizeof(drawCount)); }) == 1)
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd)
+	{
+		BeginMainPass(scene, cmd);
+		cmd->BindPipeLine(*scene.pipelines[0]);
+		cmd->BindVertexBuffer(0, *scene.positions[0], 0);
+		cmd->BindIndexBuffer(*scene.indexes[0], 0, IndexBufferFormat::UINT32);
+		cmd->DrawIndexed(INDEX_COUNT, 1, 3, 0, 0);
+		cmd->EndRenderPass();
+	}) == 1)
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd)
+	{
+		BeginMainPass(scene, cmd);
+		cmd->BindPipeLine(*scene.pipelines[0]);
+		cmd->BindIndexBuffer(*scene.indexes[0], 0, IndexBufferFormat::UINT32);
+		cmd->DrawIndexed(3, 1, 0, 0, 0);
+		cmd->EndRenderPass();
+	}) == 1)
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd)
+	{
+		// binds made before the render pass do not survive it
+		cmd->BindVertexBuffer(0, *scene.positions[0], 0);
+		cmd->BindIndexBuffer(*scene.indexes[0], 0, IndexBufferFormat::UINT32);
+		BeginMainPass(scene, cmd);
+		cmd->BindPipeLine(*scene.pipelines[0]);
+		cmd->DrawIndexed(3, 1, 0, 0, 0);
+		cmd->EndRenderPass();
+	}) == 2)
+	{
+		// a pipeline for a pass with another color format
+		RenderPassInfo2 otherPass = scene.renderPassInfo;
+		otherPass.colorAttachmentFormats[0] = DataFormat::R16G16B16A16_SFLOAT;
+		const uint32_t code = 0x07230203;
+		GraphicPipeLineDesc pipelineDesc;
+		pipelineDesc.vertShader = device.CreateShaderFromBytes(ShaderStage::STAGE_VERTEX, &code, sizeof(code));
+		pipelineDesc.fragShader = device.CreateShaderFromBytes(ShaderStage::STAGE_FRAGEMNT, &code, sizeof(code));
+		pipelineDesc.renderPassInfo = otherPass;
+		Ref<PipeLine> otherPipeline = device.CreateGraphicPipeLine(pipelineDesc);
+		QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd) { BeginMainPass(scene, cmd); cmd->BindPipeLine(*otherPipeline); cmd->Draw(3, 1, 0, 0); cmd->EndRenderPass(); }) == 1)
+	}
+	{
+		device.BeiginFrame(TimeStep(0.f));
+		device.BeginCommandList();
+		device.EndFrame(TimeStep(0.f));
+		QK_CORE_VERIFY(device.GetFrameStats().validationErrors == 1)
+	}
+	cout << "End of expected validation errors" << endl;
+
+	// a recorded frame replays to the same commands, and the stream of the replay is the same stream
+	device.SetRecordCommands(true);
+	const CommandStats_Null recordedStats = RecordFrame(device, scene, sortedDraws);
+	const vector<uint8_t> commands = device.TakeRecordedCommands();
+	QK_CORE_VERIFY(!commands.empty() && device.TakeRecordedCommands().empty())
+	cout << "Recorded stream of " << drawCount << " draws: " << commands.size() / 1024 << " KB" << endl;
+
+	device.BeiginFrame(TimeStep(0.f));
+	CommandList* cmd = device.BeginCommandList();
+	{
+		auto t = timer("Replaying the recorded stream");
+		QK_CORE_VERIFY(ReplayCommands_Null(commands, device, *cmd))
+	}
+	device.SubmitCommandList(cmd);
+	const CommandStats_Null replayedStats = device.GetFrameStats();
+	device.EndFrame(TimeStep(0.f));
+	QK_CORE_VERIFY(SameStats(replayedStats, recordedStats))
+	QK_CORE_VERIFY(device.TakeRecordedCommands() == commands)
+	device.SetRecordCommands(false);
+
+	// a stream cut in the middle of the last draw or with an unknown command is reported, not read past its end
+	{
+		Device_Null otherDevice;
+		otherDevice.Init();
+		CommandList* otherCmd = otherDevice.BeginCommandList();
+		const vector<uint8_t> truncated(commands.begin(), commands.end() - 2);
+		QK_CORE_VERIFY(!ReplayCommands_Null(truncated, otherDevice, *otherCmd))
+		QK_CORE_VERIFY(otherDevice.GetCurrentFrame().cmdLists[QUEUE_TYPE_GRAPHICS][0]->GetStats().indexedDraws == drawCount - 1)
+		QK_CORE_VERIFY(!ReplayCommands_Null({ (uint8_t)0xff }, otherDevice, *otherCmd))
+		otherDevice.ShutDown();
+	}
+
+	// command lists recorded on the JobSystem add up to the same stats
+	JobSystem jobSystem(4);
+	const uint32_t listCount = 8;
+	const uint32_t drawsPerList = (drawCount + listCount - 1) / listCount;
+	device.BeiginFrame(TimeStep(0.f));
+	JobSystem::Counter counter;
+	jobSystem.Dispatch(listCount, 1, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const uint32_t first = min(i * drawsPerList, drawCount);
+			const vector<SceneDraw> part(sortedDraws.begin() + first, sortedDraws.begin() + min(first + drawsPerList, drawCount));
+			CommandList* list = device.BeginCommandList();
+			DrawScene(scene, part, list);
+			device.SubmitCommandList(list);
+		}
+	}, &counter);
+	jobSystem.Wait(&counter, 1);
+	const CommandStats_Null parallelStats = device.GetFrameStats();
+	device.EndFrame(TimeStep(0.f));
+	QK_CORE_VERIFY(parallelStats.validationErrors == 0 && parallelStats.renderPasses == listCount)
+	QK_CORE_VERIFY(parallelStats.indexedDraws == drawCount && parallelStats.indices == sortedStats.indices)
+
+	// one render pass whose draws are recorded in secondary command lists, each one rebinds what it draws with
+	const CommandStats_Null secondaryStats = RecordFrameInSecondaries(device, jobSystem, scene, sortedDraws, listCount);
+	QK_CORE_VERIFY(secondaryStats.validationErrors == 0 && secondaryStats.renderPasses == 1)
+	QK_CORE_VERIFY(secondaryStats.indexedDraws == drawCount && secondaryStats.indices == sortedStats.indices)
+	QK_CORE_VERIFY(secondaryStats.uniformBufferBinds == listCount && secondaryStats.pipelineBinds >= sortedStats.pipelineBinds)
+	PrintStats("Secondary command lists", secondaryStats);
+	{
+		auto t = timer("Recording " + to_string(drawCount) + " draws in " + to_string(listCount) + " secondary command lists");
+		RecordFrameInSecondaries(device, jobSystem, scene, sortedDraws, listCount);
+	}
+
+	// the secondaries are nested in the recorded stream and replayed in secondaries again
+	device.SetRecordCommands(true);
+	RecordFrameInSecondaries(device, jobSystem, scene, sortedDraws, listCount);
+	const vector<uint8_t> secondaryCommands = device.TakeRecordedCommands();
+	device.BeiginFrame(TimeStep(0.f));
+	cmd = device.BeginCommandList();
+	QK_CORE_VERIFY(ReplayCommands_Null(secondaryCommands, device, *cmd))
+	device.SubmitCommandList(cmd);
+	QK_CORE_VERIFY(SameStats(device.GetFrameStats(), secondaryStats))
+	device.EndFrame(TimeStep(0.f));
+	QK_CORE_VERIFY(device.TakeRecordedCommands() == secondaryCommands)
+	device.SetRecordCommands(false);
+
+	cout << "The next validation errors are expected" << endl;
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd)
+	{
+		// draws of a pass with secondary contents are not recorded inline
+		BeginMainPass(scene, cmd, RenderPassContents::SECONDARY_COMMAND_LISTS);
+		RecordDraws(scene, sortedDraws.data(), 1, 0, cmd);
+		cmd->EndRenderPass();
+	}) == 2)
+	QK_CORE_VERIFY(CountErrors(device, [&](CommandList* cmd)
+	{
+		BeginMainPass(scene, cmd);
+		CommandList* secondary = device.BeginSecondaryCommandList(*cmd);
+		cmd->ExecuteSecondaryCommandLists(&secondary, 1);
+		cmd->EndRenderPass();
+	}) == 2)
+	{
+		device.BeiginFrame(TimeStep(0.f));
+		cmd = device.BeginCommandList();
+		BeginMainPass(scene, cmd, RenderPassContents::SECONDARY_COMMAND_LISTS);
+		device.BeginSecondaryCommandList(*cmd);
+		cmd->EndRenderPass();
+		device.SubmitCommandList(cmd);
+		device.EndFrame(TimeStep(0.f));
+		QK_CORE_VERIFY(device.GetFrameStats().validationErrors == 1)
+	}
+	cout << "End of expected validation errors" << endl;
+
+	// frame data binds as uniform and storage buffers, is not reused while the next frame is in flight, and once every
+	// frame slot has grown to the workload no buffer is created anymore
+	{
+		vector<FrameAllocation> lastFrame;
+		uint32_t lastFrameIndex = 0;
+		uint32_t bufferCounts[MAX_FRAME_NUM_IN_FLIGHT] = {};
+		for (uint32_t frameIndex = 1; frameIndex <= 4 * MAX_FRAME_NUM_IN_FLIGHT; frameIndex++)
+		{
+			device.BeiginFrame(TimeStep(0.f));
+			cmd = device.BeginCommandList();
+
+			mt19937 sizeRng(23);
+			vector<FrameAllocation> allocations;
+			for (uint32_t i = 0; i < 2000; i++)
+				allocations.push_back(device.AllocateFrameData(1 + sizeRng() % (16 * 1024)));
+			allocations.push_back(device.AllocateFrameData(FrameDataAllocator::BLOCK_SIZE + 1));
+
+			for (const FrameAllocation& a : allocations)
+			{
+				QK_CORE_VERIFY(a.offset % device.GetDeviceProperties().limits.minUniformBufferOffsetAlignment == 0)
+				QK_CORE_VERIFY(a.data == (uint8_t*)a.buffer->GetMappedDataPtr() + a.offset && a.offset + a.size <= a.buffer->GetDesc().size)
+				memset(a.data, (int)frameIndex, a.size);
+				cmd->BindUniformBuffer(0, 0, *a.buffer, a.offset, min<uint64_t>(a.size, 256));
+				cmd->BindStorageBuffer(0, 1, *a.buffer, a.offset, a.size);
+			}
+
+			for (const FrameAllocation& a : lastFrame)
+				QK_CORE_VERIFY(all_of((uint8_t*)a.data, (uint8_t*)a.data + a.size, [&](uint8_t x) { return x == (uint8_t)lastFrameIndex; }), "Frame data overwritten while its frame is in flight")
+
+			device.SubmitCommandList(cmd);
+			QK_CORE_VERIFY(device.GetFrameStats().validationErrors == 0)
+
+			uint32_t& bufferCount = bufferCounts[device.GetCurrentFrameIndex()];
+			const uint32_t currentCount = device.GetCurrentFrame().dataAllocator.GetBufferCount();
+			QK_CORE_VERIFY(bufferCount == 0 || currentCount == bufferCount)
+			bufferCount = currentCount;
+
+			device.EndFrame(TimeStep(0.f));
+			lastFrame = move(allocations);
+			lastFrameIndex = frameIndex;
+		}
+		cout << "Frame data of " << lastFrame.size() << " allocations in " << bufferCounts[0] << " buffers per frame" << endl;
+	}
+
+	// bindless materials: every texture is written once when it is registered, a material change flushes no descriptor set
+	{
+		uint32_t indexes[MATERIAL_COUNT];
+		for (uint32_t i = 0; i < MATERIAL_COUNT; i++)
+			indexes[i] = device.RegisterBindlessImage(*scene.textures[i], *scene.sampler);
+		for (uint32_t i = 0; i < MATERIAL_COUNT; i++)
+			QK_CORE_VERIFY(indexes[i] == i)
+
+		device.BeiginFrame(TimeStep(0.f));
+		cmd = device.BeginCommandList();
+		BeginMainPass(scene, cmd);
+		RecordBindlessDraws(scene, sortedDraws, cmd);
+		cmd->EndRenderPass();
+		device.SubmitCommandList(cmd);
+		const CommandStats_Null bindlessStats = device.GetFrameStats();
+		device.EndFrame(TimeStep(0.f));
+
+		const uint32_t materialRuns = CountRuns(sortedDraws, &SceneDraw::material);
+		QK_CORE_VERIFY(bindlessStats.validationErrors == 0 && bindlessStats.indexedDraws == drawCount)
+		QK_CORE_VERIFY(bindlessStats.imageBinds == 0 && bindlessStats.bindlessImageBinds == 1 && bindlessStats.pushConstants == materialRuns)
+		QK_CORE_VERIFY(sortedStats.descriptorSetFlushes == 1 + materialRuns && bindlessStats.descriptorSetFlushes == 1)
+		cout << "Descriptor set flushes of " << materialRuns << " material changes: " << sortedStats.descriptorSetFlushes << " binding textures, "
+			<< bindlessStats.descriptorSetFlushes << " with bindless textures" << endl;
+
+		// an unregistered index is not handed out again while the frames in flight may read it
+		device.BeiginFrame(TimeStep(0.f));
+		device.UnregisterBindlessImage(indexes[5]);
+		QK_CORE_VERIFY(device.RegisterBindlessImage(*scene.textures[5], *scene.sampler) == MATERIAL_COUNT)
+		device.EndFrame(TimeStep(0.f));
+		for (uint32_t i = 0; i < MAX_FRAME_NUM_IN_FLIGHT; i++)
+		{
+			device.BeiginFrame(TimeStep(0.f));
+			device.EndFrame(TimeStep(0.f));
+		}
+		QK_CORE_VERIFY(device.RegisterBindlessImage(*scene.textures[5], *scene.sampler) == indexes[5])
+	}
+
+	// descriptor sets are found by their contents: a frame drawing with the sets of the last one writes none, once
+	// they went unused for the ring's frames new sets are written into them instead of allocating more
+	{
+		Device& baseDevice = device;
+		RecordFrame(device, scene, sortedDraws);
+		const DescriptorSetStats cached = baseDevice.GetDescriptorSetStats();
+		RecordFrame(device, scene, sortedDraws);
+		DescriptorSetStats stats = baseDevice.GetDescriptorSetStats();
+		QK_CORE_VERIFY(stats.misses == cached.misses && stats.descriptorUpdates == cached.descriptorUpdates)
+		QK_CORE_VERIFY(stats.hits - cached.hits == sortedStats.descriptorSetFlushes && stats.poolAllocations == 0)
+
+		for (uint32_t i = 0; i < Device_Null::DESCRIPTOR_SET_RING_SIZE; i++)
+		{
+			device.BeiginFrame(TimeStep(0.f));
+			device.EndFrame(TimeStep(0.f));
+		}
+		const DescriptorSetStats before = baseDevice.GetDescriptorSetStats();
+		Scene other = scene;
+		other.ubo = device.CreateBuffer(scene.ubo->GetDesc());
+		RecordFrame(device, other, sortedDraws);
+		stats = baseDevice.GetDescriptorSetStats();
+		QK_CORE_VERIFY(stats.misses > before.misses && stats.vacantReuses - before.vacantReuses == stats.misses - before.misses)
+		QK_CORE_VERIFY(stats.allocatedSets == before.allocatedSets && stats.descriptorUpdates - before.descriptorUpdates == stats.misses - before.misses)
+		cout << "Descriptor sets: " << stats.hits << " hits, " << stats.misses << " misses (" << stats.vacantReuses << " vacant reuses), "
+			<< stats.allocatedSets << " sets" << endl;
+	}
+
+	device.ShutDown();
+	cout << "Null device checks passed" << endl;
+}
@@ -0,0 +1,284 @@
+#include <iostream>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/JobSystem.h>
+#include <Quark/Render/RenderScene.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+
+// Occlusion culling test: rasterizes a wall into the OcclusionBuffer and checks what it hides, checks that only pixels
+// an occluder covers entirely take its depth, compares the hierarchical test with testing every pixel and the
+// rasterization in bands on the JobSystem with the serial one, then culls a city of buildings through RenderScene
+// with and without the buildings as occluders.
+// Usage: OcclusionCulling_Test [object count]
+
+constexpr float CITY_SIZE = 1000.f;
+constexpr uint32_t BLOCK_COUNT = 20;
+constexpr uint32_t FRAME_COUNT = 20;
+
+static UniformBufferData_Camera CreateCamera(const glm::vec3& position, const glm::vec3& target)
+{
+	UniformBufferData_Camera camera;
+	camera.view = glm::lookAt(position, target, glm::vec3(0.f, 1.f, 0.f));
+	camera.proj = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 2000.f);
+	camera.proj[1][1] *= -1;
+	camera.viewproj = camera.proj * camera.view;
+	return camera;
+}
+
+// unit cube around the origin, the shape of every building
+static Occluder CreateBoxOccluder(uint64_t id, const glm::mat4& model_matrix)
+{
+	Occluder occluder;
+	occluder.id = id;
+	occluder.model_matrix = model_matrix;
+	for (uint32_t i = 0; i < 8; i++)
+		occluder.positions.push_back(glm::vec3(i & 1 ? 1.f : -1.f, i & 2 ? 1.f : -1.f, i & 4 ? 1.f : -1.f));
+	occluder.indices = {
+		0, 1, 3, 0, 3, 2,	4, 5, 7, 4, 7, 6,	// -z, +z
+		0, 2, 6, 0, 6, 4,	1, 3, 7, 1, 7, 5,	// -x, +x
+		0, 1, 5, 0, 5, 4,	2, 3, 7, 2, 7, 6,	// -y, +y
+	};
+	return occluder;
+}
+
+static math::Aabb UnitBox(const glm::vec3& center, float half_size)
+{
+	return math::Aabb(center - glm::vec3(half_size), center + glm::vec3(half_size));
+}
+
+// the hierarchy may only give up early where every pixel would have agreed
+static bool IsVisibleBruteForce(const OcclusionBuffer& buffer, const glm::mat4& viewproj, const math::Aabb& aabb)
+{
+	glm::vec2 screen_min(numeric_limits<float>::max());
+	glm::vec2 screen_max(numeric_limits<float>::lowest());
+	float nearest_depth = 0.f;
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		const glm::vec3 corner(i & 1 ? aabb.Max().x : aabb.Min().x, i & 2 ? aabb.Max().y : aabb.Min().y, i & 4 ? aabb.Max().z : aabb.Min().z);
+		const glm::vec4 c = viewproj * glm::vec4(corner, 1.f);
+		if (c.z < 0.f)
+			return true;
+		const glm::vec2 screen((c.x / c.w * 0.5f + 0.5f) * buffer.GetWidth(), (c.y / c.w * 0.5f + 0.5f) * buffer.GetHeight());
+		screen_min = glm::min(screen_min, screen);
+		screen_max = glm::max(screen_max, screen);
+		nearest_depth = max(nearest_depth, 1.f / c.w);
+	}
+
+	if (screen_max.x < 0.f || screen_max.y < 0.f || screen_min.x >= (float)buffer.GetWidth() || screen_min.y >= (float)buffer.GetHeight())
+		return true;
+
+	nearest_depth *= 1.f + 1e-3f;
+	for (uint32_t y = (uint32_t)max(screen_min.y, 0.f); y <= (uint32_t)min(screen_max.y, buffer.GetHeight() - 1.f); y++)
+	{
+		for (uint32_t x = (uint32_t)max(screen_min.x, 0.f); x <= (uint32_t)min(screen_max.x, buffer.GetWidth() - 1.f); x++)
+		{
+			if (nearest_depth >= buffer.GetDepth(x, y))
+				return true;
+		}
+	}
+	return false;
+}
+
+static void TestWall()
+{
+	// a 20 x 10 wall 10 units in front of the camera
+	UniformBufferData_Camera camera = CreateCamera(glm::vec3(0.f, 5.f, 0.f), glm::vec3(0.f, 5.f, 1.f));
+	vector<Occluder> occluders;
+	occluders.push_back(CreateBoxOccluder(1, glm::scale(glm::translate(glm::mat4(1.f), glm::vec3(0.f, 5.f, 10.f)), glm::vec3(10.f, 5.f, 0.5f))));
+
+	OcclusionBuffer buffer;
+	buffer.Rasterize(occluders, camera.viewproj);
+
+	QK_CORE_VERIFY(!buffer.IsVisible(UnitBox(glm::vec3(0.f, 5.f, 30.f), 1.f)), "Behind the wall")
+	QK_CORE_VERIFY(!buffer.IsVisible(UnitBox(glm::vec3(-3.f, 3.f, 20.f), 2.f)), "Behind the wall")
+	QK_CORE_VERIFY(buffer.IsVisible(UnitBox(glm::vec3(0.f, 5.f, 5.f), 1.f)), "In front of the wall")
+	QK_CORE_VERIFY(buffer.IsVisible(UnitBox(glm::vec3(40.f, 5.f, 30.f), 1.f)), "Beside the wall")
+	QK_CORE_VERIFY(buffer.IsVisible(UnitBox(glm::vec3(0.f, 20.f, 30.f), 1.f)), "Above the wall")
+	QK_CORE_VERIFY(buffer.IsVisible(UnitBox(glm::vec3(0.f, 5.f, 0.f), 1.f)), "Around the camera")
+	QK_CORE_VERIFY(buffer.IsVisible(UnitBox(glm::vec3(0.f, 5.f, 10.f), 1.f)), "Inside the wall")
+	QK_CORE_VERIFY(buffer.IsVisible(UnitBox(glm::vec3(0.f, 10.f, 12.f), 1.f)), "Partly behind the wall")
+
+	// the wall's own bounds are never hidden by the wall
+	QK_CORE_VERIFY(buffer.IsVisible(math::Aabb(glm::vec3(-10.f, 0.f, 9.5f), glm::vec3(10.f, 10.f, 10.5f))))
+	cout << "Wall test passed" << endl;
+}
+
+// a quad turned away from the camera and around the view axis, so its outline crosses pixels at every angle
+static void TestCoverage()
+{
+	UniformBufferData_Camera camera = CreateCamera(glm::vec3(0.f, 5.f, 0.f), glm::vec3(0.f, 5.f, 1.f));
+	Occluder quad;
+	quad.model_matrix = glm::translate(glm::mat4(1.f), glm::vec3(0.3f, 5.2f, 10.f));
+	quad.model_matrix = glm::rotate(quad.model_matrix, glm::radians(17.f), glm::vec3(0.f, 0.f, 1.f));
+	quad.model_matrix = glm::rotate(quad.model_matrix, glm::radians(40.f), glm::vec3(0.f, 1.f, 0.f));
+	quad.positions = { glm::vec3(-4.f, -3.f, 0.f), glm::vec3(4.f, -3.f, 0.f), glm::vec3(4.f, 3.f, 0.f), glm::vec3(-4.f, 3.f, 0.f) };
+	quad.indices = { 0, 1, 2, 0, 2, 3 };
+
+	OcclusionBuffer buffer;
+	buffer.Rasterize({ quad }, camera.viewproj);
+
+	// the outline in pixels and the depth plane, 1/w is linear in screen space
+	glm::vec3 corners[4];
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		const glm::vec4 c = camera.viewproj * quad.model_matrix * glm::vec4(quad.positions[i], 1.f);
+		corners[i] = glm::vec3((c.x / c.w * 0.5f + 0.5f) * buffer.GetWidth(), (c.y / c.w * 0.5f + 0.5f) * buffer.GetHeight(), 1.f / c.w);
+	}
+	const glm::vec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+	auto planeDepth = [&](float x, float y) { return corners[0].z - (normal.x * (x - corners[0].x) + normal.y * (y - corners[0].y)) / normal.z; };
+	const float winding = normal.z > 0.f ? 1.f : -1.f;
+	auto insideBy = [&](float x, float y)
+	{
+		float distance = numeric_limits<float>::max();
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			const glm::vec2 edge(corners[(i + 1) % 4].x - corners[i].x, corners[(i + 1) % 4].y - corners[i].y);
+			distance = min(distance, winding * (edge.x * (y - corners[i].y) - edge.y * (x - corners[i].x)) / glm::length(edge));
+		}
+		return distance;
+	};
+
+	uint32_t covered = 0;
+	for (uint32_t y = 0; y < buffer.GetHeight(); y++)
+	{
+		for (uint32_t x = 0; x < buffer.GetWidth(); x++)
+		{
+			float pixelInside = numeric_limits<float>::max();
+			float pixelDepth = numeric_limits<float>::max();
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				pixelInside = min(pixelInside, insideBy(float(x + (i & 1)), float(y + (i >> 1))));
+				pixelDepth = min(pixelDepth, planeDepth(float(x + (i & 1)), float(y + (i >> 1))));
+			}
+
+			const float depth = buffer.GetDepth(x, y);
+			if (depth > 0.f)
+			{
+				covered++;
+				QK_CORE_VERIFY(pixelInside > -1e-3f, "Pixel ({}, {}) is not entirely behind the occluder", x, y)
+				QK_CORE_VERIFY(depth <= pixelDepth * (1.f + 1e-4f), "Pixel ({}, {}) is nearer than the occluder", x, y)
+			}
+			else
+			{
+				// including the pixels on the diagonal the two triangles share
+				QK_CORE_VERIFY(pixelInside < 1e-2f, "Pixel ({}, {}) is entirely behind the occluder but not covered", x, y)
+			}
+		}
+	}
+	QK_CORE_VERIFY(covered > 0)
+	cout << "Coverage test passed, " << covered << " pixels covered" << endl;
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+	TestWall();
+	TestCoverage();
+
+	uint32_t objectCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 200000;
+	mt19937 rng(7);
+
+	// a grid of buildings with small objects scattered in the streets between them
+	RenderScene scene;
+	const float blockSize = CITY_SIZE / BLOCK_COUNT;
+	uniform_real_distribution<float> height(10.f, 60.f);
+	uint32_t entity = 0;
+	for (uint32_t bx = 0; bx < BLOCK_COUNT; bx++)
+	{
+		for (uint32_t bz = 0; bz < BLOCK_COUNT; bz++)
+		{
+			const float h = height(rng);
+			const glm::vec3 center((bx + 0.5f) * blockSize, h * 0.5f, (bz + 0.5f) * blockSize);
+			const glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.f), center), glm::vec3(blockSize * 0.4f, h * 0.5f, blockSize * 0.4f));
+
+			RenderObject obj;
+			obj.id = RenderScene::GetRenderObjectID(entity, 0);
+			obj.model_matrix = model;
+			obj.aabb = math::Aabb(glm::vec3(-1.f), glm::vec3(1.f));
+			scene.AddOrUpdateRenderObject(obj, entity++);
+			scene.AddOrUpdateOccluder(CreateBoxOccluder(obj.id, model));
+		}
+	}
+
+	uniform_real_distribution<float> xz(0.f, CITY_SIZE);
+	uniform_real_distribution<float> y(0.f, 3.f);
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		RenderObject obj;
+		obj.id = RenderScene::GetRenderObjectID(entity, 0);
+		obj.model_matrix = glm::translate(glm::mat4(1.f), glm::vec3(xz(rng), y(rng), xz(rng)));
+		obj.aabb = math::Aabb(glm::vec3(-0.5f), glm::vec3(0.5f));
+		scene.AddOrUpdateRenderObject(obj, entity++);
+	}
+	cout << scene.render_objects.size() << " objects, " << scene.occluders.size() << " occluders" << endl;
+
+	// standing in a street looking along the city
+	UniformBufferData_Camera camera = CreateCamera(glm::vec3(blockSize, 2.f, 0.f), glm::vec3(CITY_SIZE * 0.6f, 2.f, CITY_SIZE));
+	Visibility& vis = scene.main_camera_visibility;
+
+	scene.enable_occlusion_culling = false;
+	scene.UpdateVisibility(vis, camera);
+	const size_t frustumVisible = vis.main_camera_visible_object_indexes.size();
+	{
+		auto t = timer("Frustum culling");
+		for (uint32_t frame = 0; frame < FRAME_COUNT; frame++)
+			scene.UpdateVisibility(vis, camera);
+	}
+
+	scene.enable_occlusion_culling = true;
+	scene.UpdateVisibility(vis, camera);
+	QK_CORE_VERIFY(vis.main_camera_visible_object_indexes.size() + vis.main_camera_occluded_count == frustumVisible)
+	{
+		auto t = timer("Frustum and occlusion culling");
+		for (uint32_t frame = 0; frame < FRAME_COUNT; frame++)
+			scene.UpdateVisibility(vis, camera);
+	}
+	cout << "Visible in the frustum: " << frustumVisible << ", after occlusion: " << vis.main_camera_visible_object_indexes.size()
+		<< " (" << vis.main_camera_occluded_count << " occluded) over " << FRAME_COUNT << " frames" << endl;
+
+	// the hierarchy gives the same answer as every pixel
+	const OcclusionBuffer& buffer = scene.occlusion_buffer;
+	cout << "Occlusion buffer: " << buffer.GetWidth() << "x" << buffer.GetHeight() << ", " << buffer.GetLevelCount() << " levels" << endl;
+	for (uint32_t i = 0; i < scene.render_objects.size(); i++)
+	{
+		const math::Aabb aabb = scene.render_object_bounds.Get(i);
+		QK_CORE_VERIFY(buffer.IsVisible(aabb) == IsVisibleBruteForce(buffer, camera.viewproj, aabb))
+	}
+
+	// bands on the job system write exactly the same depth
+	JobSystem jobSystem(4);
+	OcclusionBuffer parallelBuffer;
+	parallelBuffer.Rasterize(scene.occluders, camera.viewproj, &jobSystem);
+	for (uint32_t y = 0; y < buffer.GetHeight(); y++)
+	{
+		for (uint32_t x = 0; x < buffer.GetWidth(); x++)
+			QK_CORE_VERIFY(parallelBuffer.GetDepth(x, y) == buffer.GetDepth(x, y))
+	}
+
+	Visibility parallelVis;
+	scene.UpdateVisibility(parallelVis, camera, &jobSystem);
+	{
+		auto t = timer("Frustum and occlusion culling on " + to_string(jobSystem.GetNumWorkerThreads()) + " worker threads");
+		for (uint32_t frame = 0; frame < FRAME_COUNT; frame++)
+			scene.UpdateVisibility(parallelVis, camera, &jobSystem);
+	}
+	vector<uint32_t> expected = vis.main_camera_visible_object_indexes;
+	vector<uint32_t> visible = parallelVis.main_camera_visible_object_indexes;
+	sort(expected.begin(), expected.end());
+	sort(visible.begin(), visible.end());
+	QK_CORE_VERIFY(visible == expected)
+	QK_CORE_VERIFY(parallelVis.main_camera_occluded_count == vis.main_camera_occluded_count)
+
+	// deleting a building takes its occluder along
+	const size_t occluderCount = scene.occluders.size();
+	scene.DeleteRenderObjectsByEntityID(0);
+	QK_CORE_VERIFY(scene.occluders.size() == occluderCount - 1)
+	for (size_t i = 0; i < scene.occluders.size(); i++)
+		QK_CORE_VERIFY(*scene.occluder_to_offset.find(scene.occluders[i].id) == i)
+}
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <random>
+#include <cstring>
+#include <Quark/Core/Logger.h>
+#include <Quark/RHI/Vulkan/PipelineCache_Vulkan.h>
+
+using namespace std;
+using namespace quark;
+using namespace quark::rhi;
+
+// Pipeline cache file test: round trips a fake driver blob through the on disk format and checks that files from
+// another device or driver, truncated files and files with flipped bytes are all rejected.
+
+static PipelineCacheKey CreateKey()
+{
+	PipelineCacheKey key;
+	key.vendorID = 0x10de;
+	key.deviceID = 0x2684;
+	key.driverVersion = 0x8a3c0000;
+	for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+	{
+		key.pipelineCacheUUID[i] = (uint8_t)(i * 7 + 1);
+		key.deviceUUID[i] = (uint8_t)(i * 13 + 2);
+		key.driverUUID[i] = (uint8_t)(i * 31 + 3);
+	}
+	return key;
+}
+
+// what a driver returns from vkGetPipelineCacheData(): its own header, then anything
+static vector<uint8_t> CreateDriverData(const PipelineCacheKey& key, size_t payloadSize)
+{
+	VkPipelineCacheHeaderVersionOne header = {};
+	header.headerSize = sizeof(header);
+	header.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+	header.vendorID = key.vendorID;
+	header.deviceID = key.deviceID;
+	memcpy(header.pipelineCacheUUID, key.pipelineCacheUUID, VK_UUID_SIZE);
+
+	vector<uint8_t> data(sizeof(header) + payloadSize);
+	memcpy(data.data(), &header, sizeof(header));
+	mt19937 rng(5);
+	for (size_t i = sizeof(header); i < data.size(); i++)
+		data[i] = (uint8_t)rng();
+	return data;
+}
+
+int main()
+{
+	Logger::Init();
+
+	const PipelineCacheKey key = CreateKey();
+	const vector<uint8_t> driverData = CreateDriverData(key, 4096);
+	const vector<uint8_t> file = SerializePipelineCache(key, driverData.data(), driverData.size());
+
+	vector<uint8_t> loaded;
+	QK_CORE_VERIFY(DeserializePipelineCache(key, file, loaded))
+	QK_CORE_VERIFY(loaded == driverData)
+
+	// any part of the key that differs means another device or driver
+	auto rejected_with = [&](auto change)
+	{
+		PipelineCacheKey other = key;
+		change(other);
+		vector<uint8_t> data = { 1, 2, 3 };
+		return !DeserializePipelineCache(other, file, data) && data.empty();
+	};
+	QK_CORE_VERIFY(rejected_with([](PipelineCacheKey& k) { k.vendorID++; }))
+	QK_CORE_VERIFY(rejected_with([](PipelineCacheKey& k) { k.deviceID++; }))
+	QK_CORE_VERIFY(rejected_with([](PipelineCacheKey& k) { k.driverVersion++; }))
+	QK_CORE_VERIFY(rejected_with([](PipelineCacheKey& k) { k.pipelineCacheUUID[3]++; }))
+	QK_CORE_VERIFY(rejected_with([](PipelineCacheKey& k) { k.deviceUUID[0]++; }))
+	QK_CORE_VERIFY(rejected_with([](PipelineCacheKey& k) { k.driverUUID[15]++; }))
+
+	// every truncation and every flipped byte is caught
+	for (size_t size = 0; size < file.size(); size++)
+	{
+		const vector<uint8_t> truncated(file.begin(), file.begin() + size);
+		QK_CORE_VERIFY(!DeserializePipelineCache(key, truncated, loaded) && loaded.empty())
+	}
+
+	for (size_t i = 0; i < file.size(); i++)
+	{
+		vector<uint8_t> damaged = file;
+		damaged[i] ^= 0x40;
+		QK_CORE_VERIFY(!DeserializePipelineCache(key, damaged, loaded))
+	}
+
+	vector<uint8_t> extended = file;
+	extended.push_back(0);
+	QK_CORE_VERIFY(!DeserializePipelineCache(key, extended, loaded))
+
+	// a blob whose own header disagrees with the device is not handed to the driver either
+	PipelineCacheKey otherDevice = key;
+	otherDevice.deviceID++;
+	const vector<uint8_t> foreignData = CreateDriverData(otherDevice, 64);
+	QK_CORE_VERIFY(!DeserializePipelineCache(key, SerializePipelineCache(key, foreignData.data(), foreignData.size()), loaded))
+
+	cout << "Pipeline cache file checks passed" << endl;
+}
@@ -0,0 +1,234 @@
+#include <iostream>
+#include <string>
+#include <Quark/Core/Logger.h>
+#include <Quark/Render/RenderGraph.h>
+#include <Quark/RHI/Null/Device_Null.h>
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+using namespace quark::rhi;
+
+// Render graph test: declares the editor's frame, a main pass, the UI pass sampling its color, an entity ID pass read
+// back to the CPU and a debug pass nobody reads, and checks the culled passes, the barriers and which transient images
+// alias, then executes it on the null device. Checks that a graph of the same shape reuses its compilation and its
+// images, and that a chain of passes ping-pongs between two physical images. Times the declaration and compilation.
+// Usage: RenderGraph_Test [frame count]
+
+constexpr uint32_t WIDTH = 1280;
+constexpr uint32_t HEIGHT = 720;
+constexpr uint32_t CHAIN_LENGTH = 8;
+
+static ImageDesc AttachmentDesc(DataFormat format)
+{
+	ImageDesc desc;
+	desc.width = WIDTH;
+	desc.height = HEIGHT;
+	desc.format = format;
+	return desc;
+}
+
+struct EditorFrame
+{
+	RenderGraphImage swapchain, viewport, depth, entity_color, entity_depth, debug;
+	uint32_t main_pass, ui_pass, entity_pass, readback_pass, debug_pass;
+};
+
+static EditorFrame DeclareEditorFrame(RenderGraph& graph, Image* swapchain, Image* viewport, bool pick_entity)
+{
+	graph.Reset();
+
+	EditorFrame frame;
+	frame.swapchain = graph.ImportImage("swapchain", swapchain, RenderGraphImageUsage::NONE, RenderGraphImageUsage::PRESENT);
+	frame.viewport = graph.ImportImage("viewport", viewport);
+	frame.depth = graph.CreateImage("depth", AttachmentDesc(DataFormat::D32_SFLOAT));
+	frame.debug = graph.CreateImage("debug", AttachmentDesc(DataFormat::R8G8B8A8_UNORM));
+
+	uint32_t pass_count = 0;
+	frame.main_pass = pass_count++;
+	graph.AddPass("main")
+		.AddColorOutput(frame.viewport)
+		.SetDepthOutput(frame.depth)
+		.SetExecute([](CommandList* cmd) {});
+
+	frame.debug_pass = pass_count++;
+	graph.AddPass("debug")
+		.AddTextureInput(frame.viewport)
+		.AddColorOutput(frame.debug)
+		.SetExecute([](CommandList* cmd) { QK_CORE_VERIFY(0, "culled pass executed") });
+
+	frame.ui_pass = pass_count++;
+	graph.AddPass("ui")
+		.AddTextureInput(frame.viewport)
+		.AddColorOutput(frame.swapchain)
+		.SetExecute([](CommandList* cmd) {});
+
+	frame.entity_pass = frame.readback_pass = UINT32_MAX;
+	frame.entity_color = frame.entity_depth = RENDER_GRAPH_IMAGE_NONE;
+	if (pick_entity)
+	{
+		frame.entity_color = graph.CreateImage("entity_id", AttachmentDesc(DataFormat::R32G32_UINT));
+		frame.entity_depth = graph.CreateImage("entity_depth", AttachmentDesc(DataFormat::D32_SFLOAT));
+
+		frame.entity_pass = pass_count++;
+		graph.AddPass("entity_id")
+			.AddColorOutput(frame.entity_color)
+			.SetDepthOutput(frame.entity_depth)
+			.SetExecute([](CommandList* cmd) {});
+
+		frame.readback_pass = pass_count++;
+		graph.AddPass("readback")
+			.AddTransferInput(frame.entity_color)
+			.SetSideEffect()
+			.SetExecute([](CommandList* cmd) {});
+	}
+
+	graph.Compile();
+	return frame;
+}
+
+static const RenderGraphBarrier* FindBarrier(const vector<RenderGraphBarrier>& barriers, RenderGraphImage image)
+{
+	for (const RenderGraphBarrier& barrier : barriers)
+	{
+		if (barrier.image == image)
+			return &barrier;
+	}
+	return nullptr;
+}
+
+static CommandStats_Null ExecuteFrame(Device_Null& device, RenderGraph& graph)
+{
+	device.BeiginFrame(TimeStep(0.f));
+	CommandList* cmd = device.BeginCommandList();
+	graph.Execute(cmd);
+	device.SubmitCommandList(cmd);
+	device.EndFrame(TimeStep(0.f));
+	return device.GetFrameStats();
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+
+	uint32_t frameCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 10000;
+
+	Device_Null device(WIDTH, HEIGHT);
+	QK_CORE_VERIFY(device.Init())
+
+	ImageDesc viewportDesc = AttachmentDesc(DataFormat::R8G8B8A8_UNORM);
+	viewportDesc.usageBits = IMAGE_USAGE_COLOR_ATTACHMENT_BIT | IMAGE_USAGE_SAMPLING_BIT;
+	Ref<Image> viewport = device.CreateImage(viewportDesc);
+
+	// the debug pass writes an image no one reads, every other pass leads to an imported image or a side effect
+	RenderGraph graph(&device);
+	EditorFrame frame = DeclareEditorFrame(graph, device.GetPresentImage(), viewport.get(), true);
+	QK_CORE_VERIFY(graph.IsPassCulled(frame.debug_pass))
+	QK_CORE_VERIFY(!graph.IsPassCulled(frame.main_pass) && !graph.IsPassCulled(frame.ui_pass))
+	QK_CORE_VERIFY(!graph.IsPassCulled(frame.entity_pass) && !graph.IsPassCulled(frame.readback_pass))
+	QK_CORE_VERIFY(graph.GetStats().passes == 5 && graph.GetStats().culled_passes == 1)
+
+	// the depth of the main pass is free once the pass ends, the entity ID pass renders into the same image
+	QK_CORE_VERIFY(graph.GetPhysicalImageIndex(frame.depth) == graph.GetPhysicalImageIndex(frame.entity_depth))
+	QK_CORE_VERIFY(graph.GetPhysicalImageIndex(frame.entity_color) != graph.GetPhysicalImageIndex(frame.depth))
+	QK_CORE_VERIFY(graph.GetPhysicalImageIndex(frame.debug) == UINT32_MAX)
+	QK_CORE_VERIFY(graph.GetStats().transient_images == 3 && graph.GetStats().physical_images == 2)
+
+	// attachments start undefined, the viewport is sampled once the main pass wrote it
+	QK_CORE_VERIFY(graph.GetBarriers(frame.main_pass).size() == 2)
+	for (const RenderGraphBarrier& barrier : graph.GetBarriers(frame.main_pass))
+		QK_CORE_VERIFY(barrier.barrier.layoutBefore == ImageLayout::UNDEFINED)
+
+	const RenderGraphBarrier* sampleViewport = FindBarrier(graph.GetBarriers(frame.ui_pass), frame.viewport);
+	QK_CORE_VERIFY(sampleViewport && sampleViewport->barrier.layoutBefore == ImageLayout::COLOR_ATTACHMENT_OPTIMAL)
+	QK_CORE_VERIFY(sampleViewport->barrier.layoutAfter == ImageLayout::SHADER_READ_ONLY_OPTIMAL)
+	QK_CORE_VERIFY(sampleViewport->barrier.srcStageBits == PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT)
+	QK_CORE_VERIFY(sampleViewport->barrier.srcMemoryAccessBits == BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT)
+	QK_CORE_VERIFY(sampleViewport->barrier.dstStageBits == PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
+
+	// the aliased depth waits for the main pass depth tests before it is discarded
+	const RenderGraphBarrier* aliasDepth = FindBarrier(graph.GetBarriers(frame.entity_pass), frame.entity_depth);
+	QK_CORE_VERIFY(aliasDepth && aliasDepth->barrier.layoutBefore == ImageLayout::UNDEFINED)
+	QK_CORE_VERIFY(aliasDepth->barrier.srcStageBits == (PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT))
+	QK_CORE_VERIFY(aliasDepth->barrier.srcMemoryAccessBits == BARRIER_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT)
+
+	const RenderGraphBarrier* copyEntity = FindBarrier(graph.GetBarriers(frame.readback_pass), frame.entity_color);
+	QK_CORE_VERIFY(copyEntity && copyEntity->barrier.layoutAfter == ImageLayout::TRANSFER_SRC_OPTIMAL)
+
+	QK_CORE_VERIFY(graph.GetFinalBarriers().size() == 1)
+	const RenderGraphBarrier& present = graph.GetFinalBarriers()[0];
+	QK_CORE_VERIFY(present.image == frame.swapchain && present.barrier.layoutBefore == ImageLayout::COLOR_ATTACHMENT_OPTIMAL)
+	QK_CORE_VERIFY(present.barrier.layoutAfter == ImageLayout::PRESENT)
+
+	// the null device validates the recorded render passes
+	CommandStats_Null stats = ExecuteFrame(device, graph);
+	QK_CORE_VERIFY(stats.validationErrors == 0 && stats.renderPasses == 3)
+	QK_CORE_VERIFY(stats.barriers == graph.GetStats().barriers)
+	QK_CORE_VERIFY(graph.GetImage(frame.depth) == graph.GetImage(frame.entity_depth))
+	QK_CORE_VERIFY(graph.GetImage(frame.swapchain) == device.GetPresentImage())
+	QK_CORE_VERIFY((graph.GetImage(frame.entity_color)->GetDesc().usageBits & IMAGE_USAGE_CAN_COPY_FROM_BIT) != 0)
+	cout << "Editor frame: " << graph.GetStats().passes << " passes, " << graph.GetStats().culled_passes << " culled, "
+		<< graph.GetStats().barriers << " barriers, " << graph.GetStats().transient_images << " transient images in "
+		<< graph.GetStats().physical_images << " physical images" << endl;
+
+	// the same shape compiles once and keeps its images, another shape compiles again
+	const Image* depthImage = graph.GetImage(frame.depth);
+	frame = DeclareEditorFrame(graph, device.GetPresentImage(), viewport.get(), true);
+	ExecuteFrame(device, graph);
+	QK_CORE_VERIFY(graph.GetStats().compiles == 1 && graph.GetStats().cached_compiles == 1)
+	QK_CORE_VERIFY(graph.GetImage(frame.depth) == depthImage)
+
+	frame = DeclareEditorFrame(graph, device.GetPresentImage(), viewport.get(), false);
+	stats = ExecuteFrame(device, graph);
+	QK_CORE_VERIFY(graph.GetStats().compiles == 2 && stats.validationErrors == 0 && stats.renderPasses == 2)
+	QK_CORE_VERIFY(graph.GetStats().physical_images == 1 && graph.GetImage(frame.depth) == depthImage)
+
+	// the entity ID image waits in the pool while picking is off, toggling picking creates no image
+	const uint32_t createdImages = graph.GetStats().created_images;
+	QK_CORE_VERIFY(createdImages == 2)
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		frame = DeclareEditorFrame(graph, device.GetPresentImage(), viewport.get(), i % 2 == 0);
+		stats = ExecuteFrame(device, graph);
+		QK_CORE_VERIFY(stats.validationErrors == 0 && graph.GetImage(frame.depth) == depthImage)
+	}
+	QK_CORE_VERIFY(graph.GetStats().created_images == createdImages)
+
+	// every pass of a chain samples the output of the pass before it, two images are enough for all of them
+	{
+		RenderGraph chain(&device);
+		RenderGraphImage previous = chain.CreateImage("source", AttachmentDesc(DataFormat::R16G16B16A16_SFLOAT));
+		chain.AddPass("source").AddColorOutput(previous);
+		for (uint32_t i = 0; i < CHAIN_LENGTH; i++)
+		{
+			RenderGraphImage next = chain.CreateImage("chain", AttachmentDesc(DataFormat::R16G16B16A16_SFLOAT));
+			chain.AddPass("chain").AddTextureInput(previous).AddColorOutput(next);
+			previous = next;
+		}
+		RenderGraphImage output = chain.ImportImage("output", viewport.get());
+		chain.AddPass("output").AddTextureInput(previous).AddColorOutput(output);
+		chain.Compile();
+
+		QK_CORE_VERIFY(chain.GetStats().culled_passes == 0 && chain.GetStats().transient_images == CHAIN_LENGTH + 1)
+		QK_CORE_VERIFY(chain.GetStats().physical_images == 2)
+		stats = ExecuteFrame(device, chain);
+		QK_CORE_VERIFY(stats.validationErrors == 0 && stats.renderPasses == CHAIN_LENGTH + 2)
+		cout << "Chain of " << CHAIN_LENGTH + 2 << " passes: " << chain.GetStats().transient_images << " transient images in "
+			<< chain.GetStats().physical_images << " physical images" << endl;
+	}
+
+	{
+		auto t = timer("Declaring and compiling " + to_string(frameCount) + " frames of the same shape");
+		for (uint32_t i = 0; i < frameCount; i++)
+			DeclareEditorFrame(graph, device.GetPresentImage(), viewport.get(), true);
+	}
+	{
+		auto t = timer("Declaring and compiling " + to_string(frameCount) + " frames of alternating shapes");
+		for (uint32_t i = 0; i < frameCount; i++)
+			DeclareEditorFrame(graph, device.GetPresentImage(), viewport.get(), i % 2 == 0);
+	}
+
+	device.ShutDown();
+	cout << "All render graph checks passed" << endl;
+	return 0;
+}
@@ -0,0 +1,163 @@
+#include <iostream>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <unordered_map>
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/Util/FlatHashMap.h>
+#include <Quark/Render/RenderScene.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+
+// Render object removal test: checks util::FlatHashMap against std::unordered_map, then fills a RenderScene with entities
+// of a few sections each, deletes a part of them at once and checks that every remaining object is still found through
+// its id, its entity and the bvh.
+// Usage: RenderObjectRemoval_Test [entity count] [deleted entity count]
+
+constexpr uint32_t MAX_SECTION_COUNT = 4;
+
+static uint32_t GetSectionCount(uint64_t entity_id)
+{
+	return 1 + (uint32_t)(entity_id % MAX_SECTION_COUNT);
+}
+
+static void VerifyScene(const RenderScene& scene, const vector<uint64_t>& entities)
+{
+	size_t objectCount = 0;
+	for (uint64_t entity : entities)
+		objectCount += GetSectionCount(entity);
+	QK_CORE_VERIFY(scene.render_objects.size() == objectCount)
+	QK_CORE_VERIFY(scene.bvh.GetProxyCount() == objectCount)
+	QK_CORE_VERIFY(scene.bvh.Validate())
+
+	for (uint32_t i = 0; i < scene.render_objects.size(); i++)
+		QK_CORE_VERIFY(scene.bvh.GetUserData(scene.render_objects[i].bvh_proxy) == i)
+
+	QK_CORE_VERIFY(scene.entity_to_first_offset.size() == entities.size())
+	for (uint64_t entity : entities)
+	{
+		// the entity's list holds exactly its sections
+		uint32_t listed = 0;
+		uint32_t prev = ~0u;
+		for (uint32_t offset = *scene.entity_to_first_offset.find(entity); offset != ~0u; offset = scene.render_objects[offset].next_in_entity)
+		{
+			QK_CORE_VERIFY(scene.render_objects[offset].entity_id == entity)
+			QK_CORE_VERIFY(scene.render_objects[offset].prev_in_entity == prev)
+			prev = offset;
+			listed++;
+		}
+		QK_CORE_VERIFY(listed == GetSectionCount(entity))
+
+		for (uint32_t section = 0; section < GetSectionCount(entity); section++)
+		{
+			const uint64_t id = RenderScene::GetRenderObjectID(entity, section);
+			const uint32_t* offset = scene.render_object_to_offset.find(id);
+			QK_CORE_VERIFY(offset && scene.render_objects[*offset].id == id)
+			QK_CORE_VERIFY(scene.render_objects[*offset].entity_id == entity)
+		}
+	}
+}
+
+// random inserts and erases over a small key range, so runs of neighbouring slots form and get shifted back
+static void TestFlatHashMap()
+{
+	mt19937 rng(3);
+	uniform_int_distribution<uint64_t> key(0, 2000);
+	util::FlatHashMap<uint64_t, uint32_t> map;
+	unordered_map<uint64_t, uint32_t> expected;
+	for (uint32_t i = 0; i < 200000; i++)
+	{
+		const uint64_t k = key(rng);
+		if (rng() % 3 == 0)
+		{
+			QK_CORE_VERIFY(map.erase(k) == (expected.erase(k) == 1))
+		}
+		else
+		{
+			map[k] = i;
+			expected[k] = i;
+		}
+	}
+
+	QK_CORE_VERIFY(map.size() == expected.size())
+	for (uint64_t k = 0; k <= 2000; k++)
+	{
+		auto find = expected.find(k);
+		const uint32_t* value = map.find(k);
+		QK_CORE_VERIFY((value != nullptr) == (find != expected.end()))
+		QK_CORE_VERIFY(!value || *value == find->second)
+	}
+
+	size_t visited = 0;
+	map.for_each([&](uint64_t k, uint32_t value) { QK_CORE_VERIFY(expected.at(k) == value) visited++; });
+	QK_CORE_VERIFY(visited == expected.size())
+	cout << "FlatHashMap test passed" << endl;
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+	TestFlatHashMap();
+
+	const uint32_t entityCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 40000;
+	const uint32_t deleteCount = argc > 2 ? (uint32_t)stoul(argv[2]) : entityCount / 10;
+	mt19937_64 rng(5);
+
+	// random ids, like the uuids of scene entities
+	vector<uint64_t> entities(entityCount);
+	for (uint64_t& entity : entities)
+		entity = rng();
+
+	RenderScene scene;
+	uniform_real_distribution<float> position(0.f, 1000.f);
+	{
+		auto t = timer("Insert " + to_string(entityCount) + " entities");
+		for (uint64_t entity : entities)
+		{
+			const glm::mat4 model = glm::translate(glm::mat4(1.f), glm::vec3(position(rng), position(rng), position(rng)));
+			for (uint32_t section = 0; section < GetSectionCount(entity); section++)
+			{
+				RenderObject obj;
+				obj.id = RenderScene::GetRenderObjectID(entity, section);
+				obj.model_matrix = model;
+				obj.aabb = math::Aabb(glm::vec3(-1.f), glm::vec3(1.f));
+				scene.AddOrUpdateRenderObject(obj, entity);
+			}
+		}
+	}
+	cout << scene.render_objects.size() << " render objects" << endl;
+	VerifyScene(scene, entities);
+
+	// moving every entity walks its sections
+	{
+		auto t = timer("Move " + to_string(entityCount) + " entities");
+		for (uint64_t entity : entities)
+			scene.UpdateRenderObjectsTransform(entity, glm::translate(glm::mat4(1.f), glm::vec3(position(rng), position(rng), position(rng))));
+	}
+	VerifyScene(scene, entities);
+
+	shuffle(entities.begin(), entities.end(), rng);
+	{
+		auto t = timer("Delete " + to_string(deleteCount) + " entities");
+		for (uint32_t i = 0; i < deleteCount; i++)
+			scene.DeleteRenderObjectsByEntityID(entities[i]);
+	}
+	entities.erase(entities.begin(), entities.begin() + deleteCount);
+	VerifyScene(scene, entities);
+
+	// deleting unknown or already deleted entities does nothing
+	scene.DeleteRenderObjectsByEntityID(0);
+	VerifyScene(scene, entities);
+
+	{
+		auto t = timer("Delete the remaining " + to_string(entities.size()) + " entities");
+		for (uint64_t entity : entities)
+			scene.DeleteRenderObjectsByEntityID(entity);
+	}
+	entities.clear();
+	VerifyScene(scene, entities);
+	QK_CORE_VERIFY(scene.render_object_to_offset.size() == 0)
+}
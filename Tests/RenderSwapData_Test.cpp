@@ -0,0 +1,202 @@
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <Quark/Core/Logger.h>
+#include <Quark/Scene/Scene.h>
+#include <Quark/Scene/Components/CommonCmpts.h>
+#include <Quark/Scene/Components/TransformCmpt.h>
+#include <Quark/Scene/Components/MeshCmpt.h>
+#include <Quark/Scene/Components/MeshRendererCmpt.h>
+#include <Quark/Render/RenderSwapContext.h>
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+
+// Allocation counter and benchmark for Scene::FillMeshSwapData with a scene where every object moves every frame.
+// Filling the swap data must not touch the heap once the swap data containers have grown to the scene's size.
+
+static std::atomic<uint64_t> s_allocationCount = 0;
+
+void* operator new(size_t size)
+{
+	s_allocationCount++;
+	if (void* ptr = std::malloc(size ? size : 1))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+constexpr uint32_t OBJECT_COUNT = 100000;
+constexpr uint32_t FRAME_COUNT = 20;
+constexpr uint32_t SECTION_COUNT = 3;
+
+// What the render side does with the swap data once it consumed it
+static void ConsumeSwapData(RenderSwapData& swapData)
+{
+	swapData.dirty_static_mesh_render_proxies.clear();
+	swapData.arena.reset();
+	swapData.dirty_transforms.clear();
+}
+
+static void MoveAllObjects(Scene& scene, uint32_t frame)
+{
+	for (auto [transform_cmpt] : scene.GetComponents<TransformCmpt>())
+		transform_cmpt->SetLocalPosition(glm::vec3((float)frame, 0.f, 0.f));
+
+	scene.RunTransformUpdateSystem();
+}
+
+// The previous FillMeshSwapData: every moving object rebuilt its proxy with a heap allocated section array
+struct LegacyStaticMeshRenderProxy
+{
+	uint64_t entity_id = 0;
+	AssetID mesh_asset_id = 0;
+	glm::mat4 transform;
+
+	std::vector<MeshSectionDesc> mesh_sections;
+};
+
+static void LegacyFillMeshSwapData(Scene& scene, std::vector<LegacyStaticMeshRenderProxy>& out)
+{
+	for (const auto [id_cmpt, mesh_cmpt, mesh_renderer_cmpt, transform_cmpt] : scene.GetComponents<IdCmpt, MeshCmpt, MeshRendererCmpt, TransformCmpt>())
+	{
+		mesh_renderer_cmpt->SetTransformDirty(false);
+
+		LegacyStaticMeshRenderProxy newRenderProxy;
+		newRenderProxy.entity_id = id_cmpt->id;
+		newRenderProxy.mesh_asset_id = mesh_cmpt->sharedMesh->GetAssetID();
+		newRenderProxy.transform = transform_cmpt->GetWorldMatrix();
+
+		for (uint32_t i = 0; i < mesh_cmpt->sharedMesh->subMeshes.size(); ++i)
+		{
+			const auto& submesh = mesh_cmpt->sharedMesh->subMeshes[i];
+			MeshSectionDesc newSectionDesc;
+			newSectionDesc.aabb = submesh.aabb;
+			newSectionDesc.index_count = submesh.count;
+			newSectionDesc.index_offset = submesh.startIndex;
+			newSectionDesc.material_asset_id = mesh_renderer_cmpt->GetMaterialID(i);
+			newRenderProxy.mesh_sections.push_back(newSectionDesc);
+		}
+
+		out.push_back(newRenderProxy);
+	}
+}
+
+int main()
+{
+	Logger::Init();
+
+	auto mesh = CreateRef<MeshAsset>();
+	mesh->subMeshes.resize(SECTION_COUNT);
+	for (uint32_t i = 0; i < SECTION_COUNT; i++)
+	{
+		mesh->subMeshes[i].startIndex = i * 36;
+		mesh->subMeshes[i].count = 36;
+	}
+
+	Scene scene("RenderSwapData_Test");
+	for (uint32_t i = 0; i < OBJECT_COUNT; i++)
+	{
+		Entity* entity = scene.CreateEntity();
+		entity->AddComponent<MeshCmpt>()->sharedMesh = mesh;
+		entity->AddComponent<MeshRendererCmpt>()->SetMesh(mesh);
+	}
+
+	RenderSwapData swapData;
+
+	// First frame sends full proxies for every object
+	scene.FillMeshSwapData(swapData);
+	QK_CORE_VERIFY(swapData.dirty_static_mesh_render_proxies.size() == OBJECT_COUNT)
+	QK_CORE_VERIFY(swapData.dirty_transforms.empty())
+	QK_CORE_VERIFY(swapData.dirty_static_mesh_render_proxies[0].mesh_section_count == SECTION_COUNT)
+	ConsumeSwapData(swapData);
+
+	// Moving objects only send transforms, first frame grows the transform stream
+	MoveAllObjects(scene, 1);
+	scene.FillMeshSwapData(swapData);
+	QK_CORE_VERIFY(swapData.dirty_static_mesh_render_proxies.empty())
+	QK_CORE_VERIFY(swapData.dirty_transforms.size() == OBJECT_COUNT)
+	ConsumeSwapData(swapData);
+
+	// Allocation counter test
+	{
+		uint64_t allocations = 0;
+		for (uint32_t frame = 2; frame < FRAME_COUNT; frame++)
+		{
+			MoveAllObjects(scene, frame);
+
+			uint64_t before = s_allocationCount;
+			scene.FillMeshSwapData(swapData);
+			allocations += s_allocationCount - before;
+
+			QK_CORE_VERIFY(swapData.dirty_transforms.size() == OBJECT_COUNT)
+			ConsumeSwapData(swapData);
+		}
+		cout << "Allocations while filling transform deltas: " << allocations << endl;
+		QK_CORE_VERIFY(allocations == 0)
+
+		// Full proxies reuse the arena blocks and the proxy vector once they have grown
+		allocations = 0;
+		size_t arenaBlocks = 0;
+		for (uint32_t frame = 0; frame < 4; frame++)
+		{
+			for (auto [mesh_renderer_cmpt] : scene.GetComponents<MeshRendererCmpt>())
+				mesh_renderer_cmpt->SetDirty(true);
+
+			uint64_t before = s_allocationCount;
+			scene.FillMeshSwapData(swapData);
+			if (frame > 0)
+				allocations += s_allocationCount - before;
+			else
+				arenaBlocks = swapData.arena.get_block_count();
+
+			QK_CORE_VERIFY(swapData.dirty_static_mesh_render_proxies.size() == OBJECT_COUNT)
+			ConsumeSwapData(swapData);
+		}
+		cout << "Allocations while filling full proxies: " << allocations << endl;
+		QK_CORE_VERIFY(allocations == 0)
+		QK_CORE_VERIFY(swapData.arena.get_block_count() == arenaBlocks)
+	}
+
+	// Benchmark
+	{
+		std::vector<LegacyStaticMeshRenderProxy> legacyProxies;
+		uint64_t before = s_allocationCount;
+		{
+			auto t = timer("Legacy proxies, 100k moving objects", FRAME_COUNT);
+			for (uint32_t frame = 0; frame < FRAME_COUNT; frame++)
+			{
+				MoveAllObjects(scene, frame);
+				LegacyFillMeshSwapData(scene, legacyProxies);
+				legacyProxies.clear();
+			}
+		}
+		cout << "  allocations per frame: " << (s_allocationCount - before) / FRAME_COUNT
+			<< ", bytes per object: " << sizeof(LegacyStaticMeshRenderProxy) + SECTION_COUNT * sizeof(MeshSectionDesc) << endl;
+
+		before = s_allocationCount;
+		{
+			auto t = timer("Transform deltas, 100k moving objects", FRAME_COUNT);
+			for (uint32_t frame = 0; frame < FRAME_COUNT; frame++)
+			{
+				MoveAllObjects(scene, frame);
+				scene.FillMeshSwapData(swapData);
+				ConsumeSwapData(swapData);
+			}
+		}
+		cout << "  allocations per frame: " << (s_allocationCount - before) / FRAME_COUNT
+			<< ", bytes per object: " << sizeof(TransformSwapData) << endl;
+	}
+}
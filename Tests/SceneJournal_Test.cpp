@@ -0,0 +1,148 @@
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/JobSystem.h>
+#include <Quark/Scene/Scene.h>
+#include <Quark/Scene/SceneSerializer.h>
+#include <Quark/Scene/SceneJournal.h>
+#include <Quark/Scene/Components/MeshCmpt.h>
+#include "SceneTestHelpers.h"
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+
+// Incremental save test: edits a large scene, saves only the deltas, and checks that loading the scene file
+// with its journal, before and after compaction, gives back the edited scene.
+// Usage: SceneJournal_Test [entity count]
+
+static Ref<Scene> LoadScene(const filesystem::path& path)
+{
+	Ref<Scene> loaded = CreateRef<Scene>("");
+	SceneSerializer serializer(loaded);
+	QK_CORE_VERIFY(serializer.Deserialize(path))
+	return loaded;
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+
+	uint32_t entityCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 100000;
+	auto scenePath = filesystem::temp_directory_path() / ("SceneJournal_Test" + string(SceneSerializer::s_DefaultExtension));
+	auto journalPath = SceneSerializer::GetJournalPath(scenePath);
+
+	Ref<Scene> scene = CreateTestScene("SceneJournal_Test", entityCount);
+	cout << "Entities: " << entityCount << endl;
+
+	JobSystem jobSystem;
+	SceneJournalSpecification specs;
+	specs.compactionSize = ~size_t(0);
+	SceneJournal journal(scene, jobSystem, specs);
+
+	{
+		auto t = timer("Full save");
+		SceneSerializer serializer(scene);
+		serializer.Serialize(scenePath);
+	}
+	journal.Begin(scenePath);
+	QK_CORE_VERIFY(!filesystem::exists(journalPath))
+
+	// Nothing changed, nothing written
+	QK_CORE_VERIFY(journal.Save())
+	QK_CORE_VERIFY(journal.GetStats().changedEntities == 0)
+	QK_CORE_VERIFY(!filesystem::exists(journalPath))
+
+	// One entity
+	{
+		auto entities = scene->GetAllEntitiesWith<IdCmpt, RelationshipCmpt>();
+		entities[entityCount / 2]->GetComponent<TransformCmpt>()->SetLocalPosition(glm::vec3(1.f, 2.f, 3.f));
+		{
+			auto t = timer("Incremental save of one entity");
+			QK_CORE_VERIFY(journal.Save())
+		}
+		QK_CORE_VERIFY(journal.GetStats().changedEntities == 1)
+		cout << "Journal size: " << filesystem::file_size(journalPath) << " bytes, scene file size: " << filesystem::file_size(scenePath) << " bytes" << endl;
+	}
+
+	// Renames, removed components, deletions, new entities and reparenting
+	{
+		auto entities = scene->GetAllEntitiesWith<IdCmpt, RelationshipCmpt>();
+		Entity* renamed = entities[1];
+		Entity* unnamed = entities[2];
+		Entity* deleted = entities[8];		// a root, its children go with it
+		Entity* moved = entities[17];
+		Entity* newParent = entities[24];
+
+		renamed->GetComponent<NameCmpt>()->name = "Renamed";
+		unnamed->RemoveComponent<NameCmpt>();
+		scene->DeleteEntity(deleted);
+		scene->AttachChild(moved, newParent);
+		scene->DetachChild(entities[25]);
+
+		Entity* created = scene->CreateEntity("Created", newParent);
+		created->GetComponent<TransformCmpt>()->SetLocalPosition(glm::vec3(-5.f));
+		scene->CreateEntity("CreatedRoot");
+
+		QK_CORE_VERIFY(journal.Save())
+		QK_CORE_VERIFY(journal.GetStats().deletedEntities == 8)
+	}
+
+	{
+		Ref<Scene> loaded;
+		{
+			auto t = timer("Load with journal");
+			loaded = LoadScene(scenePath);
+		}
+		VerifySameScene(*scene, *loaded, false);
+	}
+
+	// Compaction merges the journal into the scene file while saves keep appending
+	{
+		SceneJournalSpecification compactSpecs;
+		compactSpecs.compactionSize = 0;
+		SceneJournal compactingJournal(scene, jobSystem, compactSpecs);
+		compactingJournal.Begin(scenePath);
+
+		scene->GetAllEntitiesWith<IdCmpt, RelationshipCmpt>()[3]->GetComponent<TransformCmpt>()->SetLocalPosition(glm::vec3(7.f));
+		QK_CORE_VERIFY(compactingJournal.Save())
+		QK_CORE_VERIFY(compactingJournal.GetStats().compactions == 1)
+
+		scene->GetAllEntitiesWith<IdCmpt, RelationshipCmpt>()[4]->GetComponent<NameCmpt>()->name = "AfterCompactionStarted";
+		QK_CORE_VERIFY(compactingJournal.Save())
+
+		{
+			auto t = timer("Background compaction");
+			compactingJournal.WaitForCompaction();
+		}
+		cout << "Journal size after compaction: " << filesystem::file_size(journalPath) << " bytes" << endl;
+
+		VerifySameScene(*scene, *LoadScene(scenePath), false);
+	}
+
+	// A unique mesh replacing the shared one is a change of its own. Not loaded back, resolving mesh ids needs the AssetManager
+	{
+		SceneJournal meshJournal(scene, jobSystem, specs);
+		meshJournal.Begin(scenePath);
+
+		auto sharedMesh = CreateRef<MeshAsset>();
+		auto uniqueMesh = CreateRef<MeshAsset>();
+		Entity* entity = scene->GetAllEntitiesWith<IdCmpt, RelationshipCmpt>()[5];
+		entity->AddComponent<MeshCmpt>()->sharedMesh = sharedMesh;
+		QK_CORE_VERIFY(meshJournal.Save())
+		QK_CORE_VERIFY(meshJournal.GetStats().changedEntities == 1)
+
+		const auto journalSize = filesystem::file_size(journalPath);
+		entity->GetComponent<MeshCmpt>()->uniqueMesh = uniqueMesh;
+		QK_CORE_VERIFY(meshJournal.Save())
+		QK_CORE_VERIFY(meshJournal.GetStats().changedEntities == 1)
+		QK_CORE_VERIFY(filesystem::file_size(journalPath) > journalSize)
+
+		QK_CORE_VERIFY(meshJournal.Save())
+		QK_CORE_VERIFY(meshJournal.GetStats().changedEntities == 0)
+	}
+
+	filesystem::remove(scenePath);
+	filesystem::remove(journalPath);
+}
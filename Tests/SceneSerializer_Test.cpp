@@ -0,0 +1,113 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <Quark/Core/Logger.h>
+#include <Quark/Scene/Scene.h>
+#include <Quark/Scene/SceneSerializer.h>
+#include <Quark/Scene/SceneBinaryFormat.h>
+#include "SceneTestHelpers.h"
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+
+// Round trip test of the binary scene format and load time benchmark against the YAML path.
+// Usage: SceneSerializer_Test [entity count]
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+
+	uint32_t entityCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 50000;
+	auto tempDir = filesystem::temp_directory_path();
+	auto yamlPath = tempDir / ("SceneSerializer_Test" + string(SceneSerializer::s_DefaultExtension));
+	auto binaryPath = tempDir / ("SceneSerializer_Test" + string(SceneSerializer::s_BinaryExtension));
+	auto convertedPath = tempDir / ("SceneSerializer_Test_Converted" + string(SceneSerializer::s_BinaryExtension));
+
+	Ref<Scene> scene = CreateTestScene("SceneSerializer_Test", entityCount, false);
+	cout << "Entities: " << entityCount << endl;
+
+	{
+		SceneSerializer serializer(scene);
+		{
+			auto t = timer("Save YAML");
+			serializer.Serialize(yamlPath);
+		}
+		{
+			auto t = timer("Save binary");
+			QK_CORE_VERIFY(serializer.SerializeBinary(binaryPath))
+		}
+	}
+	cout << "YAML size: " << filesystem::file_size(yamlPath) << " bytes, binary size: " << filesystem::file_size(binaryPath) << " bytes" << endl;
+
+	// Round trip
+	{
+		Ref<Scene> loaded = CreateRef<Scene>("");
+		SceneSerializer serializer(loaded);
+		{
+			auto t = timer("Load binary");
+			QK_CORE_VERIFY(serializer.DeserializeBinary(binaryPath))
+		}
+		VerifySameScene(*scene, *loaded, true);
+	}
+
+	// Benchmark the YAML path
+	{
+		Ref<Scene> loaded = CreateRef<Scene>("");
+		SceneSerializer serializer(loaded);
+		{
+			auto t = timer("Load YAML");
+			QK_CORE_VERIFY(serializer.Deserialize(yamlPath))
+		}
+		QK_CORE_VERIFY(loaded->GetEntities().size() == entityCount)
+	}
+
+	{
+		QK_CORE_VERIFY(SceneSerializer::Convert(binaryPath, yamlPath))
+		QK_CORE_VERIFY(SceneSerializer::Convert(yamlPath, convertedPath))
+
+		// Ids and hierarchy survive YAML, rotations only approximately
+		Ref<Scene> loaded = CreateRef<Scene>("");
+		SceneSerializer serializer(loaded);
+		QK_CORE_VERIFY(serializer.DeserializeBinary(convertedPath))
+		QK_CORE_VERIFY(loaded->GetEntities().size() == entityCount)
+	}
+
+	// A child index outside the file is rejected before any entity is created
+	{
+		fstream file(binaryPath, ios::in | ios::out | ios::binary);
+		BinarySceneHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		for (uint32_t i = 0; i < header.sectionCount; i++)
+		{
+			BinarySceneSection section;
+			file.read(reinterpret_cast<char*>(&section), sizeof(section));
+			if (section.type == BinarySceneSectionType::CHILD_INDEXES)
+			{
+				const uint32_t badIndex = header.entityCount;
+				file.seekp(section.offset + (section.elementCount - 1) * sizeof(uint32_t));
+				file.write(reinterpret_cast<const char*>(&badIndex), sizeof(badIndex));
+				break;
+			}
+		}
+		file.close();
+
+		Ref<Scene> loaded = CreateRef<Scene>("");
+		SceneSerializer serializer(loaded);
+		QK_CORE_VERIFY(!serializer.DeserializeBinary(binaryPath))
+		QK_CORE_VERIFY(loaded->GetEntities().empty())
+	}
+
+	// Corrupted files are rejected
+	{
+		filesystem::resize_file(binaryPath, filesystem::file_size(binaryPath) / 2);
+		Ref<Scene> loaded = CreateRef<Scene>("");
+		SceneSerializer serializer(loaded);
+		QK_CORE_VERIFY(!serializer.DeserializeBinary(binaryPath))
+	}
+
+	filesystem::remove(yamlPath);
+	filesystem::remove(binaryPath);
+	filesystem::remove(convertedPath);
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <Quark/Core/Logger.h>
+#include <Quark/Scene/Scene.h>
+#include <Quark/Scene/Components/CommonCmpts.h>
+#include <Quark/Scene/Components/TransformCmpt.h>
+#include <Quark/Scene/Components/RelationshipCmpt.h>
+
+// Scene fixtures shared by the scene saving tests
+
+// A forest of small hierarchies: every root has a handful of children. Children are named "Child<index>",
+// or have no NameCmpt if namedChildren is false
+inline quark::Ref<quark::Scene> CreateTestScene(const std::string& sceneName, uint32_t entityCount, bool namedChildren = true)
+{
+	using namespace quark;
+
+	Ref<Scene> scene = CreateRef<Scene>(sceneName);
+	scene->ReserveEntities(entityCount);
+
+	Entity* root = nullptr;
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		Entity* entity = (i % 8 == 0)? scene->CreateEntity("Root" + std::to_string(i)) : scene->CreateEntity(namedChildren? "Child" + std::to_string(i) : "", root);
+		if (i % 8 == 0)
+			root = entity;
+
+		auto* tc = entity->GetComponent<TransformCmpt>();
+		tc->SetLocalPosition(glm::vec3(i * 0.5f, i * 0.25f, -(float)i));
+		tc->SetLocalRotate(glm::normalize(glm::quat(1.f, i * 0.001f, 0.3f, -0.2f)));
+		tc->SetLocalScale(glm::vec3(1.f + i * 1e-6f));
+	}
+
+	return scene;
+}
+
+// Compares ids, names and the hierarchy. The binary format stores rotations as quaternions and round trips transforms
+// bit exact, YAML stores them as euler angles, so without exactTransforms only positions are compared, approximately
+inline void VerifySameScene(quark::Scene& expected, quark::Scene& loaded, bool exactTransforms)
+{
+	using namespace quark;
+
+	auto& expectedEntities = expected.GetAllEntitiesWith<IdCmpt, RelationshipCmpt>();
+	auto& loadedEntities = loaded.GetAllEntitiesWith<IdCmpt, RelationshipCmpt>();
+	QK_CORE_VERIFY(expected.sceneName == loaded.sceneName)
+	QK_CORE_VERIFY(expectedEntities.size() == loadedEntities.size())
+
+	for (auto* e : expectedEntities)
+	{
+		Entity* l = loaded.GetEntityWithID(e->GetComponent<IdCmpt>()->id);
+		QK_CORE_VERIFY(l)
+
+		auto* en = e->GetComponent<NameCmpt>();
+		auto* ln = l->GetComponent<NameCmpt>();
+		QK_CORE_VERIFY((en == nullptr) == (ln == nullptr))
+		QK_CORE_VERIFY(!en || en->name == ln->name)
+
+		auto* et = e->GetComponent<TransformCmpt>();
+		auto* lt = l->GetComponent<TransformCmpt>();
+		glm::vec3 ep = et->GetLocalPosition(), lp = lt->GetLocalPosition();
+		if (exactTransforms)
+		{
+			glm::quat eq = et->GetLocalRotate(), lq = lt->GetLocalRotate();
+			glm::vec3 es = et->GetLocalScale(), ls = lt->GetLocalScale();
+			QK_CORE_VERIFY(memcmp(&ep, &lp, sizeof(ep)) == 0)
+			QK_CORE_VERIFY(memcmp(&eq, &lq, sizeof(eq)) == 0)
+			QK_CORE_VERIFY(memcmp(&es, &ls, sizeof(es)) == 0)
+		}
+		else
+		{
+			QK_CORE_VERIFY(std::abs(ep.x - lp.x) < 1e-3f && std::abs(ep.y - lp.y) < 1e-3f && std::abs(ep.z - lp.z) < 1e-3f)
+		}
+
+		auto& ec = e->GetComponent<RelationshipCmpt>()->GetChildEntities();
+		auto& lc = l->GetComponent<RelationshipCmpt>()->GetChildEntities();
+		QK_CORE_VERIFY(ec.size() == lc.size())
+		for (size_t i = 0; i < ec.size(); i++)
+			QK_CORE_VERIFY(ec[i]->GetComponent<IdCmpt>()->id == lc[i]->GetComponent<IdCmpt>()->id)
+
+		Entity* eParent = e->GetComponent<RelationshipCmpt>()->GetParentEntity();
+		Entity* lParent = l->GetComponent<RelationshipCmpt>()->GetParentEntity();
+		QK_CORE_VERIFY((eParent == nullptr) == (lParent == nullptr))
+		QK_CORE_VERIFY(!eParent || eParent->GetComponent<IdCmpt>()->id == lParent->GetComponent<IdCmpt>()->id)
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Prints how long its scope took when it ends, also per frame when given the number of frames the scope ran
+struct timer
+{
+	std::string name;
+	uint32_t frames;
+	std::chrono::high_resolution_clock::time_point start;
+
+	timer(const std::string& name, uint32_t frames = 0) : name(name), frames(frames), start(std::chrono::high_resolution_clock::now()) {}
+	~timer()
+	{
+		const double ms = elapsed_ms();
+		std::cout << name << ": " << ms << " milliseconds";
+		if (frames > 0)
+			std::cout << ", " << ms / frames << " milliseconds per frame";
+		std::cout << std::endl;
+	}
+
+	double elapsed_ms() const
+	{
+		auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+		return us / 1000.0;
+	}
+};
@@ -0,0 +1,187 @@
+#include <iostream>
+#include <string>
+#include <random>
+#include <vector>
+#include <cstring>
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/Util/AlignedAlloc.h>
+#include <Quark/Core/Util/RingAllocator.h>
+#include "TestTimer.h"
+
+using namespace std;
+using namespace quark;
+using namespace quark::util;
+
+// Upload staging test: checks that the ring the upload batcher stages static data in never hands out memory the GPU
+// may still read, then measures staging throughput of a level load of meshes. Every vertex and index buffer with its
+// own staging buffer and submission, as meshes used to be uploaded, against all of them staged in one persistent ring
+// and submitted once per frame, with the GPU finishing a batch two frames after it was submitted.
+// Only the CPU side is measured and the GPU copies are the same in both cases. A freed staging buffer is reused hot in
+// cache by the next upload, so the copies alone do not favor the ring, what it saves is the submissions and the CPU
+// waiting for the queue after every upload.
+// Usage: UploadRing_Test [mesh count]
+
+constexpr uint64_t RING_SIZE = 64 * 1024 * 1024;
+constexpr uint32_t MESHES_PER_FRAME = 250;
+constexpr uint64_t GPU_LATENCY = 2;
+
+struct Allocation
+{
+	uint64_t offset;
+	uint64_t size;
+	uint64_t value;
+};
+
+static void CheckRing()
+{
+	const uint64_t size = 1024 * 1024;
+	const uint64_t alignments[] = { 4, 16, 48, 256 };
+	RingAllocator ring(size);
+	mt19937 rng(5);
+
+	vector<Allocation> live;
+	uint64_t value = 0;
+	uint64_t completed = 0;
+	uint32_t wraps = 0;
+	uint32_t fulls = 0;
+	uint64_t lastOffset = 0;
+	for (uint32_t i = 0; i < 200000; i++)
+	{
+		// the GPU finishes batches at its own pace
+		if (rng() % 4 == 0 && completed < value)
+		{
+			completed += 1 + rng() % (value - completed);
+			ring.release(completed);
+			erase_if(live, [&](const Allocation& a) { return a.value <= completed; });
+		}
+
+		if (rng() % 16 == 0)
+		{
+			ring.close(++value);
+			for (Allocation& a : live)
+				a.value = a.value == 0 ? value : a.value;
+		}
+
+		const uint64_t allocSize = 1 + rng() % (rng() % 8 == 0 ? size / 4 : 4096);
+		const uint64_t alignment = alignments[rng() % 4];
+		const uint64_t offset = ring.allocate(allocSize, alignment);
+		if (offset == RingAllocator::INVALID_OFFSET)
+		{
+			fulls++;
+			continue;
+		}
+
+		QK_CORE_VERIFY(offset % alignment == 0 && offset + allocSize <= size)
+		for (const Allocation& a : live)
+			QK_CORE_VERIFY(offset + allocSize <= a.offset || a.offset + a.size <= offset, "Allocation overlaps memory the GPU may still read")
+
+		wraps += offset < lastOffset ? 1 : 0;
+		lastOffset = offset;
+		live.push_back({ offset, allocSize, 0 });
+	}
+
+	ring.close(++value);
+	ring.release(value);
+	QK_CORE_VERIFY(ring.get_used_size() == 0 && !ring.has_pending())
+	QK_CORE_VERIFY(ring.allocate(size, 16) == 0)
+	QK_CORE_VERIFY(ring.allocate(1, 1) == RingAllocator::INVALID_OFFSET)
+	QK_CORE_VERIFY(wraps > 0 && fulls > 0)
+	cout << "Ring checks passed: " << wraps << " wrap arounds, " << fulls << " allocations waited for the GPU" << endl;
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+	CheckRing();
+
+	const uint32_t meshCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 5000;
+
+	// index, position, normal and tangent, uv buffers of meshes with 500 to 20000 vertices
+	mt19937 rng(17);
+	vector<uint64_t> bufferSizes;
+	for (uint32_t i = 0; i < meshCount; i++)
+	{
+		const uint64_t vertexCount = 500 + rng() % 19500;
+		bufferSizes.push_back(vertexCount * 6 * sizeof(uint32_t));
+		bufferSizes.push_back(vertexCount * 12);
+		bufferSizes.push_back(vertexCount * 24);
+		bufferSizes.push_back(vertexCount * 8);
+	}
+
+	uint64_t totalBytes = 0;
+	uint64_t largest = 0;
+	for (uint64_t size : bufferSizes)
+	{
+		totalBytes += size;
+		largest = max(largest, size);
+	}
+	vector<uint8_t> source(largest, 0x5a);
+
+	// a staging buffer and a submission per buffer
+	double separateMs = 0.0;
+	{
+		timer t("separate");
+		uint64_t checksum = 0;
+		for (uint64_t size : bufferSizes)
+		{
+			uint8_t* staging = static_cast<uint8_t*>(memalign_alloc(256, size));
+			memcpy(staging, source.data(), size);
+			checksum += staging[size - 1];
+			memalign_free(staging);
+		}
+		separateMs = t.elapsed_ms();
+		QK_CORE_VERIFY(checksum == bufferSizes.size() * 0x5a)
+	}
+
+	// one persistent ring, one submission per frame
+	double batchedMs = 0.0;
+	uint64_t submissions = 0;
+	uint64_t stagingWaits = 0;
+	{
+		uint8_t* ringMemory = static_cast<uint8_t*>(memalign_alloc(256, RING_SIZE));
+		RingAllocator ring(RING_SIZE);
+		uint64_t value = 0;
+
+		timer t("batched");
+		for (size_t i = 0; i < bufferSizes.size(); i++)
+		{
+			const uint64_t size = bufferSizes[i];
+			uint64_t offset = ring.allocate(size, 16);
+			while (offset == RingAllocator::INVALID_OFFSET)
+			{
+				// out of staging memory, submit what is there and wait for the oldest batch
+				if (ring.get_open_size() > 0)
+				{
+					ring.close(++value);
+					submissions++;
+				}
+				ring.release(ring.get_oldest_pending_value());
+				stagingWaits++;
+				offset = ring.allocate(size, 16);
+			}
+			memcpy(ringMemory + offset, source.data(), size);
+
+			// end of frame
+			if ((i + 1) % (4 * MESHES_PER_FRAME) == 0 || i + 1 == bufferSizes.size())
+			{
+				if (ring.get_open_size() > 0)
+				{
+					ring.close(++value);
+					submissions++;
+				}
+				if (value > GPU_LATENCY)
+					ring.release(value - GPU_LATENCY);
+			}
+		}
+		batchedMs = t.elapsed_ms();
+		memalign_free(ringMemory);
+	}
+
+	const double megabytes = totalBytes / (1024.0 * 1024.0);
+	cout << "Uploading " << meshCount << " meshes, " << bufferSizes.size() << " buffers, " << (uint64_t)megabytes << " MB" << endl;
+	cout << "Staging buffer per upload: " << separateMs << " ms, " << megabytes / (separateMs / 1000.0) << " MB/s, " << bufferSizes.size() << " submissions, " << bufferSizes.size() << " waits for the queue" << endl;
+	cout << "Batched staging ring: " << batchedMs << " ms, " << megabytes / (batchedMs / 1000.0) << " MB/s, " << submissions << " submissions, " << stagingWaits << " waits for staging memory" << endl;
+
+	QK_CORE_VERIFY(submissions <= (meshCount + MESHES_PER_FRAME - 1) / MESHES_PER_FRAME + stagingWaits)
+	cout << "Upload ring checks passed" << endl;
+}
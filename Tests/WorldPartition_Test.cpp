@@ -0,0 +1,217 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/JobSystem.h>
+#include <Quark/Scene/Scene.h>
+#include <Quark/Scene/WorldPartition.h>
+#include <Quark/Scene/SceneSerializer.h>
+#include <Quark/Scene/SceneBinaryFormat.h>
+#include <Quark/Scene/Components/CommonCmpts.h>
+#include <Quark/Scene/Components/TransformCmpt.h>
+#include <Quark/Scene/Components/RelationshipCmpt.h>
+
+using namespace std;
+using namespace quark;
+
+// Headless fly-through of a streamed world: builds a grid of cells, then moves a viewer diagonally across it,
+// timing every WorldPartition::Update() and checking the memory budget and the residency around the viewer.
+// Usage: WorldPartition_Test [frame count]
+
+constexpr int GRID_SIZE = 16;
+constexpr float CELL_SIZE = 64.f;
+constexpr uint32_t ROOTS_PER_CELL = 40;
+constexpr uint32_t CHILDREN_PER_ROOT = 7;
+constexpr uint32_t ENTITIES_PER_CELL = ROOTS_PER_CELL * (CHILDREN_PER_ROOT + 1);
+constexpr double HITCH_MS = 4.0;
+constexpr int CORRUPTED_CELL = GRID_SIZE / 2;    // on the viewer's path, x and z
+
+static Ref<Scene> CreateWorld()
+{
+	Ref<Scene> scene = CreateRef<Scene>("WorldPartition_Test");
+	scene->ReserveEntities(GRID_SIZE * GRID_SIZE * ENTITIES_PER_CELL);
+
+	for (int z = 0; z < GRID_SIZE; z++)
+	{
+		for (int x = 0; x < GRID_SIZE; x++)
+		{
+			for (uint32_t i = 0; i < ROOTS_PER_CELL; i++)
+			{
+				Entity* root = scene->CreateEntity("Root");
+				float offset = (i + 0.5f) * CELL_SIZE / ROOTS_PER_CELL;
+				root->GetComponent<TransformCmpt>()->SetLocalPosition(glm::vec3(x * CELL_SIZE + offset, 0.f, z * CELL_SIZE + offset));
+
+				for (uint32_t c = 0; c < CHILDREN_PER_ROOT; c++)
+				{
+					Entity* child = scene->CreateEntity("", root);
+					child->GetComponent<TransformCmpt>()->SetLocalPosition(glm::vec3(0.f, (float)c, 0.f));
+				}
+			}
+		}
+	}
+
+	return scene;
+}
+
+// Number of entities whose root lies in the cell containing position
+static uint32_t CountEntitiesInCell(Scene& scene, const glm::vec3& position)
+{
+	int cx = (int)std::floor(position.x / CELL_SIZE);
+	int cz = (int)std::floor(position.z / CELL_SIZE);
+
+	uint32_t count = 0;
+	for (auto* entity : scene.GetAllEntitiesWith<IdCmpt, RelationshipCmpt>())
+	{
+		Entity* root = entity;
+		while (Entity* parent = root->GetComponent<RelationshipCmpt>()->GetParentEntity())
+			root = parent;
+
+		glm::vec3 p = root->GetComponent<TransformCmpt>()->GetLocalPosition();
+		if ((int)std::floor(p.x / CELL_SIZE) == cx && (int)std::floor(p.z / CELL_SIZE) == cz)
+			count++;
+	}
+
+	return count;
+}
+
+// Points the first child index of a cell file outside of it. The file still opens, instantiating it fails
+static void CorruptHierarchy(const filesystem::path& cellPath)
+{
+	vector<char> data(filesystem::file_size(cellPath));
+	ifstream(cellPath, ios::binary).read(data.data(), data.size());
+
+	BinarySceneHeader header;
+	memcpy(&header, data.data(), sizeof(header));
+	for (uint32_t i = 0; i < header.sectionCount; i++)
+	{
+		BinarySceneSection section;
+		memcpy(&section, data.data() + sizeof(header) + i * sizeof(section), sizeof(section));
+		if (section.type == BinarySceneSectionType::CHILD_INDEXES && section.elementCount > 0)
+		{
+			const uint32_t invalid = header.entityCount;
+			memcpy(data.data() + section.offset, &invalid, sizeof(invalid));
+		}
+	}
+
+	ofstream(cellPath, ios::binary).write(data.data(), data.size());
+}
+
+int main(int argc, char** argv)
+{
+	Logger::Init();
+
+	uint32_t frameCount = argc > 1 ? (uint32_t)stoul(argv[1]) : 2000;
+	auto manifestPath = filesystem::temp_directory_path() / ("WorldPartition_Test" + string(WorldPartition::s_DefaultExtension));
+	auto cellDirectory = filesystem::temp_directory_path() / "WorldPartition_Test_cells";
+
+	{
+		auto buildStart = chrono::high_resolution_clock::now();
+		QK_CORE_VERIFY(WorldPartition::Build(CreateWorld(), manifestPath, CELL_SIZE))
+		auto ms = chrono::duration_cast<chrono::milliseconds>(chrono::high_resolution_clock::now() - buildStart).count();
+		cout << "Built " << GRID_SIZE * GRID_SIZE << " cells with " << ENTITIES_PER_CELL << " entities each: " << ms << " milliseconds" << endl;
+	}
+
+	const string corruptedCell = "cell_" + to_string(CORRUPTED_CELL) + "_" + to_string(CORRUPTED_CELL) + string(SceneSerializer::s_BinaryExtension);
+	CorruptHierarchy(cellDirectory / corruptedCell);
+
+	JobSystem jobSystem;
+	Ref<Scene> scene = CreateRef<Scene>("");
+
+	WorldPartitionSpecification specs;
+	specs.loadRadius = 2 * CELL_SIZE;
+	specs.unloadRadius = 2.5f * CELL_SIZE;
+	specs.memoryBudget = 4ull << 20;
+	specs.maxEntitiesPerFrame = 2 * ENTITIES_PER_CELL;
+
+	WorldPartition partition(scene, jobSystem, specs);
+	QK_CORE_VERIFY(partition.Open(manifestPath))
+	QK_CORE_VERIFY(partition.GetCellCount() == GRID_SIZE * GRID_SIZE)
+
+	glm::vec3 start(CELL_SIZE * 0.5f, 10.f, CELL_SIZE * 0.5f);
+	glm::vec3 end(CELL_SIZE * (GRID_SIZE - 0.5f), 10.f, CELL_SIZE * (GRID_SIZE - 0.5f));
+
+	partition.Flush(start);
+	QK_CORE_VERIFY(CountEntitiesInCell(*scene, start) == ENTITIES_PER_CELL)
+	cout << "Initial resident cells: " << partition.GetStats().residentCells << ", entities: " << scene->GetEntities().size() << endl;
+
+	// the editor deletes one root of the start cell and moves another under an entity of its own, unloading the cell
+	// skips both and the moved hierarchy outlives it. Loading the cell again restores the deleted one only
+	uint32_t unloadCallbacks = 0;
+	partition.SetUnloadCallback([&]() { unloadCallbacks++; });
+	Entity* keeper = scene->CreateEntity("Keeper");
+	keeper->GetComponent<TransformCmpt>()->SetLocalPosition(glm::vec3(-CELL_SIZE * GRID_SIZE, 0.f, 0.f));
+	{
+		vector<Entity*> startRoots;
+		for (auto* entity : scene->GetAllEntitiesWith<IdCmpt, RelationshipCmpt>())
+		{
+			glm::vec3 p = entity->GetComponent<TransformCmpt>()->GetLocalPosition();
+			if (entity != keeper && !entity->GetComponent<RelationshipCmpt>()->GetParentEntity() && p.x < CELL_SIZE && p.z < CELL_SIZE)
+				startRoots.push_back(entity);
+		}
+		QK_CORE_VERIFY(startRoots.size() == ROOTS_PER_CELL)
+		scene->DeleteEntity(startRoots[0]);
+		scene->AttachChild(startRoots[1], keeper);
+	}
+	const UUID movedId = keeper->GetComponent<RelationshipCmpt>()->GetChildEntities()[0]->GetComponent<IdCmpt>()->id;
+
+	int64_t liveEntities = scene->GetEntities().size();
+	double totalMs = 0, maxMs = 0;
+	uint32_t hitches = 0, budgetLimitedFrames = 0;
+	size_t peakMemory = 0;
+
+	for (uint32_t frame = 0; frame < frameCount; frame++)
+	{
+		glm::vec3 viewer = start + (end - start) * ((float)frame / (frameCount - 1));
+
+		auto frameStart = chrono::high_resolution_clock::now();
+		partition.Update(viewer);
+		double ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - frameStart).count();
+
+		totalMs += ms;
+		maxMs = std::max(maxMs, ms);
+		if (ms > HITCH_MS)
+			hitches++;
+
+		const auto& stats = partition.GetStats();
+		QK_CORE_VERIFY(stats.usedMemory <= specs.memoryBudget)
+		QK_CORE_VERIFY(stats.createdEntities <= specs.maxEntitiesPerFrame)
+		peakMemory = std::max(peakMemory, stats.usedMemory);
+		budgetLimitedFrames += stats.budgetLimited ? 1 : 0;
+
+		liveEntities += (int64_t)stats.createdEntities - (int64_t)stats.deletedEntities;
+		QK_CORE_VERIFY(liveEntities == (int64_t)scene->GetEntities().size())
+	}
+
+	QK_CORE_VERIFY(unloadCallbacks > 0)
+	QK_CORE_VERIFY(partition.GetStats().failedCells == 1)
+	QK_CORE_VERIFY(scene->GetEntityWithID(movedId) && scene->GetEntityWithID(keeper->GetComponent<IdCmpt>()->id) == keeper)
+	QK_CORE_VERIFY(keeper->GetComponent<RelationshipCmpt>()->GetChildEntities().size() == 1)
+
+	cout << "Frames: " << frameCount << ", average update: " << totalMs / frameCount << " ms, max update: " << maxMs << " ms" << endl;
+	cout << "Hitches (> " << HITCH_MS << " ms): " << hitches << endl;
+	cout << "Peak memory: " << peakMemory << " bytes of " << specs.memoryBudget << ", budget limited frames: " << budgetLimitedFrames << endl;
+
+	// Teleport back, everything around the viewer becomes resident again and the far corner is gone.
+	// The moved hierarchy still has the IDs of the cell file, it is not created a second time
+	partition.Flush(start);
+	QK_CORE_VERIFY(CountEntitiesInCell(*scene, start) == ENTITIES_PER_CELL - (CHILDREN_PER_ROOT + 1))
+	QK_CORE_VERIFY(CountEntitiesInCell(*scene, end) == 0)
+	QK_CORE_VERIFY(keeper->GetComponent<RelationshipCmpt>()->GetChildEntities().size() == 1)
+	QK_CORE_VERIFY(keeper->GetComponent<RelationshipCmpt>()->GetChildEntities()[0]->GetComponent<IdCmpt>()->id == movedId)
+	for (auto* entity : scene->GetAllEntitiesWith<IdCmpt, RelationshipCmpt>())
+		QK_CORE_VERIFY(scene->GetEntityWithID(entity->GetComponent<IdCmpt>()->id) == entity)
+
+	// The corrupted cell is not requested again, not even when the viewer stands in it
+	const glm::vec3 corrupted(CELL_SIZE * (CORRUPTED_CELL + 0.5f), 10.f, CELL_SIZE * (CORRUPTED_CELL + 0.5f));
+	partition.Flush(corrupted);
+	QK_CORE_VERIFY(partition.GetStats().failedCells == 1)
+	QK_CORE_VERIFY(CountEntitiesInCell(*scene, corrupted) == 0)
+
+	filesystem::remove(manifestPath);
+	filesystem::remove_all(cellDirectory);
+}